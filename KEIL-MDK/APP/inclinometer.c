@@ -1,20 +1,21 @@
 #include "inclinometer.h"
 #include <math.h>
-#include <stdlib.h>
 #include "sca100t.h"
 #include "nrf_delay.h"
+#include "app_util_platform.h"
 
 
 #define INCLINOMETER_PWOER_ENBALE()		nrf_gpio_pin_set(INCLINOMETER_PWOER_PIN)
 #define INCLINOMETER_PWOER_DISABLE()	nrf_gpio_pin_clear(INCLINOMETER_PWOER_PIN)
 
-/* SCA100Tϵ */
+/* SCA100T系列灵敏度 */
 #define	SCA100T_D01_RESOLUTION				1638	
 #define	SCA100T_D02_RESOLUTION				819
 #define SCA100T_D01_DATA_VALID_MIN		205
 #define SCA100T_D01_DATA_VALID_MAX		1843
 
 #define SCA100T_READ_DELAY						1
+#define INCLINOMETER_READ_TIMES					5 //每次采样每轴读取次数，不超过SCA_BURST_MAX_TIMES
 uint32_t READ_DELAY = 5;
 const uint16_t ScaResolution[] = {SCA100T_D01_RESOLUTION, SCA100T_D02_RESOLUTION};
 static SCA_Type ScaType = SCA_D01;
@@ -29,111 +30,111 @@ static float Inclinometer_ReadTemp(void)
 	return (tempDigital - 197) / (-1.083);
 }
 
-static int Compare_Uint16(const void *data1, const void *data2)
+//单轴读数累加器：只记录和、最小值、最大值，去掉最大最小值后取平均，不需要缓存全部读数
+typedef struct {
+	uint32_t sum;
+	uint16_t min;
+	uint16_t max;
+	uint8_t nums;
+}Inclinometer_Acc_t;
+
+static void Inclinometer_AccReset(Inclinometer_Acc_t* acc)
 {
-	return *(uint16_t*)data1 - *(uint16_t*)data2;
+	acc->sum = 0;
+	acc->min = 0XFFFF;
+	acc->max = 0;
+	acc->nums = 0;
 }
 
-//ȡС1024()㼴ڣ1024㼴Ұ
-//תǶȺ45.45Ϊ4545
-float g_f_acceleration = 0;
-float g_angle = 0;
-static float Inclinometer_ReadXAngle(uint8_t ReadTimes)
+static void Inclinometer_AccAdd(Inclinometer_Acc_t* acc, uint16_t acceleration)
 {
-//	SCA_WriteCommand(STX);
-//	SCA_WriteCommand(MEAS);
-	
-	if(ReadTimes == 0)
+	if(acceleration < SCA100T_D01_DATA_VALID_MIN)
 	{
-		return 0.0;
+		acceleration = SCA100T_D01_DATA_VALID_MIN;
+	}
+	else if(acceleration > SCA100T_D01_DATA_VALID_MAX)
+	{
+		acceleration = SCA100T_D01_DATA_VALID_MAX;
 	}
 	
-	uint16_t acceleration;
-	uint16_t* pValue = (uint16_t*)malloc(sizeof(uint16_t)*ReadTimes);
+	acc->sum += acceleration;
+	acc->min = acceleration < acc->min ? acceleration : acc->min;
+	acc->max = acceleration > acc->max ? acceleration : acc->max;
+	acc->nums++;
+}
+
+//如果读取的数据小于1024(负数)则代表右倾即左摆，大于1024（正数）则代表左倾即右摆
+//读数不少于3次时去掉最大最小值后取平均，再转换为角度
+static float Inclinometer_AccAngle(Inclinometer_Acc_t* acc)
+{
+	float f_acceleration;
 	
-	for(int i=0; i<ReadTimes; i++)
+	if(acc->nums == 0)
 	{
-		acceleration  = (uint16_t)SCA_ReadXChannel();
-		if(acceleration<SCA100T_D01_DATA_VALID_MIN || acceleration>SCA100T_D01_DATA_VALID_MAX)
-		{
-			if(acceleration<SCA100T_D01_DATA_VALID_MIN)
-			{
-				acceleration = SCA100T_D01_DATA_VALID_MIN;
-			}
-			else
-			{
-				acceleration = SCA100T_D01_DATA_VALID_MAX;
-			}
-		}
-		*(pValue+i) = acceleration;
-		nrf_delay_ms(READ_DELAY);
+		return 0.0;
 	}
 	
-	qsort(pValue, ReadTimes, sizeof(uint16_t), Compare_Uint16);
-
-	uint32_t temp = 0;
-	for(int i=1; i<ReadTimes-1; i++)
+	if(acc->nums > 2)
 	{
-		temp += pValue[i];
+		f_acceleration = (float)(acc->sum - acc->min - acc->max) / (acc->nums - 2);
 	}
-	float f_acceleration = temp / (ReadTimes-2);
-	g_f_acceleration = f_acceleration;
-	free((void*)pValue);
-
-	float angle = (asin((f_acceleration - 1024) / ScaResolution[ScaType])) * 180 /3.1415926;
-	return angle;
+	else
+	{
+		f_acceleration = (float)acc->sum / acc->nums;
+	}
+	
+	return (asin((f_acceleration - 1024) / ScaResolution[ScaType])) * 180 /3.1415926;
 }
 
-uint16_t data_y[10];
-uint16_t data_y_min = 0XFFFF;
-uint16_t data_y_max = 0;
-static float Inclinometer_ReadYAngle(uint8_t ReadTimes)
+static float Inclinometer_ReadXAngle(uint8_t ReadTimes)
 {
-//	SCA_WriteCommand(STY);
-//	SCA_WriteCommand(MEAS);
+	Inclinometer_Acc_t acc;
 	
-	if(ReadTimes == 0)
+	Inclinometer_AccReset(&acc);
+	for(int i=0; i<ReadTimes; i++)
 	{
-		return 0.0;
+		Inclinometer_AccAdd(&acc, (uint16_t)SCA_ReadXChannel());
+		nrf_delay_ms(READ_DELAY);
 	}
 	
-	uint16_t acceleration;
-	uint16_t* pValue = (uint16_t*)malloc(sizeof(uint16_t)*ReadTimes);
+	return Inclinometer_AccAngle(&acc);
+}
+
+static float Inclinometer_ReadYAngle(uint8_t ReadTimes)
+{
+	Inclinometer_Acc_t acc;
+	
+	Inclinometer_AccReset(&acc);
 	for(int i=0; i<ReadTimes; i++)
 	{
-		acceleration = SCA_ReadYChannel();
-		data_y[i] = acceleration;
-		if(data_y_min > acceleration) data_y_min = acceleration;
-		if(data_y_max < acceleration) data_y_max = acceleration;		
-		
-		if(acceleration<SCA100T_D01_DATA_VALID_MIN || acceleration>SCA100T_D01_DATA_VALID_MAX)
-		{
-			if(acceleration<SCA100T_D01_DATA_VALID_MIN)
-			{
-				acceleration = SCA100T_D01_DATA_VALID_MIN;
-			}
-			else
-			{
-				acceleration = SCA100T_D01_DATA_VALID_MAX;
-			}
-		}
-		*(pValue+i) = acceleration;
+		Inclinometer_AccAdd(&acc, (uint16_t)SCA_ReadYChannel());
 		nrf_delay_ms(READ_DELAY);
 	}
 	
-	qsort(pValue, ReadTimes, sizeof(uint16_t), Compare_Uint16);
-	qsort(data_y, ReadTimes, sizeof(uint16_t), Compare_Uint16);
+	return Inclinometer_AccAngle(&acc);
+}
+
+//连续读取完成后从RAM中取出X、Y轴读数计算角度
+static void Inclinometer_BurstData(Inclinometer_Data* data, uint8_t ReadTimes)
+{
+	Inclinometer_Acc_t accX, accY;
 	
-	uint32_t temp = 0;
-	for(int i=1; i<ReadTimes-1; i++)
+	Inclinometer_AccReset(&accX);
+	Inclinometer_AccReset(&accY);
+	for(int i=0; i<ReadTimes; i++)
 	{
-		temp += pValue[i];
+		Inclinometer_AccAdd(&accX, SCA_BurstGetXChannel(i));
+		Inclinometer_AccAdd(&accY, SCA_BurstGetYChannel(i));
 	}
-	float f_acceleration = temp / (ReadTimes-2);
-	free((void*)pValue);
+	
+	data->XAngle = Inclinometer_AccAngle(&accX);
+	data->YAngle = Inclinometer_AccAngle(&accY);
+}
 
-	float angle = (asin((f_acceleration - 1024) / ScaResolution[ScaType])) * 180 /3.1415926;
-	return angle;
+/* SCA100T连续读取完成，唤醒任务计算角度 */
+void SCA_BurstDoneHandler(void)
+{
+	Inclinometer_Info.LPMHandle->TaskSetStatus(INCLINOMETER_TASK_ID, LPM_TASK_STA_RUN);
 }
 
 static void Inclinometer_TaskStart(void)
@@ -163,26 +164,50 @@ static void Inclinometer_TaskOperate(void)
 	{
 		case INCLINOMETER_TASK_ACTIVE:
 			SCA_Init();
-			INCLINOMETER_PWOER_ENBALE(); //ǲ
+			INCLINOMETER_PWOER_ENBALE(); //打开倾角采样功能
 			nrf_delay_ms(power_delay);
 			InclinometerTaskStatus = INCLINOMETER_TASK_IDLE;
 			Inclinometer_Info.State = INCLINOMETER_TASK_ACTIVE;
 			Inclinometer_Info.LPMHandle->TaskSetStatus(INCLINOMETER_TASK_ID, LPM_TASK_STA_RUN);
-			Inclinometer_Info.Data.XAngle = Inclinometer_ReadXAngle(5);
-			Inclinometer_Info.Data.YAngle = Inclinometer_ReadYAngle(5);
 			Inclinometer_Info.Data.Temperature = Inclinometer_ReadTemp();
+			
+			/* X、Y轴交替读取由定时器与PPI完成，期间CPU休眠，读完后中断唤醒 */
+			if(SCA_BurstStart(INCLINOMETER_READ_TIMES, READ_DELAY * 1000 / 2) == 1)
+			{
+				InclinometerTaskStatus = INCLINOMETER_TASK_SAMPLE;
+				Inclinometer_Info.LPMHandle->TaskSetStatus(INCLINOMETER_TASK_ID, LPM_TASK_STA_LP);
+				break;
+			}
+			Inclinometer_Info.Data.XAngle = Inclinometer_ReadXAngle(INCLINOMETER_READ_TIMES);
+			Inclinometer_Info.Data.YAngle = Inclinometer_ReadYAngle(INCLINOMETER_READ_TIMES);
 			Inclinometer_Info.Data.UpdateFlag = 1;
 			InclinometerTaskStatus = INCLINOMETER_TASK_STOP;
 			break;
 		
+		case INCLINOMETER_TASK_SAMPLE:
+			CRITICAL_REGION_ENTER();
+			if(SCA_BurstDone() == 0)
+			{
+				Inclinometer_Info.LPMHandle->TaskSetStatus(INCLINOMETER_TASK_ID, LPM_TASK_STA_LP);
+			}
+			CRITICAL_REGION_EXIT();
+			
+			if(SCA_BurstDone() == 1)
+			{
+				Inclinometer_BurstData(&Inclinometer_Info.Data, INCLINOMETER_READ_TIMES);
+				Inclinometer_Info.Data.UpdateFlag = 1;
+				InclinometerTaskStatus = INCLINOMETER_TASK_STOP;
+			}
+			break;
+		
 		case INCLINOMETER_TASK_STOP:
 			SCA_Default();
-			INCLINOMETER_PWOER_DISABLE(); //رǲ
+			INCLINOMETER_PWOER_DISABLE(); //关闭倾角采样功能
 			stateTmp = InclinometerTaskStatus;
 			InclinometerTaskStatus = INCLINOMETER_TASK_IDLE;
 			Inclinometer_Info.State = INCLINOMETER_TASK_IDLE;
 			Inclinometer_Info.LPMHandle->TaskSetStatus(INCLINOMETER_TASK_ID, LPM_TASK_STA_STOP);
-			Inclinometer_TaskStopHandler((void *)&stateTmp); /* Ǵֹͣ */
+			Inclinometer_TaskStopHandler((void *)&stateTmp); /* 倾角传感器任务停止处理 */
 			break;
 	}
 	
@@ -231,7 +256,7 @@ Inclinometer_Info_t* Inclinometer_TaskInit(LPM_t* LPMHandle)
 	return &Inclinometer_Info;
 }
 
-/* Ǵֹͣ */
+/* 倾角传感器任务停止处理 */
 __weak void Inclinometer_TaskStopHandler(void* param)
 {
 	return;
@@ -18,6 +18,7 @@ typedef enum {
 	INCLINOMETER_TASK_IDLE,
 	INCLINOMETER_TASK_ACTIVE,
 	INCLINOMETER_TASK_STOP,
+	INCLINOMETER_TASK_SAMPLE, //等待连续读取完成
 }Inclinometer_Task_State;
 
 typedef struct {
@@ -1,6 +1,8 @@
 #include "iot_operate.h"
 #include "sys_param.h"
 #include "calendar.h"
+#include "sample_batch.h"
+#include "math.h"
 
 
 IoT_dev_t IoT_dev;
@@ -39,14 +41,96 @@ void IoT_WriteYAngle(uint32_t value)
 void IoT_SetSampleInterval(uint32_t value)
 {
 	sys_param_t* param = Sys_ParamGetHandle();
-	param->iot_sample_interval = value; //ò
+	param->iot_sample_interval = value; //设置采样间隔
 	param->update_flag = 1;
 }
 
 void IoT_SetTimeStamp(uint32_t value)
 {
 	Calendar_t* calendar = Calendar_GetHandle();
-	calendar->SetTimeStamp(value); //ʱ
+	calendar->SetTimeStamp(value); //设置时间戳
+}
+
+//阈值模式事件判断，阈值不大于0的轴不判断，有事件返回1
+static uint8_t IoT_EventCheck(sys_param_t* param, float* value)
+{
+	float thres[2] = {param->iot_x_angle_threshold, param->iot_y_angle_threshold};
+	uint8_t event = 0;
+	uint8_t bit;
+	
+	for(uint8_t i = 0; i < 2; i++)
+	{
+		if(thres[i] <= 0)
+		{
+			continue;
+		}
+		
+		if(param->iot_mode == IOT_MODE_RELATIVE)
+		{
+			event |= fabsf(value[i] - IoT_dev.event_ref[i]) >= thres[i];
+			continue;
+		}
+		
+		//绝对阈值模式：进入与退出告警都上报，带回差防止在阈值附近反复上报
+		bit = 1 << i;
+		if(!(IoT_dev.event_alarm & bit) && fabsf(value[i]) >= thres[i])
+		{
+			IoT_dev.event_alarm |= bit;
+			event = 1;
+		}
+		else if((IoT_dev.event_alarm & bit) && fabsf(value[i]) < thres[i] * (1 - IOT_EVENT_HYST_RATIO))
+		{
+			IoT_dev.event_alarm &= ~bit;
+			event = 1;
+		}
+	}
+	
+	return event;
+}
+
+//按采样间隔采样写入批量缓存，由LORA任务合并为一帧上行，上行未完成而缓存已满时丢弃最早采样，保证最新数据。
+//周期模式在缓存满或达到上报周期时上报；阈值模式越限时立即上报并请求确认，否则只按心跳周期上报
+void IoT_BatchPush(void)
+{
+	SampleBatch_t* batch = SampleBatch_GetHandle();
+	sys_param_t* param = Sys_ParamGetHandle();
+	Inclinometer_Data* data = &IoT_dev.inclinometer_info->Data;
+	float value[3] = {data->XAngle, data->YAngle, 0}; //倾角测点没有Z轴角度
+	uint32_t time_stamp = Calendar_GetHandle()->GetTimeStamp();
+	
+	if(batch->Push(time_stamp, data->Temperature, value, 3) == 0)
+	{
+		batch->Drop();
+		batch->Push(time_stamp, data->Temperature, value, 3);
+	}
+	
+	if(param->iot_mode != IOT_MODE_RELATIVE && param->iot_mode != IOT_MODE_ABSOLUTE)
+	{
+		if(batch->Ready(time_stamp, IoT_dev.batch_period))
+		{
+			IoT_dev.batch_ready = 1;
+		}
+		return;
+	}
+	
+	if(IoT_EventCheck(param, value))
+	{
+		IoT_dev.event_confirm = 1;
+		IoT_dev.event_nums++;
+	}
+	else if(time_stamp - IoT_dev.report_time >= IoT_dev.heartbeat)
+	{
+		IoT_dev.heartbeat_nums++;
+	}
+	else
+	{
+		return;
+	}
+	
+	IoT_dev.batch_ready = 1;
+	IoT_dev.report_time = time_stamp;
+	IoT_dev.event_ref[0] = value[0];
+	IoT_dev.event_ref[1] = value[1];
 }
 
 void IoT_Operate(void)
@@ -73,6 +157,7 @@ void IoT_Operate(void)
 		IoT_WriteTemperature(IoT_dev.inclinometer_info->Data.Temperature);
 		IoT_WriteXAngle(IoT_dev.inclinometer_info->Data.XAngle);
 		IoT_WriteYAngle(IoT_dev.inclinometer_info->Data.YAngle);
+		IoT_BatchPush();
 	}
 	
 	if(IoT_dev.gas_gauge_flag == 1)
@@ -87,7 +172,7 @@ IoT_dev_t * IoT_Init(iot_object_t *sensor,
 {
 	IoT_dev.gas_gauge_flag = 0;
 	IoT_dev.gas_gauge = 100;
-
+	
 	IoT_dev.sensor = sensor;
 	IoT_dev.inclinometer_info = inclinometer_handle;
 	
@@ -109,10 +194,28 @@ IoT_dev_t * IoT_Init(iot_object_t *sensor,
 	IoT_WriteYAngle(0);
 	IoT_dev.sensor->resetPropChangeFlag(DATA_Y_ANGLE_ID);	
 	
+	SampleBatch_Init();
+	IoT_dev.batch_period = IOT_BATCH_PERIOD_DEFAULT;
+	IoT_dev.batch_ready = 0;
+	
+	IoT_dev.event_alarm = 0;
+	IoT_dev.event_confirm = 0;
+	IoT_dev.event_ref[0] = 0;
+	IoT_dev.event_ref[1] = 0;
+	IoT_dev.report_time = 0;
+	IoT_dev.heartbeat = IOT_EVENT_HEARTBEAT_DEFAULT;
+	IoT_dev.event_nums = 0;
+	IoT_dev.heartbeat_nums = 0;
+	
 	IoT_dev.operate = IoT_Operate;
 	
 	return &IoT_dev;
 }
 
+IoT_dev_t* IoT_GetHandle(void)
+{
+	return &IoT_dev;
+}
+
 
 
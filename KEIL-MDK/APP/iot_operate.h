@@ -12,16 +12,39 @@
 #define DATA_X_ANGLE_ID 					7
 #define DATA_Y_ANGLE_ID 					8
 
+#define IOT_BATCH_PERIOD_DEFAULT			600u //批量上报周期(s)，默认采样间隔60s时每帧10个采样
+
+/* 数据采样模式，同SYS_PARAM_IOT_MODE */
+#define IOT_MODE_PERIOD						0 //周期模式，每个上报周期上报
+#define IOT_MODE_RELATIVE					1 //相对阈值模式，角度相对上次上报值变化超过阈值立即上报
+#define IOT_MODE_ABSOLUTE					2 //绝对阈值模式，角度绝对值越过阈值(进入或退出告警)立即上报
+
+#define IOT_EVENT_HYST_RATIO				0.1f //绝对阈值模式回差，回落到阈值*(1-回差)以下才退出告警
+#define IOT_EVENT_HEARTBEAT_DEFAULT			3600u //阈值模式下没有事件时的心跳上报周期(s)
+#define IOT_UPLINK_CONFIRM					0X01 //上行标志：请求网关确认，同网关PEER_UPLINK_CONFIRM
+
 typedef struct {
 	uint8_t gas_gauge_flag;
 	uint8_t gas_gauge;
-
+	uint8_t batch_ready; //批量缓存待上行
+	uint32_t batch_period; //批量上报周期(s)
+	
+	uint8_t event_alarm; //绝对阈值模式各轴告警位图
+	uint8_t event_confirm; //事件上报，请求网关确认
+	float event_ref[2]; //相对阈值模式XY轴参考值(上次上报的角度)
+	uint32_t report_time; //阈值模式上次上报时间戳
+	uint32_t heartbeat; //阈值模式心跳上报周期(s)
+	uint32_t event_nums; //事件上报次数
+	uint32_t heartbeat_nums; //心跳上报次数
+	
 	iot_object_t *sensor;
 	Inclinometer_Info_t *inclinometer_info;
-
+	
 	void (*operate)(void);
 } IoT_dev_t;
 
+void IoT_BatchPush(void);
+IoT_dev_t* IoT_GetHandle(void);
 IoT_dev_t * IoT_Init(iot_object_t *sensor, 
 					 Inclinometer_Info_t *inclinometer_handle);
 
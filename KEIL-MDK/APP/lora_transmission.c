@@ -1,7 +1,13 @@
-#include "lora_transmission.h"
-#include "wireless_comm_services.h"
 #include "nrf_drv_spi.h"
 #include "nrf_drv_gpiote.h"
+#include "nrf_drv_timer.h" //须在lora_transmission.h之前，避免MODE宏与TIMER寄存器名冲突
+#include "nrf_drv_ppi.h"
+#include "nrf_spim.h"
+#include "nrf_spi.h"
+#include "nrf_egu.h"
+#include "nrf_delay.h"
+#include "lora_transmission.h"
+#include "wireless_comm_services.h"
 #include "sw_timer_rtc.h"
 #include "rng_lpm.h"
 #include "light.h"
@@ -11,6 +17,11 @@
 #include "sys_param.h"
 #include "uart_svc.h"
 #include "calendar.h"
+#include "flash.h"
+#include "mono_clock.h"
+#include "app_util_platform.h"
+#include "sample_batch.h"
+#include "iot_operate.h"
 
 
 typedef enum {
@@ -26,26 +37,194 @@ static Lora_Info_t Lora_Info;
 static Lora_ConnStatus LoraConnStatus = LORA_OFFLINE;
 static Lora_ConnStatus LoraPreConnStatus = LORA_OFFLINE;
 
-/* SPIʵID,IDŶӦ0:SPI0  1:SPI1 2:SPI2 */
+/* SPI驱动程序实例ID,ID和外设编号对应，0:SPI0  1:SPI1 2:SPI2 */
 #define SPI_INSTANCE  0 
-/* ΪspiSPIʵ */
+/* 定义名称为spi的SPI驱动程序实例 */
 static const nrf_drv_spi_t spi = NRF_DRV_SPI_INSTANCE(SPI_INSTANCE); 
-/* SPIɱ־ */
+/* SPI传输完成标志 */
 static volatile bool spi_xfer_done; 
 static radio_drv_funcs_t wireless_drv;
 
 __weak void LORA_TaskStopHandler(void* param);
 void LORA_TxCompleteCallback(uint8_t* pData, uint16_t size);
 
+/* DIO1上升沿经GPIOTE->PPI触发定时器捕获，边沿时刻不受中断响应延时影响 */
+static const nrf_drv_timer_t lora_capture_timer = NRF_DRV_TIMER_INSTANCE(LORA_CAPTURE_TIMER_INSTANCE);
+static nrf_ppi_channel_t lora_capture_ppi;
+static uint8_t lora_capture_init = 0;
+static volatile uint64_t lora_irq_ticks = 0; //最近一次DIO1边沿时刻，单调时钟计数值
+static volatile uint32_t lora_irq_us = 0; //最近一次DIO1边沿时刻，捕获定时器微秒计数值
+
+/* DIO1上升沿经PPI启动SPIM长度为0的传输(nRF52832勘误109：CPU休眠时PPI启动的EasyDMA首次访问可能出错)，
+   STARTED经EGU中断唤醒CPU，由中断设置长度并依次启动两条命令，EasyDMA读出中断状态与接收缓冲区状态；
+   SPIM0的中断向量由SPI驱动占用，故经EGU转发。定时器在两次传输结束后唤醒CPU处理接收 */
+#define LORA_PREFETCH_SPIM						NRF_SPIM0 //与SPI_INSTANCE同一外设，预读期间切换为SPIM模式
+#define LORA_PREFETCH_EGU						NRF_EGU3 //EGU0由app_timer使用，EGU1/2/4/5由协议栈使用
+#define LORA_PREFETCH_EGU_IRQn					SWI3_EGU3_IRQn
+#define LORA_PREFETCH_EGU_IRQHandler			SWI3_EGU3_IRQHandler
+#define LORA_PREFETCH_EGU_IRQ_PRIORITY			APP_IRQ_PRIORITY_HIGH //高于预读定时器中断，完成处理前传输已结束
+static const nrf_drv_timer_t lora_prefetch_timer = NRF_DRV_TIMER_INSTANCE(LORA_PREFETCH_TIMER_INSTANCE);
+static nrf_ppi_channel_t lora_prefetch_ppi[4];
+static nrf_ppi_channel_group_t lora_prefetch_group;
+static nrf_gpiote_events_t lora_irq_event; //DIO1的GPIOTE输入事件
+static uint32_t lora_irq_int_mask; //DIO1的GPIOTE中断使能位
+static uint8_t lora_prefetch_init = 0;
+static volatile uint8_t lora_prefetch_armed = 0;
+static volatile uint8_t lora_prefetch_valid = 0;
+static volatile uint8_t lora_prefetch_xfer_ok = 0; //两条命令均已传输结束
+static uint8_t lora_prefetch_tx[2][4] = {{SX126X_CMD_GET_IRQ_STATUS, 0XFF, 0XFF, 0XFF}, 
+										 {SX126X_CMD_GET_RX_BUFFER_STATUS, 0XFF, 0XFF, 0XFF}};
+static uint8_t lora_prefetch_rx[2][4]; //[0]:状态,中断高字节,中断低字节 [1]:状态,负载长度,缓冲区起始地址
+
+/* 最近一次DIO1中断时刻，接收完成后即为帧接收时刻 */
+uint64_t LORA_IrqTicks(void)
+{
+	uint64_t ticks;
+	
+	CRITICAL_REGION_ENTER();
+	ticks = lora_irq_ticks;
+	CRITICAL_REGION_EXIT();
+	
+	return ticks;
+}
+
+/* 最近一次DIO1边沿时刻，1us分辨率，约71分钟回绕，用于测量空中时间等时间差 */
+uint32_t LORA_IrqTimeUs(void)
+{
+	return lora_irq_us;
+}
+
+/* 射频模块状态机：除接收监听外的状态均计入不在接收的时间 */
+static volatile Lora_RadioState LoraRadioState = LORA_RADIO_OFF;
+static uint8_t lora_cfg_override = 0; //链路扫描临时参数生效
+static Lora_RadioCfg_t lora_cfg;
+static volatile uint8_t lora_radio_fault = 0;
+static uint64_t lora_rx_leave_ticks = 0; //离开接收监听时刻
+static uint64_t lora_deaf_ticks = 0; //累计不在接收监听的时间
+static Lora_RadioStat_t Lora_RadioStat;
+
+static void LORA_RadioStateUpdate(Lora_RadioState state, uint64_t ticks)
+{
+	if(LoraRadioState != LORA_RADIO_RX && LoraRadioState != LORA_RADIO_OFF)
+	{
+		lora_deaf_ticks += ticks - lora_rx_leave_ticks;
+	}
+	
+	if(state != LORA_RADIO_RX && state != LORA_RADIO_OFF)
+	{
+		lora_rx_leave_ticks = ticks;
+	}
+	LoraRadioState = state;
+}
+
+void LORA_RadioSetState(Lora_RadioState state)
+{
+	uint64_t now = Mono_ClockGetTicks();
+	
+	CRITICAL_REGION_ENTER();
+	LORA_RadioStateUpdate(state, now);
+	CRITICAL_REGION_EXIT();
+}
+
+/* BUSY或DIO1等待超时时由驱动调用，巡检时复位恢复 */
+void LORA_RadioFault(uint8_t fault)
+{
+	lora_radio_fault |= fault;
+}
+
+uint8_t LORA_RadioFaulted(void)
+{
+	return lora_radio_fault;
+}
+
+Lora_RadioStat_t* LORA_RadioStatGet(void)
+{
+	uint64_t now = Mono_ClockGetTicks();
+	uint64_t deaf;
+	
+	CRITICAL_REGION_ENTER();
+	deaf = lora_deaf_ticks;
+	if(LoraRadioState != LORA_RADIO_RX && LoraRadioState != LORA_RADIO_OFF)
+	{
+		deaf += now - lora_rx_leave_ticks;
+	}
+	CRITICAL_REGION_EXIT();
+	
+	Lora_RadioStat.deaf_ms = (uint32_t)MONO_CLOCK_TICKS_TO_MS(deaf);
+	return &Lora_RadioStat;
+}
+
+/* 进入接收监听，所有退出接收的路径最终都经由此处返回接收 */
+static void LORA_RxRearm(void)
+{
+	extern void _ClearIrqStatus(uint16_t irq);
+	
+	LORA_RadioSetState(LORA_RADIO_RX);
+	_ClearIrqStatus(SX126X_IRQ_ALL & ~SX126X_IRQ_RX_DONE); //未处理的超时等标志会使DIO1保持高电平，不再产生上升沿
+	wireless_drv.radio_Rxmode();
+}
+
+/* 由中断响应延时回推边沿时刻 */
+static void LORA_IrqStamp(void)
+{
+	uint32_t now = nrf_drv_timer_capture(&lora_capture_timer, NRF_TIMER_CC_CHANNEL1);
+	uint32_t edge = nrf_drv_timer_capture_get(&lora_capture_timer, NRF_TIMER_CC_CHANNEL0);
+	lora_irq_us = edge;
+	lora_irq_ticks = Mono_ClockGetTicks() - MONO_CLOCK_US_TO_TICKS(now - edge);
+}
+
 static void gpiote_in_pin_handler(nrf_drv_gpiote_pin_t pin, nrf_gpiote_polarity_t action)
 {
 	if(pin == LORA_IRQ_PIN)
 	{
 		if(action == NRF_GPIOTE_POLARITY_LOTOHI)
 		{
-			//LORA
-			LORA_TxCompleteCallback(NULL, NULL);
+			LORA_IrqStamp();
+			
+			//接收LORA数据
+			LORA_TxCompleteCallback(NULL, 0);
+		}
+	}
+}
+
+static void lora_capture_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+}
+
+static void LORA_CaptureConfig(void)
+{
+	uint32_t err_code;
+	
+	if(lora_capture_init == 0)
+	{
+		nrf_drv_timer_config_t timer_cfg = NRF_DRV_TIMER_DEFAULT_CONFIG;
+		timer_cfg.frequency = NRF_TIMER_FREQ_1MHz;
+		timer_cfg.bit_width = NRF_TIMER_BIT_WIDTH_32;
+		err_code = nrf_drv_timer_init(&lora_capture_timer, &timer_cfg, lora_capture_timer_handler);
+		APP_ERROR_CHECK(err_code);
+		
+		err_code = nrf_drv_ppi_init();
+		if(err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED)
+		{
+			APP_ERROR_CHECK(err_code);
 		}
+		
+		err_code = nrf_drv_ppi_channel_alloc(&lora_capture_ppi);
+		APP_ERROR_CHECK(err_code);
+		lora_capture_init = 1;
+	}
+	
+	err_code = nrf_drv_ppi_channel_assign(lora_capture_ppi,
+										  nrf_drv_gpiote_in_event_addr_get(LORA_IRQ_PIN),
+										  nrf_drv_timer_capture_task_address_get(&lora_capture_timer, NRF_TIMER_CC_CHANNEL0));
+	APP_ERROR_CHECK(err_code);
+	
+	err_code = nrf_drv_ppi_channel_enable(lora_capture_ppi);
+	APP_ERROR_CHECK(err_code);
+	
+	if(!nrf_drv_timer_is_enabled(&lora_capture_timer))
+	{
+		nrf_drv_timer_enable(&lora_capture_timer);
 	}
 }
 
@@ -69,12 +248,266 @@ static void LORA_ExtIntConfig(void)
 												 &gpiote_in_pin_handler);
 	
 	nrf_drv_gpiote_in_event_enable(LORA_IRQ_PIN, true);
+	LORA_CaptureConfig();
+}
+
+/* 预读结束或撤销后，外设交还SPI驱动，片选交还GPIO，恢复DIO1中断 */
+static void LORA_PrefetchRestore(void)
+{
+	nrf_drv_ppi_group_disable(lora_prefetch_group);
+	nrf_spim_disable(LORA_PREFETCH_SPIM);
+	nrf_spi_enable((NRF_SPI_Type *)LORA_PREFETCH_SPIM);
+	nrf_drv_gpiote_out_task_disable(LORA_SPI_CS_PIN);
+	nrf_drv_timer_clear(&lora_prefetch_timer);
+	lora_prefetch_armed = 0;
+}
+
+static void lora_prefetch_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+	/* 撤防时已收尾的预读不再重复处理 */
+	if(event_type == NRF_TIMER_EVENT_COMPARE2 && lora_prefetch_armed == 1)
+	{
+		lora_prefetch_valid = lora_prefetch_xfer_ok;
+		LORA_PrefetchRestore();
+		nrf_gpiote_event_clear(lora_irq_event);
+		nrf_gpiote_int_enable(lora_irq_int_mask);
+		LORA_IrqStamp();
+		
+		//接收LORA数据
+		LORA_TxCompleteCallback(NULL, 0);
+	}
+}
+
+/* 传输一条预读命令，先等待上一次传输的结束事件(经ch2拉高片选)，返回是否传输结束 */
+static uint8_t LORA_PrefetchXfer(uint8_t index)
+{
+	uint32_t i;
+	
+	for(i = 0; i < LORA_PREFETCH_XFER_MAX_US && !nrf_spim_event_check(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END); i++)
+	{
+		nrf_delay_us(1);
+	}
+	nrf_spim_event_clear(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END);
+	
+	nrf_spim_tx_buffer_set(LORA_PREFETCH_SPIM, lora_prefetch_tx[index], sizeof(lora_prefetch_tx[index]));
+	nrf_spim_rx_buffer_set(LORA_PREFETCH_SPIM, lora_prefetch_rx[index], sizeof(lora_prefetch_rx[index]));
+	nrf_drv_gpiote_clr_task_trigger(LORA_SPI_CS_PIN);
+	nrf_spim_task_trigger(LORA_PREFETCH_SPIM, NRF_SPIM_TASK_START);
+	
+	for(i = 0; i < LORA_PREFETCH_XFER_MAX_US && !nrf_spim_event_check(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END); i++)
+	{
+		nrf_delay_us(1);
+	}
+	
+	return nrf_spim_event_check(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END);
+}
+
+/* 长度为0的传输已唤醒CPU，CPU运行期间启动实际传输 */
+void LORA_PREFETCH_EGU_IRQHandler(void)
+{
+	uint8_t ok;
+	
+	if(!nrf_egu_event_check(LORA_PREFETCH_EGU, NRF_EGU_EVENT_TRIGGERED0))
+	{
+		return;
+	}
+	nrf_egu_event_clear(LORA_PREFETCH_EGU, NRF_EGU_EVENT_TRIGGERED0);
+	
+	if(lora_prefetch_armed == 0)
+	{
+		return;
+	}
+	nrf_ppi_channel_disable(lora_prefetch_ppi[3]); //实际传输的STARTED不再转发
+	
+	ok = LORA_PrefetchXfer(0);
+	if(ok)
+	{
+		nrf_delay_us(LORA_PREFETCH_GAP_US);
+		ok = LORA_PrefetchXfer(1);
+	}
+	lora_prefetch_xfer_ok = ok;
+}
+
+/* ch0:DIO1->SPIM启动(长度为0) ch1:DIO1->定时器启动 ch2:SPIM结束->片选拉高 
+   ch3:SPIM STARTED->EGU触发，定时器CC2停止并中断 */
+static void LORA_PrefetchConfig(void)
+{
+	uint32_t err_code;
+	uint8_t i;
+	
+	if(lora_prefetch_init == 0)
+	{
+		nrf_drv_timer_config_t timer_cfg = NRF_DRV_TIMER_DEFAULT_CONFIG;
+		timer_cfg.frequency = NRF_TIMER_FREQ_1MHz;
+		timer_cfg.bit_width = NRF_TIMER_BIT_WIDTH_16;
+		err_code = nrf_drv_timer_init(&lora_prefetch_timer, &timer_cfg, lora_prefetch_timer_handler);
+		APP_ERROR_CHECK(err_code);
+		nrf_drv_timer_extended_compare(&lora_prefetch_timer, NRF_TIMER_CC_CHANNEL2, LORA_PREFETCH_DONE_US, 
+									   NRF_TIMER_SHORT_COMPARE2_STOP_MASK | NRF_TIMER_SHORT_COMPARE2_CLEAR_MASK, true);
+		
+		for(i = 0; i < 4; i++)
+		{
+			err_code = nrf_drv_ppi_channel_alloc(&lora_prefetch_ppi[i]);
+			APP_ERROR_CHECK(err_code);
+		}
+		err_code = nrf_drv_ppi_group_alloc(&lora_prefetch_group);
+		APP_ERROR_CHECK(err_code);
+		
+		nrf_egu_int_enable(LORA_PREFETCH_EGU, NRF_EGU_INT_TRIGGERED0);
+		NRFX_IRQ_PRIORITY_SET(LORA_PREFETCH_EGU_IRQn, LORA_PREFETCH_EGU_IRQ_PRIORITY);
+		NRFX_IRQ_ENABLE(LORA_PREFETCH_EGU_IRQn);
+		lora_prefetch_init = 1;
+	}
+	
+	nrf_drv_gpiote_out_config_t out_config = GPIOTE_CONFIG_OUT_TASK_TOGGLE(true);
+	err_code = nrf_drv_gpiote_out_init(LORA_SPI_CS_PIN, &out_config);
+	APP_ERROR_CHECK(err_code);
+	
+	uint32_t irq_event_addr = nrf_drv_gpiote_in_event_addr_get(LORA_IRQ_PIN);
+	lora_irq_event = (nrf_gpiote_events_t)(irq_event_addr - (uint32_t)NRF_GPIOTE);
+	lora_irq_int_mask = NRF_GPIOTE_INT_IN0_MASK << ((lora_irq_event - NRF_GPIOTE_EVENTS_IN_0) / sizeof(uint32_t));
+	
+	uint32_t cs_set = nrf_drv_gpiote_set_task_addr_get(LORA_SPI_CS_PIN);
+	uint32_t spim_start = nrf_spim_task_address_get(LORA_PREFETCH_SPIM, NRF_SPIM_TASK_START);
+	
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(lora_prefetch_ppi[0], irq_event_addr, spim_start));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(lora_prefetch_ppi[1], irq_event_addr, 
+											   nrf_drv_timer_task_address_get(&lora_prefetch_timer, NRF_TIMER_TASK_START)));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(lora_prefetch_ppi[2], 
+											   nrf_spim_event_address_get(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END), cs_set));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(lora_prefetch_ppi[3], 
+											   nrf_spim_event_address_get(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_STARTED),
+											   (uint32_t)nrf_egu_task_trigger_address_get(LORA_PREFETCH_EGU, 0)));
+	
+	for(i = 0; i < 4; i++)
+	{
+		APP_ERROR_CHECK(nrf_drv_ppi_channel_include_in_group(lora_prefetch_ppi[i], lora_prefetch_group));
+	}
+	
+	/* 定时器仅由PPI启动，使能驱动但不计数 */
+	if(!nrf_drv_timer_is_enabled(&lora_prefetch_timer))
+	{
+		nrf_drv_timer_enable(&lora_prefetch_timer);
+		nrf_drv_timer_pause(&lora_prefetch_timer);
+		nrf_drv_timer_clear(&lora_prefetch_timer);
+	}
+}
+
+/* 预读是否已由DIO1启动，ch0与ch1由同一事件触发，以SPIM的STARTED事件判断运行状态 */
+static uint8_t LORA_PrefetchStarted(void)
+{
+	if(!nrf_gpiote_event_is_set(lora_irq_event))
+	{
+		return 0;
+	}
+	
+	nrf_delay_us(1); //PPI触发的START任务在数个时钟周期内产生STARTED事件
+	
+	return nrf_spim_event_check(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_STARTED);
+}
+
+/* 进入接收后布防：预置长度为0的传输(勘误109)，片选交由GPIOTE任务，关闭DIO1中断由预读结束中断代替 */
+void LORA_PrefetchArm(void)
+{
+	if(lora_prefetch_init == 0 || lora_prefetch_armed == 1)
+	{
+		return;
+	}
+	
+	CRITICAL_REGION_ENTER();
+	lora_prefetch_valid = 0;
+	nrf_gpiote_int_disable(lora_irq_int_mask);
+	
+	/* DIO1已触发未处理，由GPIOTE中断按原流程处理 */
+	if(!nrf_gpiote_event_is_set(lora_irq_event))
+	{
+		nrf_drv_timer_clear(&lora_prefetch_timer);
+		nrf_timer_event_clear(lora_prefetch_timer.p_reg, NRF_TIMER_EVENT_COMPARE2);
+		nrf_spi_disable((NRF_SPI_Type *)LORA_PREFETCH_SPIM);
+		nrf_spim_tx_buffer_set(LORA_PREFETCH_SPIM, lora_prefetch_tx[0], 0);
+		nrf_spim_rx_buffer_set(LORA_PREFETCH_SPIM, lora_prefetch_rx[0], 0);
+		nrf_spim_tx_list_disable(LORA_PREFETCH_SPIM);
+		nrf_spim_rx_list_disable(LORA_PREFETCH_SPIM);
+		nrf_spim_event_clear(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_END);
+		nrf_egu_event_clear(LORA_PREFETCH_EGU, NRF_EGU_EVENT_TRIGGERED0);
+		lora_prefetch_xfer_ok = 0;
+		nrf_spim_event_clear(LORA_PREFETCH_SPIM, NRF_SPIM_EVENT_STARTED);
+		nrf_spim_enable(LORA_PREFETCH_SPIM);
+		nrf_drv_gpiote_out_task_enable(LORA_SPI_CS_PIN);
+		nrf_drv_ppi_group_enable(lora_prefetch_group);
+		lora_prefetch_armed = 1;
+		
+		/* 布防过程中DIO1已上升且未启动预读，撤销 */
+		if(nrf_gpiote_event_is_set(lora_irq_event) && !LORA_PrefetchStarted())
+		{
+			LORA_PrefetchRestore();
+		}
+	}
+	
+	if(lora_prefetch_armed == 0)
+	{
+		nrf_gpiote_int_enable(lora_irq_int_mask);
+	}
+	CRITICAL_REGION_EXIT();
+}
+
+/* CPU访问SPI前撤防，预读已启动则等待其完成 */
+static void LORA_PrefetchDisarm(void)
+{
+	uint32_t wait_us = 0;
+	
+	CRITICAL_REGION_ENTER();
+	if(lora_prefetch_armed == 1)
+	{
+		/* 同时关闭ch0与ch1，DIO1要么已同时启动SPIM与定时器，要么均未启动 */
+		nrf_ppi_channels_disable((1UL << lora_prefetch_ppi[0]) | (1UL << lora_prefetch_ppi[1]));
+		if(!LORA_PrefetchStarted())
+		{
+			LORA_PrefetchRestore();
+			nrf_gpiote_int_enable(lora_irq_int_mask);
+		}
+	}
+	CRITICAL_REGION_EXIT();
+	
+	/* 当前上下文优先级不低于定时器中断时中断无法执行，只按硬件完成事件等待 */
+	while(lora_prefetch_armed == 1 && wait_us < LORA_PREFETCH_WAIT_US &&
+		  !nrf_timer_event_check(lora_prefetch_timer.p_reg, NRF_TIMER_EVENT_COMPARE2))
+	{
+		nrf_delay_us(1);
+		wait_us++;
+	}
+	
+	/* 定时器中断未及处理，在此收尾，DIO1事件保留由GPIOTE中断按原流程处理 */
+	CRITICAL_REGION_ENTER();
+	if(lora_prefetch_armed == 1)
+	{
+		lora_prefetch_valid = lora_prefetch_xfer_ok;
+		LORA_PrefetchRestore();
+		nrf_gpiote_int_enable(lora_irq_int_mask);
+	}
+	CRITICAL_REGION_EXIT();
 }
 
-//SPI¼
+/* 取出预读的中断状态与接收缓冲区状态，每次DIO1中断只能取一次，无效时返回0 */
+uint8_t LORA_PrefetchGet(uint16_t* irq, uint8_t* payload_len, uint8_t* buf_pointer)
+{
+	if(lora_prefetch_valid == 0)
+	{
+		return 0;
+	}
+	
+	lora_prefetch_valid = 0;
+	*irq = ((uint16_t)lora_prefetch_rx[0][2] << 8) | lora_prefetch_rx[0][3];
+	*payload_len = lora_prefetch_rx[1][2];
+	*buf_pointer = lora_prefetch_rx[1][3];
+	
+	return 1;
+}
+
+//SPI事件处理函数
 static void spi_event_handler(nrf_drv_spi_evt_t const * p_event, void * p_context)
 {
-  //SPI  
+  //设置SPI传输完成  
 	spi_xfer_done = true;
 }
 
@@ -102,6 +535,11 @@ static void LORA_SPI_ConfigDefault(void)
 
 void LORA_SPI_Transfer(uint8_t* tx_buffer, uint8_t tx_length, uint8_t* rx_buffer, uint8_t rx_length)
 {
+	if(lora_prefetch_armed == 1)
+	{
+		LORA_PrefetchDisarm();
+	}
+	
 	spi_xfer_done = false;
 	LORA_SPI_CS_ENABLE();
 	APP_ERROR_CHECK(nrf_drv_spi_transfer(&spi, tx_buffer, tx_length, rx_buffer, rx_length));
@@ -110,6 +548,7 @@ void LORA_SPI_Transfer(uint8_t* tx_buffer, uint8_t tx_length, uint8_t* rx_buffer
 
 static void LORA_RADIO_Init(void)
 {
+	lora_cfg_override = 0; //重新按系统参数配置
 	wireless_drv = radio_sx1262_lora_init();
 	wireless_drv.radio_reset();
 	wireless_drv.radio_init();
@@ -158,14 +597,26 @@ void LORA_Config(void)
 	LORA_RESET_DISABLE();
 	LORA_ExtIntConfig();
 	LORA_SPI_Config();
+	LORA_PrefetchConfig();
 	LORA_RADIO_Init();
 	nrf_delay_us(100);
 }
 	
 void LORA_ConfigDefault(void)
 {
+	if(lora_capture_init == 1)
+	{
+		nrf_drv_ppi_channel_disable(lora_capture_ppi);
+		nrf_drv_timer_disable(&lora_capture_timer); //停止定时器，释放高速时钟
+	}
+	if(lora_prefetch_init == 1)
+	{
+		LORA_PrefetchDisarm();
+		nrf_drv_gpiote_out_uninit(LORA_SPI_CS_PIN);
+	}
 	nrfx_gpiote_in_event_disable(LORA_IRQ_PIN);
 	nrfx_gpiote_in_uninit(LORA_IRQ_PIN);
+	LORA_RadioSetState(LORA_RADIO_OFF);
 	LORA_SPI_ConfigDefault();
 	nrf_gpio_cfg_default(LORA_POWER_PIN);
 	nrf_gpio_cfg_default(LORA_TRANSMIT_PIN);
@@ -209,12 +660,12 @@ static void LORA_IdleLowPowerManage(void)
 		return;
 	}
 	
-	Lora_Info.LPMHandle->TaskSetStatus(LORA_TASK_ID, LPM_TASK_STA_LP);  /* ͹״̬ */
+	Lora_Info.LPMHandle->TaskSetStatus(LORA_TASK_ID, LPM_TASK_STA_LP);  /* 设置任务低功耗状态 */
 }
 
 void SWT_LoraTaskTimeSliceCallback(void)
 {
-	if(LoraState!=LORA_TIMEOUT && LORA_TIMEOUT!=LORA_STOP)
+	if(LoraState!=LORA_TIMEOUT && LoraState!=LORA_STOP)
 	{
 		LoraState = LORA_TIMEOUT;
 	}
@@ -222,7 +673,7 @@ void SWT_LoraTaskTimeSliceCallback(void)
 
 void SWT_LoraTxTimeoutCallback(void)
 {
-	if(LoraState!=LORA_TIMEOUT && LORA_TIMEOUT!=LORA_STOP)
+	if(LoraState!=LORA_TIMEOUT && LoraState!=LORA_STOP)
 	{
 		LoraState = LORA_TX_FAIL;
 	}
@@ -230,7 +681,7 @@ void SWT_LoraTxTimeoutCallback(void)
 
 void SWT_LoraIdleCallback(void)
 {
-	if(LoraState!=LORA_TIMEOUT && LORA_TIMEOUT!=LORA_STOP)
+	if(LoraState!=LORA_TIMEOUT && LoraState!=LORA_STOP)
 	{
 		LoraState = LORA_ACTIVE;
 	}
@@ -238,9 +689,21 @@ void SWT_LoraIdleCallback(void)
 
 void LORA_TxCompleteCallback(uint8_t* pData, uint16_t size)
 {
+	/* 发送回复期间DIO1为发送完成中断，由发送流程查询处理 */
+	if(LoraRadioState == LORA_RADIO_TX)
+	{
+		return;
+	}
+	
+	/* 任务停止期间到达的中断同样记录，任务重新启动时处理 */
+	if(LoraRadioState == LORA_RADIO_RX)
+	{
+		LORA_RadioStateUpdate(LORA_RADIO_RX_PEND, lora_irq_ticks);
+	}
+	
 	if(Lora_Info.State == LORA_ACTIVE)
 	{
-		if(LoraState!=LORA_TIMEOUT && LORA_TIMEOUT!=LORA_STOP)
+		if(LoraState!=LORA_TIMEOUT && LoraState!=LORA_STOP)
 		{
 			LoraState = LORA_TX_SUCCESS;
 		}
@@ -287,20 +750,61 @@ static void LORA_FillConnCmdCache(void)
 {
 	LoraTxCount = 0;
 	
-	/* ͷ */
+	/* 命令头 */
 	uint32_t cmdHeader = CMD_CONNECT;
 	memcpy(&LoraTxBuf[LoraTxCount], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
 	LoraTxCount += sizeof(cmdHeader);
 	
-	/* ݶγ */
+	/* 数据段长度 */
 	LoraTxBuf[LoraTxCount] = 8;
 	LoraTxCount += 1;
 	
-	/* ݶβ㳤ַ */
+	/* 数据段测点长地址 */
+	wireless_comm_services_t* wirelessCommSvc = Wireless_CommSvcGetHandle();
+	wirelessCommSvc->_sensor->readPropToBuf(1, &LoraTxBuf[LoraTxCount]);
+	LoraTxCount += 8;
+	
+	/* CRC16 */
+	uint16_t crc16 = wirelessCommSvc->modbusRtuCRC(LoraTxBuf, LoraTxCount);
+	memcpy(&LoraTxBuf[LoraTxCount], (uint8_t*)&crc16, sizeof(crc16));
+	LoraTxCount += sizeof(crc16);
+}
+
+/* 批量采样数据帧：命令头+长度+长地址8+属性个数(0)+基准采样+批量段，缓存中放不下的采样留到下一帧 */
+static void LORA_FillBatchCmdCache(uint8_t flags)
+{
+	static uint16_t publish_fcnt = 0;
+	extern sx1262_drive_t* lora_obj_get(void);
 	wireless_comm_services_t* wirelessCommSvc = Wireless_CommSvcGetHandle();
+	uint8_t battery = 0;
+	uint8_t len;
+	
+	LoraTxCount = 0;
+	
+	/* 命令头，网络字节序 */
+	LoraTxBuf[LoraTxCount++] = (CMD_PUBLISH >> 24) & 0XFF;
+	LoraTxBuf[LoraTxCount++] = (CMD_PUBLISH >> 16) & 0XFF;
+	LoraTxBuf[LoraTxCount++] = (CMD_PUBLISH >> 8) & 0XFF;
+	LoraTxBuf[LoraTxCount++] = CMD_PUBLISH & 0XFF;
+	
+	/* 数据段长度，填写数据段后更新 */
+	LoraTxCount += 1;
+	
+	/* 数据段测点长地址 */
 	wirelessCommSvc->_sensor->readPropToBuf(1, &LoraTxBuf[LoraTxCount]);
 	LoraTxCount += 8;
 	
+	/* 数据段属性个数 */
+	LoraTxBuf[LoraTxCount] = 0;
+	LoraTxCount += 1;
+	
+	/* 数据段基准采样与批量段 */
+	wirelessCommSvc->_sensor->readPropToBuf(5, &battery); //电量
+	len = SampleBatch_GetHandle()->Pack(&LoraTxBuf[LoraTxCount], LoraMTU - LoraTxCount - 2, battery, 
+										lora_obj_get()->radio_state.rssi, publish_fcnt++, flags);
+	LoraTxCount += len;
+	LoraTxBuf[DATA_LEN_BYTE_ID] = LoraTxCount - DATA_LEN_BYTE_ID - 1;
+	
 	/* CRC16 */
 	uint16_t crc16 = wirelessCommSvc->modbusRtuCRC(LoraTxBuf, LoraTxCount);
 	memcpy(&LoraTxBuf[LoraTxCount], (uint8_t*)&crc16, sizeof(crc16));
@@ -309,23 +813,34 @@ static void LORA_FillConnCmdCache(void)
 
 static void LORA_FillPublishCmdCache(void)
 {
+	IoT_dev_t* iot = IoT_GetHandle();
+	
+	/* 达到上报周期或阈值事件时发送批量采样数据帧，未发完的采样等下一次上报或缓存满时发送；事件帧请求确认 */
+	if(iot->batch_ready == 1 && SampleBatch_GetHandle()->count > 0)
+	{
+		LORA_FillBatchCmdCache(iot->event_confirm ? IOT_UPLINK_CONFIRM : 0);
+		iot->batch_ready = 0;
+		iot->event_confirm = 0;
+		return;
+	}
+	
 	LoraTxCount = 0;
 	
-	/* ͷ */
+	/* 命令头 */
 	uint32_t cmdHeader = CMD_PUBLISH;
 	memcpy(&LoraTxBuf[LoraTxCount], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
 	LoraTxCount += sizeof(cmdHeader);
 	
-	/* ݶγ */
+	/* 数据段长度 */
 	LoraTxBuf[LoraTxCount] = 8;
 	LoraTxCount += 1;
 	
-	/* ݶβ̵ַ */
+	/* 数据段测点短地址 */
 	wireless_comm_services_t* wirelessCommSvc = Wireless_CommSvcGetHandle();
 	wirelessCommSvc->_sensor->readPropToBuf(2, &LoraTxBuf[LoraTxCount]);
 	LoraTxCount += 2;	
 	
-	/* ݶ */
+	/* 数据段属性数据 */
 	wirelessCommSvc->_sensor->readPropToBuf(3, &LoraTxBuf[LoraTxCount]);
 	LoraTxCount += 8;
 	
@@ -343,7 +858,7 @@ static FlagStatus Radio_CADDetect(void)
 #include "host_net_swap.h"
 #define COMM_TRANSMISSION_MSB		1
 #if COMM_TRANSMISSION_MSB == 1 && COMM_TRAMSMISSION_LSB == 1
-#error "ͨŴֻֽܶһ"
+#error "通信传输字节序只能定义一种"
 #endif
 #define COMM_TRAMSMISSION_LSB		0
 
@@ -355,14 +870,14 @@ lora_reply_data_t lora_reply_data = {
 	.gateway_addr = SYS_PARAM_DEV_GATEWAY_ADDR,
 };
 
-//ǲʱظĬϲ
+//倾角测点连接时回复的默认参数
 lora_reply_data_t lora_reply_init_data = {
 	.status = PERIOD | TIME_STAMP | TIME_OFFSET,
 	.period = 10,
 	.time_offset = 0,
 };
 
-//Ƶùϵ
+//传感器频率设置关系
 //0->0.78HZ
 //1->1.56HZ
 //2->3.12HZ
@@ -372,7 +887,7 @@ lora_reply_data_t lora_reply_init_data = {
 //6->50HZ
 //7->100HZ
 //8->200HZ
-//ʱظĬϲ
+//崩塌测点连接时回复的默认参数
 lora_reply_data_t lora_c_reply_init_data = {
 	.status = MODE | PERIOD | INTERVAL | TIME_STAMP | SENSOR_FREQ | TIME_OFFSET | DATA_POINTS | ACCEL_SLOPE,
 	.period = 3600 * 12,
@@ -388,7 +903,7 @@ void Lora_ConnReply(void)
 {
 	LoraReplySize = 0;
 	
-	/* ͷ */
+	/* 命令头 */
 	uint32_t cmdHeader = 0x02;
 #if COMM_TRANSMISSION_MSB == 1
 	cmdHeader = swap_htonl(cmdHeader);
@@ -396,18 +911,39 @@ void Lora_ConnReply(void)
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
 	LoraReplySize += sizeof(cmdHeader);
 	
-	/* ݶγ */
+	/* 数据段长度 */
+	uint8_t lenIndex = LoraReplySize;
 	LoraReplyBuf[LoraReplySize] = 16;
 	LoraReplySize += 1;
 	
-	/* ݶβ㳤ַ */
+	/* 数据段测点长地址 */
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.long_addr, sizeof(lora_reply_data.long_addr));
 	LoraReplySize += sizeof(lora_reply_data.long_addr);
 	
-	/* ݶسַ */
+	/* 数据段网关长地址 */
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.gateway_addr, sizeof(lora_reply_data.gateway_addr));
 	LoraReplySize += sizeof(lora_reply_data.gateway_addr);
 	
+	/* 数据段短地址(长地址末2字节)与组序号，组确认开启时下发，新测点取下一个测点序号，测点表已满时下发未分配 */
+	extern ctrl_class_t ctrl_class;
+	if(ctrl_class.dev_ctrl & 0X08)
+	{
+		extern peer_data_t peer_data;
+		int i;
+		for(i = 0; i < peer_data.current_conn_nums; i++)
+		{
+			if(memcmp(peer_data.peer_attr[i].long_addr, lora_reply_data.long_addr, 8) == 0)
+			{
+				break;
+			}
+		}
+		memcpy(&LoraReplyBuf[LoraReplySize], &lora_reply_data.long_addr[6], 2);
+		LoraReplySize += 2;
+		LoraReplyBuf[LoraReplySize] = (i < GATEWAY_CAP_SIZE) ? i : GROUP_INDEX_NONE;
+		LoraReplySize += 1;
+		LoraReplyBuf[lenIndex] = 19;
+	}
+	
 	if(lora_reply_data.status & GATEWAY_ADDR)
 	{
 		lora_reply_data.status &= ~GATEWAY_ADDR;
@@ -422,25 +958,26 @@ void Lora_ConnReply(void)
 	LORA_TRANSMIT_ENABLE();
 	LORA_RECEIVE_DISABLE();
 	
+	LORA_RadioSetState(LORA_RADIO_TX);
 	LIGHT_2_ON();
 	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
 	{
 		extern ctrl_class_t ctrl_class;
 		if(ctrl_class.print_ctrl & 0X04)
 		{
-			printf("ظʧ!\n");
+			printf("回复失败!\n");
 		}
 	}
 	LIGHT_2_OFF();
 	
 	LORA_TRANSMIT_DISABLE();
 	LORA_RECEIVE_ENABLE();
-	wireless_drv.radio_Rxmode();
+	LORA_RxRearm();
 	
 	extern ctrl_class_t ctrl_class;
 	if(ctrl_class.print_ctrl & 0X04)
 	{
-		printf("ظ:");
+		printf("回复数据:");
 		for(int i=0; i<LoraReplySize; i++)
 		{
 			printf("0x%02x ", LoraReplyBuf[i]);
@@ -450,57 +987,158 @@ void Lora_ConnReply(void)
 }
 
 extern uint8_t device_long_addr[8];
-void Lora_DataReply(void)
+
+//目标值与测点已确认值相同的参数跳过，其余更新目标值并置为待下发
+#define PEER_CFG_UPDATE(bit, field) \
+	do \
+	{ \
+		if((p_set->status & (bit)) && !((cfg->known & (bit)) && cfg->field == p_set->field)) \
+		{ \
+			if(cfg->field != p_set->field) \
+			{ \
+				cfg->field = p_set->field; \
+				cfg->sent &= ~(bit); /* 已下发的旧值确认后不代表新值 */ \
+			} \
+			cfg->known &= ~(bit); \
+			cfg->pending |= (bit); \
+		} \
+	}while(0)
+
+/* 主机设置测点参数，只记录与测点已确认值不同的参数，返回是否有待下发参数 */
+uint8_t Lora_PeerCfgSet(peer_attr_t* peer, lora_reply_data_t* p_set)
 {
-	LoraReplySize = 0;
-	
-	/* ͷ */
-	uint32_t cmdHeader = 0x04;
-#if COMM_TRANSMISSION_MSB == 1
-	cmdHeader = swap_htonl(cmdHeader);
-#endif
-	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
-	LoraReplySize += sizeof(cmdHeader);
-	
-	uint8_t replySize = 0;
-	uint8_t lenIndex;
-	LoraReplyBuf[LoraReplySize] = replySize;
-	lenIndex = LoraReplySize;
-	LoraReplySize += 1;	
+	peer_cfg_t* cfg = &peer->cfg;
+	
+	PEER_CFG_UPDATE(MODE, mode);
+	PEER_CFG_UPDATE(PERIOD, period);
+	PEER_CFG_UPDATE(INTERVAL, interval);
+	PEER_CFG_UPDATE(X_THRES, x_thres);
+	PEER_CFG_UPDATE(Y_THRES, y_thres);
+	PEER_CFG_UPDATE(Z_THRES, z_thres);
+	PEER_CFG_UPDATE(SENSOR_FREQ, sensor_freq);
+	PEER_CFG_UPDATE(ACCEL_SLOPE, accel_slope);
+	PEER_CFG_UPDATE(DATA_POINTS, data_points);
+	
+	//长地址、时间戳与时间偏移每次设置都下发
+	if(p_set->status & TIME_OFFSET)
+	{
+		cfg->time_offset = p_set->time_offset;
+	}
+	cfg->pending |= p_set->status & (LONG_ADDR | TIME_STAMP | TIME_OFFSET);
 	
-	/* ݶβ㳤ַ */
-	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&device_long_addr, sizeof(device_long_addr));
-	LoraReplySize += sizeof(device_long_addr);	
+	return cfg->pending != 0;
+}
+
+/* 从待下发参数中取出本次回复的参数，超过PEER_CFG_REPLY_MAX_ATTRS个的留到下次回复 */
+static void Lora_PeerCfgReply(peer_attr_t* peer, lora_reply_data_t* lora_reply)
+{
+	peer_cfg_t* cfg = &peer->cfg;
+	uint16_t status = 0;
+	uint8_t nums = 0;
 	
-	uint8_t attr_num = 0;
-	uint8_t attr_index = 0;
-	uint8_t attr_id[255];
-	uint8_t attr_value_index = 0;
-	uint8_t addr_value[255];
+	for(uint16_t bit = 1; bit != 0 && nums < PEER_CFG_REPLY_MAX_ATTRS; bit <<= 1)
+	{
+		if(cfg->pending & bit & ~cfg->sent)
+		{
+			status |= bit;
+			nums++;
+		}
+	}
 	
-	lora_reply_data_t lora_reply = {0};
+	lora_reply->status = status;
+	lora_reply->mode = cfg->mode;
+	lora_reply->period = cfg->period;
+	lora_reply->interval = cfg->interval;
+	lora_reply->time_offset = cfg->time_offset;
+	lora_reply->x_thres = cfg->x_thres;
+	lora_reply->y_thres = cfg->y_thres;
+	lora_reply->z_thres = cfg->z_thres;
+	lora_reply->sensor_freq = cfg->sensor_freq;
+	lora_reply->accel_slope = cfg->accel_slope;
+	lora_reply->data_points = cfg->data_points;
+	
+	cfg->sent |= status;
+}
+
+/* 连接回复的默认参数作为测点的目标值，测点下一帧确认后记为已确认，主机已设置待下发的参数保留 */
+static void Lora_PeerCfgInit(peer_attr_t* peer, lora_reply_data_t* lora_reply)
+{
+	peer_cfg_t* cfg = &peer->cfg;
+	uint16_t status = lora_reply->status & PEER_CFG_TRACK_MASK & ~cfg->pending;
+	
+	if(status & MODE)
+		cfg->mode = lora_reply->mode;
+	if(status & PERIOD)
+		cfg->period = lora_reply->period;
+	if(status & INTERVAL)
+		cfg->interval = lora_reply->interval;
+	if(status & X_THRES)
+		cfg->x_thres = lora_reply->x_thres;
+	if(status & Y_THRES)
+		cfg->y_thres = lora_reply->y_thres;
+	if(status & Z_THRES)
+		cfg->z_thres = lora_reply->z_thres;
+	if(status & SENSOR_FREQ)
+		cfg->sensor_freq = lora_reply->sensor_freq;
+	if(status & ACCEL_SLOPE)
+		cfg->accel_slope = lora_reply->accel_slope;
+	if(status & DATA_POINTS)
+		cfg->data_points = lora_reply->data_points;
+	
+	cfg->known = 0; //测点重新连接，之前确认的参数可能已恢复默认
+	cfg->sent = status;
+	cfg->retry_nums = 0;
+}
+
+/* 取出数据回复测点待下发的连接/配置参数，需要校时加上时间戳，
+ * 返回回复之后是否仍有待下发数据(只对支持上行标志的测点置位) */
+static uint8_t Lora_DataReplyPeer(lora_reply_data_t* lora_reply, const lora_reply_data_t* init_data)
+{
 	extern peer_data_t peer_data;
 	for(int i = 0; i < peer_data.current_conn_nums; i++)
 	{
-		if(*(uint32_t*)peer_data.peer_attr[i].long_addr == *(uint32_t*)device_long_addr &&
-		   *(uint32_t*)&peer_data.peer_attr[i].long_addr[4]  == *(uint32_t*)&device_long_addr[4])
+		peer_attr_t* peer = &peer_data.peer_attr[i];
+		
+		if(*(uint32_t*)peer->long_addr == *(uint32_t*)device_long_addr &&
+		   *(uint32_t*)&peer->long_addr[4]  == *(uint32_t*)&device_long_addr[4])
 		{
-			if(peer_data.peer_attr[i].init_flag == 1)
+			if(peer->init_flag == 1)
 			{
-				peer_data.peer_attr[i].init_flag = 0;
-				memcpy(&lora_reply, &lora_reply_init_data, sizeof(lora_reply_init_data));
-				lora_reply.time_offset = lora_reply_init_data.time_offset * (i+1);
+				peer->init_flag = 0;
+				memcpy(lora_reply, init_data, sizeof(lora_reply_data_t));
+				lora_reply->time_offset = init_data->time_offset * (i+1);
+				Lora_PeerCfgInit(peer, lora_reply);
 			}
-			else if(peer_data.peer_attr[i].set_flag == 1)
+			else if(peer->set_flag == 1)
 			{
-				peer_data.peer_attr[i].set_flag = 0;
-				memcpy(&lora_reply, &lora_reply_data, sizeof(lora_reply_data));
+				Lora_PeerCfgReply(peer, lora_reply);
+				peer->set_flag = (peer->cfg.pending & ~peer->cfg.sent) != 0;
 			}
-			break;
+			
+			if(peer->reply.time_fix)
+			{
+				peer->reply.time_fix = 0;
+				lora_reply->status |= TIME_STAMP;
+			}
+			
+			peer->reply.pending = peer->reply.flags_valid && (peer->init_flag || peer->set_flag);
+			return peer->reply.pending;
 		}
 	}
 	
-	if(lora_reply.status & LONG_ADDR)
+	return 0;
+}
+
+/* 按倾角测点属性编码写入属性个数+属性号+属性值，返回长度，没有属性返回0 */
+static uint8_t Lora_C8AttrFill(lora_reply_data_t* p_reply, uint8_t* buf)
+{
+	uint8_t attr_num = 0;
+	uint8_t attr_index = 0;
+	uint8_t attr_id[255];
+	uint8_t attr_value_index = 0;
+	uint8_t addr_value[255];
+	
+	if(p_reply->status & LONG_ADDR)
 	{
 //		lora_reply_data.status &= ~LONG_ADDR;
 		attr_num += 1;
@@ -509,7 +1147,7 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(lora_reply_data.long_addr);
 	}
 	
-//	if(lora_reply.status & SHORT_ADDR)
+//	if(p_reply->status & SHORT_ADDR)
 //	{
 ////		lora_reply_data.status &= ~SHORT_ADDR;
 //		attr_num += 1;
@@ -518,21 +1156,21 @@ void Lora_DataReply(void)
 //		attr_value_index += sizeof(lora_reply_data.short_addr);
 //	}
 	
-	if(lora_reply.status & MODE)
+	if(p_reply->status & MODE)
 	{
 //		lora_reply_data.status &= ~MODE;
 		attr_num += 1;
 		attr_id[attr_index++] = 3;
-		memcpy(&addr_value[attr_value_index], (uint8_t*)&lora_reply.mode, sizeof(lora_reply.mode));
-		attr_value_index += sizeof(lora_reply.mode);
+		memcpy(&addr_value[attr_value_index], (uint8_t*)&p_reply->mode, sizeof(p_reply->mode));
+		attr_value_index += sizeof(p_reply->mode);
 	}
 	
-	if(lora_reply.status & PERIOD)
+	if(p_reply->status & PERIOD)
 	{
 //		lora_reply_data.status &= ~PERIOD;
 		attr_num += 1;
 		attr_id[attr_index++] = 4;
-		uint32_t period = lora_reply.period;
+		uint32_t period = p_reply->period;
 #if COMM_TRANSMISSION_MSB == 1
 		period = swap_htonl(period);
 #endif
@@ -540,7 +1178,7 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(period);
 	}
 	
-	if(lora_reply.status & TIME_STAMP)
+	if(p_reply->status & TIME_STAMP)
 	{
 //		lora_reply_data.status &= ~TIME_STAMP;
 		attr_num += 1;
@@ -554,12 +1192,12 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(time_stamp);
 	}
 	
-	if(lora_reply.status & TIME_OFFSET)
+	if(p_reply->status & TIME_OFFSET)
 	{
 //		lora_reply_data.status &= ~TIME_OFFSET;
 		attr_num += 1;
 		attr_id[attr_index++] = 6;
-		uint16_t time_offset = lora_reply.time_offset;
+		uint16_t time_offset = p_reply->time_offset;
 #if COMM_TRANSMISSION_MSB == 1
 		time_offset = swap_htons(time_offset);
 #endif
@@ -567,12 +1205,12 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(time_offset);
 	}
 	
-	if(lora_reply.status & X_THRES)
+	if(p_reply->status & X_THRES)
 	{
 //		lora_reply_data.status &= ~X_THRES;
 		attr_num += 1;
 		attr_id[attr_index++] = 12;
-		float x_thres = lora_reply.x_thres;
+		float x_thres = p_reply->x_thres;
 #if COMM_TRANSMISSION_MSB == 1
 		swap_reverse((uint8_t*)&x_thres, sizeof(x_thres));
 #endif
@@ -580,12 +1218,12 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(x_thres);
 	}
 	
-	if(lora_reply.status & Y_THRES)
+	if(p_reply->status & Y_THRES)
 	{
 //		lora_reply_data.status &= ~Y_THRES;
 		attr_num += 1;
 		attr_id[attr_index++] = 13;
-		float y_thres = lora_reply.y_thres;
+		float y_thres = p_reply->y_thres;
 #if COMM_TRANSMISSION_MSB == 1
 		swap_reverse((uint8_t*)&y_thres, sizeof(y_thres));
 #endif
@@ -593,12 +1231,12 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(y_thres);
 	}
 	
-	if(lora_reply.status & Z_THRES)
+	if(p_reply->status & Z_THRES)
 	{
 //		lora_reply_data.status &= ~Z_THRES;
 		attr_num += 1;
 		attr_id[attr_index++] = 14;
-		float z_thres = lora_reply.z_thres;
+		float z_thres = p_reply->z_thres;
 #if COMM_TRANSMISSION_MSB == 1
 		swap_reverse((uint8_t*)&z_thres, sizeof(z_thres));
 #endif
@@ -606,20 +1244,56 @@ void Lora_DataReply(void)
 		attr_value_index += sizeof(z_thres);
 	}
 	
-	/* ݶγ */
-	replySize = 8;
-	if(attr_num != 0)
+	if(attr_num == 0)
 	{
-		replySize += 1 + attr_index + attr_value_index;
-		LoraReplyBuf[LoraReplySize] = attr_num; //Ը
-		LoraReplySize += 1;	
-		
-		memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&attr_id, attr_index); //ID
-		LoraReplySize += attr_index;
-		
-		memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&addr_value, attr_value_index); //ֵ
-		LoraReplySize += attr_value_index;
+		return 0;
 	}
+	
+	buf[0] = attr_num; //属性个数
+	memcpy(&buf[1], (uint8_t*)&attr_id, attr_index); //属性ID
+	memcpy(&buf[1 + attr_index], (uint8_t*)&addr_value, attr_value_index); //属性值
+	return 1 + attr_index + attr_value_index;
+}
+
+void Lora_DataReply(void)
+{
+	LoraReplySize = 0;
+	
+	/* 命令头 */
+	uint32_t cmdHeader = 0x04;
+#if COMM_TRANSMISSION_MSB == 1
+	cmdHeader = swap_htonl(cmdHeader);
+#endif
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	LoraReplySize += sizeof(cmdHeader);
+	
+	uint8_t replySize = 0;
+	uint8_t lenIndex;
+	LoraReplyBuf[LoraReplySize] = replySize;
+	lenIndex = LoraReplySize;
+	LoraReplySize += 1;	
+	
+	/* 数据段测点长地址 */
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&device_long_addr, sizeof(device_long_addr));
+	LoraReplySize += sizeof(device_long_addr);	
+	
+	lora_reply_data_t lora_reply = {0};
+	if(Lora_DataReplyPeer(&lora_reply, &lora_reply_init_data))
+	{
+		/* 下行待发标志 */
+		cmdHeader = CMD_PUBLISH_RESP | CMD_FLAG_PENDING;
+#if COMM_TRANSMISSION_MSB == 1
+		cmdHeader = swap_htonl(cmdHeader);
+#endif
+		memcpy(LoraReplyBuf, (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	}
+	
+	/* 数据段属性 */
+	uint8_t attrSize = Lora_C8AttrFill(&lora_reply, &LoraReplyBuf[LoraReplySize]);
+	LoraReplySize += attrSize;
+	
+	/* 数据段长度 */
+	replySize = 8 + attrSize;
 	LoraReplyBuf[lenIndex] = replySize;
 	
 	/* CRC16 */
@@ -631,25 +1305,26 @@ void Lora_DataReply(void)
 	LORA_TRANSMIT_ENABLE();
 	LORA_RECEIVE_DISABLE();
 	
+	LORA_RadioSetState(LORA_RADIO_TX);
 	LIGHT_2_ON();
 	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
 	{
 		extern ctrl_class_t ctrl_class;
 		if(ctrl_class.print_ctrl & 0X04)
 		{
-			printf("ظʧ!\n");
+			printf("回复失败!\n");
 		}
 	}
 	LIGHT_2_OFF();
 	
 	LORA_TRANSMIT_DISABLE();
 	LORA_RECEIVE_ENABLE();
-	wireless_drv.radio_Rxmode();	
+	LORA_RxRearm();
 	
 	extern ctrl_class_t ctrl_class;
 	if(ctrl_class.print_ctrl & 0X04)
 	{
-		printf("ظ:");
+		printf("回复数据:");
 		for(int i=0; i<LoraReplySize; i++)
 		{
 			printf("0x%02x ", LoraReplyBuf[i]);
@@ -658,57 +1333,16 @@ void Lora_DataReply(void)
 	}
 }
 
-void Lora_C_DataReply(void)
+/* 按崩塌计测点属性编码写入属性个数+属性号+属性值，返回长度，没有属性返回0 */
+static uint8_t Lora_C9AttrFill(lora_reply_data_t* p_reply, uint8_t* buf)
 {
-	LoraReplySize = 0;
-	
-	/* ͷ */
-	uint32_t cmdHeader = 0x04;
-#if COMM_TRANSMISSION_MSB == 1
-	cmdHeader = swap_htonl(cmdHeader);
-#endif
-	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
-	LoraReplySize += sizeof(cmdHeader);
-	
-	uint8_t replySize = 0;
-	uint8_t lenIndex;
-	LoraReplyBuf[LoraReplySize] = replySize;
-	lenIndex = LoraReplySize;
-	LoraReplySize += 1;	
-	
-	/* ݶβ㳤ַ */
-	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&device_long_addr, sizeof(device_long_addr));
-	LoraReplySize += sizeof(device_long_addr);	
-	
 	uint8_t attr_num = 0;
 	uint8_t attr_index = 0;
 	uint8_t attr_id[255];
 	uint8_t attr_value_index = 0;
 	uint8_t addr_value[255];
 	
-	lora_reply_data_t lora_reply = {0};
-	extern peer_data_t peer_data;
-	for(int i = 0; i < peer_data.current_conn_nums; i++)
-	{
-		if(*(uint32_t*)peer_data.peer_attr[i].long_addr == *(uint32_t*)device_long_addr &&
-		   *(uint32_t*)&peer_data.peer_attr[i].long_addr[4]  == *(uint32_t*)&device_long_addr[4])
-		{
-			if(peer_data.peer_attr[i].init_flag == 1)
-			{
-				peer_data.peer_attr[i].init_flag = 0;
-				memcpy(&lora_reply, &lora_c_reply_init_data, sizeof(lora_c_reply_init_data));
-				lora_reply.time_offset = lora_c_reply_init_data.time_offset * (i+1);
-			}
-			else if(peer_data.peer_attr[i].set_flag == 1)
-			{
-				peer_data.peer_attr[i].set_flag = 0;
-				memcpy(&lora_reply, &lora_reply_data, sizeof(lora_reply_data));
-			}
-			break;
-		}
-	}
-	
-	if(lora_reply.status & LONG_ADDR)
+	if(p_reply->status & LONG_ADDR)
 	{
 //		lora_reply_data.status &= ~LONG_ADDR;
 		attr_num += 1;
@@ -717,7 +1351,7 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(lora_reply_data.long_addr);
 	}
 	
-//	if(lora_reply.status & SHORT_ADDR)
+//	if(p_reply->status & SHORT_ADDR)
 //	{
 ////		lora_reply_data.status &= ~SHORT_ADDR;
 //		attr_num += 1;
@@ -726,21 +1360,21 @@ void Lora_C_DataReply(void)
 //		attr_value_index += sizeof(lora_reply_data.short_addr);
 //	}
 	
-	if(lora_reply.status & MODE)
+	if(p_reply->status & MODE)
 	{
 //		lora_reply_data.status &= ~MODE;
 		attr_num += 1;
 		attr_id[attr_index++] = 3;
-		memcpy(&addr_value[attr_value_index], (uint8_t*)&lora_reply.mode, sizeof(lora_reply.mode));
-		attr_value_index += sizeof(lora_reply.mode);
+		memcpy(&addr_value[attr_value_index], (uint8_t*)&p_reply->mode, sizeof(p_reply->mode));
+		attr_value_index += sizeof(p_reply->mode);
 	}
 
-	if(lora_reply.status & PERIOD)
+	if(p_reply->status & PERIOD)
 	{
 //		lora_reply_data.status &= ~PERIOD;
 		attr_num += 1;
 		attr_id[attr_index++] = 4;
-		uint32_t period = lora_reply.period;
+		uint32_t period = p_reply->period;
 #if COMM_TRANSMISSION_MSB == 1
 		period = swap_htonl(period);
 #endif
@@ -748,12 +1382,12 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(period);
 	}
 
-	if(lora_reply.status & INTERVAL)
+	if(p_reply->status & INTERVAL)
 	{
 //		lora_reply_data.status &= ~INTERVAL;
 		attr_num += 1;
 		attr_id[attr_index++] = 5;
-		uint32_t interval = lora_reply.interval;
+		uint32_t interval = p_reply->interval;
 #if COMM_TRANSMISSION_MSB == 1
 		interval = swap_htonl(interval);
 #endif
@@ -761,16 +1395,16 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(interval);
 	}
 	
-	if(lora_reply.status & SENSOR_FREQ)
+	if(p_reply->status & SENSOR_FREQ)
 	{
 //		lora_reply_data.status &= ~SENSOR_FREQ;
 		attr_num += 1;
 		attr_id[attr_index++] = 6;
-		memcpy(&addr_value[attr_value_index], (uint8_t*)&lora_reply.sensor_freq, sizeof(lora_reply.sensor_freq));
-		attr_value_index += sizeof(lora_reply.sensor_freq);
+		memcpy(&addr_value[attr_value_index], (uint8_t*)&p_reply->sensor_freq, sizeof(p_reply->sensor_freq));
+		attr_value_index += sizeof(p_reply->sensor_freq);
 	}
 	
-	if(lora_reply.status & TIME_STAMP)
+	if(p_reply->status & TIME_STAMP)
 	{
 //		lora_reply_data.status &= ~TIME_STAMP;
 		attr_num += 1;
@@ -784,12 +1418,12 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(time_stamp);
 	}
 	
-	if(lora_reply.status & TIME_OFFSET)
+	if(p_reply->status & TIME_OFFSET)
 	{
 //		lora_reply_data.status &= ~TIME_OFFSET;
 		attr_num += 1;
 		attr_id[attr_index++] = 8;
-		uint16_t time_offset = lora_reply.time_offset;
+		uint16_t time_offset = p_reply->time_offset;
 #if COMM_TRANSMISSION_MSB == 1
 		time_offset = swap_htons(time_offset);
 #endif
@@ -797,12 +1431,12 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(time_offset);
 	}
 	
-	if(lora_reply.status & ACCEL_SLOPE)
+	if(p_reply->status & ACCEL_SLOPE)
 	{
 //		lora_reply_data.status &= ~ACCEL_SLOPE;
 		attr_num += 1;
 		attr_id[attr_index++] = 9;
-		uint16_t accel_slope = lora_reply.accel_slope;
+		uint16_t accel_slope = p_reply->accel_slope;
 #if COMM_TRANSMISSION_MSB == 1
 		swap_reverse((uint8_t*)&accel_slope, sizeof(accel_slope));
 #endif
@@ -810,12 +1444,12 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(accel_slope);
 	}
 	
-	if(lora_reply.status & DATA_POINTS)
+	if(p_reply->status & DATA_POINTS)
 	{
 //		lora_reply_data.status &= ~DATA_POINTS;
 		attr_num += 1;
 		attr_id[attr_index++] = 10;
-		uint16_t data_points = lora_reply.data_points;
+		uint16_t data_points = p_reply->data_points;
 #if COMM_TRANSMISSION_MSB == 1
 		swap_reverse((uint8_t*)&data_points, sizeof(data_points));
 #endif
@@ -823,20 +1457,56 @@ void Lora_C_DataReply(void)
 		attr_value_index += sizeof(data_points);
 	}
 	
-	/* ݶγ */
-	replySize = 8;
-	if(attr_num != 0)
+	if(attr_num == 0)
 	{
-		replySize += 1 + attr_index + attr_value_index;
-		LoraReplyBuf[LoraReplySize] = attr_num; //Ը
-		LoraReplySize += 1;	
-		
-		memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&attr_id, attr_index); //ID
-		LoraReplySize += attr_index;
-		
-		memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&addr_value, attr_value_index); //ֵ
-		LoraReplySize += attr_value_index;
+		return 0;
 	}
+	
+	buf[0] = attr_num; //属性个数
+	memcpy(&buf[1], (uint8_t*)&attr_id, attr_index); //属性ID
+	memcpy(&buf[1 + attr_index], (uint8_t*)&addr_value, attr_value_index); //属性值
+	return 1 + attr_index + attr_value_index;
+}
+
+void Lora_C_DataReply(void)
+{
+	LoraReplySize = 0;
+	
+	/* 命令头 */
+	uint32_t cmdHeader = 0x04;
+#if COMM_TRANSMISSION_MSB == 1
+	cmdHeader = swap_htonl(cmdHeader);
+#endif
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	LoraReplySize += sizeof(cmdHeader);
+	
+	uint8_t replySize = 0;
+	uint8_t lenIndex;
+	LoraReplyBuf[LoraReplySize] = replySize;
+	lenIndex = LoraReplySize;
+	LoraReplySize += 1;	
+	
+	/* 数据段测点长地址 */
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&device_long_addr, sizeof(device_long_addr));
+	LoraReplySize += sizeof(device_long_addr);	
+	
+	lora_reply_data_t lora_reply = {0};
+	if(Lora_DataReplyPeer(&lora_reply, &lora_c_reply_init_data))
+	{
+		/* 下行待发标志 */
+		cmdHeader = CMD_PUBLISH_RESP | CMD_FLAG_PENDING;
+#if COMM_TRANSMISSION_MSB == 1
+		cmdHeader = swap_htonl(cmdHeader);
+#endif
+		memcpy(LoraReplyBuf, (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	}
+	
+	/* 数据段属性 */
+	uint8_t attrSize = Lora_C9AttrFill(&lora_reply, &LoraReplyBuf[LoraReplySize]);
+	LoraReplySize += attrSize;
+	
+	/* 数据段长度 */
+	replySize = 8 + attrSize;
 	LoraReplyBuf[lenIndex] = replySize;
 	
 	/* CRC16 */
@@ -849,25 +1519,26 @@ void Lora_C_DataReply(void)
 	LORA_TRANSMIT_ENABLE();
 	LORA_RECEIVE_DISABLE();
 	
+	LORA_RadioSetState(LORA_RADIO_TX);
 	LIGHT_2_ON();
 	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
 	{
 		extern ctrl_class_t ctrl_class;
 		if(ctrl_class.print_ctrl & 0X04)
 		{
-			printf("ظʧ!\n");
+			printf("回复失败!\n");
 		}
 	}
 	LIGHT_2_OFF();
 	
 	LORA_TRANSMIT_DISABLE();
 	LORA_RECEIVE_ENABLE();
-	wireless_drv.radio_Rxmode();	
+	LORA_RxRearm();
 	
 	extern ctrl_class_t ctrl_class;
 	if(ctrl_class.print_ctrl & 0X04)
 	{
-		printf("ظ:");
+		printf("回复数据:");
 		for(int i=0; i<LoraReplySize; i++)
 		{
 			printf("0x%02x ", LoraReplyBuf[i]);
@@ -881,7 +1552,7 @@ void Lora_TestReply(void)
 {
 	LoraReplySize = 0;
 	
-	/* ͷ */
+	/* 命令头 */
 	uint32_t cmdHeader = 0x06;
 #if COMM_TRANSMISSION_MSB == 1
 	cmdHeader = swap_htonl(cmdHeader);
@@ -889,19 +1560,19 @@ void Lora_TestReply(void)
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
 	LoraReplySize += sizeof(cmdHeader);
 	
-	/* ݶγ */
+	/* 数据段长度 */
 	LoraReplyBuf[LoraReplySize] = 16 + payload_length;
 	LoraReplySize += 1;
 	
-	/* ݶβ㳤ַ */
+	/* 数据段测点长地址 */
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.long_addr, sizeof(lora_reply_data.long_addr));
 	LoraReplySize += sizeof(lora_reply_data.long_addr);
 	
-	/* ݶسַ */
+	/* 数据段网关长地址 */
 	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.gateway_addr, sizeof(lora_reply_data.gateway_addr));
 	LoraReplySize += sizeof(lora_reply_data.gateway_addr);
 	
-	/* ݶغ */
+	/* 数据段载荷 */
 	memset(&LoraReplyBuf[LoraReplySize], 0XA5, payload_length);
 	LoraReplySize += payload_length;	
 	
@@ -914,13 +1585,14 @@ void Lora_TestReply(void)
 	LORA_TRANSMIT_ENABLE();
 	LORA_RECEIVE_DISABLE();
 
+	LORA_RadioSetState(LORA_RADIO_TX);
 	LIGHT_2_ON();
 	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
 	{
 		extern ctrl_class_t ctrl_class;
 		if(ctrl_class.print_ctrl & 0X04)
 		{
-			printf("ظʧ!\n");
+			printf("回复失败!\n");
 		}
 	}
 	LIGHT_2_OFF();
@@ -929,12 +1601,12 @@ void Lora_TestReply(void)
 	
 	LORA_TRANSMIT_DISABLE();
 	LORA_RECEIVE_ENABLE();
-	wireless_drv.radio_Rxmode();
+	LORA_RxRearm();
 	
 	extern ctrl_class_t ctrl_class;
 	if(ctrl_class.print_ctrl & 0X04)
 	{
-		printf("ظ:");
+		printf("回复数据:");
 		for(int i=0; i<LoraReplySize; i++)
 		{
 			printf("0x%02x ", LoraReplyBuf[i]);
@@ -943,14 +1615,363 @@ void Lora_TestReply(void)
 	}
 }
 
+/* 测试类命令回复，数据段为测点长地址+网关长地址+p_data */
+void Lora_TestCmdReply(uint32_t cmd, uint8_t* p_data, uint8_t size)
+{
+	LoraReplySize = 0;
+	
+	/* 命令头 */
+	uint32_t cmdHeader = cmd;
+#if COMM_TRANSMISSION_MSB == 1
+	cmdHeader = swap_htonl(cmdHeader);
+#endif
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	LoraReplySize += sizeof(cmdHeader);
+	
+	/* 数据段长度 */
+	LoraReplyBuf[LoraReplySize] = 16 + size;
+	LoraReplySize += 1;
+	
+	/* 数据段测点长地址 */
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.long_addr, sizeof(lora_reply_data.long_addr));
+	LoraReplySize += sizeof(lora_reply_data.long_addr);
+	
+	/* 数据段网关长地址 */
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.gateway_addr, sizeof(lora_reply_data.gateway_addr));
+	LoraReplySize += sizeof(lora_reply_data.gateway_addr);
+	
+	/* 数据段载荷 */
+	memcpy(&LoraReplyBuf[LoraReplySize], p_data, size);
+	LoraReplySize += size;
+	
+	/* CRC16 */
+	wireless_comm_services_t* wirelessCommSvc = Wireless_CommSvcGetHandle();
+	uint16_t crc16 = wirelessCommSvc->modbusRtuCRC(LoraReplyBuf, LoraReplySize);
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&crc16, sizeof(crc16));
+	LoraReplySize += sizeof(crc16);
+	
+	LORA_TRANSMIT_ENABLE();
+	LORA_RECEIVE_DISABLE();
+
+	LORA_RadioSetState(LORA_RADIO_TX);
+	LIGHT_2_ON();
+	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
+	{
+		extern ctrl_class_t ctrl_class;
+		if(ctrl_class.print_ctrl & 0X04)
+		{
+			printf("回复失败!\n");
+		}
+	}
+	LIGHT_2_OFF();
+	
+	LORA_TRANSMIT_DISABLE();
+	LORA_RECEIVE_ENABLE();
+	LORA_RxRearm();
+}
+
+/* 按测点类型(长地址首字节)编码属性，用于组确认帧中的全体测点参数 */
+uint8_t Lora_AttrFill(uint8_t type, lora_reply_data_t* p_reply, uint8_t* buf)
+{
+	if(type == 0XC8)
+	{
+		return Lora_C8AttrFill(p_reply, buf);
+	}
+	else if(type == 0XC9)
+	{
+		return Lora_C9AttrFill(p_reply, buf);
+	}
+	
+	return 0;
+}
+
+/* 广播帧发送，数据段为网关长地址+p_data，返回帧长度 */
+uint8_t Lora_BroadcastSend(uint32_t cmd, uint8_t* p_data, uint8_t size)
+{
+	LoraReplySize = 0;
+	
+	/* 命令头 */
+	uint32_t cmdHeader = cmd;
+#if COMM_TRANSMISSION_MSB == 1
+	cmdHeader = swap_htonl(cmdHeader);
+#endif
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&cmdHeader, sizeof(cmdHeader));
+	LoraReplySize += sizeof(cmdHeader);
+	
+	/* 数据段长度 */
+	LoraReplyBuf[LoraReplySize] = 8 + size;
+	LoraReplySize += 1;
+	
+	/* 数据段网关长地址 */
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&lora_reply_data.gateway_addr, sizeof(lora_reply_data.gateway_addr));
+	LoraReplySize += sizeof(lora_reply_data.gateway_addr);
+	
+	/* 数据段 */
+	memcpy(&LoraReplyBuf[LoraReplySize], p_data, size);
+	LoraReplySize += size;
+	
+	/* CRC16 */
+	wireless_comm_services_t* wirelessCommSvc = Wireless_CommSvcGetHandle();
+	uint16_t crc16 = wirelessCommSvc->modbusRtuCRC(LoraReplyBuf, LoraReplySize);
+	memcpy(&LoraReplyBuf[LoraReplySize], (uint8_t*)&crc16, sizeof(crc16));
+	LoraReplySize += sizeof(crc16);
+	
+	LORA_TRANSMIT_ENABLE();
+	LORA_RECEIVE_DISABLE();
+
+	LORA_RadioSetState(LORA_RADIO_TX);
+	LIGHT_2_ON();
+	if(wireless_drv.radio_TXData(LoraReplyBuf, LoraReplySize))
+	{
+		extern ctrl_class_t ctrl_class;
+		if(ctrl_class.print_ctrl & 0X04)
+		{
+			printf("广播失败!\n");
+		}
+	}
+	LIGHT_2_OFF();
+	
+	LORA_TRANSMIT_DISABLE();
+	LORA_RECEIVE_ENABLE();
+	LORA_RxRearm();
+	
+	return LoraReplySize;
+}
+
+static const uint32_t lora_bw_hz_tb[] = {7810,10420,15630,20830,31250,41670,62500,125000,250000,500000};
+static const uint8_t lora_bw_reg_tb[] = {0X00,0X08,0X01,0X09,0X02,0X0A,0X03,0X04,0X05,0X06}; //带宽序号对应的寄存器值
+
+/* 当前生效的扩频因子、带宽序号与发射功率，链路扫描期间为临时参数 */
+static void LORA_RadioCfgGet(Lora_RadioCfg_t* cfg)
+{
+	sys_param_t* param = Sys_ParamGetHandle();
+	
+	if(lora_cfg_override)
+	{
+		*cfg = lora_cfg;
+		return;
+	}
+	
+	cfg->sf = param->lora_sf;
+	cfg->bw = param->lora_bw;
+	cfg->power = param->lora_power;
+}
+
+/* 临时切换扩频因子、带宽与发射功率，不修改系统参数，cfg为NULL时恢复系统参数 */
+void LORA_RadioApply(const Lora_RadioCfg_t* cfg)
+{
+	sys_param_t* param = Sys_ParamGetHandle();
+	Lora_RadioCfg_t active;
+	
+	lora_cfg_override = (cfg != NULL);
+	if(cfg != NULL)
+	{
+		lora_cfg = *cfg;
+	}
+	
+	if(LoraRadioState == LORA_RADIO_OFF)
+	{
+		return; //任务启动时按当前参数配置
+	}
+	
+	LORA_RadioCfgGet(&active);
+	wireless_drv.radio_standmode(0); //待机模式下才能修改调制参数
+	wireless_drv.radio_setModulationParams(active.sf, lora_bw_reg_tb[active.bw], param->lora_code_rate);
+	wireless_drv.radio_setTxparams(active.power, SX126X_PA_RAMP_10U);
+	LORA_RxRearm();
+}
+
+/* 指定扩频因子与带宽序号下的符号时间，单位us */
+uint32_t LORA_SymbolTimeCfgUs(uint8_t sf, uint8_t bw)
+{
+	bw = (bw < sizeof(lora_bw_hz_tb)/sizeof(lora_bw_hz_tb[0])) ? bw : 7;
+	return (uint32_t)(((uint64_t)1000000 << sf) / lora_bw_hz_tb[bw]);
+}
+
+/* 当前参数下的符号时间，单位us */
+uint32_t LORA_SymbolTimeUs(void)
+{
+	Lora_RadioCfg_t cfg;
+	LORA_RadioCfgGet(&cfg);
+	return LORA_SymbolTimeCfgUs(cfg.sf, cfg.bw);
+}
+
+/* 当前参数下payload_len字节数据帧的空中时间，单位us */
+uint32_t LORA_TimeOnAirUs(uint8_t payload_len)
+{
+	Lora_RadioCfg_t cfg;
+	LORA_RadioCfgGet(&cfg);
+	return LORA_TimeOnAirCfgUs(cfg.sf, cfg.bw, payload_len);
+}
+
+/* 指定扩频因子与带宽序号下payload_len字节数据帧的空中时间，其余参数取系统参数，单位us */
+uint32_t LORA_TimeOnAirCfgUs(uint8_t sf_cfg, uint8_t bw, uint8_t payload_len)
+{
+	sys_param_t* param = Sys_ParamGetHandle();
+	uint32_t t_sym = LORA_SymbolTimeCfgUs(sf_cfg, bw);
+	int32_t sf = sf_cfg;
+	int32_t de = (t_sym >= 16000) ? 1 : 0; //低速率优化
+	int32_t num = 8*payload_len - 4*sf + 28 + 16*param->lora_crc - 20*param->lora_header;
+	int32_t den = 4*(sf - 2*de);
+	uint32_t payload_sym = 8;
+	
+	if(num > 0 && den > 0)
+	{
+		payload_sym += ((num + den - 1) / den) * (param->lora_code_rate + 4);
+	}
+	
+	return (param->lora_preamble * 4 + 17) * t_sym / 4 + payload_sym * t_sym; //前导码(Npre+4.25)个符号
+}
+
+/* flash操作许可：收到数据帧尚未回复或正在接收数据帧时不启动flash操作，
+   擦除期间CPU停顿，否则回复会错过测点的接收窗口 */
+static uint64_t lora_preamble_tick = 0;
+static uint8_t lora_preamble_flag = 0;
+static uint8_t LORA_FlashGateRadio(void)
+{
+	extern uint16_t _GetIrqStatus(void);
+	extern void _ClearIrqStatus(uint16_t irq);
+	
+	uint16_t irq = _GetIrqStatus();
+	if(irq & SX126X_IRQ_HEADER_VALID)
+	{
+		return 0;
+	}
+	
+	if(irq & SX126X_IRQ_PREAMBLE_DETECTED)
+	{
+		uint64_t now = Mono_ClockGetTicks();
+		if(lora_preamble_flag == 0)
+		{
+			lora_preamble_flag = 1;
+			lora_preamble_tick = now;
+			return 0;
+		}
+		
+		/* 超过前导码与报头时间仍未收到报头，视为误检 */
+		uint32_t timeout_ms = LORA_TimeOnAirUs(0) / 1000 + 1;
+		if(now - lora_preamble_tick < MONO_CLOCK_MS_TO_TICKS(timeout_ms))
+		{
+			return 0;
+		}
+		_ClearIrqStatus(SX126X_IRQ_PREAMBLE_DETECTED);
+	}
+	lora_preamble_flag = 0;
+	
+	return 1;
+}
+
+static uint8_t LORA_FlashGate(uint32_t duration_ms)
+{
+	uint8_t gate;
+	
+	if(LoraState == LORA_TX_SUCCESS)
+	{
+		return 0;
+	}
+	
+	if(Lora_Info.State != LORA_ACTIVE || duration_ms <= LORA_FLASH_GATE_FREE_TIME)
+	{
+		return 1;
+	}
+	
+	gate = LORA_FlashGateRadio();
+	LORA_PrefetchArm(); //查询状态时已撤防，恢复预读
+	
+	return gate;
+}
+
 __weak void Lora_RxHandler(uint8_t* p_data, uint8_t size){}
 uint8_t rx_size;
 uint8_t rx_buf[255];
+/* 故障时复位模块并按当前参数重新配置，不重启任务 */
+static void LORA_RadioRecover(void)
+{
+	LORA_RadioSetState(LORA_RADIO_RECOVER);
+	lora_radio_fault = 0;
+	Lora_RadioStat.recover_nums++;
+	
+	wireless_drv.radio_reset();
+	wireless_drv.radio_init();
+	if(lora_radio_fault == 0)
+	{
+		LORA_TRANSMIT_DISABLE();
+		LORA_RECEIVE_ENABLE();
+		LORA_RxRearm();
+	}
+}
+
+/* 接收状态巡检：模块故障、DIO1上升沿丢失、模块意外退出接收 */
+static void LORA_RadioWatchdog(void)
+{
+	extern uint8_t _GetDeviceStatus(void);
+	static uint64_t check_ticks = 0;
+	static uint8_t dio1_high_nums = 0;
+	uint64_t now = Mono_ClockGetTicks();
+	
+	if(Lora_Info.State != LORA_ACTIVE || LoraState != LORA_IDLE ||
+	   now - check_ticks < MONO_CLOCK_MS_TO_TICKS(LORA_WATCHDOG_PERIOD_MS))
+	{
+		return;
+	}
+	check_ticks = now;
+	
+	if(lora_radio_fault != 0)
+	{
+		LORA_RadioRecover();
+		return;
+	}
+	
+	switch((uint8_t)LoraRadioState)
+	{
+		case LORA_RADIO_RX:
+			/* DIO1保持高电平却未进入中断，连续两次巡检确认 */
+			if(LORA_READ_IRQ_STATUS() == 1)
+			{
+				if(++dio1_high_nums >= 2)
+				{
+					dio1_high_nums = 0;
+					Lora_RadioStat.missed_irq_nums++;
+					LORA_RadioSetState(LORA_RADIO_RX_PEND);
+					LoraState = LORA_TX_SUCCESS;
+				}
+				break;
+			}
+			dio1_high_nums = 0;
+			
+			if((_GetDeviceStatus() & 0X70) != SX126X_STATUS_MODE_RX)
+			{
+				/* 掉电复位后模块已恢复默认参数，配置缓存不可信，按当前参数完整恢复 */
+				Lora_RadioStat.rearm_nums++;
+				LORA_RadioRecover();
+			}
+			else
+			{
+				LORA_PrefetchArm(); //查询状态时已撤防，恢复预读
+			}
+			break;
+		
+		/* 中断已记录但未投递处理 */
+		case LORA_RADIO_RX_PEND:
+			LoraState = LORA_TX_SUCCESS;
+			break;
+		
+		/* 发送流程异常退出 */
+		case LORA_RADIO_TX:
+			LORA_TRANSMIT_DISABLE();
+			LORA_RECEIVE_ENABLE();
+			LORA_RxRearm();
+			break;
+	}
+}
+
 static void LORA_StatusProc(void)
 {
 	uint8_t LoraOutState;
 	SWT_t* timer = SWT_GetHandle();
 	
+	LORA_RadioWatchdog();
+	
 	switch((uint8_t)LoraState)
 	{
 		case LORA_ACTIVE:
@@ -960,12 +1981,23 @@ static void LORA_StatusProc(void)
 			if(Lora_Info.State == LORA_IDLE)
 			{
 				Lora_Info.State = LORA_ACTIVE;
-//				timer->LoraTaskTimeSlice->Start(Lora_Info.Param.TaskTimeSlice); /* LORAʱƬʱ */
+//				timer->LoraTaskTimeSlice->Start(Lora_Info.Param.TaskTimeSlice); /* 启动LORA时间片定时器 */
 			}
 			
-			LORA_TRANSMIT_DISABLE();
-			LORA_RECEIVE_ENABLE();
-			wireless_drv.radio_Rxmode();
+			/* 任务停止期间收到的数据先处理 */
+			if(LoraRadioState == LORA_RADIO_RX_PEND)
+			{
+				LoraState = LORA_TX_SUCCESS;
+				break;
+			}
+			
+			/* 已在接收监听则不重复进入接收，避免打断正在接收的帧 */
+			if(LoraRadioState != LORA_RADIO_RX)
+			{
+				LORA_TRANSMIT_DISABLE();
+				LORA_RECEIVE_ENABLE();
+				LORA_RxRearm();
+			}
 			LIGHT_1_ON();
 			break;
 		
@@ -975,23 +2007,26 @@ static void LORA_StatusProc(void)
 			Lora_Info.Param.TxFailTimes = 0;
 			timer->LoraTxTimeout->Stop();
 			
-			wireless_drv.radio_dio1_irq_func(rx_buf, &rx_size);
+			if(wireless_drv.radio_dio1_irq_func(rx_buf, &rx_size) != LORA_RET_CODE_OK)
+			{
+				rx_size = 0;
+			}
+			LORA_RxRearm();
 			Lora_RxHandler(rx_buf, rx_size);
-			wireless_drv.radio_Rxmode();
 		
 			if(LoraConnStatus == LORA_OFFLINE)
 			{
 				timer->LoraTaskTimeSlice->Stop();
 				
-				/* LORAسɹ */
+				/* 连接LORA网关成功 */
 				LoraConnStatus = LORA_CONNECT;
 				LoraOutState = LORA_OUT_STATE_LINK;
 				Lora_Info.State = LORA_IDLE;
-				LORA_TaskStopHandler((void *)&LoraOutState); /* LORAֹͣ */
+				LORA_TaskStopHandler((void *)&LoraOutState); /* LORA任务停止处理 */
 			}
 			else
 			{
-				LoraState = LORA_TIMEOUT; /* ͳɹģʱƬʱʱ */
+				LoraState = LORA_TIMEOUT; /* 发送成功模拟时间片定时器超时 */
 			}
 			break;
 			
@@ -1003,16 +2038,16 @@ static void LORA_StatusProc(void)
 		
 			if(Lora_Info.Param.TxFailTimes >= Lora_Info.Param.TxMaxFailTimes)
 			{
-				LoraState = LORA_TIMEOUT; /* ʧܴ */
+				LoraState = LORA_TIMEOUT; /* 超过发送失败次数 */
 			}
 			else
 			{
-				timer->LoraIdle->Start(LORA_RandomDelay()); /* ʱʱLORAжʱ */
-				LORA_IdleLowPowerManage(); /* LORA͹,ȴʱ */
+				timer->LoraIdle->Start(LORA_RandomDelay()); /* 计算随机延时时间启动LORA空闲定时器 */
+				LORA_IdleLowPowerManage(); /* 进入LORA低功耗,等待定时器唤醒 */
 			}
 			break;
 		
-		/* ʱƬʱʱ¼ */
+		/* 时间片定时器超时事件 */
 		case LORA_TIMEOUT:
 			if(LoraPreConnStatus == LORA_OFFLINE)
 			{
@@ -1027,17 +2062,17 @@ static void LORA_StatusProc(void)
 			{
 				LoraOutState = LORA_OUT_STATE_CONNECT;
 			}
-		/* ֹͣLORA¼ */
+		/* 主动停止LORA活动事件 */
 		case LORA_STOP:
 			LoraState = LORA_IDLE;
 			Lora_Info.Param.TxFailTimes = 0;
-			timer->LoraTaskTimeSlice->Stop(); /* ֹͣLORAʱ */
+			timer->LoraTaskTimeSlice->Stop(); /* 停止所有LORA定时器 */
 			timer->LoraTxTimeout->Stop();
 			timer->LoraIdle->Stop();
 //			LORA_ConfigDefault();
 			Lora_Info.State = LORA_IDLE;
 			Lora_Info.LPMHandle->TaskSetStatus(LORA_TASK_ID, LPM_TASK_STA_STOP);
-			LORA_TaskStopHandler((void *)&LoraOutState); /* LORAֹͣ */
+			LORA_TaskStopHandler((void *)&LoraOutState); /* LORA任务停止处理 */
 			break;
 	}
 }
@@ -1067,10 +2102,12 @@ Lora_Info_t* LORA_TaskInit(LPM_t* LPMHandle)
 	
 	Lora_Info.LPMHandle->TaskRegister(LORA_TASK_ID);
 	
+	flash_job_gate_set(LORA_FlashGate);
+	
 	return &Lora_Info;
 }
 
-/* LORAֹͣ */
+/* LORA任务停止处理 */
 __weak void LORA_TaskStopHandler(void* param)
 {
 	return;
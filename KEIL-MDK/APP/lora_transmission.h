@@ -2,68 +2,79 @@
 #define __LORA_TRANSMISSION_H__
 #include "main.h"
 #include "low_power_manage.h"
-
-
-#define LORA_TASK_ID							1 //LORAID
-
-#define SWT_LORA_TIME_SLICE_TIME				2500000*1000u //LORAݷʱƬʱ
-#define SWT_LORA_TIMEOUT_TIME					3000u //LORAݷͳʱʱ
-
-#define LORA_DELAY_BASE_TIME					100u //LORAݷʧʱ
-#define LORA_RANDOME_DELAY_UPPER				100u //LORAݷʧʱʱ
-#define LORA_RANDOME_DELAY_LOWER				10u //LORAݷʧʱʱ
-#define LORA_TX_MAX_DELAY_TIME					1*1000u //LORAݷʧʱʱ
-#define LORA_TX_MAX_FIAL_TIMES					~0u //LORAݷʧ
-
-/* LORAͨ״̬ */
-#define LORA_OUT_STATE_OFFLINE					0X01 //δ
-#define LORA_OUT_STATE_DISCON					0X02 //̬Ͽ
-#define LORA_OUT_STATE_LINK						0X03 //δӵ̬
-#define LORA_OUT_STATE_CONNECT					0X04 //̬
+#include "uart_svc.h"
+
+
+#define LORA_TASK_ID							1 //LORA任务ID
+
+#define SWT_LORA_TIME_SLICE_TIME				2500000*1000u //LORA数据发送时间片时间
+#define SWT_LORA_TIMEOUT_TIME					3000u //LORA数据发送超时时间
+
+#define LORA_DELAY_BASE_TIME					100u //LORA数据发送失败延时基数
+#define LORA_RANDOME_DELAY_UPPER				100u //LORA数据发送失败随机延时时间上限
+#define LORA_RANDOME_DELAY_LOWER				10u //LORA数据发送失败随机延时时间下限
+#define LORA_TX_MAX_DELAY_TIME					1*1000u //LORA数据发送失败最大延时时间
+#define LORA_TX_MAX_FIAL_TIMES					~0u //LORA数据发送失败最大次数
+#define LORA_FLASH_GATE_FREE_TIME				2u //耗时不超过该值(ms)的flash操作不受收发状态限制
+#define LORA_CAPTURE_TIMER_INSTANCE				1 //DIO1边沿捕获定时器(TIMER0由协议栈使用)
+#define LORA_PREFETCH_TIMER_INSTANCE			2 //DIO1中断状态预读定时器
+#define LORA_PREFETCH_GAP_US					12u //预读两条命令之间的间隔，等待BUSY(4M SPI 4字节8us)
+#define LORA_PREFETCH_XFER_MAX_US				16u //预读单条命令最长传输时间
+#define LORA_PREFETCH_DONE_US					40u //预读完成唤醒CPU时间
+#define LORA_PREFETCH_WAIT_US					(LORA_PREFETCH_DONE_US + 20u) //撤防等待预读完成的最长时间
+#define LORA_BUSY_TIMEOUT_MS					20u //BUSY保持高电平超时时间，超时视为模块卡死
+#define LORA_TX_WAIT_MARGIN_MS					50u //发送等待DIO1超时时间=空中时间+该余量
+#define LORA_WATCHDOG_PERIOD_MS					1000u //接收状态巡检周期
+
+/* LORA通信状态 */
+#define LORA_OUT_STATE_OFFLINE					0X01 //未连接
+#define LORA_OUT_STATE_DISCON					0X02 //从连接态断开
+#define LORA_OUT_STATE_LINK						0X03 //从未连接到连接态
+#define LORA_OUT_STATE_CONNECT					0X04 //连接态
 
 #if (SYS_HW_VERSION == SYS_HW_VERSION_V0_3_0)
-/* LORAģ */
-#define LORA_POWER_PIN							4 //LORAģ鹩
-#define LORA_TRANSMIT_PIN						18 //LORA
-#define LORA_RECEIVE_PIN						17 //LORA
-#define LORA_RESET_PIN							25 //LORAλ
-#define LORA_BUSY_PIN							26 //LORA BUSY
-#define LORA_IRQ_PIN							27 //LORAж
-
-/* LORA_SPI */
-#define LORA_SPI_CS_PIN							5 //LORA_SPIƬѡ
-#define LORA_SPI_SCK_PIN    					6 //LORA_SPIʱ
-#define LORA_SPI_MISO_PIN   					8 //LORA_SPIӳ
-#define LORA_SPI_MOSI_PIN   					7 //LORA_SPI
+/* LORA模块引脚配置 */
+#define LORA_POWER_PIN							4 //LORA模块供电引脚
+#define LORA_TRANSMIT_PIN						18 //LORA发送
+#define LORA_RECEIVE_PIN						17 //LORA接收
+#define LORA_RESET_PIN							25 //LORA复位引脚
+#define LORA_BUSY_PIN							26 //LORA BUSY引脚
+#define LORA_IRQ_PIN							27 //LORA中断引脚
+
+/* LORA_SPI引脚配置 */
+#define LORA_SPI_CS_PIN							5 //LORA_SPI片选引脚
+#define LORA_SPI_SCK_PIN    					6 //LORA_SPI时钟引脚
+#define LORA_SPI_MISO_PIN   					8 //LORA_SPI主入从出引脚
+#define LORA_SPI_MOSI_PIN   					7 //LORA_SPI主出从入引脚
 #elif (SYS_HW_VERSION == SYS_HW_VERSION_V0_1_1)
-/* LORAģ */
-#define LORA_POWER_PIN							9 //LORAģ鹩
-#define LORA_TRANSMIT_PIN						2 //LORA
-#define LORA_RECEIVE_PIN						3 //LORA
-#define LORA_RESET_PIN							8 //LORAλ
-#define LORA_BUSY_PIN							30 //LORA BUSY
-#define LORA_IRQ_PIN							31 //LORAж
-
-/* LORA_SPI */
-#define LORA_SPI_CS_PIN							4 //LORA_SPIƬѡ
-#define LORA_SPI_SCK_PIN    					5 //LORA_SPIʱ
-#define LORA_SPI_MISO_PIN   					7 //LORA_SPIӳ
-#define LORA_SPI_MOSI_PIN   					6 //LORA_SPI
+/* LORA模块引脚配置 */
+#define LORA_POWER_PIN							9 //LORA模块供电引脚
+#define LORA_TRANSMIT_PIN						2 //LORA发送
+#define LORA_RECEIVE_PIN						3 //LORA接收
+#define LORA_RESET_PIN							8 //LORA复位引脚
+#define LORA_BUSY_PIN							30 //LORA BUSY引脚
+#define LORA_IRQ_PIN							31 //LORA中断引脚
+
+/* LORA_SPI引脚配置 */
+#define LORA_SPI_CS_PIN							4 //LORA_SPI片选引脚
+#define LORA_SPI_SCK_PIN    					5 //LORA_SPI时钟引脚
+#define LORA_SPI_MISO_PIN   					7 //LORA_SPI主入从出引脚
+#define LORA_SPI_MOSI_PIN   					6 //LORA_SPI主出从入引脚
 #endif
 
-/* LORAŹ״̬궨 */
-#define LORA_PWOER_ENABLE()						nrf_gpio_pin_set(LORA_POWER_PIN) //ʹLORAģ
-#define LORA_PWOER_DISABLE()					nrf_gpio_pin_clear(LORA_POWER_PIN) //ʧLORAģ
-#define LORA_TRANSMIT_ENABLE()					nrf_gpio_pin_set(LORA_TRANSMIT_PIN) //ʹLORA
-#define LORA_TRANSMIT_DISABLE()					nrf_gpio_pin_clear(LORA_TRANSMIT_PIN) //ʧLORA
-#define LORA_RECEIVE_ENABLE()					nrf_gpio_pin_set(LORA_RECEIVE_PIN) //ʹLORA
-#define LORA_RECEIVE_DISABLE()					nrf_gpio_pin_clear(LORA_RECEIVE_PIN) //ʧLORA
-#define LORA_RESET_ENABLE()						nrf_gpio_pin_clear(LORA_RESET_PIN) //ʹLORAλ
-#define LORA_RESET_DISABLE()					nrf_gpio_pin_set(LORA_RESET_PIN) //ʧLORAλ
-#define LORA_READ_STATUS()						nrf_gpio_pin_read(LORA_BUSY_PIN) //ȡLORAæµ״̬
-#define LORA_READ_IRQ_STATUS()					nrf_gpio_pin_read(LORA_IRQ_PIN) //ȡж״̬
-#define LORA_SPI_CS_ENABLE()					nrf_gpio_pin_clear(LORA_SPI_CS_PIN) //LORA SPIƬѡʹ
-#define LORA_SPI_CS_DISABLE()					nrf_gpio_pin_set(LORA_SPI_CS_PIN) //LORA SPIƬѡʧ
+/* LORA引脚功能状态宏定义 */
+#define LORA_PWOER_ENABLE()						nrf_gpio_pin_set(LORA_POWER_PIN) //使能LORA模块
+#define LORA_PWOER_DISABLE()					nrf_gpio_pin_clear(LORA_POWER_PIN) //失能LORA模块
+#define LORA_TRANSMIT_ENABLE()					nrf_gpio_pin_set(LORA_TRANSMIT_PIN) //使能LORA发送
+#define LORA_TRANSMIT_DISABLE()					nrf_gpio_pin_clear(LORA_TRANSMIT_PIN) //失能LORA发送
+#define LORA_RECEIVE_ENABLE()					nrf_gpio_pin_set(LORA_RECEIVE_PIN) //使能LORA接收
+#define LORA_RECEIVE_DISABLE()					nrf_gpio_pin_clear(LORA_RECEIVE_PIN) //失能LORA接收
+#define LORA_RESET_ENABLE()						nrf_gpio_pin_clear(LORA_RESET_PIN) //使能LORA复位
+#define LORA_RESET_DISABLE()					nrf_gpio_pin_set(LORA_RESET_PIN) //失能LORA复位
+#define LORA_READ_STATUS()						nrf_gpio_pin_read(LORA_BUSY_PIN) //读取LORA忙碌状态
+#define LORA_READ_IRQ_STATUS()					nrf_gpio_pin_read(LORA_IRQ_PIN) //读取中断引脚状态
+#define LORA_SPI_CS_ENABLE()					nrf_gpio_pin_clear(LORA_SPI_CS_PIN) //LORA SPI片选使能
+#define LORA_SPI_CS_DISABLE()					nrf_gpio_pin_set(LORA_SPI_CS_PIN) //LORA SPI片选失能
 
 #define LONG_ADDR				0X01
 #define SHORT_ADDR				0X02
@@ -85,6 +96,12 @@
 #define LORA_POWER				0X20000
 #define LORA_BW					0X40000
 #define LORA_SF					0X80000
+#define LORA_SYNC				0X100000
+
+/* 按测点跟踪确认值的参数，与测点已确认值相同时不再下发 */
+#define PEER_CFG_TRACK_MASK		(MODE|PERIOD|INTERVAL|X_THRES|Y_THRES|Z_THRES|SENSOR_FREQ|ACCEL_SLOPE|DATA_POINTS)
+/* 逐个回复下发的测点参数，不在跟踪掩码中的参数每次设置都下发 */
+#define PEER_CFG_SET_MASK		(PEER_CFG_TRACK_MASK|LONG_ADDR|TIME_STAMP|TIME_OFFSET)
 
 #define PRINT_LORA_REPLY_MSG	0
 
@@ -115,6 +132,33 @@ typedef enum {
 	LORA_STOP,
 }Lora_State;
 
+/* 射频模块状态 */
+typedef enum {
+	LORA_RADIO_OFF, //未启动
+	LORA_RADIO_RX, //接收监听
+	LORA_RADIO_RX_PEND, //DIO1已触发，等待处理
+	LORA_RADIO_TX, //发送回复
+	LORA_RADIO_RECOVER, //故障恢复
+}Lora_RadioState;
+
+/* 射频模块故障 */
+#define LORA_FAULT_BUSY							0X01 //BUSY超时
+#define LORA_FAULT_DIO1							0X02 //发送等待DIO1超时
+
+/* 链路扫描临时射频参数 */
+typedef struct {
+	uint8_t sf; //扩频因子
+	uint8_t bw; //带宽序号，同系统参数lora_bw
+	int8_t power; //发射功率
+}Lora_RadioCfg_t;
+
+typedef struct {
+	uint32_t deaf_ms; //累计不在接收监听状态的时间
+	uint32_t rearm_nums; //巡检发现模块未处于接收而重新进入接收的次数
+	uint32_t missed_irq_nums; //DIO1中断丢失次数
+	uint32_t recover_nums; //模块故障复位恢复次数
+}Lora_RadioStat_t;
+
 typedef struct {
 	uint32_t TaskTimeSlice;
 	uint32_t TxTimeout;
@@ -125,10 +169,10 @@ typedef struct {
 	uint32_t RandomDelayLower;
 	uint32_t TxMaxDelayTime;
 	
-	/* Ʋ */
-	FunctionalState IsIdleEnterLp; //DISABLELORA״̬ENABLELORA״̬͹ģʽ
+	/* 控制参数 */
+	FunctionalState IsIdleEnterLp; //DISABLE：LORA空闲状态不动作，ENABLE：LORA空闲状态进入低功耗模式
 	
-	/*  */
+	/* 被动参数 */
 	uint32_t TxFailTimes;
 }Lora_Param_t;
 
@@ -146,6 +190,23 @@ typedef struct {
 
 Lora_Info_t* LORA_TaskInit(LPM_t* LPMHandle);
 void LORA_SPI_Transfer(uint8_t* tx_buffer, uint8_t tx_length, uint8_t* rx_buffer, uint8_t rx_length);
+uint32_t LORA_SymbolTimeUs(void);
+uint32_t LORA_TimeOnAirUs(uint8_t payload_len);
+uint32_t LORA_SymbolTimeCfgUs(uint8_t sf, uint8_t bw);
+uint32_t LORA_TimeOnAirCfgUs(uint8_t sf, uint8_t bw, uint8_t payload_len);
+void LORA_RadioApply(const Lora_RadioCfg_t* cfg);
+void Lora_TestCmdReply(uint32_t cmd, uint8_t* p_data, uint8_t size);
+uint8_t Lora_AttrFill(uint8_t type, lora_reply_data_t* p_reply, uint8_t* buf);
+uint8_t Lora_BroadcastSend(uint32_t cmd, uint8_t* p_data, uint8_t size);
+uint8_t Lora_PeerCfgSet(peer_attr_t* peer, lora_reply_data_t* p_set);
+uint64_t LORA_IrqTicks(void);
+uint32_t LORA_IrqTimeUs(void);
+void LORA_PrefetchArm(void);
+void LORA_RadioSetState(Lora_RadioState state);
+void LORA_RadioFault(uint8_t fault);
+uint8_t LORA_RadioFaulted(void);
+Lora_RadioStat_t* LORA_RadioStatGet(void);
+uint8_t LORA_PrefetchGet(uint16_t* irq, uint8_t* payload_len, uint8_t* buf_pointer);
 
 #endif
 
@@ -51,15 +51,15 @@ static void Signal_Detect(void)
 			Signal_Det_Info.LPMHandle->TaskSetStatus(SIGNAL_DET_TASK_ID, LPM_TASK_STA_LP);
 			break;
 		
-		/* źżⶨʱʱ¼ */
+		/* 信号检测定时器超时事件 */
 		case SIGNAL_DET_TIMEOUT:
-		/* ֹͣźż¼ */
+		/* 主动停止信号检测任务事件 */
 		case SIGNAL_DET_STOP:
 			SignalDetState = SIGNAL_DET_IDLE;
 			timer->SignalDetTimeSlice->Stop();
 			Signal_Det_Info.State = SIGNAL_DET_IDLE;
 			Signal_Det_Info.LPMHandle->TaskSetStatus(SIGNAL_DET_TASK_ID, LPM_TASK_STA_STOP);
-			Signal_DetTaskStopHandler(NULL); /* źżֹͣ */
+			Signal_DetTaskStopHandler(NULL); /* 信号检测任务停止处理 */
 			break;
 	}
 	
@@ -83,7 +83,7 @@ Signal_Det_Info_t* Signal_DetTaskInit(LPM_t* LPMHandle)
 	return &Signal_Det_Info;
 }
 
-/* źżֹͣ */
+/* 信号检测任务停止处理 */
 __weak void Signal_DetTaskStopHandler(void* param)
 {
 	return;
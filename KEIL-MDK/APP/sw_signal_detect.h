@@ -5,7 +5,7 @@
 
 
 #define SIGNAL_DET_TASK_ID							5
-#define SIGNAL_DET_TIME_SLICE						10*1000u /* źżʱƬ */
+#define SIGNAL_DET_TIME_SLICE						10*1000u /* 信号检测时间片 */
 
 
 typedef enum {
@@ -58,16 +58,16 @@ static void SLP_StatusProc(void)
 			}
 			break;
 		
-		/* ϵͳ͹˯߶ʱʱ¼ */
+		/* 系统低功耗睡眠定时器超时事件 */
 		case SLP_TIMEOUT:
-		/* ֹͣϵͳ˯߻¼ */
+		/* 主动停止系统睡眠活动事件 */
 		case SLP_STOP:
 			stateTmp = SlpState;
 			SlpState = SLP_IDLE;
 			timer->SysLowPower->Stop();
 			SLP_Info.State = SLP_IDLE;
 			SLP_Info.LPMHandle->TaskSetStatus(SLP_TASK_ID, LPM_TASK_STA_STOP);
-			SLP_TaskStopHandler((void *)&stateTmp); /* ϵͳ͹ֹͣ */
+			SLP_TaskStopHandler((void *)&stateTmp); /* 系统低功耗任务停止处理 */
 			break;
 	}
 	
@@ -92,7 +92,7 @@ SLP_Info_t* SLP_TaskInit(LPM_t* LPMHandle)
 	return &SLP_Info;
 }
 
-/* ϵͳ͹ֹͣ */
+/* 系统低功耗任务停止处理 */
 __weak void SLP_TaskStopHandler(void* param)
 {
 	return;
@@ -25,11 +25,11 @@
 #define APP_BLE_OBSERVER_PRIO           3                                       /**< Application's BLE observer priority. You shouldn't need to modify this value. */
 #define APP_BLE_CONN_CFG_TAG            1                                       /**< A tag identifying the SoftDevice BLE configuration. */
 
-/* 㲥 */
+/* 广播间隔 */
 #define APP_ADV_INTERVAL(x)             MSEC_TO_UNITS(x, UNIT_0_625_MS)			/**< The advertising interval (in units of 0.625 ms; this value corresponds to 40 ms). */
 #define APP_ADV_DURATION                BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED   /**< The advertising time-out (in units of seconds). When set to 0, we will never time out. */
 
-/* Ӳ */
+/* 连接参数 */
 #define MIN_CONN_INTERVAL(x)            MSEC_TO_UNITS(x, UNIT_1_25_MS)        	/**< Minimum acceptable connection interval */
 #define MAX_CONN_INTERVAL(x)            MSEC_TO_UNITS(x, UNIT_1_25_MS)        	/**< Maximum acceptable connection interval */
 #define SLAVE_LATENCY                   0                                       /**< Slave latency. */
@@ -534,8 +534,8 @@ static void gap_params_init(void)
 	ble_gap_conn_params_t   gap_conn_params;
 	ble_gap_conn_sec_mode_t sec_mode;
 
-	/* GAP豸 */
-	/* GAPİȫģʽ豸дȨ */
+	/* GAP服务特征：设备名字设置 */
+	/* 设置GAP的安全模式，即设备名称特征的写权限 */
 #if (DEV_MAME_FORMAT == 0)
 	sys_param_t* param = Sys_ParamGetHandle();
 	char dev_name[sizeof(param->dev_long_addr)*2+1];
@@ -560,22 +560,22 @@ static void gap_params_init(void)
 	err_code = sd_ble_gap_device_name_set(&sec_mode, (const uint8_t *)dev_name, strlen(dev_name));
 	APP_ERROR_CHECK(err_code);
 
-	/* GAP豸 */
+	/* GAP服务特征：设备外观设置 */
 //	err_code = sd_ble_gap_appearance_set(0);
 //	APP_ERROR_CHECK(err_code);
 
 	memset(&gap_conn_params, 0, sizeof(gap_conn_params));
-	gap_conn_params.min_conn_interval = MIN_CONN_INTERVAL(ble_param.min_conn_interval); //СӼ
-	gap_conn_params.max_conn_interval = MAX_CONN_INTERVAL(ble_param.max_conn_interval); //Ӽ
-	gap_conn_params.slave_latency     = SLAVE_LATENCY; //ӻӳ
-	gap_conn_params.conn_sup_timeout  = CONN_SUP_TIMEOUT(ble_param.conn_sup_timeout); //ලʱ
+	gap_conn_params.min_conn_interval = MIN_CONN_INTERVAL(ble_param.min_conn_interval); //最小连接间隔
+	gap_conn_params.max_conn_interval = MAX_CONN_INTERVAL(ble_param.max_conn_interval); //最大连接间隔
+	gap_conn_params.slave_latency     = SLAVE_LATENCY; //从机延迟
+	gap_conn_params.conn_sup_timeout  = CONN_SUP_TIMEOUT(ble_param.conn_sup_timeout); //监督超时
 
-	/* GAPΧ豸ѡӲ */
+	/* GAP服务特征：外围设备首选连接参数设置 */
 	err_code = sd_ble_gap_ppcp_set(&gap_conn_params);
 	APP_ERROR_CHECK(err_code);
 																				
-	//GAP豸ַ
-	//GAPɽ˽еַ
+	//GAP服务特征：中心设备地址解析特征
+	//GAP服务特征：仅可解析私有地址特征
 }
 
 void gatt_evt_handler(nrf_ble_gatt_t* p_gatt, nrf_ble_gatt_evt_t const* p_evt)
@@ -590,7 +590,7 @@ void gatt_evt_handler(nrf_ble_gatt_t* p_gatt, nrf_ble_gatt_evt_t const* p_evt)
  */
 static void gatt_init(void)
 {
-	/* ʼGATTģ飬Ĭϲصm_gatt */
+	/* 初始化GATT模块，默认参数返回到m_gatt中 */
 	ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, gatt_evt_handler);
 	APP_ERROR_CHECK(err_code);
 	
@@ -599,18 +599,18 @@ static void gatt_init(void)
 }
 
 #if 0
-BLE_ADVERTISING_DEF(m_advertising);     //Ϊm_advertisingĹ㲥ģʵ
-//㲥¼
+BLE_ADVERTISING_DEF(m_advertising);     //定义名称为m_advertising的广播模块实例
+//广播事件处理函数
 static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
 {
-    //жϹ㲥¼
+    //判断广播事件类型
     switch (ble_adv_evt)
     {
-		case BLE_ADV_EVT_FAST: //ٹ㲥¼ٹ㲥¼
+		case BLE_ADV_EVT_FAST: //快速广播启动事件：快速广播启动后会产生该事件
 			LIGHT_1_TOGGLE();
             break;
         
-        case BLE_ADV_EVT_IDLE: //㲥IDLE¼㲥ʱ¼
+        case BLE_ADV_EVT_IDLE: //广播IDLE事件：广播超时后会产生该事件
 			LIGHT_1_OFF();
 			LIGHT_2_ON();
             break;
@@ -619,50 +619,50 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
             break;
     }
 }
-//㲥ʼ
+//广播初始化
 static void advertising_init(void)
 {
     ret_code_t err_code;	
 	
-    /* һ飬ԶݣΪble_advdata_manuf_data_t
-	   ָͨݵģԱҪԶݵı
-	   ĵֵַble_advdata_manuf_data_t */
+    /* 定义一个数组，存放自定义的数据，因为ble_advdata_manuf_data_t中
+	   是通过指针来引用数据的，所以必须要定义存放自定义数据的变量，将
+	   变量的地址赋值给ble_advdata_manuf_data_t */
     uint8_t my_adv_manuf_data[] = {0x01};
-	/* һԶݵĽṹù㲥ʱñĵֵַ
-	   㲥ݽṹеp_manuf_specific_data */
+	/* 定义个一个制造商自定义数据的结构体变量，配置广播数据时将该变量的地址赋值给
+	   广播数据结构体中的p_manuf_specific_data */
 	ble_advdata_manuf_data_t manuf_specific_data;
-	manuf_specific_data.company_identifier = 0x0059; //ID0x0059NordicID
-	manuf_specific_data.data.p_data = my_adv_manuf_data; //ָԶ
-    manuf_specific_data.data.size = sizeof(my_adv_manuf_data); //ԶݴС(ֽ)
+	manuf_specific_data.company_identifier = 0x0059; //制造商ID，0x0059是Nordic的ID
+	manuf_specific_data.data.p_data = my_adv_manuf_data; //指向制造商自定义的数据
+    manuf_specific_data.data.size = sizeof(my_adv_manuf_data); //制造商自定义的数据大小(字节数)
 
     ble_advertising_init_t init;
     
-    memset(&init, 0, sizeof(init)); //֮ǰ
-    init.advdata.name_type = BLE_ADVDATA_FULL_NAME; //豸ȫ
-    init.advdata.include_appearance = true; //Ƿ
-    init.advdata.flags = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE; //һɷģʽ֧BR/EDR
+    memset(&init, 0, sizeof(init)); //配置之前先清零
+    init.advdata.name_type = BLE_ADVDATA_FULL_NAME; //设备名称全名
+    init.advdata.include_appearance = true; //是否包含外观
+    init.advdata.flags = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE; //一般可发现模式，不支持BR/EDR
 	
-	ble_uuid_t adv_uuids[] = {{DEV_CFG_UUID_SERVICE, m_dev_cfg.uuid_type}}; //ȫUUID
+	ble_uuid_t adv_uuids[] = {{DEV_CFG_UUID_SERVICE, m_dev_cfg.uuid_type}}; //全部服务UUID
 	init.advdata.uuids_complete.uuid_cnt = sizeof(adv_uuids) / sizeof(adv_uuids[0]);
 	init.advdata.uuids_complete.p_uuids = adv_uuids;
 	
-//	init.advdata.p_manuf_specific_data = &manuf_specific_data; //㲥мԶ
+//	init.advdata.p_manuf_specific_data = &manuf_specific_data; //广播中加入制造商自定义数据
 	
-    init.config.ble_adv_fast_enabled = true; //ù㲥ģʽΪٹ㲥
-    init.config.ble_adv_fast_interval = APP_ADV_INTERVAL(ble_param.adv_interval); //ù㲥
-    init.config.ble_adv_fast_timeout  = APP_ADV_DURATION; //òʱ
+    init.config.ble_adv_fast_enabled = true; //设置广播模式为快速广播
+    init.config.ble_adv_fast_interval = APP_ADV_INTERVAL(ble_param.adv_interval); //设置广播间隔
+    init.config.ble_adv_fast_timeout  = APP_ADV_DURATION; //设置播持续时间
     
-    init.evt_handler = on_adv_evt; //㲥¼ص
+    init.evt_handler = on_adv_evt; //广播事件回调函数
     
-    err_code = ble_advertising_init(&m_advertising, &init); //ʼ㲥
+    err_code = ble_advertising_init(&m_advertising, &init); //初始化广播
     APP_ERROR_CHECK(err_code);
     
-    ble_advertising_conn_cfg_tag_set(&m_advertising, APP_BLE_CONN_CFG_TAG); //ñ־ǰSoftDevice汾ֻд1
+    ble_advertising_conn_cfg_tag_set(&m_advertising, APP_BLE_CONN_CFG_TAG); //设置连接设置标志，当前SoftDevice版本中只能写1
 }
-//㲥úõģʽ͹㲥ʼõĹ㲥ģʽһ
+//启动广播，该函数所用的模式必须和广播初始化中设置的广播模式一样
 void ble_advertising_start(void)
 {
-	ret_code_t err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST); //ʹù㲥ʼõĹ㲥ģʽ㲥
+	ret_code_t err_code = ble_advertising_start(&m_advertising, BLE_ADV_MODE_FAST); //使用广播初始化中设置的广播模式启动广播
 	APP_ERROR_CHECK(err_code);
 }
 #endif
@@ -678,28 +678,28 @@ static void advertising_init(void)
 	ret_code_t    err_code;
 	ble_advdata_t advdata;
 	
-	/* ù㲥 */
+	/* 配置广播数据 */
 	memset(&advdata, 0, sizeof(advdata));
-	advdata.name_type          = BLE_ADVDATA_FULL_NAME; //豸ȫ
-	advdata.include_appearance = true; //Ƿ
-	advdata.flags              = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE; //һɷģʽ֧BR/EDR
+	advdata.name_type          = BLE_ADVDATA_FULL_NAME; //设备名称全名
+	advdata.include_appearance = true; //是否包含外观
+	advdata.flags              = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE; //一般可发现模式，不支持BR/EDR
 
 	ble_advdata_t srdata;
 //	ble_uuid_t adv_uuids[] = {{DEV_CFG_UUID_SERVICE, m_dev_cfg.uuid_type}};
 	ble_uuid_t adv_uuids[] = {{LORA_CFG_UUID_SERVICE, m_lora_cfg.uuid_type}};
-	memset(&srdata, 0, sizeof(srdata)); //ȫUUID
+	memset(&srdata, 0, sizeof(srdata)); //全部服务UUID
 	srdata.uuids_complete.uuid_cnt = sizeof(adv_uuids) / sizeof(adv_uuids[0]);
 	srdata.uuids_complete.p_uuids  = adv_uuids;
 
-	/* 㲥 */
+	/* 编码广播数据 */
 	err_code = ble_advdata_encode(&advdata, m_adv_data.adv_data.p_data, &m_adv_data.adv_data.len);
 	APP_ERROR_CHECK(err_code);
 
-	/* 㲥 */
+	/* 编码广播数据 */
 	err_code = ble_advdata_encode(&srdata, m_adv_data.scan_rsp_data.p_data, &m_adv_data.scan_rsp_data.len);
 	APP_ERROR_CHECK(err_code);
 	
-	/* ù㲥 */
+	/* 配置广播参数 */
 	ble_gap_adv_params_t adv_params;
 	memset(&adv_params, 0, sizeof(adv_params));
 	adv_params.primary_phy     = BLE_GAP_PHY_1MBPS;
@@ -713,34 +713,34 @@ static void advertising_init(void)
 	APP_ERROR_CHECK(err_code);
 }
 
-//Ŷд¼ڴŶдģĴ
+//排队写入事件处理函数，用于处理排队写入模块的错误
 static void nrf_qwr_error_handler(uint32_t nrf_error)
 {
     APP_ERROR_HANDLER(nrf_error);
 }
 
-//ӲЭģ¼
+//连接参数协商模块事件处理函数
 static void on_conn_params_evt(ble_conn_params_evt_t * p_evt)
 {
 	ret_code_t err_code;
-	//ж¼ͣ¼ִж
-	//ӲЭʧ
+	//判断事件类型，根据事件类型执行动作
+	//连接参数协商失败
 	if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED)
 	{
 		err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
 		APP_ERROR_CHECK(err_code);
 	}
-	//ӲЭ̳ɹ
+	//连接参数协商成功
 	if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_SUCCEEDED)
 	{
-		//ܴ;
+		//功能代码;
 	}
 }
 
-//ӲЭģ¼nrf_error˴룬ͨnrf_errorԷϢ
+//连接参数协商模块错误处理事件，参数nrf_error包含了错误代码，通过nrf_error可以分析错误信息
 static void conn_params_error_handler(uint32_t nrf_error)
 {
-	//
+	//检查错误代码
 	APP_ERROR_HANDLER(nrf_error);
 }
 
@@ -753,19 +753,19 @@ static void conn_params_init(void)
 
 	memset(&cp_init, 0, sizeof(cp_init));
 	
-	cp_init.p_conn_params                  = NULL; //ΪNULLȡӲ
-	cp_init.first_conn_params_update_delay = FIRST_CONN_PARAMS_UPDATE_DELAY; //ӻ֪ͨ״ηӲ֮ʱ(ticks)
-	cp_init.next_conn_params_update_delay  = NEXT_CONN_PARAMS_UPDATE_DELAY; //ÿεsd_ble_gap_conn_param_update()Ӳ֮ļʱ(ticks)
-	cp_init.max_conn_params_update_count   = MAX_CONN_PARAMS_UPDATE_COUNT; //ӲЭǰӲЭ̵
-	/* Ӳ´֪ͨʹܻ¼ʼʱ
-		 ֪ͨʹܿʼʱΪӦCCCDͻ
-		 ¼ʼʱΪBLE_GATT_HANDLE_INVALID */
+	cp_init.p_conn_params                  = NULL; //设置为NULL，从主机获取连接参数
+	cp_init.first_conn_params_update_delay = FIRST_CONN_PARAMS_UPDATE_DELAY; //连接或启动通知到首次发起连接参数更新请求之间的时间(ticks)
+	cp_init.next_conn_params_update_delay  = NEXT_CONN_PARAMS_UPDATE_DELAY; //每次调用sd_ble_gap_conn_param_update()函数发起连接参数更新请求之间的间隔时间(ticks)
+	cp_init.max_conn_params_update_count   = MAX_CONN_PARAMS_UPDATE_COUNT; //放弃连接参数协商前尝试连接参数协商的最大次数
+	/* 设置连接参数更新从通知使能或者连接事件开始计时
+		 如果从通知使能开始计时，设置为对应CCCD（客户端特性配置描述符）句柄
+		 如果从连接事件开始计时，设置为BLE_GATT_HANDLE_INVALID */
 	cp_init.start_on_notify_cccd_handle    = BLE_GATT_HANDLE_INVALID;
-	cp_init.disconnect_on_fail             = false; //ӲʧܲϿ
-	cp_init.evt_handler                    = on_conn_params_evt; //עӲ¼
-	cp_init.error_handler                  = conn_params_error_handler; //עӲ´¼
+	cp_init.disconnect_on_fail             = false; //连接参数更新失败不断开连接
+	cp_init.evt_handler                    = on_conn_params_evt; //注册连接参数更新事件句柄
+	cp_init.error_handler                  = conn_params_error_handler; //注册连接参数更新错误事件句柄
 
-	/* ÿ⺯Ӳ³ʼṹΪʼӲЭģ */
+	/* 调用库函数（以连接参数更新初始化结构体为输入参数）初始化连接参数协商模块 */
 	err_code = ble_conn_params_init(&cp_init);
 	APP_ERROR_CHECK(err_code);
 }
@@ -781,7 +781,7 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 
 	switch (p_ble_evt->header.evt_id)
 	{
-		/* ¼ */
+		/* 连接事件 */
 		case BLE_GAP_EVT_CONNECTED:
 			NRF_LOG_INFO("Connected");
 			m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
@@ -792,7 +792,7 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 			ble_conn_handler();
 			break;
 		
-		/* ӶϿ¼ */
+		/* 连接断开事件 */
 		case BLE_GAP_EVT_DISCONNECTED:
 			NRF_LOG_INFO("Disconnected");
 			m_conn_handle = BLE_CONN_HANDLE_INVALID;
@@ -808,7 +808,7 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 			APP_ERROR_CHECK(err_code);
 			break;
 
-		/* PHY¼ */
+		/* PHY更新事件 */
 		case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
 		{
 			NRF_LOG_DEBUG("PHY update request.");
@@ -827,7 +827,7 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 			APP_ERROR_CHECK(err_code);
 			break;
 
-		/* GATTͻ˳ʱ¼ */
+		/* GATT客户端超时事件 */
 		case BLE_GATTC_EVT_TIMEOUT:
 			// Disconnect on GATT Client timeout event.
 			NRF_LOG_DEBUG("GATT Client Timeout.");
@@ -837,7 +837,7 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 			ble_disconn_handler();
 			break;
 
-		/* GATTʱ¼ */
+		/* GATT服务器超时事件 */
 		case BLE_GATTS_EVT_TIMEOUT:
 			// Disconnect on GATT Server timeout event.
 			NRF_LOG_DEBUG("GATT Server Timeout.");
@@ -865,22 +865,22 @@ static void ble_stack_init(void)
 {
 	ret_code_t err_code;
 	
-	/* ʹsofdevicesdk_config.hļеƵʱõƵʱ */
+	/* 请求使能sofdevice，根据sdk_config.h文件中低频时钟设置来配置低频时钟 */
 	err_code = nrf_sdh_enable_request();
 	APP_ERROR_CHECK(err_code);
 
-	/* 屣ӦóRAMʼַı */
+	/* 定义保存应用程序RAM起始地址的变量 */
 	uint32_t ram_start = 0;
-	/* ʹsdk_config.hļĬòЭջȡӦóRAMʼַ
-		 浽ram_start */
+	/* 使用sdk_config.h文件的默认配置参数配置协议栈，获取应用程序RAM起始地址
+		 保存到变量ram_start */
 	err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
 	APP_ERROR_CHECK(err_code);
 
-	/* ʹBLEЭջ */
+	/* 使能BLE协议栈 */
 	err_code = nrf_sdh_ble_enable(&ram_start);
 	APP_ERROR_CHECK(err_code);
 
-	/* עBLE¼ص  */
+	/* 注册BLE事件回调函数  */
 	NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
 }
 
@@ -964,12 +964,12 @@ void BLE_Init(void)
 	ble_param.max_conn_interval = param->ble_max_conn_interval;
 	ble_param.conn_sup_timeout = param->ble_conn_timeout;
 	
-	ble_stack_init(); //BLEЭջʼ
-	gap_params_init(); //GAPʼ
-	gatt_init(); //GATTʼ
-	services_init(); //ʼ
-	advertising_init(); //㲥ʼ
-	conn_params_init(); //Ӳʼ
+	ble_stack_init(); //BLE协议栈初始化
+	gap_params_init(); //GAP参数初始化
+	gatt_init(); //GATT初始化
+	services_init(); //服务初始化
+	advertising_init(); //广播初始化
+	conn_params_init(); //连接参数初始化
 	
 	ble_characteristic_update.ble_tx_power_update(param->ble_tx_power);
 	ble_characteristic_update.ble_adv_interval_update(param->ble_adv_interval);
@@ -0,0 +1,401 @@
+#include "block_transfer.h"
+#include "string.h"
+#include "app_util.h"
+#include "uart_svc.h"
+#include "lora_transmission.h"
+#include "wireless_comm_services.h"
+#include "host_net_swap.h"
+#include "mono_clock.h"
+#include "rx_filter.h"
+#include "string_operate.h"
+#include "vib_feature.h"
+
+
+/*
+ * 确认帧在收到请求确认的分片后立即回复，测点此时打开接收窗口；转发主机的数据量较大(115200波特率下3K约270ms)，
+ * 放到Proc中在确认之后执行，避免测点接收窗口超时。
+ * dev_ctrl 0X10开启后C9测点的波形块先在Proc中逐步提取特征，只发送特征记录，
+ * 峰值超过该测点x/y/z_thres(单位g)或无法提取特征时才转发原始数据。
+ *
+ * 特征记录：f200:<长地址> <块序号> <每轴采样点数> <FFT点数>，之后按X、Y、Z轴依次为
+ * <有效值> <峰值> <峰值因子> <频带1~4有效值>，单位mg，以\n结束。
+ */
+
+#define BLOCK_ACK_DATA_LEN					7 //确认帧数据段中网关长地址之后的长度
+
+STATIC_ASSERT(BLOCK_FRAG_MAX <= 32); //已收分片位图为32位
+
+static BlockTransfer_t block_transfer;
+static uint8_t forward_flag[BLOCK_POOL_NUMS]; //已收齐等待转发主机
+static uint8_t feature_index = BLOCK_POOL_NUMS; //正在提取特征的会话，BLOCK_POOL_NUMS表示没有
+
+static uint32_t block_full_map(uint8_t frag_nums)
+{
+	return frag_nums >= 32 ? 0XFFFFFFFF : ((1UL << frag_nums) - 1);
+}
+
+static void block_ack_send(uint8_t* long_addr, uint8_t block_id, uint8_t frag_nums, uint8_t status, uint32_t frag_map)
+{
+	extern lora_reply_data_t lora_reply_data;
+	uint8_t data[BLOCK_ACK_DATA_LEN];
+	
+#if COMM_TRANSMISSION_MSB == 1
+	frag_map = swap_htonl(frag_map);
+#endif
+	data[0] = block_id;
+	data[1] = frag_nums;
+	data[2] = status;
+	memcpy(&data[3], (uint8_t*)&frag_map, sizeof(frag_map));
+	
+	memcpy(lora_reply_data.long_addr, long_addr, 8);
+	Lora_TestCmdReply(CMD_BLOCK_ACK, data, sizeof(data));
+	
+	block_transfer.stat.ack_nums++;
+	block_transfer.stat.down_airtime_ms += (LORA_TimeOnAirUs(16 + sizeof(data) + RX_FILTER_FRAME_OVERHEAD) + 999) / 1000;
+}
+
+//会话回收：空闲优先，其次已收齐且已转发的会话，最后是超时未收齐的会话，都没有返回NULL
+static block_session_t* block_session_alloc(uint32_t now)
+{
+	block_session_t* session;
+	block_session_t* done = NULL;
+	block_session_t* stale = NULL;
+	
+	for(int i = 0; i < BLOCK_POOL_NUMS; i++)
+	{
+		session = &block_transfer.session[i];
+		if(session->state == BLOCK_SESSION_FREE)
+		{
+			return session;
+		}
+		
+		if(session->state == BLOCK_SESSION_DONE && !forward_flag[i])
+		{
+			if(done == NULL || session->last_time - done->last_time > 0X7FFFFFFF)
+			{
+				done = session;
+			}
+		}
+		else if(session->state == BLOCK_SESSION_RECV && now - session->last_time >= BLOCK_SESSION_TIMEOUT)
+		{
+			stale = session;
+		}
+	}
+	
+	if(done != NULL)
+	{
+		return done;
+	}
+	
+	if(stale != NULL)
+	{
+		block_transfer.stat.timeout_nums++;
+	}
+	return stale;
+}
+
+//同一测点可能有一个等待转发的已收齐块和一个重组中的块，块序号相同的优先，其次是重组中的会话，等待转发的会话最后
+static block_session_t* block_session_find(uint8_t* long_addr, uint8_t block_id)
+{
+	block_session_t* session;
+	block_session_t* other = NULL;
+	
+	for(int i = 0; i < BLOCK_POOL_NUMS; i++)
+	{
+		session = &block_transfer.session[i];
+		if(session->state != BLOCK_SESSION_FREE && memcmp(session->long_addr, long_addr, 8) == 0)
+		{
+			if(session->block_id == block_id)
+			{
+				return session;
+			}
+			
+			if(other == NULL || forward_flag[other - block_transfer.session] ||
+			   (!forward_flag[i] && session->state == BLOCK_SESSION_RECV))
+			{
+				other = session;
+			}
+		}
+	}
+	
+	return other;
+}
+
+static void block_session_start(block_session_t* session, uint8_t* long_addr, uint8_t block_id,
+								uint8_t frag_nums, uint16_t block_len, uint32_t now)
+{
+	session->state = BLOCK_SESSION_RECV;
+	memcpy(session->long_addr, long_addr, 8);
+	session->block_id = block_id;
+	session->frag_nums = frag_nums;
+	session->frame_nums = 0;
+	session->block_len = block_len;
+	session->frag_map = 0;
+	session->start_time = now;
+	session->last_time = now;
+	forward_flag[session - block_transfer.session] = 0;
+}
+
+static void block_forward(block_session_t* session)
+{
+	char addr[17];
+	uint16_t crc = Wireless_CommSvcGetHandle()->modbusRtuCRC(session->buf, session->block_len);
+	
+	bytes_to_hex_string(session->long_addr, addr, 8, 0);
+	printf("b200:%s %d %d %d %d %u\n", addr, session->block_id, session->block_len, crc,
+		   session->frame_nums, session->last_time - session->start_time);
+	uart_send(session->buf, session->block_len);
+	printf("\n");
+}
+
+static void BlockTransfer_Frag(uint8_t* p_frame, uint8_t size)
+{
+	uint32_t now = Mono_ClockGetMs();
+	uint8_t* long_addr = &p_frame[RX_FILTER_ADDR_OFFSET];
+	block_session_t* session;
+	uint8_t block_id, index, frag_nums, flags, frag_len;
+	uint16_t block_len;
+	
+	if(size < RX_FILTER_FRAME_OVERHEAD + BLOCK_FRAG_HEAD_LEN || p_frame[4] < BLOCK_FRAG_HEAD_LEN)
+	{
+		return;
+	}
+	
+	block_transfer.stat.frag_nums++;
+	block_transfer.stat.up_airtime_ms += (LORA_TimeOnAirUs(size) + 999) / 1000;
+	
+	block_id = p_frame[13];
+	index = p_frame[14];
+	frag_nums = p_frame[15];
+	flags = p_frame[16];
+	memcpy((uint8_t*)&block_len, &p_frame[17], sizeof(block_len));
+#if COMM_TRANSMISSION_MSB == 1
+	block_len = swap_ntohs(block_len);
+#endif
+	frag_len = p_frame[4] - BLOCK_FRAG_HEAD_LEN;
+	
+	if(block_len == 0 || block_len > BLOCK_MAX_SIZE || index >= frag_nums ||
+	   frag_nums != (block_len + BLOCK_FRAG_SIZE - 1) / BLOCK_FRAG_SIZE)
+	{
+		if(flags & BLOCK_FLAG_ACK_REQ)
+		{
+			block_ack_send(long_addr, block_id, frag_nums, BLOCK_ACK_REJECT, 0);
+		}
+		return;
+	}
+	
+	//测点开始新的块时放弃该测点未收齐的旧块
+	session = block_session_find(long_addr, block_id);
+	if(session != NULL && session->block_id != block_id && !forward_flag[session - block_transfer.session])
+	{
+		if(session->state == BLOCK_SESSION_RECV)
+		{
+			block_transfer.stat.timeout_nums++;
+		}
+		block_session_start(session, long_addr, block_id, frag_nums, block_len, now);
+	}
+	else if(session == NULL || session->block_id != block_id)
+	{
+		//旧块已收齐仍等待转发时另取会话，转发只在Proc中进行，不占用确认时机
+		session = block_session_alloc(now);
+		if(session == NULL)
+		{
+			block_transfer.stat.busy_nums++;
+			if(flags & BLOCK_FLAG_ACK_REQ)
+			{
+				block_ack_send(long_addr, block_id, frag_nums, BLOCK_ACK_BUSY, 0);
+			}
+			return;
+		}
+		block_session_start(session, long_addr, block_id, frag_nums, block_len, now);
+	}
+	
+	session->last_time = now;
+	if(session->state == BLOCK_SESSION_DONE)
+	{
+		//确认帧丢失，测点重发了已收齐块的分片
+		block_transfer.stat.dup_nums++;
+	}
+	else if(session->frag_map & (1UL << index))
+	{
+		block_transfer.stat.dup_nums++;
+		session->frame_nums++;
+	}
+	else if(frag_len == ((index == frag_nums - 1) ? block_len - index * BLOCK_FRAG_SIZE : BLOCK_FRAG_SIZE))
+	{
+		memcpy(&session->buf[index * BLOCK_FRAG_SIZE], &p_frame[RX_FILTER_ADDR_OFFSET + BLOCK_FRAG_HEAD_LEN], frag_len);
+		session->frag_map |= 1UL << index;
+		session->frame_nums++;
+		
+		if(session->frag_map == block_full_map(session->frag_nums))
+		{
+			session->state = BLOCK_SESSION_DONE;
+			forward_flag[session - block_transfer.session] = 1;
+			block_transfer.stat.block_nums++;
+			block_transfer.stat.byte_nums += session->block_len;
+			block_transfer.stat.elapsed_ms += now - session->start_time;
+		}
+	}
+	
+	if(flags & BLOCK_FLAG_ACK_REQ)
+	{
+		block_ack_send(long_addr, session->block_id, session->frag_nums,
+					   session->state == BLOCK_SESSION_DONE ? BLOCK_ACK_COMPLETE : BLOCK_ACK_RECEIVING, session->frag_map);
+	}
+}
+
+//阈值取主机为该测点设置的目标值，测点未连接返回0
+static uint8_t block_thres_get(uint8_t* long_addr, float* thres)
+{
+	extern peer_data_t peer_data;
+	peer_attr_t* peer;
+	
+	for(int i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		peer = &peer_data.peer_attr[i];
+		if(memcmp(peer->long_addr, long_addr, 8) == 0)
+		{
+			thres[0] = peer->cfg.x_thres;
+			thres[1] = peer->cfg.y_thres;
+			thres[2] = peer->cfg.z_thres;
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+static void block_feature_print(block_session_t* session, VibFeature_t* feature)
+{
+	static char line[256];
+	vib_axis_feature_t* axis;
+	str_buf_t sb;
+	
+	str_buf_init(&sb, line, sizeof(line));
+	str_buf_append_str(&sb, "f200:");
+	str_buf_append_hex(&sb, session->long_addr, 8, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, session->block_id, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, feature->sample_nums, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, feature->fft_size, 0);
+	for(int i = 0; i < VIB_FEATURE_AXIS_NUMS; i++)
+	{
+		axis = &feature->feature[i];
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_fixed(&sb, axis->rms, 1);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_fixed(&sb, axis->peak, 1);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_fixed(&sb, axis->crest, 2);
+		for(int j = 0; j < VIB_FEATURE_BAND_NUMS; j++)
+		{
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_fixed(&sb, axis->band_rms[j], 1);
+		}
+	}
+	str_buf_append_char(&sb, '\n');
+	printf("%s", line);
+}
+
+//返回0：特征提取中，1：转发原始数据，2：只发送特征
+static uint8_t block_feature(uint8_t index)
+{
+	extern ctrl_class_t ctrl_class;
+	VibFeature_t* feature = VibFeature_GetHandle();
+	block_session_t* session = &block_transfer.session[index];
+	float thres[VIB_FEATURE_AXIS_NUMS];
+	
+	if(!(ctrl_class.dev_ctrl & 0X10) || session->long_addr[0] != 0XC9)
+	{
+		return 1;
+	}
+	
+	if(feature_index != index)
+	{
+		if(feature_index < BLOCK_POOL_NUMS)
+		{
+			return 0; //其他块提取中
+		}
+		if(feature->Start(session->buf, session->block_len) == 0)
+		{
+			return 1;
+		}
+		feature_index = index;
+	}
+	
+	if(feature->Step() == 0)
+	{
+		return 0;
+	}
+	
+	feature_index = BLOCK_POOL_NUMS;
+	feature->Stop();
+	block_feature_print(session, feature);
+	
+	if(block_thres_get(session->long_addr, thres) == 0 || feature->Exceed(thres))
+	{
+		feature->stat.raw_nums++;
+		return 1;
+	}
+	
+	feature->stat.saved_bytes += session->block_len;
+	return 2;
+}
+
+static void BlockTransfer_Proc(void)
+{
+	uint32_t now = Mono_ClockGetMs();
+	block_session_t* session;
+	uint8_t result;
+	uint8_t i;
+	
+	//正在提取特征的块优先
+	for(int n = 0; n < BLOCK_POOL_NUMS; n++)
+	{
+		i = (feature_index < BLOCK_POOL_NUMS) ? (feature_index + n) % BLOCK_POOL_NUMS : n;
+		session = &block_transfer.session[i];
+		if(forward_flag[i])
+		{
+			result = block_feature(i);
+			if(result == 0)
+			{
+				return;
+			}
+			
+			forward_flag[i] = 0;
+			if(result == 1)
+			{
+				block_forward(session);
+			}
+			return; //每次调用最多转发一块
+		}
+		
+		if(session->state == BLOCK_SESSION_RECV && now - session->last_time >= BLOCK_SESSION_TIMEOUT)
+		{
+			session->state = BLOCK_SESSION_FREE;
+			block_transfer.stat.timeout_nums++;
+		}
+	}
+}
+
+BlockTransfer_t* BlockTransfer_Init(void)
+{
+	memset(&block_transfer, 0, sizeof(block_transfer));
+	memset(forward_flag, 0, sizeof(forward_flag));
+	feature_index = BLOCK_POOL_NUMS;
+	VibFeature_Init();
+	
+	block_transfer.Frag = BlockTransfer_Frag;
+	block_transfer.Proc = BlockTransfer_Proc;
+	
+	return &block_transfer;
+}
+
+BlockTransfer_t* BlockTransfer_GetHandle(void)
+{
+	return &block_transfer;
+}
+
+
@@ -0,0 +1,79 @@
+#ifndef __BLOCK_TRANSFER_H__
+#define __BLOCK_TRANSFER_H__
+#include "main.h"
+
+
+/*
+ * 块传输：C9测点波形等超过单帧长度的数据，测点按固定长度分片发送，网关在缓存池中重组，
+ * 按选择确认位图回复，测点只重发缺失分片，收齐后网关一次性转发主机。
+ *
+ * 测点分片帧CMD_BLOCK数据段：长地址8+块序号1+分片序号1+分片个数1+标志1+块长度2(网络字节序)+分片数据
+ * 分片数据长度固定为BLOCK_FRAG_SIZE，最后一片为剩余长度。标志0X01表示本轮最后一片，测点发完后打开接收窗口。
+ * 网关收到本轮最后一片(或块已收齐)后回复CMD_BLOCK_ACK，数据段：测点长地址8+网关长地址8+
+ * 块序号1+分片个数1+状态1+已收分片位图4(网络字节序，bit n为分片n)。测点按位图重发缺失分片，
+ * 重发轮次的最后一片同样带标志0X01。
+ *
+ * 转发主机记录：b200:<长地址> <块序号> <块长度> <块CRC16> <分片帧数> <用时ms>\n 之后紧跟块长度字节的原始数据与\n
+ */
+
+#define BLOCK_FRAG_SIZE						176 //分片数据长度，分片帧长度197不超过LoraMTU(200)
+#define BLOCK_MAX_SIZE						3072 //单块最大长度，data_points=512的3轴16位采样
+#define BLOCK_FRAG_MAX						((BLOCK_MAX_SIZE + BLOCK_FRAG_SIZE - 1) / BLOCK_FRAG_SIZE) //单块最多分片数
+#define BLOCK_POOL_NUMS						2 //同时重组的块数
+#define BLOCK_SESSION_TIMEOUT				30000u //超过该时间(ms)没有收到分片的重组会话可被回收
+#define BLOCK_FRAG_HEAD_LEN					14 //分片帧数据段中分片数据之前的长度
+
+#define BLOCK_FLAG_ACK_REQ					0X01 //本轮最后一片，请求确认
+
+/* 确认状态 */
+#define BLOCK_ACK_RECEIVING					0X00 //重组中，按位图重发缺失分片
+#define BLOCK_ACK_COMPLETE					0X01 //已收齐并转发主机
+#define BLOCK_ACK_BUSY						0X02 //缓存池已满，稍后重发整块
+#define BLOCK_ACK_REJECT					0X03 //块长度或分片个数超出上限
+
+typedef enum {
+	BLOCK_SESSION_FREE, //空闲
+	BLOCK_SESSION_RECV, //重组中
+	BLOCK_SESSION_DONE, //已收齐，保留块序号用于重复分片的确认
+}BlockSession_State;
+
+typedef struct {
+	BlockSession_State state;
+	uint8_t long_addr[8];
+	uint8_t block_id; //块序号
+	uint8_t frag_nums; //分片个数
+	uint8_t frame_nums; //收到的分片帧数(含重复)
+	uint16_t block_len; //块长度
+	uint32_t frag_map; //已收分片位图
+	uint32_t start_time; //收到第一个分片的时间，单位ms
+	uint32_t last_time; //最近一次收到分片的时间，单位ms
+	uint8_t buf[BLOCK_MAX_SIZE];
+}block_session_t;
+
+typedef struct {
+	uint32_t block_nums; //转发主机的块数
+	uint32_t byte_nums; //转发主机的字节数
+	uint32_t frag_nums; //收到的分片帧数
+	uint32_t dup_nums; //重复分片帧数
+	uint32_t ack_nums; //确认帧数
+	uint32_t busy_nums; //缓存池满拒绝次数
+	uint32_t timeout_nums; //未收齐即回收的会话数
+	uint32_t up_airtime_ms; //分片帧累计空中时间
+	uint32_t down_airtime_ms; //确认帧累计空中时间
+	uint32_t elapsed_ms; //已转发块从第一片到收齐的累计时间
+}block_transfer_stat_t;
+
+typedef struct {
+	block_session_t session[BLOCK_POOL_NUMS];
+	block_transfer_stat_t stat;
+	
+	void (*Frag)(uint8_t* p_frame, uint8_t size); //收到分片帧
+	void (*Proc)(void);
+}BlockTransfer_t;
+
+BlockTransfer_t* BlockTransfer_Init(void);
+BlockTransfer_t* BlockTransfer_GetHandle(void);
+
+#endif
+
+
@@ -1,205 +1,96 @@
 #include "calendar.h"
 #include "time.h"
-#include "nrf_drv_rtc.h"
-#include "nrf_drv_clock.h"
-#include "nrfx_rtc.h"
 #include "string.h"
+#include "string_operate.h"
+#include "mono_clock.h"
 
 
 static Calendar_t m_calendar;
 static Date_t m_time;
-static uint8_t m_time_count_1s = 0;
-volatile time_t m_timestamp = 0;
+static time_t m_time_stamp = ~0u; //m_time对应的时间戳，读取日期时才重新计算
+static time_t m_timestamp_base = 0; //校时时间戳
+static uint64_t m_ticks_base = 0; //校时时刻的单调时钟计数值
 
-const nrf_drv_rtc_t rtc = NRF_DRV_RTC_INSTANCE(2); /**< Declaring an instance of nrf_drv_rtc for RTC2. */
-const char Days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-
-#if RTC_SECONED_INT_EN != 1	
-volatile uint32_t m_ticks = 0;
-volatile uint32_t m_pre_count = 0;
-static uint32_t m_timestamp_base = 0;
-#endif
 
+/* 东八区时间比格林尼治时间快8个小时 */
+#define CALENDAR_TIME_ZONE_OFFSET	(3600 * 8)
+#define CALENDAR_SECONDS_PER_DAY	86400u
+#define CALENDAR_EPOCH_DAYS			719468u //0000-03-01到1970-01-01的天数
+#define CALENDAR_DAYS_PER_ERA		146097u //400年的天数
 
 /* time:0->1970-1-1-8:0:0 */
+/* 按400年周期直接换算，以3月为一年的开始使闰日落在年末，无循环 */
 void Calendar_TimeStampToDate(time_t time, Date_t* date)
 {
-	unsigned int Pass4year;
-	int hours_per_year;
-
-	/* ʱȸʱ8Сʱ */
-	time += (3600 * 8);
-	
-	date->Second=(int)(time % 60); //ȡʱ
-	time /= 60;
-	
-	date->Minute=(int)(time % 60); //ȡʱ
-	time /= 60;
-	
-	Pass4year=((unsigned int)time / (1461L * 24L)); //ȡȥٸ꣬ÿ 1461*24 Сʱ
-	date->Year=(Pass4year << 2) + 1970; //
-	time %= 1461L * 24L; //ʣµСʱ
-	
-	//УӰݣһʣµСʱ
-	for (;;)
-	{
-		hours_per_year = 365 * 24; //һСʱ
-		
-		//ж
-		if ((date->Year & 3) == 0)
-		{
-			hours_per_year += 24; //꣬һ24Сʱһ
-		}
-		
-		if (time < hours_per_year)
-		{
-			break;
-		}
-		
-		date->Year++;
-		time -= hours_per_year;
-	}
+	time += CALENDAR_TIME_ZONE_OFFSET;
 	
-	date->Hour=(int)(time % 24); //Сʱ
+	uint32_t secs = time % CALENDAR_SECONDS_PER_DAY; //一天中的秒数
+	uint32_t days = time / CALENDAR_SECONDS_PER_DAY + CALENDAR_EPOCH_DAYS;
 	
-	time /= 24; //һʣµ
-	time++; //ٶΪ
+	date->Hour = secs / 3600;
+	secs %= 3600;
+	date->Minute = secs / 60;
+	date->Second = secs % 60;
 	
-	//У·ݣ
-	if((date->Year & 3) == 0)
-	{
-		if (time > 60)
-		{
-			time--;
-		}
-		else
-		{
-			if (time == 60)
-			{
-				date->Month = 1;
-				date->Day = 29;
-				return ;
-			}
-		}
-	}
+	uint32_t era = days / CALENDAR_DAYS_PER_ERA; //400年周期数
+	uint32_t doe = days - era * CALENDAR_DAYS_PER_ERA; //周期内的天数[0, 146096]
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; //周期内的年数[0, 399]
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100); //从3月1日开始的天数[0, 365]
+	uint32_t mp = (5 * doy + 2) / 153; //从3月开始的月份[0, 11]
 	
-	//
-	for (date->Month = 0; Days[date->Month] < time;date->Month++)
-	{
-		time -= Days[date->Month];
-	}
-	
-	date->Month += 1;
-	date->Day = (int)(time);
- 
-	return;
+	date->Day = doy - (153 * mp + 2) / 5 + 1;
+	date->Month = mp < 10 ? mp + 3 : mp - 9;
+	date->Year = yoe + era * 400 + (date->Month <= 2);
 }
 
-static time_t mon_yday[2][12] =
-{
-	{0,31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
-	{0,31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335},
-};
-
-
-int IsLeap(int year)
+/* 1970-1-1-8:0:0->time:0 */
+time_t Calendar_DateToTimeStamp(Date_t* date)
 {
-	return (year) % 4 == 0 && ((year) % 100 != 0 || (year) % 400 == 0);
+	uint32_t year = date->Year - (date->Month <= 2);
+	uint32_t era = year / 400;
+	uint32_t yoe = year - era * 400;
+	uint32_t doy = (153 * (date->Month > 2 ? date->Month - 3 : date->Month + 9) + 2) / 5 + date->Day - 1;
+	uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	uint32_t days = era * CALENDAR_DAYS_PER_ERA + doe - CALENDAR_EPOCH_DAYS;
+	
+	return days * CALENDAR_SECONDS_PER_DAY + date->Hour * 3600 + date->Minute * 60 + date->Second
+		   - CALENDAR_TIME_ZONE_OFFSET;
 }
 
-/* 1970-1-1-8:0:0->time:0 */
-time_t Calendar_DateToTimeStamp(Date_t* date)
+/* 单调时钟计数值换算为时间戳，用于帧接收时刻等事件时间 */
+time_t Calendar_TicksToTimeStamp(uint64_t ticks)
 {
-	time_t result;
-	int i =0;
-	
-	//ƽʱ
-	result = (date->Year - 1970) * 365 * 24 * 3600 +
-			 (mon_yday[IsLeap(date->Year)][date->Month-1] + date->Day - 1) * 24 * 3600 +
-			  date->Hour * 3600 + date->Minute * 60 + date->Second;
-	
-	for(i=1970; i < date->Year; i++) // 
+	if(ticks < m_ticks_base)
 	{
-		if(IsLeap(i))
-		{
-			result += 24 * 3600;
-		}
+		return m_timestamp_base - (time_t)((m_ticks_base - ticks + MONO_CLOCK_FREQ - 1) / MONO_CLOCK_FREQ);
 	}
 	
-	/* ʱȸʱ8Сʱ */
-	result -= (3600 * 8);
-	
-	return(result);
+	return m_timestamp_base + (time_t)((ticks - m_ticks_base) / MONO_CLOCK_FREQ);
 }
 
-/** @brief: Function for handling the RTC2 interrupts.
- * Triggered on TICK and COMPARE0 match.
- */
-static void Calendar_RTCHandler(nrf_drv_rtc_int_type_t int_type)
+static time_t Calendar_GetTimeStamp(void)
 {
-	if(int_type == NRF_DRV_RTC_INT_COMPARE0)
-	{
-	}
-	else if (int_type == NRF_DRV_RTC_INT_TICK)
-	{
-		if(m_time_count_1s >=7 )//?D????125ms???125*8 =1000s
-		{
-				m_time_count_1s = 0;
-				m_timestamp++;
-				Calendar_TimeStampToDate(m_timestamp, &m_time);
-		}
-		else
-		{
-				m_time_count_1s++;
-		}
-	}
+	return Calendar_TicksToTimeStamp(Mono_ClockGetTicks());
 }
 
-#if RTC_SECONED_INT_EN != 1
-#define MAX_RTC2_COUNTER_VAL     0x00FFFFFF 
-static uint32_t ticks_elapse_get(void)
+static Date_t* Calendar_GetDate(void)
 {
-	uint32_t count = NRF_RTC2->COUNTER & MAX_RTC2_COUNTER_VAL;
-	uint32_t elapse = count - m_pre_count;
-	m_pre_count = count;
-	if(count > 0X007FFFFF)
+	time_t time = Calendar_GetTimeStamp();
+	
+	if(time != m_time_stamp)
 	{
-		m_pre_count = 0;
-		nrf_drv_rtc_counter_clear(&rtc);
+		m_time_stamp = time;
+		Calendar_TimeStampToDate(time, &m_time);
 	}
-	return elapse;
-}
-#endif
-
-#if RTC_SECONED_INT_EN == 1	
-static time_t Calendar_GetTimeStamp(void)
-{
-	return m_timestamp;
-}
-#else
-time_t Calendar_GetTimeStamp(void)
-{
-	m_ticks += ticks_elapse_get();
-	m_timestamp = m_timestamp_base + m_ticks / 8;
-	Calendar_TimeStampToDate(m_timestamp, &m_time);
-	return m_timestamp;
+	
+	return &m_time;
 }
-#endif
 
-#if RTC_SECONED_INT_EN == 1	
-static void Calendar_SetTimeStamp(time_t TimeStamp)
-{
-	m_timestamp = TimeStamp;
-}
-#else
 static void Calendar_SetTimeStamp(time_t TimeStamp)
 {
-	m_ticks = 0;
-	m_pre_count = 0;
-	nrf_drv_rtc_counter_clear(&rtc);
+	m_ticks_base = Mono_ClockGetTicks();
 	m_timestamp_base = TimeStamp;
 }
-#endif
 
 char* calendar_ctime(const unsigned int *timep)
 {
@@ -208,60 +99,29 @@ char* calendar_ctime(const unsigned int *timep)
 	Calendar_TimeStampToDate(*timep, &date);
 	
 	static char buf[25];
-	uint8_t i = 0;
-    sprintf(&buf[i], "%0*d", 4, date.Year); //ñݵĿ
-	i += 4;
-	buf[i] = '-';
-	i += 1;
-	sprintf(&buf[i], "%0*d", 2, date.Month);
-	i += 2;
-	buf[i] = '-';
-	i += 1;
-	sprintf(&buf[i], "%0*d", 2, date.Day);
-	i += 2;
-	buf[i] = ' ';
-	i += 1;
-	sprintf(&buf[i], "%0*d", 2, date.Hour);
-	i += 2;
-	buf[i] = ':';
-	i += 1;
-	sprintf(&buf[i], "%0*d", 2, date.Minute);
-	i += 2;
-	buf[i] = ':';
-	i += 1;
-	sprintf(&buf[i], "%0*d", 2, date.Second);
-	i += 2;
-	buf[i] = '\0';
+	str_buf_t sb;
+	str_buf_init(&sb, buf, sizeof(buf));
+	
+	str_buf_append_uint(&sb, date.Year, 4);
+	str_buf_append_char(&sb, '-');
+	str_buf_append_uint(&sb, date.Month, 2);
+	str_buf_append_char(&sb, '-');
+	str_buf_append_uint(&sb, date.Day, 2);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, date.Hour, 2);
+	str_buf_append_char(&sb, ':');
+	str_buf_append_uint(&sb, date.Minute, 2);
+	str_buf_append_char(&sb, ':');
+	str_buf_append_uint(&sb, date.Second, 2);
 	return buf;
 }
 
-/** @brief Function initialization and configuration of RTC driver instance.
- */
-static void Calendar_RTC2Config(void)
-{
-	uint32_t err_code;
-			
-	//Initialize RTC instance
-	nrf_drv_rtc_config_t config = NRF_DRV_RTC_DEFAULT_CONFIG;
-	config.prescaler = 4095; 
-	
-	err_code = nrf_drv_rtc_init(&rtc, &config, Calendar_RTCHandler);
-	APP_ERROR_CHECK(err_code);
-
-#if RTC_SECONED_INT_EN == 1	
-	//Enable tick event & interrupt
-	nrf_drv_rtc_tick_enable(&rtc, true);
-#endif
-	
-	//Power on RTC instance
-	nrf_drv_rtc_enable(&rtc);
-}
-
+/* 需在Mono_ClockInit之后调用 */
 void Calendar_Init(void)
 {
-	Calendar_RTC2Config();
+	m_ticks_base = Mono_ClockGetTicks();
 	
-	m_calendar.Date = &m_time;
+	m_calendar.GetDate = Calendar_GetDate;
 	m_calendar.GetTimeStamp = Calendar_GetTimeStamp;
 	m_calendar.SetTimeStamp = Calendar_SetTimeStamp;
 }
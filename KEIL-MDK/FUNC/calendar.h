@@ -3,29 +3,27 @@
 #include "main.h"
 
 
-#define	RTC_SECONED_INT_EN			0 /* RTCжʹ */
-
 typedef unsigned int time_t;
  
 typedef struct{
-	int Second; /*  C ȡֵΪ[0,59] */
-	int Minute; /*  - ȡֵΪ[0,59] */
-	int Hour; /* ʱ - ȡֵΪ[0,23] */
-	int Day; /* һе - ȡֵΪ[1,31] */
-	int Month; /* · - ȡֵΪ[1,12] */
-	int Year; /*  - ȡֵΪ[1970.1.1,] */
+	int Second; /* 秒 – 取值区间为[0,59] */
+	int Minute; /* 分 - 取值区间为[0,59] */
+	int Hour; /* 时 - 取值区间为[0,23] */
+	int Day; /* 一个月中的日期 - 取值区间为[1,31] */
+	int Month; /* 月份 - 取值区间为[1,12] */
+	int Year; /* 年份 - 取值区间为[1970.1.1,。。。] */
 }Date_t;
 
 typedef struct{
-	Date_t* Date;
+	Date_t* (*GetDate)(void); //读取当前日期，时间戳变化后才重新换算
 	
-	uint32_t (*GetTicks)(void);
 	time_t (*GetTimeStamp)(void);
 	void (*SetTimeStamp)(time_t TimeStamp);
 }Calendar_t;
 
 void Calendar_TimeStampToDate(time_t time, Date_t* date);
 time_t Calendar_DateToTimeStamp(Date_t* date);
+time_t Calendar_TicksToTimeStamp(uint64_t ticks);
 char* calendar_ctime(const unsigned int *timep);
 
 void Calendar_Init(void);
@@ -5,6 +5,14 @@
 #include "uart_svc.h"
 #include "calendar.h"
 #include "sys_param.h"
+#include "uplink_journal.h"
+#include "sx1262.h"
+#include "radio_time.h"
+#include "rx_filter.h"
+#include "link_sweep.h"
+#include "group_ack.h"
+#include "block_transfer.h"
+#include "vib_feature.h"
 
 
 typedef int (*data_parse_t)(uint8_t* data, uint8_t size);
@@ -17,9 +25,26 @@ const char cmd_attr_value_end_mark = ' ';
 const char* cmd_type[] = {
 	"w200",
 	"w201",
+	"w202",
+	"r200",
+	"r201",
+	"r202",
+	"w203",
+	"r203",
+	"r204",
+	"r205",
 };
 
-#define W200_ATTR_NUMS		21
+#define CMD_TYPE_W202		2 //w202:主机确认上行数据日志序号
+#define CMD_TYPE_R200		3 //r200:主机读取测点缓存数据
+#define CMD_TYPE_R201		4 //r201:主机读取射频时间统计
+#define CMD_TYPE_R202		5 //r202:主机读取测点帧计数与丢包统计
+#define CMD_TYPE_W203		6 //w203:主机启动/终止链路扫描
+#define CMD_TYPE_R203		7 //r203:主机读取链路扫描结果
+#define CMD_TYPE_R204		8 //r204:主机读取组确认广播统计
+#define CMD_TYPE_R205		9 //r205:主机读取块传输统计
+
+#define W200_ATTR_NUMS		22
 
 const char* cmd_w200_attr_tb[] = {
 	"long_addr",
@@ -42,6 +67,7 @@ const char* cmd_w200_attr_tb[] = {
 	"lora_power",
 	"lora_bw",
 	"lora_sf",
+	"lora_sync",
 	"dev_param",
 };
 
@@ -55,10 +81,18 @@ const char* cmd_w200_print_ctrl_tb[] = {
 	"reply_close",
 };
 
-#define W200_DEV_CTRL_NUMS	2
+#define W200_DEV_CTRL_NUMS	10
 const char* cmd_w200_dev_ctrl_tb[] = {
 	"reply_open",
 	"reply_close",
+	"journal_open",
+	"journal_close",
+	"filter_open",
+	"filter_close",
+	"group_open",
+	"group_close",
+	"feature_open",
+	"feature_close",
 };
 
 const char* cmd_w200_reply_tb[] = {
@@ -88,6 +122,8 @@ const char* cmd_w200_reply_tb[] = {
 	"w200:error code 23,param lora_power setting error:",
 	"w200:error code 24,param lora_bw setting error:",
 	"w200:error code 25,param lora_sf setting error:",
+	"w200:error code 26,param lora_sync setting error:",
+	"w200:error code 27,link sweep setting error:",
 };
 
 const char* cmd_w201_attr_tb[] = {
@@ -107,9 +143,25 @@ const char* cmd_w201_attr_tb[] = {
 
 static int cmd_w200_data_parse(uint8_t* data, uint8_t size);
 static int cmd_w201_data_parse(uint8_t* data, uint8_t size);
+static int cmd_w202_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r200_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r201_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r202_data_parse(uint8_t* data, uint8_t size);
+static int cmd_w203_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r203_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r204_data_parse(uint8_t* data, uint8_t size);
+static int cmd_r205_data_parse(uint8_t* data, uint8_t size);
 data_parse_t data_parse[sizeof(cmd_type) / sizeof(cmd_type[0])] = {
 	cmd_w200_data_parse,
 	cmd_w201_data_parse,
+	cmd_w202_data_parse,
+	cmd_r200_data_parse,
+	cmd_r201_data_parse,
+	cmd_r202_data_parse,
+	cmd_w203_data_parse,
+	cmd_r203_data_parse,
+	cmd_r204_data_parse,
+	cmd_r205_data_parse,
 };
 
 static int cmd_long_addr_attr_set(uint8_t* data, uint8_t size);
@@ -132,6 +184,7 @@ static int cmd_lora_freq_attr_set(uint8_t* data, uint8_t size);
 static int cmd_lora_power_attr_set(uint8_t* data, uint8_t size);
 static int cmd_lora_bw_attr_set(uint8_t* data, uint8_t size);
 static int cmd_lora_sf_attr_set(uint8_t* data, uint8_t size);
+static int cmd_lora_sync_attr_set(uint8_t* data, uint8_t size);
 static int cmd_lora_param_attr_get(uint8_t* data, uint8_t size);
 attr_set_t w200_attr_set[W200_ATTR_NUMS] = {
 	cmd_long_addr_attr_set,
@@ -154,6 +207,7 @@ attr_set_t w200_attr_set[W200_ATTR_NUMS] = {
 	cmd_lora_power_attr_set,
 	cmd_lora_bw_attr_set,
 	cmd_lora_sf_attr_set,
+	cmd_lora_sync_attr_set,
 	cmd_lora_param_attr_get,
 };
 
@@ -187,150 +241,111 @@ static uint8_t w200_reply_mark = 0;
 static char w200_reply_msg[100];
 static uint8_t w200_data_process_mark = 0;
 static uint32_t w200_data_flag = 0;
-static char lora_param[255];
+static char lora_param[400];
 
 static uint16_t m_lora_freq;
 static int8_t m_lora_power;
 static double m_lora_bw;
 static uint8_t m_lora_sf;
+static uint8_t m_lora_sync;
 	
 static double lora_bw_tb[] = {7.81,10.24,15.63,20.83,31.25,41.67,62.5,125,250,500};
 static int cmd_lora_param_attr_get(uint8_t* data, uint8_t size)
 {
 	sys_param_t* param = Sys_ParamGetHandle();
+	str_buf_t sb;
+	str_buf_init(&sb, lora_param, sizeof(lora_param));
 	
-	memset(lora_param, 0X00, sizeof(lora_param));
+	str_buf_append_str(&sb, "lora频率:");
+	str_buf_append_int(&sb, param->lora_freq);
 	
-	uint8_t i = 0;
-	sprintf(lora_param, "%s", "loraƵ:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	int_to_string(param->lora_freq, &lora_param[i], 10);
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = ' ';
+	str_buf_append_str(&sb, " lora功率:");
+	str_buf_append_int(&sb, param->lora_power);
 	
-	sprintf(&lora_param[i+1], "%s", "lora:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	int_to_string(param->lora_power, &lora_param[i], 10);
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = ' ';
-	
-	sprintf(&lora_param[i+1], "%s", "lora:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
+	str_buf_append_str(&sb, " lora带宽:");
 	double bw = lora_bw_tb[param->lora_bw];
 	if(bw < 62.5)
 	{
-		sprintf(&lora_param[i], "%.2f", bw);
+		str_buf_append_fixed(&sb, bw, 2);
 	}
 	else if(bw == 62.5)
 	{
-		sprintf(&lora_param[i], "%.1f", bw);
+		str_buf_append_fixed(&sb, bw, 1);
 	}
 	else
 	{
-		sprintf(&lora_param[i], "%.0f", bw);
+		str_buf_append_fixed(&sb, bw, 0);
 	}
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = ' ';
 	
-	sprintf(&lora_param[i+1], "%s", "loraƵ:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	int_to_string(param->lora_sf, &lora_param[i], 10);
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = ' ';
+	str_buf_append_str(&sb, " lora扩频因子:");
+	str_buf_append_int(&sb, param->lora_sf);
 	
-	sprintf(&lora_param[i+1], "%s", "صַ:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	bytes_to_hex_string(param->dev_gateway_addr, &lora_param[i], sizeof(param->dev_gateway_addr), 0);
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = ' ';
+	str_buf_append_str(&sb, " lora同步字:");
+	str_buf_append_hex(&sb, &param->lora_sync_word, 1, 0);
 	
-	sprintf(&lora_param[i+1], "%s", "汾:");
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	sprintf(&lora_param[i++], "%d", SYS_SW_MAIN_VERSION);
-	lora_param[i++] = '.';
-	sprintf(&lora_param[i++], "%d", SYS_SW_SUB_VERSION);
-	lora_param[i++] = '.';
-	sprintf(&lora_param[i++], "%d", SYS_SW_MODIFY_VERSION);
-	for(i = 0; i < sizeof(lora_param); i++)
-	{
-		if(lora_param[i] == '\0')
-		{
-			break;
-		}
-	}
-	lora_param[i] = '\n';
+	str_buf_append_str(&sb, " 网关地址:");
+	str_buf_append_hex(&sb, param->dev_gateway_addr, sizeof(param->dev_gateway_addr), 0);
+	
+	extern sx1262_drive_t* lora_obj_get(void);
+	sx1262_shadow_t* shadow = &lora_obj_get()->radio_shadow;
+	str_buf_append_str(&sb, " lora配置命令:");
+	str_buf_append_uint(&sb, shadow->sent_nums, 0);
+	str_buf_append_str(&sb, " 省略:");
+	str_buf_append_uint(&sb, shadow->saved_nums, 0);
+	
+	Lora_RadioStat_t* radio_stat = LORA_RadioStatGet();
+	str_buf_append_str(&sb, " 非接收时间(ms):");
+	str_buf_append_uint(&sb, radio_stat->deaf_ms, 0);
+	str_buf_append_str(&sb, " 重新接收:");
+	str_buf_append_uint(&sb, radio_stat->rearm_nums, 0);
+	str_buf_append_str(&sb, " 中断丢失:");
+	str_buf_append_uint(&sb, radio_stat->missed_irq_nums, 0);
+	str_buf_append_str(&sb, " 故障恢复:");
+	str_buf_append_uint(&sb, radio_stat->recover_nums, 0);
+	
+	RxFilter_t* rx_filter = RxFilter_GetHandle();
+	str_buf_append_str(&sb, " 接收通过:");
+	str_buf_append_uint(&sb, rx_filter->nums[RX_FILTER_PASS], 0);
+	str_buf_append_str(&sb, " 丢弃 短帧:");
+	str_buf_append_uint(&sb, rx_filter->nums[RX_FILTER_DROP_SHORT], 0);
+	str_buf_append_str(&sb, " 命令:");
+	str_buf_append_uint(&sb, rx_filter->nums[RX_FILTER_DROP_CMD], 0);
+	str_buf_append_str(&sb, " 长度:");
+	str_buf_append_uint(&sb, rx_filter->nums[RX_FILTER_DROP_LEN], 0);
+	str_buf_append_str(&sb, " 地址:");
+	str_buf_append_uint(&sb, rx_filter->nums[RX_FILTER_DROP_ADDR], 0);
+	
+	str_buf_append_str(&sb, " 软件版本:");
+	str_buf_append_uint(&sb, SYS_SW_MAIN_VERSION, 0);
+	str_buf_append_char(&sb, '.');
+	str_buf_append_uint(&sb, SYS_SW_SUB_VERSION, 0);
+	str_buf_append_char(&sb, '.');
+	str_buf_append_uint(&sb, SYS_SW_MODIFY_VERSION, 0);
+	str_buf_append_char(&sb, '\n');
 	
 	printf("%s",lora_param);
-	w200_reply_mark = 0XFF;//ӡϢ
+	w200_reply_mark = 0XFF;//不打印信息
 	return -1;
 }
 
+//lora_sync:<同步字> 2位16进制，网关与测点一致才能通信
+static int cmd_lora_sync_attr_set(uint8_t* data, uint8_t size)
+{
+	char str[size+1];
+	bytes_to_char(data, str, size);
+	str[size] = '\0';
+	
+	if(size != 2 || is_hex_or_digit(str[0]) == 0 || is_hex_or_digit(str[1]) == 0)
+	{
+		strcpy(w200_reply_msg, str);
+		w200_reply_mark = 27;
+		return -1;
+	}
+	
+	hex_string_to_bytes((const char*)str, &m_lora_sync, size);
+	return 0;
+}
+
 static int cmd_lora_sf_attr_set(uint8_t* data, uint8_t size)
 {
 	char str[size+1];
@@ -519,7 +534,7 @@ static int cmd_long_addr_attr_set(uint8_t* data, uint8_t size)
 	
 	for(int i = 0; i < size; i++)
 	{
-		if(is_hex_or_digit(str[i]) == 0) //жַǷ16ַ
+		if(is_hex_or_digit(str[i]) == 0) //判断字符是否是16进制字符
 		{
 			strcpy(w200_reply_msg, str);
 			w200_reply_mark = 2;
@@ -546,7 +561,7 @@ static int cmd_short_addr_attr_set(uint8_t* data, uint8_t size)
 	
 	for(int i = 0; i < size; i++)
 	{
-		if(is_hex_or_digit(str[i]) == 0) //жַǷ16ַ
+		if(is_hex_or_digit(str[i]) == 0) //判断字符是否是16进制字符
 		{
 			strcpy(w200_reply_msg, str);
 			w200_reply_mark = 3;
@@ -685,7 +700,7 @@ static int cmd_gateway_addr_attr_set(uint8_t* data, uint8_t size)
 	
 	for(int i = 0; i < size; i++)
 	{
-		if(is_hex_or_digit(str[i]) == 0) //жַǷ16ַ
+		if(is_hex_or_digit(str[i]) == 0) //判断字符是否是16进制字符
 		{
 			strcpy(w200_reply_msg, str);
 			w200_reply_mark = 15;
@@ -767,6 +782,38 @@ static int cmd_dev_ctrl_attr_set(uint8_t* data, uint8_t size)
 			{
 				ctrl_class.dev_ctrl &= ~0X01;
 			}
+			else if(i == 2)
+			{
+				ctrl_class.dev_ctrl |= 0X02;
+			}
+			else if(i == 3)
+			{
+				ctrl_class.dev_ctrl &= ~0X02;
+			}
+			else if(i == 4)
+			{
+				ctrl_class.dev_ctrl |= 0X04;
+			}
+			else if(i == 5)
+			{
+				ctrl_class.dev_ctrl &= ~0X04;
+			}
+			else if(i == 6)
+			{
+				ctrl_class.dev_ctrl |= 0X08;
+			}
+			else if(i == 7)
+			{
+				ctrl_class.dev_ctrl &= ~0X08;
+			}
+			else if(i == 8)
+			{
+				ctrl_class.dev_ctrl |= 0X10;
+			}
+			else if(i == 9)
+			{
+				ctrl_class.dev_ctrl &= ~0X10;
+			}
 			break;
 		}
 	}
@@ -786,7 +833,7 @@ static int cmd_w200_attr_value_parse(uint8_t* data, uint8_t size, uint8_t index)
 	uint8_t i;
 	for(i = 0; i < size; i++)
 	{
-		if(*(char*)&data[i] == cmd_attr_value_end_mark) //жֵλ
+		if(*(char*)&data[i] == cmd_attr_value_end_mark) //判断属性值结束位置
 		{
 			break;
 		}
@@ -799,12 +846,12 @@ static int cmd_w200_attr_value_parse(uint8_t* data, uint8_t size, uint8_t index)
 	}
 
 	w200_data_flag |= (1 << index);
-	if(w200_attr_set[index](data, i) < 0) //ֵ
+	if(w200_attr_set[index](data, i) < 0) //保存属性值
 	{
 		return -1;
 	}
 	
-	if(i == size) //ݽ
+	if(i == size) //数据解析完成
 	{
 		return 0;
 	}
@@ -817,7 +864,7 @@ static int cmd_w200_attr_parse(uint8_t* data, uint8_t size)
 	uint8_t i;
 	for(i = 0; i < size; i++)
 	{
-		if(*(char*)&data[i] == cmd_attr_end_mark) //жԽλ
+		if(*(char*)&data[i] == cmd_attr_end_mark) //判断属性结束位置
 		{
 			break;
 		}
@@ -834,14 +881,14 @@ static int cmd_w200_attr_parse(uint8_t* data, uint8_t size)
 	}
 	
 	char str[i+1];
-	bytes_to_char(data, str, i); //
+	bytes_to_char(data, str, i); //拷贝出属性类型
 	str[i] = '\0';
 	
 	for(uint8_t j = 0; j < W200_ATTR_NUMS; j++)
 	{
-		if(strcmp(str, cmd_w200_attr_tb[j]) == 0) //жǷЧ
+		if(strcmp(str, cmd_w200_attr_tb[j]) == 0) //判断属性类型是否有效
 		{
-			int len = cmd_w200_attr_value_parse(&data[i+1], size-i-1, j); //ֵ
+			int len = cmd_w200_attr_value_parse(&data[i+1], size-i-1, j); //解析属性值
 			if(len > -1)
 			{
 				if(len == 0)
@@ -875,7 +922,7 @@ static int cmd_w200_data_parse(uint8_t* data, uint8_t size)
 	uint8_t i;
 	for(i = 0; i < size; i++)
 	{
-		if(*(char*)&data[i] == cmd_dev_addr_end_mark) //жϲַλ
+		if(*(char*)&data[i] == cmd_dev_addr_end_mark) //判断测点地址结束位置
 		{
 			break;
 		}
@@ -891,10 +938,10 @@ static int cmd_w200_data_parse(uint8_t* data, uint8_t size)
 		return -1;
 	}
 	
-	char (*p_str)[4] = (char (*)[4])data; //һָһָ룬4Ԫ
+	char (*p_str)[4] = (char (*)[4])data; //定义一个指向一个数组的指针，该数组有4个元素
 	for(int j = 0; j < 4; j++)
 	{
-		if(is_hex_or_digit((*p_str)[j]) == 0) //жַǷ16ַ
+		if(is_hex_or_digit((*p_str)[j]) == 0) //判断字符是否是16进制字符
 		{
 			char str[i+1];
 			bytes_to_char(data, str, i);
@@ -904,9 +951,9 @@ static int cmd_w200_data_parse(uint8_t* data, uint8_t size)
 			return -1;
 		}
 	}
-	hex_string_to_bytes((const char*)p_str, w200_attr_tmp.comm_attr.dev_short_addr, i); //ַ
+	hex_string_to_bytes((const char*)p_str, w200_attr_tmp.comm_attr.dev_short_addr, i); //保存测点地址
 	
-	if(cmd_w200_attr_parse(&data[i+1], size-i-1) < 0) //
+	if(cmd_w200_attr_parse(&data[i+1], size-i-1) < 0) //解析属性
 	{
 		return -1;
 	}
@@ -919,6 +966,524 @@ static int cmd_w201_data_parse(uint8_t* data, uint8_t size)
 	return 0;
 }
 
+//w202:<seq> 确认序号seq及之前的上行数据日志
+static int cmd_w202_data_parse(uint8_t* data, uint8_t size)
+{
+	char str[size+1];
+	bytes_to_char(data, str, size);
+	str[size] = '\0';
+	
+	//去掉结尾的换行符
+	while(size > 0 && (str[size-1] == '\r' || str[size-1] == '\n'))
+	{
+		str[--size] = '\0';
+	}
+	
+	long long value;
+	if(size == 0 || string_to_long_integer((const char*)str, &value) < 0 || value < 0)
+	{
+		strcpy(w200_reply_msg, str);
+		w200_reply_mark = 13;
+		return -1;
+	}
+	
+	Journal_GetHandle()->Ack((uint32_t)value);
+	return 0;
+}
+
+//解析读取命令的测点短地址，省略时为ffff
+static int cmd_read_short_addr_parse(uint8_t* data, uint8_t size, uint8_t* short_addr)
+{
+	char str[size+1];
+	bytes_to_char(data, str, size);
+	str[size] = '\0';
+	
+	//去掉结尾的换行符
+	while(size > 0 && (str[size-1] == '\r' || str[size-1] == '\n'))
+	{
+		str[--size] = '\0';
+	}
+	
+	short_addr[0] = 0XFF;
+	short_addr[1] = 0XFF;
+	if(size != 0)
+	{
+		if(size != 4)
+		{
+			strcpy(w200_reply_msg, str);
+			w200_reply_mark = 3;
+			return -1;
+		}
+		
+		for(int i = 0; i < size; i++)
+		{
+			if(is_hex_or_digit(str[i]) == 0) //判断字符是否是16进制字符
+			{
+				strcpy(w200_reply_msg, str);
+				w200_reply_mark = 3;
+				return -1;
+			}
+		}
+		
+		hex_string_to_bytes((const char*)str, short_addr, size);
+	}
+	
+	return 0;
+}
+
+//r200:<short_addr> 读取单个测点缓存数据，short_addr为ffff或省略时读取全部测点
+static int cmd_r200_data_parse(uint8_t* data, uint8_t size)
+{
+	uint8_t short_addr[2];
+	if(cmd_read_short_addr_parse(data, size, short_addr) < 0)
+	{
+		return -1;
+	}
+	
+	peer_value_dump(short_addr);
+	return 0;
+}
+
+//r202:<short_addr> 读取测点帧计数与丢包统计，short_addr为ffff或省略时读取全部测点
+static int cmd_r202_data_parse(uint8_t* data, uint8_t size)
+{
+	uint8_t short_addr[2];
+	if(cmd_read_short_addr_parse(data, size, short_addr) < 0)
+	{
+		return -1;
+	}
+	
+	peer_link_dump(short_addr);
+	return 0;
+}
+
+//输出一行射频时间统计：r201:<tag> [name] <value0> <value1> ...
+static void radio_time_line(const char* tag, const char* name, const uint32_t* value, uint8_t nums)
+{
+	char line[80];
+	str_buf_t sb;
+	
+	str_buf_init(&sb, line, sizeof(line));
+	str_buf_append_str(&sb, "r201:");
+	str_buf_append_str(&sb, tag);
+	if(name != NULL)
+	{
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_str(&sb, name);
+	}
+	for(uint8_t i = 0; i < nums; i++)
+	{
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, value[i], 0);
+	}
+	str_buf_append_char(&sb, '\n');
+	
+	printf("%s", line);
+}
+
+//向主机输出射频时间统计，时间单位ms
+//帧格式：r201:begin，r201:window <分钟窗口> <小时窗口>，
+//每个状态一行r201:state <名称> <累计> <最近1分钟> <最近1小时>，
+//r201:frame <发送帧数> <接收帧数>，有空中时间的扩频因子r201:sf <sf> <发送> <接收>，
+//每个信道r201:ch <频率> <发送> <接收>，r201:end
+static void radio_time_dump(void)
+{
+	static const char* state_name[RADIO_TIME_STATE_NUMS] = {
+		"rx_armed", "rx_busy", "tx", "cad", "standby", "sleep", "reset",
+	};
+	static radio_time_report_t report;
+	uint32_t value[3];
+	uint8_t i;
+	
+	radio_time_report(&report);
+	
+	printf("r201:begin\n");
+	value[0] = report.minute_window_ms;
+	value[1] = report.hour_window_ms;
+	radio_time_line("window", NULL, value, 2);
+	for(i = 0; i < RADIO_TIME_STATE_NUMS; i++)
+	{
+		value[0] = report.total_ms[i];
+		value[1] = report.minute_ms[i];
+		value[2] = report.hour_ms[i];
+		radio_time_line("state", state_name[i], value, 3);
+	}
+	value[0] = report.tx_nums;
+	value[1] = report.rx_nums;
+	radio_time_line("frame", NULL, value, 2);
+	for(i = 0; i < RADIO_TIME_SF_NUMS; i++)
+	{
+		if(report.sf_tx_ms[i] == 0 && report.sf_rx_ms[i] == 0)
+		{
+			continue;
+		}
+		value[0] = i + RADIO_TIME_SF_MIN;
+		value[1] = report.sf_tx_ms[i];
+		value[2] = report.sf_rx_ms[i];
+		radio_time_line("sf", NULL, value, 3);
+	}
+	for(i = 0; i < RADIO_TIME_CHANNEL_NUMS; i++)
+	{
+		if(report.channel[i].frequency == 0)
+		{
+			continue;
+		}
+		value[0] = report.channel[i].frequency;
+		value[1] = report.channel[i].tx_ms;
+		value[2] = report.channel[i].rx_ms;
+		radio_time_line("ch", NULL, value, 3);
+	}
+	printf("r201:end\n");
+}
+
+//r201: 读取射频各状态时间与空中时间统计
+static int cmd_r201_data_parse(uint8_t* data, uint8_t size)
+{
+	radio_time_dump();
+	return 0;
+}
+
+//解析逗号分隔的数值列表，bw_flag为1时按带宽(kHz)解析为带宽序号，返回个数，出错返回-1
+static int link_sweep_list_parse(char* str, int* value, uint8_t max, uint8_t bw_flag)
+{
+	int nums = 0;
+	char* p = str;
+	char* end;
+	
+	while(1)
+	{
+		if(nums >= max)
+		{
+			return -1;
+		}
+		
+		end = strchr(p, ',');
+		if(end != NULL)
+		{
+			*end = '\0';
+		}
+		
+		if(bw_flag)
+		{
+			double bw;
+			int i;
+			if(string_to_double((const char*)p, &bw) < 0)
+			{
+				return -1;
+			}
+			for(i = 0; i < sizeof(lora_bw_tb)/sizeof(lora_bw_tb[0]); i++)
+			{
+				if(bw == lora_bw_tb[i])
+				{
+					break;
+				}
+			}
+			if(i >= sizeof(lora_bw_tb)/sizeof(lora_bw_tb[0]))
+			{
+				return -1;
+			}
+			value[nums++] = i;
+		}
+		else
+		{
+			if(string_to_integer((const char*)p, &value[nums]) < 0)
+			{
+				return -1;
+			}
+			nums++;
+		}
+		
+		if(end == NULL)
+		{
+			break;
+		}
+		p = end + 1;
+	}
+	
+	return nums;
+}
+
+//w203:<short_addr> [sf 7,9] [bw 125,250] [power 10,17] [len 16,64] [frames 20] 启动链路扫描
+//w203:stop 终止链路扫描，省略的参数取当前系统参数
+static int cmd_w203_data_parse(uint8_t* data, uint8_t size)
+{
+	sys_param_t* param = Sys_ParamGetHandle();
+	link_sweep_matrix_t matrix;
+	int value[LINK_SWEEP_LIST_SIZE];
+	int nums;
+	char* name;
+	char* arg;
+	char* p;
+	int i;
+	
+	char str[size+1];
+	bytes_to_char(data, str, size);
+	str[size] = '\0';
+	
+	//去掉结尾的换行符
+	while(size > 0 && (str[size-1] == '\r' || str[size-1] == '\n'))
+	{
+		str[--size] = '\0';
+	}
+	
+	if(strcmp(str, "stop") == 0)
+	{
+		LinkSweep_GetHandle()->Stop();
+		printf("w203:stop\n");
+		return 0;
+	}
+	
+	strncpy(w200_reply_msg, str, sizeof(w200_reply_msg) - 1);
+	w200_reply_mark = 28;
+	
+	//测点短地址
+	if(size < 4)
+	{
+		return -1;
+	}
+	for(i = 0; i < 4; i++)
+	{
+		if(is_hex_or_digit(str[i]) == 0)
+		{
+			return -1;
+		}
+	}
+	if(str[4] != '\0' && str[4] != cmd_dev_addr_end_mark)
+	{
+		return -1;
+	}
+	
+	uint8_t short_addr[2];
+	hex_string_to_bytes((const char*)str, short_addr, 4);
+	extern peer_data_t peer_data;
+	for(i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		if(*(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)short_addr)
+		{
+			break;
+		}
+	}
+	if(i >= peer_data.current_conn_nums)
+	{
+		return -1;
+	}
+	memcpy(matrix.long_addr, peer_data.peer_attr[i].long_addr, 8);
+	
+	matrix.sf[0] = param->lora_sf;
+	matrix.bw[0] = param->lora_bw;
+	matrix.power[0] = param->lora_power;
+	matrix.len[0] = 16;
+	matrix.sf_nums = 1;
+	matrix.bw_nums = 1;
+	matrix.power_nums = 1;
+	matrix.len_nums = 1;
+	matrix.frames = 20;
+	
+	//属性名与取值成对出现，以空格分隔
+	p = (str[4] == '\0') ? &str[4] : &str[5];
+	while(*p != '\0')
+	{
+		name = p;
+		arg = strchr(name, cmd_attr_end_mark);
+		if(arg == NULL)
+		{
+			return -1;
+		}
+		*arg++ = '\0';
+		p = strchr(arg, cmd_attr_value_end_mark);
+		if(p == NULL)
+		{
+			p = arg + strlen(arg);
+		}
+		else
+		{
+			*p++ = '\0';
+		}
+		
+		nums = link_sweep_list_parse(arg, value, LINK_SWEEP_LIST_SIZE, strcmp(name, "bw") == 0);
+		if(nums <= 0)
+		{
+			return -1;
+		}
+		
+		for(i = 0; i < nums; i++)
+		{
+			if(strcmp(name, "sf") == 0)
+			{
+				if(value[i] < 5 || value[i] > 12)
+				{
+					return -1;
+				}
+				matrix.sf[i] = value[i];
+				matrix.sf_nums = nums;
+			}
+			else if(strcmp(name, "bw") == 0)
+			{
+				matrix.bw[i] = value[i];
+				matrix.bw_nums = nums;
+			}
+			else if(strcmp(name, "power") == 0)
+			{
+				if(value[i] < -9 || value[i] > 22)
+				{
+					return -1;
+				}
+				matrix.power[i] = value[i];
+				matrix.power_nums = nums;
+			}
+			else if(strcmp(name, "len") == 0)
+			{
+				if(value[i] < 0 || value[i] > 200)
+				{
+					return -1;
+				}
+				matrix.len[i] = value[i];
+				matrix.len_nums = nums;
+			}
+			else if(strcmp(name, "frames") == 0 && nums == 1)
+			{
+				if(value[i] <= 0 || value[i] > LINK_SWEEP_MAX_FRAMES)
+				{
+					return -1;
+				}
+				matrix.frames = value[i];
+			}
+			else
+			{
+				return -1;
+			}
+		}
+	}
+	
+	if(LinkSweep_GetHandle()->Start(&matrix) == 0)
+	{
+		return -1; //组合数超出上限
+	}
+	
+	w200_reply_mark = 0;
+	printf("w203:start %d\n", LinkSweep_GetHandle()->cell_nums);
+	return 0;
+}
+
+//向主机输出链路扫描结果
+//帧格式：r203:begin <状态> <组合数> <当前组合> <每组合帧数>，
+//每个组合一行r203:cell <序号> <sf> <带宽kHz> <功率> <载荷长度> <已测试> <收到帧数> <丢包率0.1%>
+//<rssi最小 平均 最大> <snr最小 平均 最大> <往返时间最小 平均 最大(ms)>，
+//r203:best <空中时间最短的可靠组合序号，没有为-1>，r203:end
+static void link_sweep_dump(void)
+{
+	LinkSweep_t* sweep = LinkSweep_GetHandle();
+	link_sweep_cell_t* cell;
+	char line[128];
+	str_buf_t sb;
+	
+	printf("r203:begin %d %d %d %d\n", sweep->state, sweep->cell_nums, sweep->cell_index, sweep->frames);
+	for(uint8_t i = 0; i < sweep->cell_nums; i++)
+	{
+		cell = &sweep->cell[i];
+		str_buf_init(&sb, line, sizeof(line));
+		str_buf_append_str(&sb, "r203:cell ");
+		str_buf_append_uint(&sb, i, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, cell->sf, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_fixed(&sb, lora_bw_tb[cell->bw], 2);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_int(&sb, cell->power);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, cell->len, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, cell->done, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, cell->rx_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, sweep->Per(i), 0);
+		if(cell->rx_nums != 0)
+		{
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->rssi_min);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->rssi_sum / cell->rx_nums);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->rssi_max);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->snr_min);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->snr_sum / cell->rx_nums);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_int(&sb, cell->snr_max);
+		}
+		else
+		{
+			str_buf_append_str(&sb, " 0 0 0 0 0 0");
+		}
+		if(cell->rtt_nums != 0)
+		{
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_uint(&sb, cell->rtt_min, 0);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_uint(&sb, cell->rtt_sum / cell->rtt_nums, 0);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_uint(&sb, cell->rtt_max, 0);
+		}
+		else
+		{
+			str_buf_append_str(&sb, " 0 0 0");
+		}
+		str_buf_append_char(&sb, '\n');
+		printf("%s", line);
+	}
+	printf("r203:best %d\n", sweep->Best());
+	printf("r203:end\n");
+}
+
+//r203: 读取链路扫描各组合统计
+static int cmd_r203_data_parse(uint8_t* data, uint8_t size)
+{
+	link_sweep_dump();
+	return 0;
+}
+
+//r204: 读取组确认广播统计
+//帧格式：r204:<开启> <周期(s)> <广播次数> <确认数据帧数> <广播空中时间(ms)> <代替的逐个回复次数>
+static int cmd_r204_data_parse(uint8_t* data, uint8_t size)
+{
+	extern ctrl_class_t ctrl_class;
+	group_ack_stat_t* stat = &GroupAck_GetHandle()->stat;
+	
+	printf("r204:%d %d %u %u %u %u\n", (ctrl_class.dev_ctrl & 0X08) ? 1 : 0, GROUP_ACK_PERIOD, 
+		   stat->beacon_nums, stat->ack_nums, stat->airtime_ms, stat->saved_nums);
+	return 0;
+}
+
+//r205: 读取块传输统计
+//帧格式：r205:<转发块数> <转发字节数> <分片帧数> <重复分片数> <确认帧数> <缓存满次数> <未收齐回收数>
+//<分片空中时间(ms)> <确认空中时间(ms)> <每KB上下行空中时间(ms)> <吞吐率(B/s)>
+//<特征提取开启> <特征提取块数> <超阈值转发原始数据块数> <节省的主机串口字节数>
+static int cmd_r205_data_parse(uint8_t* data, uint8_t size)
+{
+	extern ctrl_class_t ctrl_class;
+	block_transfer_stat_t* stat = &BlockTransfer_GetHandle()->stat;
+	vib_feature_stat_t* feature = &VibFeature_GetHandle()->stat;
+	uint32_t airtime_kb = 0;
+	uint32_t throughput = 0;
+	
+	if(stat->byte_nums > 0)
+	{
+		airtime_kb = (uint32_t)((uint64_t)(stat->up_airtime_ms + stat->down_airtime_ms) * 1024 / stat->byte_nums);
+	}
+	if(stat->elapsed_ms > 0)
+	{
+		throughput = (uint32_t)((uint64_t)stat->byte_nums * 1000 / stat->elapsed_ms);
+	}
+	
+	printf("r205:%u %u %u %u %u %u %u %u %u %u %u %d %u %u %u\n", stat->block_nums, stat->byte_nums, stat->frag_nums, 
+		   stat->dup_nums, stat->ack_nums, stat->busy_nums, stat->timeout_nums, 
+		   stat->up_airtime_ms, stat->down_airtime_ms, airtime_kb, throughput, 
+		   (ctrl_class.dev_ctrl & 0X10) ? 1 : 0, feature->block_nums, feature->raw_nums, feature->saved_bytes);
+	return 0;
+}
+
 void cmd_data_rx(uint8_t* data, uint8_t size)
 {
 	if(cmd_data_rx_size != 0)
@@ -941,7 +1506,7 @@ void cmd_data_parse(void)
 	uint8_t i;
 	for(i = 0; i < cmd_data_rx_size; i++)
 	{
-		if(*(char*)&cmd_data_buf[i] == cmd_type_end_mark) //жͽλ
+		if(*(char*)&cmd_data_buf[i] == cmd_type_end_mark) //判断命令类型结束位置
 		{
 			break;
 		}
@@ -955,15 +1520,15 @@ void cmd_data_parse(void)
 	}
 	
 	char str[i+1];
-	bytes_to_char(cmd_data_buf, str, i); //
+	bytes_to_char(cmd_data_buf, str, i); //拷贝出命令
 	str[i] = '\0';
 	
 	uint8_t j;
 	for(j = 0; j < sizeof(cmd_type) / sizeof(cmd_type[0]); j++)
 	{
-		if(strcmp(cmd_type[j], str) == 0) //ǷЧ
+		if(strcmp(cmd_type[j], str) == 0) //检查命令是否有效
 		{
-			if(data_parse[j](&cmd_data_buf[i+1], cmd_data_rx_size-i-1) < 0) //ݽ
+			if(data_parse[j](&cmd_data_buf[i+1], cmd_data_rx_size-i-1) < 0) //数据解析
 			{
 				cmd_data_rx_size = 0;
 				return;
@@ -980,6 +1545,13 @@ void cmd_data_parse(void)
 		return;
 	}
 	
+	if(j == CMD_TYPE_W202 || j == CMD_TYPE_R200 || j == CMD_TYPE_R201 || j == CMD_TYPE_R202 ||
+	   j == CMD_TYPE_W203 || j == CMD_TYPE_R203 || j == CMD_TYPE_R204 || j == CMD_TYPE_R205) //确认与读取命令解析时已处理，不回复
+	{
+		cmd_data_rx_size = 0;
+		return;
+	}
+	
 	memcpy(&w200_attr, &w200_attr_tmp, sizeof(w200_attr_tmp));
 	cmd_data_rx_size = 0;
 	w200_reply_mark = 1;
@@ -995,9 +1567,12 @@ void cmd_data_process(void)
 		lora_reply_data.status = w200_data_flag;
 		
 		extern peer_data_t peer_data;
+		extern ctrl_class_t ctrl_class;
 		uint8_t is_exit_dev = 0;
+		uint8_t group_flag = 0;
+		uint8_t set_map[(GATEWAY_CAP_SIZE + 7) / 8] = {0}; //需要逐个下发参数的测点
 		if(peer_data.current_conn_nums != 0 &&
-		   (lora_reply_data.status & (~(GATEWAY_ADDR|PRINT_CTRL|DEV_CTRL|LORA_FREQ|LORA_POWER|LORA_BW|LORA_SF))))
+		   (lora_reply_data.status & (~(GATEWAY_ADDR|PRINT_CTRL|DEV_CTRL|LORA_FREQ|LORA_POWER|LORA_BW|LORA_SF|LORA_SYNC))))
 		{
 			for(int i = 0; i < peer_data.current_conn_nums; i++)
 			{
@@ -1005,7 +1580,15 @@ void cmd_data_process(void)
 				   *(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)w200_attr.comm_attr.dev_short_addr)
 				{
 					is_exit_dev = 1;
-					peer_data.peer_attr[i].set_flag = 1;
+					
+					//组确认开启时全体测点参数随广播下发，旧测点仍逐个回复
+					if(*(uint16_t*)w200_attr.comm_attr.dev_short_addr == 0XFFFF && 
+					   (ctrl_class.dev_ctrl & 0X08) && peer_data.peer_attr[i].reply.flags_valid)
+					{
+						group_flag = 1;
+						continue;
+					}
+					set_map[i / 8] |= 1 << (i % 8);
 					
 					if(*(uint16_t*)w200_attr.comm_attr.dev_short_addr != 0XFFFF)
 					{
@@ -1014,7 +1597,7 @@ void cmd_data_process(void)
 				}
 			}
 		}
-		else if(lora_reply_data.status & (GATEWAY_ADDR|PRINT_CTRL|DEV_CTRL|LORA_FREQ|LORA_POWER|LORA_BW|LORA_SF))
+		else if(lora_reply_data.status & (GATEWAY_ADDR|PRINT_CTRL|DEV_CTRL|LORA_FREQ|LORA_POWER|LORA_BW|LORA_SF|LORA_SYNC))
 		{
 			is_exit_dev = 1;
 		}
@@ -1097,6 +1680,20 @@ void cmd_data_process(void)
 			memcpy(&lora_reply_data.gateway_addr, &w200_attr.comm_attr.gateway_addr, sizeof(w200_attr.comm_attr.gateway_addr));
 		}
 		
+		if(group_flag)
+		{
+			GroupAck_GetHandle()->SetAttr(&lora_reply_data);
+		}
+		
+		//按测点已确认的参数只下发变化的参数
+		for(int i = 0; i < peer_data.current_conn_nums; i++)
+		{
+			if((set_map[i / 8] & (1 << (i % 8))) && Lora_PeerCfgSet(&peer_data.peer_attr[i], &lora_reply_data))
+			{
+				peer_data.peer_attr[i].set_flag = 1;
+			}
+		}
+		
 		if(lora_reply_data.status & PRINT_CTRL)
 		{
 			lora_reply_data.status &= ~PRINT_CTRL;
@@ -1110,14 +1707,17 @@ void cmd_data_process(void)
 		if(lora_reply_data.status & LORA_FREQ ||
 		   lora_reply_data.status & LORA_POWER ||
 		   lora_reply_data.status & LORA_BW ||
-		   lora_reply_data.status & LORA_SF)
+		   lora_reply_data.status & LORA_SF ||
+		   lora_reply_data.status & LORA_SYNC)
 		{
 			lora_reply_data.status &= ~LORA_FREQ;
 			lora_reply_data.status &= ~LORA_POWER;
 			lora_reply_data.status &= ~LORA_BW;
 			lora_reply_data.status &= ~LORA_SF;
+			lora_reply_data.status &= ~LORA_SYNC;
 			
-			//lora
+			//设置lora，基准参数改变后终止链路扫描
+			LinkSweep_GetHandle()->Stop();
 			sys_param_t* param = Sys_ParamGetHandle();
 			param->lora_freq = m_lora_freq;
 			param->lora_power = m_lora_power;
@@ -1130,6 +1730,8 @@ void cmd_data_process(void)
 				}
 			}
 			param->lora_sf = m_lora_sf;
+			param->lora_sync_word = m_lora_sync;
+			param->update_flag = 1; //保存LORA参数
 			
 			extern void LORA_Config(void);
 			extern void LORA_ConfigDefault(void);
@@ -1247,6 +1849,14 @@ void cmd_data_reply(void)
 			printf("%s", cmd_w200_reply_tb[25]);
 			printf("%s\n", w200_reply_msg);
 			break;
+		case 27:
+			printf("%s", cmd_w200_reply_tb[26]);
+			printf("%s\n", w200_reply_msg);
+			break;
+		case 28:
+			printf("%s", cmd_w200_reply_tb[27]);
+			printf("%s\n", w200_reply_msg);
+			break;
 		case 0:
 			break;
 	}
@@ -1261,6 +1871,7 @@ void cmd_init(void)
 	m_lora_power = param->lora_power;
 	m_lora_bw = lora_bw_tb[param->lora_bw];
 	m_lora_sf = param->lora_sf;
+	m_lora_sync = param->lora_sync_word;
 	cmd_lora_param_attr_get(NULL, NULL);
 }
 
@@ -1,8 +1,8 @@
 #include "filter_butterworth.h"
 
-#define FILTER_ORDER_N		6			//
+#define FILTER_ORDER_N		6			//过滤器阶数
 
-const double b[] = {					//ϵ
+const double b[] = {					//常系数
 	0.000000332396951,
 	0.000001994381709,
 	0.000004985954273,
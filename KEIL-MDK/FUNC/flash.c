@@ -1,11 +1,11 @@
 /********************************************************************************
-  * ļ flash.c 
-  *    flashд
-  * 汾 V3.5.0
-  * ڣ   2015.8.10
-  * ߣ   Steven
-  * £
-  * 	1. ޸ΪHALд  2019.2.14)
+  * 文件名： flash.c 
+  * 描述：   flash读写操作
+  * 库版本： V3.5.0
+  * 日期：   2015.8.10
+  * 作者：   Steven
+  * 更新：
+  * 	1. 修改为HAL库的写法 （徐辉 2019.2.14)
   * 
   *
 ********************************************************************************/  
@@ -27,6 +27,27 @@
 
 //static FLASH_EraseInitTypeDef _eraseConfig;
 
+/* flash后台任务 */
+typedef struct {
+	uint8_t type; //任务类型
+	uint32_t addr; //操作地址
+	uint32_t* p_data; //写入数据，任务完成前保持有效
+	uint32_t size; //擦除页数或写入u32个数
+	flash_job_cb_t cb; //完成回调
+	void* p_context;
+}flash_job_t;
+
+#define FLASH_JOB_ERASE						0
+#define FLASH_JOB_WRITE						1
+
+static flash_job_t flash_job_queue[FLASH_JOB_QUEUE_SIZE];
+static uint8_t flash_job_head = 0; //队首，正在执行或待执行的任务
+static uint8_t flash_job_nums = 0;
+static uint8_t flash_job_running = 0;
+static volatile uint8_t flash_job_done = 0;
+static volatile uint8_t flash_job_result = 0;
+static flash_job_gate_t flash_job_gate = NULL;
+
 static void wait_for_flash_ready(nrf_fstorage_t const * p_fstorage)
 {
     /* While fstorage is busy, sleep and wait for an event. */
@@ -45,7 +66,14 @@ static uint32_t nrf_flash_end_addr_get()
 
 static void fstorage_evt_handler(nrf_fstorage_evt_t* p_evt)
 {
-	//FS
+	//后台任务完成，回调在主循环中执行
+	if(p_evt->p_param == (void*)&flash_job_queue[flash_job_head] && flash_job_running)
+	{
+		flash_job_result = (p_evt->result == NRF_SUCCESS) ? 0 : 1;
+		flash_job_done = 1;
+	}
+	
+	//FS操作错误
 	if(p_evt->result != NRF_SUCCESS)
 	{
 		return;
@@ -53,15 +81,15 @@ static void fstorage_evt_handler(nrf_fstorage_evt_t* p_evt)
 	
 	switch((uint8_t)p_evt->id)
 	{
-		//¼
+		//读完成事件
 		case NRF_FSTORAGE_EVT_READ_RESULT:
 			break;
 		
-		//д¼
+		//写完成事件
 		case NRF_FSTORAGE_EVT_WRITE_RESULT:
 			break;
 		
-		//¼
+		//擦除完成事件
 		case NRF_FSTORAGE_EVT_ERASE_RESULT:
 			break;
 		
@@ -80,9 +108,9 @@ nrf_fstorage_api_t* p_fs_api = &nrf_fstorage_nvmc;
 #endif
 /*******************************************************************************
 * Function Name  : fs_flash_init
-* Description    : flashĳʼ
-* Input          : 
-* Return         : 
+* Description    : flash的初始化函数
+* Input          : 无
+* Return         : 无
 *******************************************************************************/
 void fs_flash_init(void)
 {
@@ -95,14 +123,14 @@ void fs_flash_init(void)
 
 /*******************************************************************************
 * Function Name  : flash_write
-* Description    : flashд
-* Input          : u32 pageStartAddr: дflashҳʼַ
-* 				   u32 *p_data: ҳд
-* 				   u32 size: дݵĸ
-* Return         : 0: ȷִ,
-* 				   1: 
+* Description    : flash的写函数
+* Input          : u32 pageStartAddr: 待写flash页的起始地址
+* 				   u32 *p_data: 本页待写入的连续数据
+* 				   u32 size: 写入数据的个数
+* Return         : 0: 正确执行,
+* 				   1: 擦除错误
 * 				   2: write error
-* Attention		 : һu32 ָ룬һǰ4ֽڶдġԣsizeҲu32ĸֽ4֮һ
+* Attention		 : 输入数据一定是u32 的指针，即数据一定是按照4字节对齐写入的。所以：size也是u32的个数（字节数的4分之一）
 *******************************************************************************/
 uint8_t flash_write(uint32_t pageStartAddr, uint32_t *pData, uint32_t size)
 {
@@ -127,11 +155,184 @@ uint8_t flash_write(uint32_t pageStartAddr, uint32_t *pData, uint32_t size)
 	return err_code;
 }
 
+/*******************************************************************************
+* Function Name  : flash_page_erase
+* Description    : flash页擦除函数
+* Input          : u32 pageStartAddr: 待擦除flash页的起始地址
+* 				   u32 pageNb: 待擦除页数
+* Return         : 0: 正确执行, 非0: 擦除错误
+*******************************************************************************/
+uint8_t flash_page_erase(uint32_t pageStartAddr, uint32_t pageNb)
+{
+	uint32_t err_code;
+	err_code = nrf_fstorage_erase(&nrf_flash_write, pageStartAddr, pageNb, NULL);
+	if(err_code != NRF_SUCCESS)
+	{
+		return 1;
+	}
+	
+	wait_for_flash_ready(&nrf_flash_write);
+	return 0;
+}
+
+/*******************************************************************************
+* Function Name  : flash_write_words
+* Description    : flash的写函数，不擦除页，用于向已擦除区域追加数据
+* Input          : u32 startAddr: 待写flash地址(4字节对齐)
+* 				   u32 *p_data: 待写入的连续数据
+* 				   u32 size: 写入数据的个数(u32的个数)
+* Return         : 0: 正确执行, 非0: 写错误
+*******************************************************************************/
+uint8_t flash_write_words(uint32_t startAddr, uint32_t *pData, uint32_t size)
+{
+	uint32_t err_code;
+	err_code = nrf_fstorage_write(&nrf_flash_write, startAddr, pData, 4*size, NULL);
+	if(err_code != NRF_SUCCESS)
+	{
+		return 2;
+	}
+	
+	wait_for_flash_ready(&nrf_flash_write);
+	return 0;
+}
+
+static uint8_t flash_job_push(uint8_t type, uint32_t addr, uint32_t* p_data, uint32_t size, flash_job_cb_t cb, void* p_context)
+{
+	if(flash_job_nums >= FLASH_JOB_QUEUE_SIZE)
+	{
+		return 1;
+	}
+	
+	flash_job_t* job = &flash_job_queue[(flash_job_head + flash_job_nums) % FLASH_JOB_QUEUE_SIZE];
+	job->type = type;
+	job->addr = addr;
+	job->p_data = p_data;
+	job->size = size;
+	job->cb = cb;
+	job->p_context = p_context;
+	flash_job_nums++;
+	
+	return 0;
+}
+
+/*******************************************************************************
+* Function Name  : flash_job_erase
+* Description    : 添加后台页擦除任务，不等待完成
+* Input          : u32 pageStartAddr: 待擦除flash页的起始地址
+* 				   u32 pageNb: 待擦除页数
+* 				   cb: 完成回调，在主循环中调用
+* Return         : 0: 添加成功, 1: 任务队列已满
+*******************************************************************************/
+uint8_t flash_job_erase(uint32_t pageStartAddr, uint32_t pageNb, flash_job_cb_t cb, void* p_context)
+{
+	return flash_job_push(FLASH_JOB_ERASE, pageStartAddr, NULL, pageNb, cb, p_context);
+}
+
+/*******************************************************************************
+* Function Name  : flash_job_write
+* Description    : 添加后台写任务(不擦除)，不等待完成
+* Input          : u32 startAddr: 待写flash地址(4字节对齐)
+* 				   u32 *p_data: 待写入数据，回调前必须保持有效
+* 				   u32 size: 写入数据的个数(u32的个数)
+* 				   cb: 完成回调，在主循环中调用
+* Return         : 0: 添加成功, 1: 任务队列已满
+*******************************************************************************/
+uint8_t flash_job_write(uint32_t startAddr, uint32_t *pData, uint32_t size, flash_job_cb_t cb, void* p_context)
+{
+	return flash_job_push(FLASH_JOB_WRITE, startAddr, pData, size, cb, p_context);
+}
+
+//注册flash操作许可判断函数，由无线收发模块提供
+void flash_job_gate_set(flash_job_gate_t gate)
+{
+	flash_job_gate = gate;
+}
+
+//预计耗时duration_ms的flash操作当前是否可以执行
+uint8_t flash_job_allowed(uint32_t duration_ms)
+{
+	if(flash_job_gate == NULL)
+	{
+		return 1;
+	}
+	
+	return flash_job_gate(duration_ms);
+}
+
+uint8_t flash_job_idle(void)
+{
+	return (flash_job_nums == 0);
+}
+
+/*******************************************************************************
+* Function Name  : flash_job_proc
+* Description    : flash后台任务处理，主循环中调用
+*                  上一任务完成后执行回调，再在无线收发空闲时启动下一任务
+*******************************************************************************/
+void flash_job_proc(void)
+{
+	flash_job_t* job = &flash_job_queue[flash_job_head];
+	uint32_t err_code;
+	
+	if(flash_job_running)
+	{
+		if(!flash_job_done)
+		{
+			return;
+		}
+		
+		flash_job_running = 0;
+		flash_job_done = 0;
+		flash_job_head = (flash_job_head + 1) % FLASH_JOB_QUEUE_SIZE;
+		flash_job_nums--;
+		if(job->cb != NULL)
+		{
+			job->cb(flash_job_result, job->p_context);
+		}
+		job = &flash_job_queue[flash_job_head];
+	}
+	
+	if(flash_job_nums == 0)
+	{
+		return;
+	}
+	
+	uint32_t duration = (job->type == FLASH_JOB_ERASE) ?
+						(job->size * FLASH_PAGE_ERASE_TIME) :
+						(job->size * FLASH_WORD_WRITE_TIME_US / 1000 + 1);
+	if(!flash_job_allowed(duration))
+	{
+		return;
+	}
+	
+	nrf_flash_write.end_addr = nrf_flash_end_addr_get();
+	flash_job_done = 0;
+	flash_job_running = 1;
+	if(job->type == FLASH_JOB_ERASE)
+	{
+		err_code = nrf_fstorage_erase(&nrf_flash_write, job->addr, job->size, job);
+	}
+	else
+	{
+		err_code = nrf_fstorage_write(&nrf_flash_write, job->addr, job->p_data, 4*job->size, job);
+	}
+	
+	if(err_code == NRF_ERROR_NO_MEM)
+	{
+		flash_job_running = 0; //fstorage队列已满，稍后重试
+	}
+	else if(err_code != NRF_SUCCESS)
+	{
+		flash_job_result = 1;
+		flash_job_done = 1;
+	}
+}
+
 /*******************************************************************************
 * Function Name  : flash_read
-* Description    : flashĶ
+* Description    : flash的读函数
 * Input          : u32 startAddr,u32 *p_data,u32 size
-* Attention		 : һu32 ָ룬һǰ4ֽڶдġԣsizeҲu32ĸֽ4֮һ
+* Attention		 : 输入数据一定是u32 的指针，即数据一定是按照4字节对齐写入的。所以：size也是u32的个数（字节数的4分之一）
 *******************************************************************************/
 void flash_read(uint32_t startAddr, uint8_t *pData, uint32_t size)
 {
@@ -140,7 +341,7 @@ void flash_read(uint32_t startAddr, uint8_t *pData, uint32_t size)
 	APP_ERROR_CHECK(err_code);
 }
 
-//BLEӦʹ
+//非BLE应用使用
 //uint8_t flash_write(uint32_t pageStartAddr, uint32_t *pData, uint32_t size)
 //{
 //	uint32_t endAddr = pageStartAddr + 4*size;
@@ -158,7 +359,7 @@ void flash_read(uint32_t startAddr, uint8_t *pData, uint32_t size)
 //	return 0;
 //}
 
-//BLEӦʹ
+//非BLE应用使用
 //void flash_read(uint32_t startAddr,uint8_t *pData, uint32_t size)
 //{
 //	uint8_t i;
@@ -171,9 +372,9 @@ void flash_read(uint32_t startAddr, uint8_t *pData, uint32_t size)
 
 /*******************************************************************************
 * Function Name  : flash_read
-* Description    : flashĶ
+* Description    : flash的读函数
 * Input          : u32 startAddr,u32 *p_data,u32 size
-* Attention		 : һu32 ָ룬һǰ4ֽڶдġԣsizeҲu32ĸֽ4֮һ
+* Attention		 : 输入数据一定是u32 的指针，即数据一定是按照4字节对齐写入的。所以：size也是u32的个数（字节数的4分之一）
 *******************************************************************************/
 /*
 void flash_read(uint32_t startAddr,uint32_t *pData,uint32_t size)
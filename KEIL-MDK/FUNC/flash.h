@@ -5,31 +5,52 @@
 
 #define TH_FLASH_PAGE_SIZE_2_POWER 12	//4096bytes = 2^12 bytes
 
+#define FLASH_JOB_QUEUE_SIZE		8 //flash后台任务队列大小
+#define FLASH_PAGE_ERASE_TIME		90 //页擦除时间，单位ms(nRF52832最大85ms)
+#define FLASH_WORD_WRITE_TIME_US	41 //单字写入时间，单位us
+
+typedef void (*flash_job_cb_t)(uint8_t result, void* p_context); //result 0:成功, 非0:失败
+typedef uint8_t (*flash_job_gate_t)(uint32_t duration_ms); //返回1允许执行
+
 
 void fs_flash_init(void);
 
 /*******************************************************************************
 * Function Name  : flash_write
-* Description    : flashд
-* Input          : u32 pageStartAddr: дflashҳʼַ
-* 				   u32 *p_data: ҳд
-* 				   u32 size: дݵĸ
-* Return         : 0: ȷִ,
-* 				   1: 
+* Description    : flash的写函数
+* Input          : u32 pageStartAddr: 待写flash页的起始地址
+* 				   u32 *p_data: 本页待写入的连续数据
+* 				   u32 size: 写入数据的个数
+* Return         : 0: 正确执行,
+* 				   1: 擦除错误
 * 				   2: write error
-* Attention		 : һu32 ָ룬һǰ4ֽڶдġԣsizeҲu32ĸֽ4֮һ
+* Attention		 : 输入数据一定是u32 的指针，即数据一定是按照4字节对齐写入的。所以：size也是u32的个数（字节数的4分之一）
 *******************************************************************************/
 uint8_t flash_write(uint32_t pageStartAddr, uint32_t *pData, uint32_t size);
 
-//byteȡ
+//擦除pageNb个flash页
+uint8_t flash_page_erase(uint32_t pageStartAddr, uint32_t pageNb);
+
+//不擦除页直接写入，size为u32的个数
+uint8_t flash_write_words(uint32_t startAddr, uint32_t *pData, uint32_t size);
+
+//flash后台任务，完成后在主循环中回调
+uint8_t flash_job_erase(uint32_t pageStartAddr, uint32_t pageNb, flash_job_cb_t cb, void* p_context);
+uint8_t flash_job_write(uint32_t startAddr, uint32_t *pData, uint32_t size, flash_job_cb_t cb, void* p_context);
+void flash_job_gate_set(flash_job_gate_t gate);
+uint8_t flash_job_allowed(uint32_t duration_ms);
+uint8_t flash_job_idle(void);
+void flash_job_proc(void);
+
+//按照byte读取
 void flash_read(uint32_t startAddr, uint8_t *pData, uint32_t size);
 
 /*******************************************************************************
 * Function Name  : flash_read
-* Description    : flashĶ
+* Description    : flash的读函数
 * Input          : u32 startAddr,u32 *p_data,u32 size
-* Output         : 0ȷִ,	 0
-* Attention		 : һu32 ָ룬һǰ4ֽڶдġԣsizeҲu32ĸֽ4֮һ
+* Output         : 0：正确执行,	 非0：出错
+* Attention		 : 输入数据一定是u32 的指针，即数据一定是按照4字节对齐写入的。所以：size也是u32的个数（字节数的4分之一）
 *******************************************************************************/
 //void flash_read(uint32_t StartAddr,uint32_t *pData,uint32_t size);
 #endif
@@ -0,0 +1,161 @@
+#include "group_ack.h"
+#include "string.h"
+#include "wireless_comm_services.h"
+#include "host_net_swap.h"
+#include "calendar.h"
+#include "rx_filter.h"
+#include "link_sweep.h"
+
+
+static GroupAck_t group_ack;
+static uint32_t last_period; //最近一次广播的周期号(网关时间戳/周期)
+static uint8_t beacon_buf[MAX_WIRELESS_COMM_BUF_SIZE - RX_FILTER_FRAME_OVERHEAD - 8];
+
+static void GroupAck_Ack(uint8_t index, uint8_t confirm)
+{
+	if(index >= GATEWAY_CAP_SIZE)
+	{
+		return;
+	}
+	
+	if(!(group_ack.ack_map[index / 8] & (1 << (index % 8))))
+	{
+		group_ack.ack_map[index / 8] |= 1 << (index % 8);
+		group_ack.ack_count++;
+	}
+	group_ack.stat.ack_nums++;
+	if(confirm)
+	{
+		group_ack.stat.saved_nums++;
+	}
+}
+
+//测点相关的参数不放入广播，由逐个回复下发
+static void GroupAck_SetAttr(lora_reply_data_t* p_attr)
+{
+	memcpy(&group_ack.attr, p_attr, sizeof(lora_reply_data_t));
+	group_ack.attr.status &= ~(LONG_ADDR | SHORT_ADDR | TIME_OFFSET);
+	group_ack.attr_repeat = group_ack.attr.status ? GROUP_ACK_ATTR_REPEAT : 0;
+}
+
+//确认数据取短地址列表与位图中较短的一种
+static uint8_t group_ack_fill(uint8_t* buf)
+{
+	extern peer_data_t peer_data;
+	uint8_t map_len = (peer_data.current_conn_nums + 7) / 8;
+	uint8_t size = 0;
+	
+	if(group_ack.ack_count * 2 < map_len)
+	{
+		buf[size++] = GROUP_ACK_MODE_LIST;
+		buf[size++] = group_ack.ack_count;
+		for(int i = 0; i < peer_data.current_conn_nums; i++)
+		{
+			if(group_ack.ack_map[i / 8] & (1 << (i % 8)))
+			{
+				memcpy(&buf[size], &peer_data.peer_attr[i].long_addr[6], 2);
+				size += 2;
+			}
+		}
+	}
+	else
+	{
+		buf[size++] = GROUP_ACK_MODE_MAP;
+		buf[size++] = map_len;
+		memcpy(&buf[size], group_ack.ack_map, map_len);
+		size += map_len;
+	}
+	
+	return size;
+}
+
+static void group_ack_send(void)
+{
+	static const uint8_t node_type[] = {0XC8, 0XC9};
+	uint32_t time_stamp = Calendar_GetHandle()->GetTimeStamp();
+	uint32_t period = GROUP_ACK_PERIOD;
+	uint8_t size = 0;
+	uint8_t nums_index;
+	uint8_t len;
+	
+	beacon_buf[size++] = group_ack.period_seq;
+#if COMM_TRANSMISSION_MSB == 1
+	time_stamp = swap_htonl(time_stamp);
+	period = swap_htonl(period);
+#endif
+	memcpy(&beacon_buf[size], (uint8_t*)&time_stamp, sizeof(time_stamp));
+	size += sizeof(time_stamp);
+	memcpy(&beacon_buf[size], (uint8_t*)&period, sizeof(period));
+	size += sizeof(period);
+	
+	size += group_ack_fill(&beacon_buf[size]);
+	
+	/* 全体测点参数，每类测点一段 */
+	nums_index = size;
+	beacon_buf[size++] = 0;
+	if(group_ack.attr_repeat > 0)
+	{
+		group_ack.attr_repeat--;
+		for(int i = 0; i < sizeof(node_type); i++)
+		{
+			len = Lora_AttrFill(node_type[i], &group_ack.attr, &beacon_buf[size + 2]);
+			if(len == 0)
+			{
+				continue;
+			}
+			beacon_buf[size] = node_type[i];
+			beacon_buf[size + 1] = len;
+			size += 2 + len;
+			beacon_buf[nums_index]++;
+		}
+	}
+	
+	len = Lora_BroadcastSend(CMD_GROUP_ACK, beacon_buf, size);
+	group_ack.stat.beacon_nums++;
+	group_ack.stat.airtime_ms += (LORA_TimeOnAirUs(len) + 999) / 1000;
+	
+	group_ack.period_seq++;
+	group_ack.ack_count = 0;
+	memset(group_ack.ack_map, 0, sizeof(group_ack.ack_map));
+}
+
+//网关时间跨过周期边界时广播，测点按网关时间在周期起点打开接收窗口
+static void GroupAck_Proc(void)
+{
+	extern ctrl_class_t ctrl_class;
+	uint32_t period = Calendar_GetHandle()->GetTimeStamp() / GROUP_ACK_PERIOD;
+	
+	if(!(ctrl_class.dev_ctrl & 0X08))
+	{
+		last_period = period;
+		return;
+	}
+	
+	//链路扫描组合参数下测点收不到广播，推迟到恢复基准参数之后
+	if(period == last_period || LinkSweep_GetHandle()->state == LINK_SWEEP_CELL)
+	{
+		return;
+	}
+	
+	last_period = period;
+	group_ack_send();
+}
+
+GroupAck_t* GroupAck_Init(void)
+{
+	memset(&group_ack, 0, sizeof(group_ack));
+	last_period = Calendar_GetHandle()->GetTimeStamp() / GROUP_ACK_PERIOD;
+	
+	group_ack.Ack = GroupAck_Ack;
+	group_ack.SetAttr = GroupAck_SetAttr;
+	group_ack.Proc = GroupAck_Proc;
+	
+	return &group_ack;
+}
+
+GroupAck_t* GroupAck_GetHandle(void)
+{
+	return &group_ack;
+}
+
+
@@ -0,0 +1,50 @@
+#ifndef __GROUP_ACK_H__
+#define __GROUP_ACK_H__
+#include "main.h"
+#include "uart_svc.h"
+#include "lora_transmission.h"
+
+
+/*
+ * 组确认帧：网关每个周期广播一次，确认上一周期收到的所有测点数据帧，同时下发网关时间与全体测点参数，
+ * 下行空中时间随周期数增长，不再随测点数增长。dev_ctrl 0X08开启后只对支持上行标志的测点生效，旧测点仍逐个回复。
+ *
+ * 帧格式：命令头CMD_GROUP_ACK+长度+数据段+CRC16，数据段：
+ * 网关长地址8+周期序号1+网关时间戳4+周期4(s)+确认方式1+确认长度1+确认数据+参数段个数1+参数段
+ * 确认方式0：确认数据为短地址列表，确认长度为地址个数；确认方式1：确认数据为按组序号排列的位图，确认长度为字节数，
+ * 组序号在连接回复数据段末尾下发(组确认开启时连接回复数据段为测点长地址8+网关长地址8+短地址2+组序号1)。
+ * 参数段：测点类型1(长地址首字节)+参数长度1+属性个数1+属性号+属性值，编码与该类测点数据回复相同。
+ */
+
+#define GROUP_ACK_PERIOD					10u //广播周期(s)，与倾角测点默认上报周期一致
+#define GROUP_ACK_ATTR_REPEAT				3 //全体测点参数连续下发的周期数
+#define GROUP_ACK_MAP_SIZE					((GATEWAY_CAP_SIZE + 7) / 8) //确认位图字节数
+#define GROUP_ACK_MODE_LIST					0 //短地址列表
+#define GROUP_ACK_MODE_MAP					1 //位图
+
+typedef struct {
+	uint32_t beacon_nums; //广播次数
+	uint32_t ack_nums; //确认的数据帧数
+	uint32_t airtime_ms; //广播累计空中时间
+	uint32_t saved_nums; //以组确认代替的逐个回复次数
+}group_ack_stat_t;
+
+typedef struct {
+	uint8_t period_seq; //周期序号
+	uint8_t attr_repeat; //全体测点参数剩余下发周期数
+	uint16_t ack_count; //本周期确认的测点个数
+	uint8_t ack_map[GROUP_ACK_MAP_SIZE]; //本周期确认位图，按测点序号
+	lora_reply_data_t attr; //全体测点参数
+	group_ack_stat_t stat;
+	
+	void (*Ack)(uint8_t index, uint8_t confirm); //确认测点数据帧，confirm:测点请求了确认
+	void (*SetAttr)(lora_reply_data_t* p_attr); //下发全体测点参数
+	void (*Proc)(void);
+}GroupAck_t;
+
+GroupAck_t* GroupAck_Init(void);
+GroupAck_t* GroupAck_GetHandle(void);
+
+#endif
+
+
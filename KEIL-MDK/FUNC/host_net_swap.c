@@ -1,11 +1,11 @@
 #include "host_net_swap.h"
 
 
-// ʹС˻
+// 短整型大小端互换
 #define BIGLITTLESWAP16(N)  (((( unsigned short)(N) & 0xff00) >> 8) | \
                             ((( unsigned short)(N) & 0x00ff) << 8))
 
- // ʹС˻
+ // 长整型大小端互换
 #define BIGLITTLESWAP32(N)  ((((unsigned int)(N) & 0xff000000) >> 24) | \
                             (((unsigned int)(N) & 0x00ff0000) >> 8) | \
                             (((unsigned int)(N) & 0x0000ff00) << 8) | \
@@ -13,7 +13,7 @@
 
  
 
-/* ˷1С˷0 */
+/* 本机大端返回1，小端返回0 */
 int isCPUBigEndian(void)
 {
      union{
@@ -26,9 +26,9 @@ int isCPUBigEndian(void)
 }
 
 /**
- * ģhtonlֽתֽ
- * Ϊˣֱֽͬӷ
- * ΪСˣתɴٷ
+ * 模拟htonl函数，本机字节序转网络字节序
+ * 若本机为大端，与网络字节序同，直接返回
+ * 若本机为小端，转换成大端再返回
  */
 unsigned long int swap_htonl(unsigned long int host)
 {
@@ -36,9 +36,9 @@ unsigned long int swap_htonl(unsigned long int host)
 }
 
 /**
- * ģntohlֽתֽ
- * Ϊˣֱֽͬӷ
- * ΪСˣתСٷ
+ * 模拟ntohl函数，网络字节序转本机字节序
+ * 若本机为大端，与网络字节序同，直接返回
+ * 若本机为小端，网络数据转换成小端再返回
  */
 unsigned long int swap_ntohl(unsigned long int net)
 {
@@ -46,9 +46,9 @@ unsigned long int swap_ntohl(unsigned long int net)
 }
 
 /**
- * ģhtonsֽתֽ
- * Ϊˣֱֽͬӷ
- * ΪСˣתɴٷ
+ * 模拟htons函数，本机字节序转网络字节序
+ * 若本机为大端，与网络字节序同，直接返回
+ * 若本机为小端，转换成大端再返回
 
  */
 unsigned short int swap_htons(unsigned short int host)
@@ -57,9 +57,9 @@ unsigned short int swap_htons(unsigned short int host)
 }
 
 /**
- * ģntohsֽתֽ
- * Ϊˣֱֽͬӷ
- * ΪСˣתСٷ
+ * 模拟ntohs函数，网络字节序转本机字节序
+ * 若本机为大端，与网络字节序同，直接返回
+ * 若本机为小端，网络数据转换成小端再返回
  */
 unsigned short int swap_ntohs(unsigned short int net)
 {
@@ -67,7 +67,7 @@ unsigned short int swap_ntohs(unsigned short int net)
 }
 
 /**
- * ת
+ * 翻转数组
  */
 void swap_reverse(unsigned char *array, unsigned int size)
 {
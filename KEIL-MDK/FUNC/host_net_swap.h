@@ -2,11 +2,11 @@
 #define __HOST_NET_SWAP_H__
 
 
-/* ֽ */
+/* 主机到网络字节序 */
 unsigned long int swap_htonl(unsigned long int host);
 unsigned short int swap_htons(unsigned short int host);
 
-/* 絽ֽ */
+/* 网络到主机字节序 */
 unsigned long int swap_ntohl(unsigned long int net);
 unsigned short int swap_ntohs(unsigned short int net);
 
@@ -1,211 +1,181 @@
 /*
  * iotobject.c
  *
- *  Created on: 201921
+ *  Created on: 2019年2月1日
  *      Author: xuhui
  */
 
 #include "iotobject.h"
 #include "flash.h"
+#include "app_util.h"
+#include <string.h>
 
 static iot_object_t self;
 
+STATIC_ASSERT(MAX_PROP_COUNT <= 32);			//修改标志与永久属性使用32位位图
+STATIC_ASSERT(MAX_PROP_MEM_SIZE <= 0X3FF);		//起始位置占10位
+STATIC_ASSERT(MAX_PROP_LEN <= 0X3F);			//长度占6位
+
 static uint8_t _isPropChanged(uint8_t id) {
-	return self._propModifyFlag[id];
+	if (id >= self._propCount)
+		return 0;
+	return (self._propModifyFlag >> id) & 0X01;
 }
 
 static void _resetPropChangeFlag(uint8_t id) {
-	self._propModifyFlag[id] = 0;
+	if (id < self._propCount)
+		self._propModifyFlag &= ~(1UL << id);
 }
 
 static void _setPropCount(uint8_t len) {
-	self._propCount = len;
+	self._propCount = len > MAX_PROP_COUNT ? MAX_PROP_COUNT : len;
 }
 
-//Է1򷵻0
+//如果是永久属性返回1，否则返回0
 static uint8_t _isPermanentProp(uint8_t id) {
-	uint8_t i;
-
-	for (i = 0; i < self._permanentPropCount; i++) {
-		if (id == self._permanentProps[i])
-			return 1;
-	}
-	return 0;
+	return (self._permanentPropMask >> id) & 0X01;
 }
 
 static void _setPropLen(uint8_t id, uint8_t len) {
 	if (id < self._propCount)
-		self._propLen[id] = len;
+		self._propLayout[id] = PROP_LAYOUT(0, len > MAX_PROP_LEN ? MAX_PROP_LEN : len);
 }
 
 static uint8_t _getPropLen(uint8_t id) {
 	if (id < self._propCount)
-		return self._propLen[id];
+		return PROP_LEN(self._propLayout[id]);
 	else
 		return 0;
 }
 
-//ʼԸʼַ
+//初始化属性起始地址，超出property buffer的属性长度置0
 static void _initPropStartIds() {
-	uint8_t i = 1;
-	self._propStartId[0] = 0;
+	uint8_t i;
+	uint16_t start = 0;
+	uint8_t len;
 
-	for (; i < self._propCount; i++) {
-		self._propStartId[i] = self._propStartId[i - 1] + self._propLen[i - 1];
+	self._permanentPropSize = 0;
+	for (i = 0; i < self._propCount; i++) {
+		len = PROP_LEN(self._propLayout[i]);
+		if (start + len > MAX_PROP_MEM_SIZE)
+			len = 0;
+
+		self._propLayout[i] = PROP_LAYOUT(start, len);
+		start += len;
+
+		if (_isPermanentProp(i))
+			self._permanentPropSize += len;
 	}
 }
 
-//ȡbufеݣд뱾ĳ
+//读取buf中的数据，写入本测点的某个属性中
 static void _writePropFromBuf(uint8_t id, uint8_t *buf) {
 	if (id >= self._propCount)
 		return;
 
-	uint8_t i = 0;
-	uint8_t start = self._propStartId[id];
+	uint16_t layout = self._propLayout[id];
 
-	for (; i < self._propLen[id]; i++)
-		self._propBuffer[start + i] = buf[i];
+	memcpy(&self._propBuffer[PROP_START(layout)], buf, PROP_LEN(layout));
 
-	//һǲǳ̵ַַ, ǵĻڿҲһ
-	if (id == IOT_OBJ_LONG_ADDR) {
-		for (i = 0; i < 8; i++)
-			self._longAddr[i] = buf[i];
-	} else if (id == IOT_OBJ_SHORT_ADDR) {
-		for (i = 0; i < 2; i++)
-			self._shortAddr[i] = buf[i];
-	}
+	//检查一下是不是长地址或短地址, 是的话在快捷数组里面也放一份
+	if (id == IOT_OBJ_LONG_ADDR)
+		memcpy(self._longAddr, buf, 8);
+	else if (id == IOT_OBJ_SHORT_ADDR)
+		memcpy(self._shortAddr, buf, 2);
 
-	//һǲǸ
+	//检查一下是不是改了永久属性
 	if (_isPermanentProp(id))
 		self._permanentPropModifyFlag = 1;
 
-	self._propModifyFlag[id] = 1;
+	self._propModifyFlag |= 1UL << id;
 }
 
-//ĳԵݶⲿbuf
+//将某个属性的数据读到外部buf中
 static void _readPropToBuf(uint8_t id, uint8_t *buf) {
 	if (id >= self._propCount)
 		return;
 
-	uint8_t i = 0;
-	uint8_t start = self._propStartId[id];
+	uint16_t layout = self._propLayout[id];
 
-	for (; i < self._propLen[id]; i++)
-		buf[i] = self._propBuffer[start + i];
+	memcpy(buf, &self._propBuffer[PROP_START(layout)], PROP_LEN(layout));
 }
 
-//ַǷһ£һΪ1Ϊ0
+//长地址是否一致，如果一致为1，否则为0
 static uint8_t _isLongAddrEq(uint8_t *addr) {
-	uint8_t flag = 1;
-	uint8_t i = 0;
-	for (; i < 8; i++) {
-		if (addr[i] != self._longAddr[i]) {
-			flag = 0;
-			break;
-		}
-	}
-
-	return flag;
+	return memcmp(addr, self._longAddr, 8) == 0;
 }
 
-//̵ַǷһ£һΪ1Ϊ0
+//短地址是否一致，如果一致为1，否则为0
 static uint8_t _isShortAddrEq(uint8_t *addr) {
 	return ((self._shortAddr[0] == addr[0]) && (self._shortAddr[1] == addr[1]))
-			|| ((addr[0] == 0xff) && (addr[1] == 0xff));	//㲥ַ
+			|| ((addr[0] == 0xff) && (addr[1] == 0xff));	//广播地址
 }
 
 static uint8_t _saveLongAddr2Flash() {
 	uint32_t longAddr[2];
 
-	longAddr[0] = self._longAddr[0] | self._longAddr[1] << 8
-			| self._longAddr[2] << 16 | self._longAddr[3] << 24;
-
-	longAddr[1] = self._longAddr[4] | self._longAddr[5] << 8
-			| self._longAddr[6] << 16 | self._longAddr[7] << 24;
+	memcpy(longAddr, self._longAddr, 8);
 
 	return flash_write(LONG_ADDR_FLASH_PAGE_ADDR, longAddr, 2);
 }
 
+//永久属性按属性号顺序紧密排列存储
 static uint8_t _saveProp2Flash() {
-	if (self._permanentPropModifyFlag == 0 || self._permanentPropCount == 0)
+	if (self._permanentPropModifyFlag == 0 || self._permanentPropSize == 0)
 		return 0;
 
-	//־
+	//清楚标志
 	self._permanentPropModifyFlag = 0;
 
-	uint8_t i = 0;
-
-	uint32_t size = 0;
-	//Ŀռ(bytes)
-	for (i = 0; i < self._permanentPropCount; i++) {
-		size += self._propLen[self._permanentProps[i]];
-	}
-
-	uint32_t size32 = 0;
-	if (size % 4 == 0)
-		size32 = (size >> 2);
-	else
-		size32 = (size >> 2) + 1;
-
-	uint32_t buf[size32];
-	for (i = 0; i < size32; i++)
-		buf[i] = 0;
-
-	//memset(buf, 0, size32);
-
-	uint32_t id = 0;
-	uint32_t start = 0;
-	uint8_t len = 0;
-	uint8_t j;
-
-	uint8_t count4 = 0;
+	uint32_t buf[(MAX_PROP_MEM_SIZE + 3) >> 2];
+	uint8_t *p = (uint8_t *)buf;
+	uint8_t i;
+	uint16_t layout;
 
-	for (i = 0; i < self._permanentPropCount; i++) {
-		start = self._propStartId[self._permanentProps[i]];
-		len = self._propLen[self._permanentProps[i]];
-		for (j = 0; j < len; j++) {
-			if (count4 == 4) {
-				id++;
-				count4 = 0;
-			}
+	memset(buf, 0, sizeof(buf));
 
-			buf[id] = buf[id] | (self._propBuffer[j + start] << (8 * count4));
+	for (i = 0; i < self._propCount; i++) {
+		if (!_isPermanentProp(i))
+			continue;
 
-			count4++;
-		}
+		layout = self._propLayout[i];
+		memcpy(p, &self._propBuffer[PROP_START(layout)], PROP_LEN(layout));
+		p += PROP_LEN(layout);
 	}
 
-	//תΪ32λַ
-	return flash_write(OTHER_PROP_FLASH_PAGE_ADDR, buf, size32);
+	//转换为32位的数组地址与个数
+	return flash_write(OTHER_PROP_FLASH_PAGE_ADDR, buf, (self._permanentPropSize + 3) >> 2);
 }
 
-//flashжȡ籣
+//从flash中读取掉电保护数据
 void _loadPropFromFlash() {
 	//load long address
 	flash_read(LONG_ADDR_FLASH_PAGE_ADDR, self._longAddr, 8);
+	memcpy(&self._propBuffer[PROP_START(self._propLayout[IOT_OBJ_LONG_ADDR])], self._longAddr,
+			PROP_LEN(self._propLayout[IOT_OBJ_LONG_ADDR]));
 
+	//Other properties，一次读出紧密排列的永久属性再分发到各属性
+	uint8_t buf[MAX_PROP_MEM_SIZE];
+	uint8_t *p = buf;
 	uint8_t i;
-	uint32_t start = 0;
-	start = self._propStartId[IOT_OBJ_LONG_ADDR];
-	for (i = 0; i < 8; i++)
-		self._propBuffer[start + i] = self._longAddr[i];
-
-	//Other properties
-	uint8_t j;
-	uint8_t len = 0;
-
-	for (i = 0; i < self._permanentPropCount; i++) {
-		start = self._propStartId[self._permanentProps[i]];
-		len = self._propLen[self._permanentProps[i]];
-
-		flash_read(OTHER_PROP_FLASH_PAGE_ADDR, &self._propBuffer[start], len);
-
-		//short addr
-		if (self._permanentProps[i] == IOT_OBJ_SHORT_ADDR) {
-			for (j = 0; j < len; j++)
-				self._shortAddr[j] = self._propBuffer[start + j];
-		}
+	uint16_t layout;
+
+	if (self._permanentPropSize == 0)
+		return;
+
+	flash_read(OTHER_PROP_FLASH_PAGE_ADDR, buf, self._permanentPropSize);
+
+	for (i = 0; i < self._propCount; i++) {
+		if (!_isPermanentProp(i))
+			continue;
+
+		layout = self._propLayout[i];
+		memcpy(&self._propBuffer[PROP_START(layout)], p, PROP_LEN(layout));
+		p += PROP_LEN(layout);
 	}
+
+	//short addr
+	memcpy(self._shortAddr, &self._propBuffer[PROP_START(self._propLayout[IOT_OBJ_SHORT_ADDR])], 2);
 }
 
 static void _init() {
@@ -233,14 +203,15 @@ iot_object_t * createSensorHandler(void) {
 
 	//private properties
 	self._propCount = 6;	//at least 3 properties
-	self._permanentPropCount = 1;	//at least 1 permanent prop (short addr)
-	self._permanentProps[0] = IOT_OBJ_SHORT_ADDR;
+	self._permanentPropMask = 1UL << IOT_OBJ_SHORT_ADDR;	//at least 1 permanent prop (short addr)
+	self._permanentPropSize = 0;
 
 	self._permanentPropModifyFlag = 0;
+	self._propModifyFlag = 0;
 
-	self._propLen[IOT_OBJ_INIT_ADDR] = 2;
-	self._propLen[IOT_OBJ_LONG_ADDR] = 8;
-	self._propLen[IOT_OBJ_SHORT_ADDR] = 2;
+	self._propLayout[IOT_OBJ_INIT_ADDR] = PROP_LAYOUT(0, 2);
+	self._propLayout[IOT_OBJ_LONG_ADDR] = PROP_LAYOUT(0, 8);
+	self._propLayout[IOT_OBJ_SHORT_ADDR] = PROP_LAYOUT(0, 2);
 
 	return &self;
 }
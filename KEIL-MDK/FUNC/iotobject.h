@@ -1,8 +1,8 @@
 /*
  * iotobject.h
- * вĻ࣬Ĺ뷽
- * c汾
- *  Created on: 201921
+ * 描述所有测点的基类，包含测点的公共属性与方法定义
+ * （c版本）
+ *  Created on: 2019年2月1日
  *      Author: xuhui
  */
 
@@ -11,8 +11,14 @@
 
 #include "main.h"
 
-#define MAX_PROP_COUNT	256			//֧256
-#define MAX_PROP_MEM_SIZE	1024	//1024 bytes
+#define MAX_PROP_COUNT	16			//支持最多16个属性(不超过32，修改标志使用位图)
+#define MAX_PROP_MEM_SIZE	64		//所有属性最大64 bytes
+#define MAX_PROP_LEN		63		//单个属性最大长度
+
+//属性布局：低10位为属性在property buffer中的起始位置，高6位为属性长度
+#define PROP_LAYOUT(start, len)		((uint16_t)(((len) << 10) | ((start) & 0X3FF)))
+#define PROP_START(layout)			((layout) & 0X3FF)
+#define PROP_LEN(layout)			((layout) >> 10)
 
 
 #ifdef TH_STM32f103C8T6
@@ -26,44 +32,44 @@
 #define OTHER_PROP_FLASH_PAGE_ADDR	ADDR_FLASH_PAGE_86	//page 63
 #endif
 
-//Ժ
+//属性号
 enum {
 	IOT_OBJ_INIT_ADDR, IOT_OBJ_LONG_ADDR, IOT_OBJ_SHORT_ADDR
 };
 
-//
+//测点基类
 typedef struct iot_object {
 	//Public functions
 	uint8_t (*isPropChanged)(uint8_t id);
 	void (*resetPropChangeFlag)(uint8_t id);
 
-	//Ը
+	//设置属性个数
 	void (*setPropCount)(uint8_t len);
 
-	//Գ
+	//设置属性长度
 	void (*setPropLen)(uint8_t id, uint8_t len);
 
 	uint8_t (*getPropLen)(uint8_t id);
 
-	//ʼʼַ籣Ե
+	//初始化属性起始地址、掉电保护属性等
 	void (*init)();
 
-	//ȡbufеݣд뱾ĳ(жǷԱ޸ˣ־һҪдflash)
+	//读取buf中的数据，写入本测点的某个属性中(并且判断是否有永久属性被修改了，标志一下需要写入flash)
 	void (*writePropFromBuf)(uint8_t id, uint8_t *buf);
 
-	//ĳԵݶⲿbuf
+	//将某个属性的数据读到外部buf中
 	void (*readPropToBuf)(uint8_t id, uint8_t *buf);
 
-	//ַǷһ£һΪ1Ϊ0
+	//长地址是否一致，如果一致为1，否则为0
 	uint8_t (*isLongAddrEq)(uint8_t *addr);
 
-	//̵ַǷһ£һΪ1Ϊ0
+	//短地址是否一致，如果一致为1，否则为0
 	uint8_t (*isShortAddrEq)(uint8_t *addr);
 
-	//ַ洢flash
+	//将长地址存储到flash中
 	uint8_t (*saveLongAddr2Flash)();
 
-	//Դ洢flash
+	//将永久属性存储到flash中
 	uint8_t (*saveProp2Flash)();
 
 	//Private properties
@@ -72,19 +78,18 @@ typedef struct iot_object {
 	uint8_t _longAddr[8];			//long address
 	uint8_t _propCount;				//total number of properties
 
-	uint8_t _propBuffer[MAX_PROP_MEM_SIZE];	//property buffer (max: 256 properties)
-	uint8_t _propLen[MAX_PROP_COUNT];			//ڴĳpropertyֽڳ
-	uint8_t _propStartId[MAX_PROP_COUNT];//ڴĳpropertyproperty bufferеʵλ
+	uint8_t _propBuffer[MAX_PROP_MEM_SIZE];	//property buffer
+	uint16_t _propLayout[MAX_PROP_COUNT];	//属性起始位置与长度，见PROP_LAYOUT
 
-	//ڴ洢Ҫ籣Ժ(ַ⣬Ĭϳַдģڶflashҳϣ⾭)
-	uint8_t _permanentProps[MAX_PROP_COUNT];
-	uint8_t _permanentPropCount;	//the total amount of permanent properties
+	//需要掉电保护的属性位图(长地址除外，默认长地址就是写保护的，并且在独立的flash页上，避免经常擦除)
+	uint32_t _permanentPropMask;
+	uint8_t _permanentPropSize;		//掉电保护属性总长度
 	uint8_t _permanentPropModifyFlag;//indicate some permanent properties have been modified
-	uint8_t _propModifyFlag[MAX_PROP_COUNT];
+	uint32_t _propModifyFlag;		//属性修改标志位图
 
 } iot_object_t;
 
-//һܲ
+//创建一个智能测点
 iot_object_t * createSensorHandler(void);
 
 #endif /* IOTOBJECT_H_ */
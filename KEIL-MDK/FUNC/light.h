@@ -4,12 +4,12 @@
 
 
 #if (SYS_HW_VERSION == SYS_HW_VERSION_V0_3_0)
-#define LED_1_PIN					16 //̵
-#define LED_2_PIN					15 //
+#define LED_1_PIN					16 //绿灯
+#define LED_2_PIN					15 //红灯
 #elif (SYS_HW_VERSION == SYS_HW_VERSION_V0_1_1)
-#define LED_1_PIN					20 //̵
-#define LED_2_PIN					19 //
-#define LED_3_PIN					18 //
+#define LED_1_PIN					20 //绿灯
+#define LED_2_PIN					19 //红灯
+#define LED_3_PIN					18 //蓝灯
 #endif
 
 #define LIGHT_1_ON()				nrf_gpio_pin_clear(LED_1_PIN)
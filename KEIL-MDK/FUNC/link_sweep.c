@@ -0,0 +1,287 @@
+#include "link_sweep.h"
+#include "string.h"
+#include "uart_svc.h"
+#include "lora_transmission.h"
+#include "wireless_comm_services.h"
+#include "host_net_swap.h"
+#include "mono_clock.h"
+#include "rx_filter.h"
+
+
+/*
+ * 网关在两个时间点切换射频参数：回复CMD_SWEEP之后切换到组合参数；组合测试帧收齐或回退超时之后
+ * 恢复基准参数。收齐时最后一帧的回复还没有发出，恢复放到Proc中在回复之后执行。
+ * 组合测试期间网关只在组合参数下接收，其他测点的数据帧收不到，测点按重发机制补发。
+ */
+
+#define LINK_SWEEP_TEST_SEQ_LEN				12 //测试帧数据段包含测试序号与往返时间的最小长度
+#define LINK_SWEEP_CMD_DATA_LEN				8 //CMD_SWEEP数据段中组合参数长度
+
+static LinkSweep_t link_sweep;
+static uint32_t last_rx_time; //最近一次收到目标测点测试帧的时间，单位ms
+static uint8_t cell_end; //当前组合测试帧已收齐，等待恢复基准参数
+
+static void link_sweep_cell_cfg(link_sweep_cell_t* cell, Lora_RadioCfg_t* cfg)
+{
+	cfg->sf = cell->sf;
+	cfg->bw = cell->bw;
+	cfg->power = cell->power;
+}
+
+static uint8_t LinkSweep_Start(link_sweep_matrix_t* p_matrix)
+{
+	uint8_t nums = p_matrix->sf_nums * p_matrix->bw_nums * p_matrix->power_nums * p_matrix->len_nums;
+	link_sweep_cell_t* cell;
+	
+	if(nums == 0 || nums > LINK_SWEEP_MAX_CELLS || 
+	   p_matrix->frames == 0 || p_matrix->frames > LINK_SWEEP_MAX_FRAMES)
+	{
+		return 0;
+	}
+	
+	link_sweep.Stop();
+	
+	memcpy(link_sweep.long_addr, p_matrix->long_addr, 8);
+	link_sweep.frames = p_matrix->frames;
+	link_sweep.cell_nums = 0;
+	link_sweep.cell_index = 0;
+	memset(link_sweep.cell, 0, sizeof(link_sweep.cell));
+	
+	//按扩频因子、带宽、功率、载荷长度顺序展开
+	for(int i = 0; i < p_matrix->sf_nums; i++)
+	{
+		for(int j = 0; j < p_matrix->bw_nums; j++)
+		{
+			for(int k = 0; k < p_matrix->power_nums; k++)
+			{
+				for(int l = 0; l < p_matrix->len_nums; l++)
+				{
+					cell = &link_sweep.cell[link_sweep.cell_nums++];
+					cell->sf = p_matrix->sf[i];
+					cell->bw = p_matrix->bw[j];
+					cell->power = p_matrix->power[k];
+					cell->len = p_matrix->len[l];
+					cell->snr_min = INT8_MAX;
+					cell->snr_max = INT8_MIN;
+					cell->rssi_min = INT16_MAX;
+					cell->rssi_max = INT16_MIN;
+					cell->rtt_min = UINT16_MAX;
+				}
+			}
+		}
+	}
+	
+	cell_end = 0;
+	last_rx_time = Mono_ClockGetMs();
+	link_sweep.state = LINK_SWEEP_WAIT_NODE;
+	
+	return 1;
+}
+
+static void LinkSweep_Stop(void)
+{
+	if(link_sweep.state == LINK_SWEEP_CELL)
+	{
+		LORA_RadioApply(NULL);
+	}
+	
+	if(link_sweep.state == LINK_SWEEP_WAIT_NODE || link_sweep.state == LINK_SWEEP_CELL)
+	{
+		link_sweep.state = LINK_SWEEP_ABORT;
+	}
+	
+	cell_end = 0;
+}
+
+//基准参数下收到目标测点测试帧，下发当前组合参数并切换
+static void link_sweep_cell_enter(void)
+{
+	link_sweep_cell_t* cell = &link_sweep.cell[link_sweep.cell_index];
+	uint8_t data[LINK_SWEEP_CMD_DATA_LEN];
+	uint16_t fallback = LINK_SWEEP_FALLBACK_TIME;
+	Lora_RadioCfg_t cfg;
+	
+#if COMM_TRANSMISSION_MSB == 1
+	fallback = swap_htons(fallback);
+#endif
+	data[0] = link_sweep.cell_index;
+	data[1] = cell->sf;
+	data[2] = cell->bw;
+	data[3] = (uint8_t)cell->power;
+	data[4] = cell->len;
+	data[5] = link_sweep.frames;
+	memcpy(&data[6], (uint8_t*)&fallback, sizeof(fallback));
+	
+	Lora_TestCmdReply(CMD_SWEEP, data, sizeof(data));
+	
+	link_sweep_cell_cfg(cell, &cfg);
+	LORA_RadioApply(&cfg);
+	link_sweep.state = LINK_SWEEP_CELL;
+}
+
+//组合参数下收到目标测点测试帧，记录统计
+static void link_sweep_cell_record(uint8_t* p_frame, int16_t rssi, int8_t snr)
+{
+	link_sweep_cell_t* cell = &link_sweep.cell[link_sweep.cell_index];
+	uint8_t seq = cell->rx_nums;
+	uint16_t rtt = 0;
+	
+	if(p_frame[4] >= LINK_SWEEP_TEST_SEQ_LEN)
+	{
+		seq = p_frame[14];
+		memcpy((uint8_t*)&rtt, &p_frame[15], sizeof(rtt));
+#if COMM_TRANSMISSION_MSB == 1
+		rtt = swap_ntohs(rtt);
+#endif
+	}
+	
+	if(seq >= link_sweep.frames || (cell->seq_map & (1u << seq)))
+	{
+		return; //超出范围或重复帧
+	}
+	
+	cell->seq_map |= 1u << seq;
+	cell->rx_nums++;
+	
+	cell->rssi_sum += rssi;
+	cell->rssi_min = rssi < cell->rssi_min ? rssi : cell->rssi_min;
+	cell->rssi_max = rssi > cell->rssi_max ? rssi : cell->rssi_max;
+	cell->snr_sum += snr;
+	cell->snr_min = snr < cell->snr_min ? snr : cell->snr_min;
+	cell->snr_max = snr > cell->snr_max ? snr : cell->snr_max;
+	
+	//往返时间为测点测得的上一帧结果，0表示无效
+	if(rtt != 0)
+	{
+		cell->rtt_nums++;
+		cell->rtt_sum += rtt;
+		cell->rtt_min = rtt < cell->rtt_min ? rtt : cell->rtt_min;
+		cell->rtt_max = rtt > cell->rtt_max ? rtt : cell->rtt_max;
+	}
+	
+	if(cell->rx_nums >= link_sweep.frames || seq == link_sweep.frames - 1)
+	{
+		cell_end = 1;
+	}
+}
+
+static uint8_t LinkSweep_TestFrame(uint8_t* p_frame, uint8_t size, int16_t rssi, int8_t snr)
+{
+	if(link_sweep.state != LINK_SWEEP_WAIT_NODE && link_sweep.state != LINK_SWEEP_CELL)
+	{
+		return 0;
+	}
+	
+	if(size < RX_FILTER_HEAD_SIZE + 1 || memcmp(&p_frame[5], link_sweep.long_addr, 8) != 0)
+	{
+		return 0;
+	}
+	
+	last_rx_time = Mono_ClockGetMs();
+	
+	if(link_sweep.state == LINK_SWEEP_WAIT_NODE)
+	{
+		link_sweep_cell_enter();
+		return 1;
+	}
+	
+	link_sweep_cell_record(p_frame, rssi, snr);
+	return 0;
+}
+
+static void LinkSweep_Proc(void)
+{
+	uint32_t now = Mono_ClockGetMs();
+	
+	if(link_sweep.state == LINK_SWEEP_CELL)
+	{
+		if(cell_end == 0 && now - last_rx_time < LINK_SWEEP_FALLBACK_TIME * 1000u)
+		{
+			return;
+		}
+		
+		cell_end = 0;
+		LORA_RadioApply(NULL);
+		link_sweep.cell[link_sweep.cell_index].done = 1;
+		link_sweep.cell_index++;
+		last_rx_time = now;
+		link_sweep.state = link_sweep.cell_index < link_sweep.cell_nums ? LINK_SWEEP_WAIT_NODE : LINK_SWEEP_DONE;
+		
+		extern ctrl_class_t ctrl_class;
+		if(ctrl_class.print_ctrl & 0X02)
+		{
+			printf("链路扫描组合%d完成,收到%d/%d帧\n", link_sweep.cell_index - 1, 
+				   link_sweep.cell[link_sweep.cell_index - 1].rx_nums, link_sweep.frames);
+		}
+	}
+	else if(link_sweep.state == LINK_SWEEP_WAIT_NODE)
+	{
+		if(now - last_rx_time >= LINK_SWEEP_NODE_TIMEOUT * 1000u)
+		{
+			link_sweep.state = LINK_SWEEP_ABORT;
+		}
+	}
+}
+
+static uint16_t LinkSweep_Per(uint8_t index)
+{
+	link_sweep_cell_t* cell = &link_sweep.cell[index];
+	
+	if(index >= link_sweep.cell_nums || link_sweep.frames == 0)
+	{
+		return 0;
+	}
+	
+	return (uint16_t)((link_sweep.frames - cell->rx_nums) * 1000u / link_sweep.frames);
+}
+
+//按回复帧长度比较空中时间，相同时取发射功率低的组合
+static int LinkSweep_Best(void)
+{
+	int best = -1;
+	uint32_t best_toa = 0;
+	uint32_t toa;
+	link_sweep_cell_t* cell;
+	
+	for(int i = 0; i < link_sweep.cell_nums; i++)
+	{
+		cell = &link_sweep.cell[i];
+		if(!cell->done || LinkSweep_Per(i) > LINK_SWEEP_RELIABLE_PER)
+		{
+			continue;
+		}
+		
+		toa = LORA_TimeOnAirCfgUs(cell->sf, cell->bw, cell->len + 16 + RX_FILTER_FRAME_OVERHEAD);
+		if(best < 0 || toa < best_toa || (toa == best_toa && cell->power < link_sweep.cell[best].power))
+		{
+			best = i;
+			best_toa = toa;
+		}
+	}
+	
+	return best;
+}
+
+LinkSweep_t* LinkSweep_Init(void)
+{
+	link_sweep.state = LINK_SWEEP_IDLE;
+	link_sweep.cell_nums = 0;
+	link_sweep.cell_index = 0;
+	cell_end = 0;
+	
+	link_sweep.Start = LinkSweep_Start;
+	link_sweep.Stop = LinkSweep_Stop;
+	link_sweep.TestFrame = LinkSweep_TestFrame;
+	link_sweep.Proc = LinkSweep_Proc;
+	link_sweep.Best = LinkSweep_Best;
+	link_sweep.Per = LinkSweep_Per;
+	
+	return &link_sweep;
+}
+
+LinkSweep_t* LinkSweep_GetHandle(void)
+{
+	return &link_sweep;
+}
+
+
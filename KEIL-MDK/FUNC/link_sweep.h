@@ -0,0 +1,89 @@
+#ifndef __LINK_SWEEP_H__
+#define __LINK_SWEEP_H__
+#include "main.h"
+
+
+/*
+ * 链路扫描：主机指定测点与SF/带宽/功率/载荷长度组合，网关与测点逐个组合切换参数测试，
+ * 统计每个组合的丢包率、信号强度、信噪比与往返时间。
+ *
+ * 测点测试帧CMD_TEST数据段：长地址8+回复载荷长度1+测试序号1+上一次往返时间2(ms,网络字节序)
+ * 网关在基准参数下收到目标测点的测试帧后回复CMD_SWEEP，数据段：测点长地址8+网关长地址8+
+ * 组合序号1+扩频因子1+带宽序号1+发射功率1+载荷长度1+测试帧数1+回退时间2(s,网络字节序)。
+ * 双方随后切换到该组合，测点发送测试帧数个测试帧(序号从0开始)，网关逐帧回复CMD_TEST_RESP；
+ * 发送完毕或超过回退时间没有收到对方的帧，双方都回到基准参数，测点继续在基准参数下发送测试帧。
+ * 测点侧的扫描命令解析、测试帧打包与回退见wireless_comm_services的parseSweep/packSweepTest/sweepProc。
+ */
+
+#define LINK_SWEEP_LIST_SIZE				4 //每个参数最多4个取值
+#define LINK_SWEEP_MAX_CELLS				32 //最多测试组合数
+#define LINK_SWEEP_MAX_FRAMES				32 //每个组合最多测试帧数
+#define LINK_SWEEP_FALLBACK_TIME			20u //组合参数下超过该时间(s)没有收到测试帧则回到基准参数
+#define LINK_SWEEP_NODE_TIMEOUT				300u //基准参数下超过该时间(s)没有收到测试帧则终止扫描
+#define LINK_SWEEP_RELIABLE_PER				50u //丢包率不超过该值(0.1%)的组合视为可靠
+
+typedef enum {
+	LINK_SWEEP_IDLE, //未启动
+	LINK_SWEEP_WAIT_NODE, //基准参数下等待测点测试帧
+	LINK_SWEEP_CELL, //组合参数下测试
+	LINK_SWEEP_DONE, //全部组合完成
+	LINK_SWEEP_ABORT, //主机终止或测点失联
+}LinkSweep_State;
+
+/* 主机下发的测试矩阵 */
+typedef struct {
+	uint8_t long_addr[8]; //测点长地址
+	uint8_t sf[LINK_SWEEP_LIST_SIZE];
+	uint8_t bw[LINK_SWEEP_LIST_SIZE]; //带宽序号，同系统参数lora_bw
+	int8_t power[LINK_SWEEP_LIST_SIZE];
+	uint8_t len[LINK_SWEEP_LIST_SIZE]; //测试帧回复载荷长度
+	uint8_t sf_nums;
+	uint8_t bw_nums;
+	uint8_t power_nums;
+	uint8_t len_nums;
+	uint8_t frames; //每个组合的测试帧数
+}link_sweep_matrix_t;
+
+/* 单个组合的测试结果 */
+typedef struct {
+	uint8_t sf;
+	uint8_t bw;
+	int8_t power;
+	uint8_t len;
+	uint8_t done; //已测试
+	uint8_t rx_nums; //收到的测试帧数(不含重复帧)
+	uint8_t rtt_nums; //有效往返时间个数
+	int8_t snr_min;
+	int8_t snr_max;
+	int16_t snr_sum;
+	int16_t rssi_min;
+	int16_t rssi_max;
+	int32_t rssi_sum;
+	uint16_t rtt_min; //单位ms
+	uint16_t rtt_max;
+	uint32_t rtt_sum;
+	uint32_t seq_map; //已收到的测试序号
+}link_sweep_cell_t;
+
+typedef struct {
+	LinkSweep_State state;
+	uint8_t long_addr[8]; //测点长地址
+	uint8_t frames; //每个组合的测试帧数
+	uint8_t cell_nums;
+	uint8_t cell_index; //当前组合
+	link_sweep_cell_t cell[LINK_SWEEP_MAX_CELLS];
+	
+	uint8_t (*Start)(link_sweep_matrix_t* p_matrix); //组合数超出上限返回0
+	void (*Stop)(void);
+	uint8_t (*TestFrame)(uint8_t* p_frame, uint8_t size, int16_t rssi, int8_t snr); //已回复返回1
+	void (*Proc)(void);
+	int (*Best)(void); //空中时间最短的可靠组合，没有返回-1
+	uint16_t (*Per)(uint8_t index); //组合丢包率，单位0.1%
+}LinkSweep_t;
+
+LinkSweep_t* LinkSweep_Init(void);
+LinkSweep_t* LinkSweep_GetHandle(void);
+
+#endif
+
+
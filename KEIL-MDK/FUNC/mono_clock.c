@@ -0,0 +1,51 @@
+#include "mono_clock.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+
+
+static uint64_t m_mono_ticks = 0; //累计计数值
+static uint32_t m_mono_counter = 0; //上次读取的RTC计数器值
+
+APP_TIMER_DEF(m_mono_guard_id);
+
+/* 定时读取一次计数器，保证两次读取间隔小于RTC计数器溢出时间 */
+static void Mono_ClockGuardCallback(void* param)
+{
+	(void)Mono_ClockGetTicks();
+}
+
+uint64_t Mono_ClockGetTicks(void)
+{
+	uint64_t ticks;
+	
+	CRITICAL_REGION_ENTER();
+	uint32_t counter = app_timer_cnt_get();
+	m_mono_ticks += (counter - m_mono_counter) & MONO_CLOCK_COUNTER_MASK;
+	m_mono_counter = counter;
+	ticks = m_mono_ticks;
+	CRITICAL_REGION_EXIT();
+	
+	return ticks;
+}
+
+/* 毫秒计数，49天回绕，用于无符号差值计算超时 */
+uint32_t Mono_ClockGetMs(void)
+{
+	return (uint32_t)MONO_CLOCK_TICKS_TO_MS(Mono_ClockGetTicks());
+}
+
+/* 需在app_timer_init之后调用 */
+void Mono_ClockInit(void)
+{
+	m_mono_ticks = 0;
+	m_mono_counter = app_timer_cnt_get();
+	
+	app_timer_create(&m_mono_guard_id,
+					 APP_TIMER_MODE_REPEATED,
+					 Mono_ClockGuardCallback);
+	app_timer_start(m_mono_guard_id, APP_TIMER_TICKS(MONO_CLOCK_GUARD_INTERVAL), NULL);
+}
+
+
+
+
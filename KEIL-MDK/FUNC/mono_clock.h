@@ -0,0 +1,24 @@
+#ifndef __MONO_CLOCK_H__
+#define __MONO_CLOCK_H__
+#include "main.h"
+
+
+/* 单调时钟，基于app_timer使用的RTC1计数器(24位)扩展为64位，不随校时变化 */
+#define MONO_CLOCK_FREQ						32768u //时钟频率，单位Hz(APP_TIMER_CONFIG_RTC_FREQUENCY为0)
+#define MONO_CLOCK_COUNTER_MASK				0X00FFFFFF //RTC计数器位宽
+#define MONO_CLOCK_GUARD_INTERVAL			60000u //溢出保护定时周期，单位ms(需小于计数器溢出时间512s)
+
+#define MONO_CLOCK_TICKS_TO_MS(ticks)		(((ticks) * 1000u) >> 15)
+#define MONO_CLOCK_TICKS_TO_US(ticks)		(((ticks) * 15625u) >> 9)
+#define MONO_CLOCK_MS_TO_TICKS(ms)			((((uint64_t)(ms)) << 15) / 1000u)
+#define MONO_CLOCK_US_TO_TICKS(us)			((((uint64_t)(us)) << 9) / 15625u)
+
+void Mono_ClockInit(void);
+uint64_t Mono_ClockGetTicks(void);
+uint32_t Mono_ClockGetMs(void);
+
+#endif
+
+
+
+
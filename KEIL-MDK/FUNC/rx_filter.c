@@ -0,0 +1,138 @@
+#include "rx_filter.h"
+#include "string.h"
+#include "uart_svc.h"
+
+
+/*
+ * 上行帧早期过滤：接收完成后先只读出帧头，检查命令类型、长度字节与测点长地址，
+ * 不属于本网络的帧(相邻网络、其他网关下行等)不再读取数据段，也不进入接收缓存、
+ * 日志和串口输出。测点连接帧与丢包率测试帧不检查长地址，新测点可以正常入网。
+ * dev_ctrl 0X04关闭时只计数不丢弃长地址不符的帧。
+ */
+
+static RxFilter_t rx_filter;
+static uint32_t bloom[RX_FILTER_BLOOM_BITS / 32];
+
+//长地址的两个32位哈希(FNV-1a与其变体)，第i个哈希为h1+i*h2
+static void rx_filter_hash(uint8_t* long_addr, uint32_t* h1, uint32_t* h2)
+{
+	uint32_t a = 2166136261u;
+	uint32_t b = 0X9E3779B9u;
+	
+	for(int i = 0; i < 8; i++)
+	{
+		a = (a ^ long_addr[i]) * 16777619u;
+		b = (b ^ long_addr[7 - i]) * 0X01000193u + 0X7F4A7C15u;
+	}
+	
+	*h1 = a;
+	*h2 = b | 0X01; //奇数步长，各哈希位置不重合
+}
+
+static void RxFilter_Add(uint8_t* long_addr)
+{
+	uint32_t h1, h2, bit;
+	
+	rx_filter_hash(long_addr, &h1, &h2);
+	for(int i = 0; i < RX_FILTER_BLOOM_HASHES; i++)
+	{
+		bit = (h1 + i * h2) & (RX_FILTER_BLOOM_BITS - 1);
+		bloom[bit / 32] |= 1u << (bit % 32);
+	}
+	
+	if(rx_filter.addr_nums < 0XFF)
+	{
+		rx_filter.addr_nums++;
+	}
+}
+
+static uint8_t rx_filter_addr_allowed(uint8_t* long_addr)
+{
+	uint32_t h1, h2, bit;
+	
+	rx_filter_hash(long_addr, &h1, &h2);
+	for(int i = 0; i < RX_FILTER_BLOOM_HASHES; i++)
+	{
+		bit = (h1 + i * h2) & (RX_FILTER_BLOOM_BITS - 1);
+		if(!(bloom[bit / 32] & (1u << (bit % 32))))
+		{
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+static void RxFilter_Clear(void)
+{
+	memset(bloom, 0, sizeof(bloom));
+	rx_filter.addr_nums = 0;
+}
+
+static RxFilter_Result rx_filter_check(uint8_t* p_head, uint8_t head_len, uint8_t frame_len)
+{
+	extern ctrl_class_t ctrl_class;
+	
+	if(head_len < RX_FILTER_HEAD_SIZE)
+	{
+		return RX_FILTER_DROP_SHORT;
+	}
+	
+	//命令头高3字节为0
+	if(p_head[0] != 0 || p_head[1] != 0 || p_head[2] != 0 ||
+	   (p_head[3] != RX_FILTER_CMD_CONN && p_head[3] != RX_FILTER_CMD_DATA && p_head[3] != RX_FILTER_CMD_LOST_RATE &&
+	    p_head[3] != RX_FILTER_CMD_BLOCK))
+	{
+		return RX_FILTER_DROP_CMD;
+	}
+	
+	if(p_head[4] + RX_FILTER_FRAME_OVERHEAD != frame_len)
+	{
+		return RX_FILTER_DROP_LEN;
+	}
+	
+	if((p_head[3] == RX_FILTER_CMD_DATA || p_head[3] == RX_FILTER_CMD_BLOCK) && !rx_filter_addr_allowed(&p_head[RX_FILTER_ADDR_OFFSET]))
+	{
+		if(ctrl_class.dev_ctrl & 0X04)
+		{
+			return RX_FILTER_DROP_ADDR;
+		}
+		rx_filter.nums[RX_FILTER_DROP_ADDR]++; //过滤关闭时只计数
+	}
+	
+	return RX_FILTER_PASS;
+}
+
+static RxFilter_Result RxFilter_Check(uint8_t* p_head, uint8_t head_len, uint8_t frame_len)
+{
+	RxFilter_Result result = rx_filter_check(p_head, head_len, frame_len);
+	
+	rx_filter.nums[result]++;
+	return result;
+}
+
+//允许列表由已连接测点生成，测点信息在Sys_ParamInit中已从flash恢复
+RxFilter_t* RxFilter_Init(void)
+{
+	extern peer_data_t peer_data;
+	
+	memset(rx_filter.nums, 0, sizeof(rx_filter.nums));
+	RxFilter_Clear();
+	for(int i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		RxFilter_Add(peer_data.peer_attr[i].long_addr);
+	}
+	
+	rx_filter.Check = RxFilter_Check;
+	rx_filter.Add = RxFilter_Add;
+	rx_filter.Clear = RxFilter_Clear;
+	
+	return &rx_filter;
+}
+
+RxFilter_t* RxFilter_GetHandle(void)
+{
+	return &rx_filter;
+}
+
+
@@ -0,0 +1,45 @@
+#ifndef __RX_FILTER_H__
+#define __RX_FILTER_H__
+#include "main.h"
+
+
+/* 上行帧格式：命令头(4字节,网络字节序)+数据段长度(1字节)+数据段(测点长地址8字节开头)+CRC16 */
+#define RX_FILTER_HEAD_SIZE					13 //过滤检查的帧头长度(命令头+长度+长地址)
+#define RX_FILTER_FRAME_OVERHEAD			7 //帧长度=数据段长度+命令头4+长度1+CRC16 2
+#define RX_FILTER_ADDR_OFFSET				5 //长地址在帧中的位置
+
+/* 上行命令 */
+#define RX_FILTER_CMD_CONN					0X01 //测点连接
+#define RX_FILTER_CMD_DATA					0X03 //数据上行
+#define RX_FILTER_CMD_LOST_RATE				0X05 //丢包率测试
+#define RX_FILTER_CMD_BLOCK					0X09 //块传输分片
+
+/* 测点长地址布隆过滤器，容量GATEWAY_CAP_SIZE(200)时误判率约0.9% */
+#define RX_FILTER_BLOOM_BITS				2048 //位数，必须为2的幂
+#define RX_FILTER_BLOOM_HASHES				5 //哈希函数个数
+
+/* 丢弃原因 */
+typedef enum {
+	RX_FILTER_PASS, //通过
+	RX_FILTER_DROP_SHORT, //帧长度不足帧头
+	RX_FILTER_DROP_CMD, //非本网络命令
+	RX_FILTER_DROP_LEN, //长度字节与帧长度不符
+	RX_FILTER_DROP_ADDR, //长地址不在允许列表
+	RX_FILTER_RESULT_NUMS,
+}RxFilter_Result;
+
+typedef struct {
+	uint32_t nums[RX_FILTER_RESULT_NUMS]; //各结果计数，nums[RX_FILTER_PASS]为通过帧数
+	uint8_t addr_nums; //允许列表中的测点数
+	
+	RxFilter_Result (*Check)(uint8_t* p_head, uint8_t head_len, uint8_t frame_len); //p_head:帧头，frame_len:帧长度
+	void (*Add)(uint8_t* long_addr);
+	void (*Clear)(void);
+}RxFilter_t;
+
+RxFilter_t* RxFilter_Init(void);
+RxFilter_t* RxFilter_GetHandle(void);
+
+#endif
+
+
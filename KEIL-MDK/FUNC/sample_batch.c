@@ -0,0 +1,200 @@
+#include "sample_batch.h"
+#include "string.h"
+#include "math.h"
+
+
+static SampleBatch_t sample_batch;
+
+static sample_batch_item_t* sample_batch_item(uint8_t n)
+{
+	return &sample_batch.item[(sample_batch.head + n) % SAMPLE_BATCH_MAX_NUMS];
+}
+
+static void sample_batch_put_u16(uint8_t* p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0XFF;
+}
+
+static void sample_batch_put_u32(uint8_t* p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0XFF;
+	p[2] = (v >> 8) & 0XFF;
+	p[3] = v & 0XFF;
+}
+
+static void sample_batch_put_float(uint8_t* p, float v)
+{
+	uint32_t u;
+	memcpy(&u, &v, sizeof(u));
+	sample_batch_put_u32(p, u);
+}
+
+//增量按分辨率取整，超出16位返回0
+static uint8_t sample_batch_delta(float delta, float scale, int16_t* out)
+{
+	float v = roundf(delta * scale);
+	
+	if(v > INT16_MAX || v < INT16_MIN)
+	{
+		return 0;
+	}
+	
+	*out = (int16_t)v;
+	return 1;
+}
+
+//第n个采样相对基准采样的批量段编码，时间偏移或增量超出16位返回0
+static uint8_t sample_batch_encode(uint8_t n, uint8_t* p)
+{
+	sample_batch_item_t* base = sample_batch_item(0);
+	sample_batch_item_t* item = sample_batch_item(n);
+	uint32_t offset = item->time_stamp - base->time_stamp;
+	int16_t delta;
+	
+	if(offset > UINT16_MAX)
+	{
+		return 0;
+	}
+	sample_batch_put_u16(p, (uint16_t)offset);
+	
+	if(sample_batch_delta(item->temp - base->temp, SAMPLE_BATCH_TEMP_SCALE, &delta) == 0)
+	{
+		return 0;
+	}
+	sample_batch_put_u16(p + 2, (uint16_t)delta);
+	
+	for(uint8_t i = 0; i < sample_batch.value_nums; i++)
+	{
+		if(sample_batch_delta(item->value[i] - base->value[i], SAMPLE_BATCH_VALUE_SCALE, &delta) == 0)
+		{
+			return 0;
+		}
+		sample_batch_put_u16(p + 4 + i * 2, (uint16_t)delta);
+	}
+	
+	return 1;
+}
+
+static uint8_t SampleBatch_Push(uint32_t time_stamp, float temp, float* value, uint8_t nums)
+{
+	sample_batch_item_t* item;
+	
+	if(nums > SAMPLE_BATCH_VALUE_NUMS || sample_batch.count >= SAMPLE_BATCH_MAX_NUMS ||
+	   (sample_batch.count > 0 && nums != sample_batch.value_nums))
+	{
+		return 0;
+	}
+	
+	item = sample_batch_item(sample_batch.count);
+	item->time_stamp = time_stamp;
+	item->temp = temp;
+	memcpy(item->value, value, nums * sizeof(float));
+	sample_batch.value_nums = nums;
+	sample_batch.count++;
+	
+	return 1;
+}
+
+static uint8_t SampleBatch_Ready(uint32_t time_stamp, uint32_t period)
+{
+	if(sample_batch.count == 0)
+	{
+		return 0;
+	}
+	
+	return sample_batch.count >= SAMPLE_BATCH_MAX_NUMS || time_stamp - sample_batch_item(0)->time_stamp >= period;
+}
+
+static uint8_t SampleBatch_Pack(uint8_t* buf, uint8_t size, uint8_t battery, int8_t downlink_rssi, uint16_t fcnt, uint8_t flags)
+{
+	uint8_t nums = sample_batch.value_nums;
+	sample_batch_item_t* base = sample_batch_item(0);
+	uint8_t len = 0;
+	uint8_t batch_nums = 0;
+	uint8_t flags_index;
+	
+	if(sample_batch.count == 0 || size < SAMPLE_BATCH_BASE_SIZE(nums) + 1)
+	{
+		return 0;
+	}
+	
+	/* 基准采样，格式与单采样数据帧相同 */
+	sample_batch_put_u32(&buf[len], base->time_stamp);
+	len += 4;
+	buf[len++] = battery;
+	sample_batch_put_float(&buf[len], base->temp);
+	len += 4;
+	buf[len++] = (uint8_t)downlink_rssi;
+	for(uint8_t i = 0; i < nums; i++, len += 4)
+	{
+		sample_batch_put_float(&buf[len], base->value[i]);
+	}
+	sample_batch_put_u16(&buf[len], fcnt);
+	len += 2;
+	flags_index = len;
+	buf[len++] = flags;
+	
+	/* 批量段，放不下或增量超出范围的采样留到下一帧 */
+	len++;
+	while(batch_nums + 1 < sample_batch.count && len + SAMPLE_BATCH_SIZE(nums) <= size)
+	{
+		if(sample_batch_encode(batch_nums + 1, &buf[len]) == 0)
+		{
+			break;
+		}
+		len += SAMPLE_BATCH_SIZE(nums);
+		batch_nums++;
+	}
+	
+	if(batch_nums > 0)
+	{
+		buf[flags_index] |= SAMPLE_BATCH_UPLINK_FLAG;
+		buf[flags_index + 1] = batch_nums;
+	}
+	else
+	{
+		len--;
+	}
+	
+	sample_batch.head = (sample_batch.head + batch_nums + 1) % SAMPLE_BATCH_MAX_NUMS;
+	sample_batch.count -= batch_nums + 1;
+	
+	return len;
+}
+
+static void SampleBatch_Drop(void)
+{
+	if(sample_batch.count > 0)
+	{
+		sample_batch.head = (sample_batch.head + 1) % SAMPLE_BATCH_MAX_NUMS;
+		sample_batch.count--;
+	}
+}
+
+static void SampleBatch_Clear(void)
+{
+	sample_batch.head = 0;
+	sample_batch.count = 0;
+}
+
+SampleBatch_t* SampleBatch_Init(void)
+{
+	memset(&sample_batch, 0, sizeof(sample_batch));
+	
+	sample_batch.Push = SampleBatch_Push;
+	sample_batch.Ready = SampleBatch_Ready;
+	sample_batch.Pack = SampleBatch_Pack;
+	sample_batch.Drop = SampleBatch_Drop;
+	sample_batch.Clear = SampleBatch_Clear;
+	
+	return &sample_batch;
+}
+
+SampleBatch_t* SampleBatch_GetHandle(void)
+{
+	return &sample_batch;
+}
+
+
@@ -0,0 +1,48 @@
+#ifndef __SAMPLE_BATCH_H__
+#define __SAMPLE_BATCH_H__
+#include "main.h"
+
+
+/*
+ * 测点批量采样：按采样间隔(interval)采样写入环形缓存，每个上报周期(period)合并为一帧上行，
+ * 减少每个采样点分摊的前导码、帧头、地址、CRC开销与射频唤醒次数。
+ *
+ * 批量帧仍为CMD_PUBLISH数据帧，最早的采样作为基准采样按原格式填写(时间戳+电量+温度+下行信号强度+测量值+帧计数+上行标志)，
+ * 上行标志带0X04时其后为批量段：采样个数1+每个采样(时间偏移2(s)+温度增量2+测量值增量个数*2)，
+ * 均为网络字节序16位数，增量相对基准采样。旧网关忽略批量段，只解析基准采样。
+ */
+
+#define SAMPLE_BATCH_UPLINK_FLAG			0X04 //上行标志中的批量段标志，同网关PEER_UPLINK_BATCH
+#define SAMPLE_BATCH_MAX_NUMS				12 //环形缓存采样个数
+#define SAMPLE_BATCH_VALUE_NUMS				6 //每个采样最多测量值个数
+#define SAMPLE_BATCH_TEMP_SCALE				100 //温度增量分辨率0.01℃
+#define SAMPLE_BATCH_VALUE_SCALE			1000 //测量值增量分辨率0.001(角度°/加速度g)
+#define SAMPLE_BATCH_SIZE(nums)				(4 + (nums) * 2) //批量段中每个采样的字节数
+#define SAMPLE_BATCH_BASE_SIZE(nums)		(13 + (nums) * 4) //基准采样从时间戳到上行标志的字节数
+
+typedef struct {
+	uint32_t time_stamp; //采样时间戳
+	float temp; //温度
+	float value[SAMPLE_BATCH_VALUE_NUMS]; //测量值
+}sample_batch_item_t;
+
+typedef struct {
+	uint8_t head; //最早采样位置
+	uint8_t count; //缓存采样个数
+	uint8_t value_nums; //每个采样测量值个数
+	sample_batch_item_t item[SAMPLE_BATCH_MAX_NUMS];
+	
+	uint8_t (*Push)(uint32_t time_stamp, float temp, float* value, uint8_t nums); //缓存已满或测量值个数与缓存中不同返回0，需先发送
+	uint8_t (*Ready)(uint32_t time_stamp, uint32_t period); //缓存已满或最早采样距今达到上报周期返回1
+	//从时间戳开始填写基准采样与批量段，返回长度，已填写的采样移出缓存；增量超出16位的采样留到下一帧
+	uint8_t (*Pack)(uint8_t* buf, uint8_t size, uint8_t battery, int8_t downlink_rssi, uint16_t fcnt, uint8_t flags);
+	void (*Drop)(void); //丢弃最早采样
+	void (*Clear)(void);
+}SampleBatch_t;
+
+SampleBatch_t* SampleBatch_Init(void);
+SampleBatch_t* SampleBatch_GetHandle(void);
+
+#endif
+
+
@@ -1,183 +1,394 @@
+#include "nrf_drv_timer.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_gpiote.h"
+#include "nrf_spim.h"
 #include "sca100t.h"
 #include "nrf_gpio.h"
+#include "nrf_delay.h"
+#include "app_util_platform.h"
 
 
-#define SCA_SW_SPI_SCK_SET()			nrf_gpio_pin_set(SCA_SW_SPI_SCK_PIN)
-#define SCA_SW_SPI_SCK_CLR()			nrf_gpio_pin_clear(SCA_SW_SPI_SCK_PIN)
-#define SCA_SW_SPI_MOSI_SET()			nrf_gpio_pin_set(SCA_SW_SPI_MOSI_PIN)
-#define SCA_SW_SPI_MOSI_CLR()			nrf_gpio_pin_clear(SCA_SW_SPI_MOSI_PIN)
-#define SCA_SW_SPI_CS_ENABLE()		nrf_gpio_pin_clear(SCA_SW_SPI_CS_PIN)
-#define SCA_SW_SPI_CS_DISABLE()		nrf_gpio_pin_set(SCA_SW_SPI_CS_PIN)
-#define SCA_SW_SPI_MISO_READ() 		nrf_gpio_pin_read(SCA_SW_SPI_MISO_PIN)
+#define SCA_SPI_CS_ENABLE()			nrf_gpio_pin_clear(SCA_SPI_CS_PIN)
+#define SCA_SPI_CS_DISABLE()		nrf_gpio_pin_set(SCA_SPI_CS_PIN)
 
+#define SCA_XFER_LEN				3 //命令8位+数据16位，加速度数据取高11位，温度数据取高8位
+#define SCA_XFER_MAX_US				60u //单次传输最长时间(500kHz 3字节48us)
 
-static void SCA_DelayUs(uint32_t nus)
-{
-		uint16_t i=0;  
-		while(nus--)
-		{
-			i=10;
-			while(i--); 
-		}
-}
+#if NRFX_CHECK(NRFX_SPIM_NRF52_ANOMALY_109_WORKAROUND_ENABLED)
+#define SCA_BURST_END_PER_XFER		2 //每次读取先有一次长度为0的传输，SPIM结束事件计数加倍
+#else
+#define SCA_BURST_END_PER_XFER		1
+#endif
+
+static const nrf_drv_timer_t sca_burst_timer = NRF_DRV_TIMER_INSTANCE(SCA_BURST_TIMER_INSTANCE);
+static const nrf_drv_timer_t sca_count_timer = NRF_DRV_TIMER_INSTANCE(SCA_COUNT_TIMER_INSTANCE);
+static nrf_ppi_channel_t sca_burst_ppi[3];
+static uint8_t sca_burst_init = 0;
+static volatile uint8_t sca_burst_busy = 0;
+static volatile uint8_t sca_burst_done = 0;
+static volatile uint8_t sca_burst_index = 0; //勘误109规避时下一次传输的缓冲区序号
+static uint8_t sca_burst_tx[SCA_BURST_MAX_TIMES * 2][SCA_XFER_LEN]; //X、Y通道读命令交替排列
+static uint8_t sca_burst_rx[SCA_BURST_MAX_TIMES * 2][SCA_XFER_LEN];
+
+__weak void SCA_BurstDoneHandler(void);
+static void SCA_BurstRestore(void);
 
-static void SCA_SW_SPI_Config(void)
+static void SCA_SPI_Config(void)
 {
-	nrf_gpio_cfg(SCA_SW_SPI_SCK_PIN,
+	nrf_gpio_pin_clear(SCA_SPI_SCK_PIN);
+	nrf_gpio_cfg(SCA_SPI_SCK_PIN,
 							 NRF_GPIO_PIN_DIR_OUTPUT,
-							 NRF_GPIO_PIN_INPUT_DISCONNECT,
+							 NRF_GPIO_PIN_INPUT_CONNECT,
 							 NRF_GPIO_PIN_NOPULL,
 							 NRF_GPIO_PIN_S0S1,
 							 NRF_GPIO_PIN_NOSENSE);
 	
-	nrf_gpio_cfg(SCA_SW_SPI_MOSI_PIN,
+	nrf_gpio_pin_clear(SCA_SPI_MOSI_PIN);
+	nrf_gpio_cfg(SCA_SPI_MOSI_PIN,
 							 NRF_GPIO_PIN_DIR_OUTPUT,
 							 NRF_GPIO_PIN_INPUT_DISCONNECT,
 							 NRF_GPIO_PIN_NOPULL,
 							 NRF_GPIO_PIN_S0S1,
 							 NRF_GPIO_PIN_NOSENSE);
-
-	nrf_gpio_cfg(SCA_SW_SPI_MISO_PIN,
+	
+	nrf_gpio_cfg(SCA_SPI_MISO_PIN,
 							 NRF_GPIO_PIN_DIR_INPUT,
 							 NRF_GPIO_PIN_INPUT_CONNECT,
 //							 NRF_GPIO_PIN_NOPULL,
 							 NRF_GPIO_PIN_PULLDOWN,
 							 NRF_GPIO_PIN_S0S1,
 							 NRF_GPIO_PIN_NOSENSE);
-
-	nrf_gpio_cfg(SCA_SW_SPI_CS_PIN,
+	
+	SCA_SPI_CS_DISABLE();
+	nrf_gpio_cfg(SCA_SPI_CS_PIN,
 							 NRF_GPIO_PIN_DIR_OUTPUT,
 							 NRF_GPIO_PIN_INPUT_DISCONNECT,
 							 NRF_GPIO_PIN_NOPULL,
 							 NRF_GPIO_PIN_S0S1,
 							 NRF_GPIO_PIN_NOSENSE);
+	
+	nrf_spim_pins_set(SCA_SPIM, SCA_SPI_SCK_PIN, SCA_SPI_MOSI_PIN, SCA_SPI_MISO_PIN);
+	nrf_spim_frequency_set(SCA_SPIM, SCA_SPI_FREQ);
+	nrf_spim_configure(SCA_SPIM, NRF_SPIM_MODE_0, NRF_SPIM_BIT_ORDER_MSB_FIRST);
+	nrf_spim_orc_set(SCA_SPIM, 0X00);
+	nrf_spim_enable(SCA_SPIM);
 }
 
-static void SCA_SW_SPI_ConfigDefault(void)
+static void SCA_SPI_ConfigDefault(void)
 {
-	nrf_gpio_cfg_default(SCA_SW_SPI_SCK_PIN);
-	nrf_gpio_cfg_default(SCA_SW_SPI_MOSI_PIN);
-	nrf_gpio_cfg_default(SCA_SW_SPI_MISO_PIN);
-	nrf_gpio_cfg_default(SCA_SW_SPI_CS_PIN);
+	nrf_spim_disable(SCA_SPIM);
+	nrf_gpio_cfg_default(SCA_SPI_SCK_PIN);
+	nrf_gpio_cfg_default(SCA_SPI_MOSI_PIN);
+	nrf_gpio_cfg_default(SCA_SPI_MISO_PIN);
+	nrf_gpio_cfg_default(SCA_SPI_CS_PIN);
 }
 
-static void SCA_SW_SPI_TransmitReceive(uint16_t TxData, uint8_t TxBitSize, uint16_t *pRxData, uint8_t RxBitSize)
+//单次传输，命令之后的字节发送0，EasyDMA缓冲区须在RAM中
+//pRxData为NULL时只发送，接收长度为0(nRF52832勘误58：收发均为1字节时SPIM会多发送字节)
+static void SCA_SPI_TransmitReceive(uint8_t *pTxData, uint8_t *pRxData, uint8_t Size)
 {
-	SCA_SW_SPI_CS_ENABLE();
+	nrf_spim_tx_list_disable(SCA_SPIM);
+	nrf_spim_rx_list_disable(SCA_SPIM);
+	nrf_spim_tx_buffer_set(SCA_SPIM, pTxData, Size);
+	nrf_spim_rx_buffer_set(SCA_SPIM, pRxData, pRxData == NULL ? 0 : Size);
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_END);
 	
-	uint16_t txData = TxData;
-	uint16_t rxData = 0;
+	SCA_SPI_CS_ENABLE();
+	nrf_spim_task_trigger(SCA_SPIM, NRF_SPIM_TASK_START);
+	while(!nrf_spim_event_check(SCA_SPIM, NRF_SPIM_EVENT_END));
+	SCA_SPI_CS_DISABLE();
 	
-	if(TxBitSize != 0)
+	return;
+}
+
+//数据高位在命令之后的第一个字节，11位加速度数据
+static uint16_t SCA_ChannelData(uint8_t *pRxData)
+{
+	return ((uint16_t)pRxData[1] << 3) | (pRxData[2] >> 5);
+}
+
+static void sca_burst_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+}
+
+static void sca_count_timer_handler(nrf_timer_event_t event_type, void* p_context)
+{
+	if(event_type == NRF_TIMER_EVENT_COMPARE0)
 	{
-		for(int i=0; i<TxBitSize; i++)
-		{
-			SCA_SW_SPI_SCK_CLR();
-			if(txData & 0X80)
-			{
-				SCA_SW_SPI_MOSI_SET();
-			}
-			else
-			{
-				SCA_SW_SPI_MOSI_CLR();
-			}
-			txData <<= 1;
-			SCA_DelayUs(2);
-			SCA_SW_SPI_SCK_SET();
-			SCA_DelayUs(2);
-			
-			rxData <<= 1;
-			if(SCA_SW_SPI_MISO_READ())
-			{
-				rxData++;
-			}
-		}
-		SCA_SW_SPI_SCK_CLR();
+		SCA_BurstRestore();
+		sca_burst_done = 1;
+		SCA_BurstDoneHandler();
 	}
+}
+
+/* ch0:TIMER3 CC0->片选拉低+SPIM启动 ch1:SPIM结束->片选拉高+TIMER4计数 ch2:TIMER4 CC0->TIMER3停止 */
+static void SCA_BurstConfig(void)
+{
+	uint32_t err_code;
+	uint8_t i;
 	
-	if(RxBitSize != 0)
+	if(sca_burst_init == 1)
 	{
-		rxData = 0;
-		for(int i=0; i<RxBitSize; i++)
-		{
-			SCA_SW_SPI_SCK_CLR();
-			SCA_DelayUs(2);
-			SCA_SW_SPI_SCK_SET();
-			SCA_DelayUs(2);
-			rxData <<= 1;
-			if(SCA_SW_SPI_MISO_READ())
-			{
-				rxData++;
-			}
-		}
+		return;
 	}
-
-	if(pRxData != NULL)
+	
+	nrf_drv_timer_config_t timer_cfg = NRF_DRV_TIMER_DEFAULT_CONFIG;
+	timer_cfg.frequency = NRF_TIMER_FREQ_1MHz;
+	timer_cfg.bit_width = NRF_TIMER_BIT_WIDTH_32;
+	err_code = nrf_drv_timer_init(&sca_burst_timer, &timer_cfg, sca_burst_timer_handler);
+	APP_ERROR_CHECK(err_code);
+	
+	timer_cfg.mode = NRF_TIMER_MODE_COUNTER;
+	timer_cfg.bit_width = NRF_TIMER_BIT_WIDTH_16;
+	err_code = nrf_drv_timer_init(&sca_count_timer, &timer_cfg, sca_count_timer_handler);
+	APP_ERROR_CHECK(err_code);
+	
+	err_code = nrf_drv_ppi_init();
+	if(err_code != NRF_ERROR_MODULE_ALREADY_INITIALIZED)
 	{
-		*pRxData = rxData;
+		APP_ERROR_CHECK(err_code);
 	}
 	
-	SCA_SW_SPI_SCK_CLR();
-	SCA_SW_SPI_CS_DISABLE();
+	for(i = 0; i < 3; i++)
+	{
+		err_code = nrf_drv_ppi_channel_alloc(&sca_burst_ppi[i]);
+		APP_ERROR_CHECK(err_code);
+	}
 	
-	return;
+	if (!nrf_drv_gpiote_is_init())
+	{
+		err_code = nrf_drv_gpiote_init();
+		APP_ERROR_CHECK(err_code);
+	}
+	
+	nrf_drv_gpiote_out_config_t out_config = GPIOTE_CONFIG_OUT_TASK_TOGGLE(true);
+	err_code = nrf_drv_gpiote_out_init(SCA_SPI_CS_PIN, &out_config);
+	APP_ERROR_CHECK(err_code);
+	
+	uint32_t cs_clr = nrf_drv_gpiote_clr_task_addr_get(SCA_SPI_CS_PIN);
+	uint32_t cs_set = nrf_drv_gpiote_set_task_addr_get(SCA_SPI_CS_PIN);
+	
+#if NRFX_CHECK(NRFX_SPIM_NRF52_ANOMALY_109_WORKAROUND_ENABLED)
+	/* ch0只启动长度为0的传输，片选由STARTED中断在实际传输前拉低 */
+	(void)cs_clr;
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(sca_burst_ppi[0],
+											   nrf_drv_timer_compare_event_address_get(&sca_burst_timer, NRF_TIMER_CC_CHANNEL0),
+											   nrf_spim_task_address_get(SCA_SPIM, NRF_SPIM_TASK_START)));
+	NRFX_IRQ_PRIORITY_SET(SCA_SPIM_IRQn, SCA_SPIM_IRQ_PRIORITY);
+	NRFX_IRQ_ENABLE(SCA_SPIM_IRQn);
+#else
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(sca_burst_ppi[0],
+											   nrf_drv_timer_compare_event_address_get(&sca_burst_timer, NRF_TIMER_CC_CHANNEL0), cs_clr));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_fork_assign(sca_burst_ppi[0], nrf_spim_task_address_get(SCA_SPIM, NRF_SPIM_TASK_START)));
+#endif
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(sca_burst_ppi[1],
+											   nrf_spim_event_address_get(SCA_SPIM, NRF_SPIM_EVENT_END), cs_set));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_fork_assign(sca_burst_ppi[1],
+													nrf_drv_timer_task_address_get(&sca_count_timer, NRF_TIMER_TASK_COUNT)));
+	APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(sca_burst_ppi[2],
+											   nrf_drv_timer_compare_event_address_get(&sca_count_timer, NRF_TIMER_CC_CHANNEL0),
+											   nrf_drv_timer_task_address_get(&sca_burst_timer, NRF_TIMER_TASK_STOP)));
+	
+	/* 定时器由连续读取启动，使能驱动但不计数 */
+	nrf_drv_timer_enable(&sca_burst_timer);
+	nrf_drv_timer_pause(&sca_burst_timer);
+	nrf_drv_timer_clear(&sca_burst_timer);
+	nrf_drv_timer_enable(&sca_count_timer);
+	nrf_drv_timer_pause(&sca_count_timer);
+	nrf_drv_timer_clear(&sca_count_timer);
+	
+	for(i = 0; i < SCA_BURST_MAX_TIMES * 2; i++)
+	{
+		sca_burst_tx[i][0] = (i & 0X01) ? RDAY : RDAX;
+	}
+	
+	sca_burst_init = 1;
 }
 
 void SCA_Init(void)
 {
-	SCA_SW_SPI_Config();
+	SCA_SPI_Config();
+	SCA_BurstConfig();
 }
 
 void SCA_Default(void)
 {
-	SCA_SW_SPI_ConfigDefault();
+	SCA_BurstStop();
+	SCA_SPI_ConfigDefault();
 }
 
 void SCA_WriteCommand(uint8_t cmd)
 {
-	SCA_SW_SPI_TransmitReceive(cmd, 8, NULL, 0);
+	uint8_t tx[1] = {cmd};
+	SCA_SPI_TransmitReceive(tx, NULL, sizeof(tx));
 }
 
 uint8_t SCA_ReadTemperature(void)
 {
-	uint16_t temp;
-	SCA_SW_SPI_TransmitReceive(RWTR, 8, &temp, 8);
-	return (uint8_t)temp;	
+	uint8_t tx[2] = {RWTR, 0X00};
+	uint8_t rx[2];
+	SCA_SPI_TransmitReceive(tx, rx, sizeof(tx));
+	return rx[1];
 }
 
 uint16_t SCA_ReadXChannel(void)
 {
-	uint16_t xChannelData;
-	SCA_SW_SPI_TransmitReceive(RDAX, 8, &xChannelData, 11);
-	return xChannelData;
+	uint8_t tx[SCA_XFER_LEN] = {RDAX, 0X00, 0X00};
+	uint8_t rx[SCA_XFER_LEN];
+	SCA_SPI_TransmitReceive(tx, rx, sizeof(tx));
+	return SCA_ChannelData(rx);
 }
 
 uint16_t SCA_ReadYChannel(void)
 {
-	uint16_t yChannelData;
-	SCA_SW_SPI_TransmitReceive(RDAY, 8, &yChannelData, 11);
-	return yChannelData;	
+	uint8_t tx[SCA_XFER_LEN] = {RDAY, 0X00, 0X00};
+	uint8_t rx[SCA_XFER_LEN];
+	SCA_SPI_TransmitReceive(tx, rx, sizeof(tx));
+	return SCA_ChannelData(rx);
 }
 
+//启动连续读取：每隔interval_us读一次通道，X、Y交替共times轮，完成后中断一次并调用SCA_BurstDoneHandler
+//轮数超限、间隔过短或正在读取返回0，读取期间不能调用单次读写
+uint8_t SCA_BurstStart(uint8_t times, uint32_t interval_us)
+{
+	if(sca_burst_init == 0 || sca_burst_busy == 1 || times == 0 || times > SCA_BURST_MAX_TIMES ||
+	   interval_us <= SCA_XFER_MAX_US)
+	{
+		return 0;
+	}
+	
+	sca_burst_done = 0;
+	sca_burst_busy = 1;
+	
+	nrf_drv_timer_clear(&sca_burst_timer);
+	nrf_drv_timer_clear(&sca_count_timer);
+	nrf_drv_timer_extended_compare(&sca_burst_timer, NRF_TIMER_CC_CHANNEL0, nrf_drv_timer_us_to_ticks(&sca_burst_timer, interval_us),
+								   NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, false);
+	nrf_drv_timer_extended_compare(&sca_count_timer, NRF_TIMER_CC_CHANNEL0, times * 2 * SCA_BURST_END_PER_XFER,
+								   NRF_TIMER_SHORT_COMPARE0_STOP_MASK | NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+	
+#if NRFX_CHECK(NRFX_SPIM_NRF52_ANOMALY_109_WORKAROUND_ENABLED)
+	sca_burst_index = 0;
+	nrf_spim_tx_buffer_set(SCA_SPIM, sca_burst_tx[0], 0);
+	nrf_spim_rx_buffer_set(SCA_SPIM, sca_burst_rx[0], 0);
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_STARTED);
+	nrf_spim_int_enable(SCA_SPIM, NRF_SPIM_INT_STARTED_MASK);
+#else
+	nrf_spim_tx_buffer_set(SCA_SPIM, sca_burst_tx[0], SCA_XFER_LEN);
+	nrf_spim_rx_buffer_set(SCA_SPIM, sca_burst_rx[0], SCA_XFER_LEN);
+	nrf_spim_tx_list_enable(SCA_SPIM);
+	nrf_spim_rx_list_enable(SCA_SPIM);
+#endif
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_END);
+	
+	nrf_drv_gpiote_out_task_enable(SCA_SPI_CS_PIN);
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		APP_ERROR_CHECK(nrf_drv_ppi_channel_enable(sca_burst_ppi[i]));
+	}
+	
+	nrf_drv_timer_resume(&sca_count_timer);
+	nrf_drv_timer_resume(&sca_burst_timer);
+	
+	return 1;
+}
 
+/* 连续读取结束或停止后，关闭PPI，片选交还GPIO */
+static void SCA_BurstRestore(void)
+{
+	nrf_drv_timer_pause(&sca_burst_timer);
+	nrf_drv_timer_pause(&sca_count_timer);
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		nrf_drv_ppi_channel_disable(sca_burst_ppi[i]);
+	}
+	
+	nrf_drv_gpiote_out_task_disable(SCA_SPI_CS_PIN);
+	SCA_SPI_CS_DISABLE();
+	nrf_drv_timer_clear(&sca_burst_timer);
+	nrf_drv_timer_clear(&sca_count_timer);
+	nrf_spim_tx_list_disable(SCA_SPIM);
+	nrf_spim_rx_list_disable(SCA_SPIM);
+	nrf_spim_int_disable(SCA_SPIM, NRF_SPIM_INT_STARTED_MASK);
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_STARTED);
+	sca_burst_busy = 0;
+}
 
+#if NRFX_CHECK(NRFX_SPIM_NRF52_ANOMALY_109_WORKAROUND_ENABLED)
+/* 等待结束事件计数达到count，每次读取的长度为0的传输与实际传输各计一次 */
+static void SCA_BurstCountWait(uint32_t count)
+{
+	for(uint32_t i = 0; i < SCA_XFER_MAX_US && nrf_drv_timer_capture(&sca_count_timer, NRF_TIMER_CC_CHANNEL1) < count; i++)
+	{
+		nrf_delay_us(1);
+	}
+}
 
+/* 长度为0的传输已唤醒CPU，拉低片选启动实际传输，STARTED后缓冲区寄存器可预置，恢复长度0等待下一次 */
+void SCA_SPIM_IRQHandler(void)
+{
+	if(!nrf_spim_event_check(SCA_SPIM, NRF_SPIM_EVENT_STARTED) || 
+	   !nrf_spim_int_enable_check(SCA_SPIM, NRF_SPIM_INT_STARTED_MASK))
+	{
+		return;
+	}
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_STARTED);
+	
+	if(sca_burst_index >= SCA_BURST_MAX_TIMES * 2)
+	{
+		return;
+	}
+	
+	//长度为0的传输的结束事件经ch1拉高片选，须在拉低片选之前
+	SCA_BurstCountWait(sca_burst_index * 2 + 1);
+	
+	nrf_spim_tx_buffer_set(SCA_SPIM, sca_burst_tx[sca_burst_index], SCA_XFER_LEN);
+	nrf_spim_rx_buffer_set(SCA_SPIM, sca_burst_rx[sca_burst_index], SCA_XFER_LEN);
+	sca_burst_index++;
+	
+	nrf_drv_gpiote_clr_task_trigger(SCA_SPI_CS_PIN);
+	nrf_spim_task_trigger(SCA_SPIM, NRF_SPIM_TASK_START);
+	for(uint32_t i = 0; i < SCA_XFER_MAX_US && !nrf_spim_event_check(SCA_SPIM, NRF_SPIM_EVENT_STARTED); i++)
+	{
+		nrf_delay_us(1);
+	}
+	nrf_spim_event_clear(SCA_SPIM, NRF_SPIM_EVENT_STARTED);
+	
+	nrf_spim_tx_buffer_set(SCA_SPIM, sca_burst_tx[0], 0);
+	nrf_spim_rx_buffer_set(SCA_SPIM, sca_burst_rx[0], 0);
+}
+#endif
 
+//未完成时停止连续读取，已启动的传输结束后才拉高片选
+void SCA_BurstStop(void)
+{
+	if(sca_burst_init == 0 || sca_burst_busy == 0)
+	{
+		return;
+	}
+	
+	nrf_drv_ppi_channel_disable(sca_burst_ppi[0]);
+	nrf_delay_us(SCA_XFER_MAX_US);
+	SCA_BurstRestore();
+}
 
+uint8_t SCA_BurstDone(void)
+{
+	return sca_burst_done;
+}
 
+uint16_t SCA_BurstGetXChannel(uint8_t index)
+{
+	return SCA_ChannelData(sca_burst_rx[index * 2]);
+}
 
+uint16_t SCA_BurstGetYChannel(uint8_t index)
+{
+	return SCA_ChannelData(sca_burst_rx[index * 2 + 1]);
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+/* 连续读取完成处理，在定时器中断中调用 */
+__weak void SCA_BurstDoneHandler(void)
+{
+	return;
+}
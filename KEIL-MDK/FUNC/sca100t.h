@@ -3,28 +3,44 @@
 #include "main.h"
 
 
-/* ģSPI */
-#define SCA_SW_SPI_SCK_PIN				12
-#define SCA_SW_SPI_MOSI_PIN				14
-#define SCA_SW_SPI_MISO_PIN				13
-#define SCA_SW_SPI_CS_PIN					11
-
-/* ģSPI˿ */
-#define SCA_SW_SPI_SCK_PORT				P0
-#define SCA_SW_SPI_MOSI_PORT			P0
-#define SCA_SW_SPI_MISO_PORT			P0
-#define SCA_SW_SPI_CS_PORT				P0
-
-
-//========SCA100T
-#define MEAS  0x00	//ģʽ
-#define RWTR  0x08	//д¶ݼĴ
-#define RDSR  0x0A	//״̬Ĵ
-#define RLOAD 0x0B	//NVݵڴĴ
-#define STX   0x0E	//XͨԼ
-#define STY   0x0F	//YͨԼ
-#define RDAX  0x10	//Xͨٶ
-#define RDAY  0x11	//Yͨٶ 
+/* SPI引脚设置 */
+#define SCA_SPI_SCK_PIN					12
+#define SCA_SPI_MOSI_PIN				14
+#define SCA_SPI_MISO_PIN				13
+#define SCA_SPI_CS_PIN					11
+
+/* SPI端口设置 */
+#define SCA_SPI_SCK_PORT				P0
+#define SCA_SPI_MOSI_PORT				P0
+#define SCA_SPI_MISO_PORT				P0
+#define SCA_SPI_CS_PORT					P0
+
+/* 硬件SPI设置，SPIM0由LORA使用 */
+#define SCA_SPIM						NRF_SPIM1
+#define SCA_SPI_FREQ					NRF_SPIM_FREQ_500K //SCA100T的SCK最高500kHz
+
+/* 连续读取：TIMER3按间隔经PPI拉低片选并启动SPIM，EasyDMA依次读X、Y通道，
+   SPIM结束经PPI拉高片选并由TIMER4计数，读完后TIMER4停止TIMER3并中断一次，期间CPU休眠 */
+#define SCA_BURST_TIMER_INSTANCE		3 //连续读取间隔定时器
+#define SCA_COUNT_TIMER_INSTANCE		4 //连续读取计数定时器(计数模式)
+#define SCA_BURST_MAX_TIMES				16 //连续读取最多轮数，每轮读X、Y通道各一次
+
+/* nRF52832勘误109：CPU休眠时由PPI启动的EasyDMA首次访问可能出错。开启规避后PPI先启动长度为0的传输，
+   STARTED中断唤醒CPU后由中断设置缓冲区并启动实际传输，每次传输中断一次 */
+#define SCA_SPIM_IRQn					SPIM1_SPIS1_TWIM1_TWIS1_SPI1_TWI1_IRQn
+#define SCA_SPIM_IRQHandler				SPIM1_SPIS1_TWIM1_TWIS1_SPI1_TWI1_IRQHandler
+#define SCA_SPIM_IRQ_PRIORITY			APP_IRQ_PRIORITY_HIGH
+
+
+//========SCA100T控制命令
+#define MEAS  0x00	//测量模式
+#define RWTR  0x08	//读写温度数据寄存器
+#define RDSR  0x0A	//状态寄存器
+#define RLOAD 0x0B	//重新载入NV数据到内存输出寄存器
+#define STX   0x0E	//X通道自检
+#define STY   0x0F	//Y通道自检
+#define RDAX  0x10	//读X通道加速度数据
+#define RDAY  0x11	//读Y通道加速度数据 
 
 
 void SCA_Init(void);
@@ -33,6 +49,11 @@ void SCA_WriteCommand(uint8_t cmd);
 uint8_t SCA_ReadTemperature(void);
 uint16_t SCA_ReadXChannel(void);
 uint16_t SCA_ReadYChannel(void);
+uint8_t SCA_BurstStart(uint8_t times, uint32_t interval_us);
+void SCA_BurstStop(void);
+uint8_t SCA_BurstDone(void);
+uint16_t SCA_BurstGetXChannel(uint8_t index);
+uint16_t SCA_BurstGetYChannel(uint8_t index);
 
 
 #endif
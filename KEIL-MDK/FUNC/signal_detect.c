@@ -93,7 +93,7 @@ void Signal_DetInit(void)
 #endif
 }
 
-/* źżж¼ */
+/* 信号检测中断事件处理 */
 __weak void Signal_DetEvtHandler(void* param)
 {
 	return;
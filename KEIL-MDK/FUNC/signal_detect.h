@@ -4,8 +4,8 @@
 #include "nrf_drv_lpcomp.h"
 
 
-#define SIGNAL_DET_USE_INT_COPM //ʹڲȽź
-//#define SIGNAL_DET_USE_EXT_COPM //ʹⲿȽź
+#define SIGNAL_DET_USE_INT_COPM //使用内部比较器检测信号
+//#define SIGNAL_DET_USE_EXT_COPM //使用外部比较器检测信号
 
 #ifdef SIGNAL_DET_USE_INT_COPM
 	#undef SIGNAL_DET_USE_EXT_COPM
@@ -5,12 +5,34 @@
 #include <string.h> 
 
 
+static const char hex_upper_tb[] = "0123456789ABCDEF";
+static const char hex_lower_tb[] = "0123456789abcdef";
+
+/* 两位十进制数字表，整数转换每次处理两位 */
+static const char digit_pair_tb[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const uint32_t pow10_tb[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+/* 定点小数的最大位数，小数部分(<2^40)乘以10^6不超过64位 */
+#define STR_BUF_FIXED_FRAC_BITS		40
+
+
 /**
- * @brief  ʮַתΪֽ
- *         expsrc[]="AD12E3C5"-->dst[]={0XAD,0X12,0XE3,0XC5}
- * @param  src: Դʮַ
- * @param  dst: Ŀֽ
- * @param  src_len: ַstrlen(source)
+ * @brief  十六进制字符串转换为字节流
+ *         exp：src[]="AD12E3C5"-->dst[]={0XAD,0X12,0XE3,0XC5}
+ * @param  src: 源十六进制字符串
+ * @param  dst: 目标字节流数组
+ * @param  src_len: 字符串长度strlen(source)
  * @retval None
  */
 void hex_string_to_bytes(const char* src, unsigned char* dst, int src_len)
@@ -20,7 +42,7 @@ void hex_string_to_bytes(const char* src, unsigned char* dst, int src_len)
 
     for (short i = 0; i < src_len; i += 2)
     {
-        high_byte = toupper(src[i]); //СдĸתΪдĸ
+        high_byte = toupper(src[i]); //将小写字母转换为大写字母
         low_byte  = toupper(src[i + 1]);
 
         if (high_byte > 0x39)
@@ -38,24 +60,22 @@ void hex_string_to_bytes(const char* src, unsigned char* dst, int src_len)
 }
 
 /**
- * @brief  ֽתΪʮַ
- *         expsrc[]={0XAD,0X12,0XE3,0XC5}-->dst[]="AD12E3C5"
- * @param  src: Դֽ
- * @param  dst: Ŀʮַ
- * @param  src_len: ֽ鳤sizeof(src)
- * @param  upper_lower: 0תĸΪд1תĸΪСд
+ * @brief  字节流数组转换为十六进制字符串
+ *         exp：src[]={0XAD,0X12,0XE3,0XC5}-->dst[]="AD12E3C5"
+ * @param  src: 源字节流数组
+ * @param  dst: 目标十六进制字符串
+ * @param  src_len: 字节流数组长度sizeof(src)
+ * @param  upper_lower: 0转换后的字母为大写，1转换后的字母为小写
  * @retval None
  */
 void bytes_to_hex_string(const unsigned char* src, char* dst, int src_len, unsigned char upper_lower)
 {
-    char tmp[3];
+	const char* tb = upper_lower ? hex_lower_tb : hex_upper_tb; //查表转换，避免每字节调用sprintf
 
     for(int i = 0; i < src_len; i++)
     {
-		(upper_lower) ? 
-			(sprintf(tmp, "%02x", (unsigned char)src[i])) : //ÿ⺯ֽתΪ16ַСд
-			(sprintf(tmp, "%02X", (unsigned char)src[i]));	//ÿ⺯ֽתΪ16ַд
-        memcpy(&dst[i*2], tmp, 2);
+		dst[i*2] = tb[src[i] >> 4];
+		dst[i*2 + 1] = tb[src[i] & 0X0F];
     }
 	
 	dst[src_len*2] = '\0';
@@ -64,11 +84,11 @@ void bytes_to_hex_string(const unsigned char* src, char* dst, int src_len, unsig
 }
 
 /**
- * @brief  ֽתΪַ
- *         expsrc[]={0X31,0X32,0X33,0X34}-->dst[]="1234"
- * @param  src: Դֽ
- * @param  dst: Ŀַ
- * @param  src_len: ֽ鳤sizeof(src)
+ * @brief  字节流数组转换为字符串
+ *         exp：src[]={0X31,0X32,0X33,0X34}-->dst[]="1234"
+ * @param  src: 源字节流数组
+ * @param  dst: 目标字符串
+ * @param  src_len: 字节流数组长度sizeof(src)
  * @retval None
  */
 void bytes_to_char(const unsigned char* src, char* dst, int src_len)
@@ -77,12 +97,12 @@ void bytes_to_char(const unsigned char* src, char* dst, int src_len)
 }
 
 /**
- * @brief  ַвĿַ
- *         expsrc[]="abcdef" dst[]="de"
- * @param  src: Դַ
- * @param  dst: Ŀַ
- * @retval -1ʧ
- *         ĿַԴַгֵʼλ
+ * @brief  在字符串中查找目标字符串
+ *         exp：src[]="abcdef" dst[]="de"
+ * @param  src: 源字符串
+ * @param  dst: 目标字符串
+ * @retval -1：查找失败
+ *         其它：目标字符串在源字符串中出现的起始位置
  */
 int string_contains(const char *src, const char *dst)
 {
@@ -113,12 +133,12 @@ int string_contains(const char *src, const char *dst)
 }
 
 /**
- * @brief  ַתΪ
- *         expsrc[]="-1234" dst=-1234
- * @param  src: Դַ
- * @param  dst: Ŀ
- * @retval -1ԴַаǷַ
- *         0תɹ
+ * @brief  数字字符串转换为整数
+ *         exp：src[]="-1234" dst=-1234
+ * @param  src: 源字符串
+ * @param  dst: 目标整数
+ * @retval -1：源字符串中包含非法字符串
+ *         0：转换成功
  */
 int string_to_integer(const char* src, int* dst)
 {
@@ -133,25 +153,25 @@ int string_to_integer(const char* src, int* dst)
 	
 	while(*str)
 	{
-		if(!isdigit(*str)) //жַǷַ
+		if(!isdigit(*str)) //判断字符是否是数字字符
 		{
 			return -1;
 		}
 		str++;
 	}
 	
-	*dst = atoi(src); //⺯asciiתΪint
+	*dst = atoi(src); //库函数ascii转换为int
 	
 	return 0;
 }
 
 /**
- * @brief  ַתΪ
- *         expsrc[]="-1234567890123" dst=-1234567890123
- * @param  src: Դַ
- * @param  dst: Ŀ곤
- * @retval -1ԴַаǷַ
- *         0תɹ
+ * @brief  数字字符串转换为长整数
+ *         exp：src[]="-1234567890123" dst=-1234567890123
+ * @param  src: 源字符串
+ * @param  dst: 目标长整数
+ * @retval -1：源字符串中包含非法字符串
+ *         0：转换成功
  */
 int string_to_long_integer(const char* src, long long* dst)
 {
@@ -166,25 +186,25 @@ int string_to_long_integer(const char* src, long long* dst)
 	
 	while(*str)
 	{
-		if(!isdigit(*str)) //жַǷַ
+		if(!isdigit(*str)) //判断字符是否是数字字符
 		{
 			return -1;
 		}
 		str++;
 	}
 	
-	*dst = atoll(src); //⺯asciiתΪlong
+	*dst = atoll(src); //库函数ascii转换为long
 	
 	return 0;
 }
 
 /**
- * @brief  ַתΪ
- *         expsrc[]="-0.3254" dst=-0.3254
- * @param  src: Դַ
- * @param  dst: Ŀ긡
- * @retval -1ԴַаǷַ
- *         0תɹ
+ * @brief  数字字符串转换为浮点数
+ *         exp：src[]="-0.3254" dst=-0.3254
+ * @param  src: 源字符串
+ * @param  dst: 目标浮点数
+ * @retval -1：源字符串中包含非法字符串
+ *         0：转换成功
  */
 int string_to_double(const char* src, double* dst)
 {
@@ -211,7 +231,7 @@ int string_to_double(const char* src, double* dst)
 			continue;
 		}
 		
-		if(!isdigit(*str)) //жַǷַ
+		if(!isdigit(*str)) //判断字符是否是数字字符
 		{
 			return -1;
 		}
@@ -219,27 +239,27 @@ int string_to_double(const char* src, double* dst)
 		str++;
 	}
 	
-	*dst = atof(src); //⺯asciiתΪfloat
+	*dst = atof(src); //库函数ascii转换为float
 	return 0;
 }
 
 /**
- * @brief  жһַǷ16ַ
- * @param  src: Դַ
- * @retval 0Դַ16ַ
- *         Դַ16ַ
+ * @brief  判断一个字符是否是16进制字符
+ * @param  src: 源字符
+ * @retval 0：源字符不是16进制字符
+ *         其它：源字符是16进制字符
  */
 int is_hex_or_digit(const char src)
 {
-	return isxdigit(src);  //⺯жһַǷ16ַ
+	return isxdigit(src);  //库函数判断一个字符是否是16进制字符
 }
 
 /**
- * @brief  תΪַ
- * @param  value: ת
- * @param  str: תַ
- * @param  radix: ת281016
- * @retval תַ
+ * @brief  将整数转换为字符串
+ * @param  value: 待转换的整数
+ * @param  str: 保存转换后的字符串
+ * @param  radix: 转换进制数，如2，8，10，16
+ * @retval 转换后的字符串
  */
 char* int_to_string(int value, char *string, int radix)
 {
@@ -282,5 +302,229 @@ char* int_to_string(int value, char *string, int radix)
 	return string;
 }
 
+/**
+ * @brief  初始化追加式字符串缓存
+ * @param  sb: 字符串缓存
+ * @param  buf: 存放字符串的数组
+ * @param  size: 数组大小
+ * @retval None
+ */
+void str_buf_init(str_buf_t* sb, char* buf, uint16_t size)
+{
+	sb->buf = buf;
+	sb->size = size;
+	sb->len = 0;
+	
+	if(size != 0)
+	{
+		buf[0] = '\0';
+	}
+}
 
+/**
+ * @brief  向字符串缓存写入数据，空间不足时截断
+ * @param  sb: 字符串缓存
+ * @param  src: 待写入数据
+ * @param  len: 数据长度
+ * @retval None
+ */
+static void str_buf_append_mem(str_buf_t* sb, const char* src, uint16_t len)
+{
+	if(sb->len + len >= sb->size)
+	{
+		len = (sb->size > sb->len) ? (sb->size - sb->len - 1) : 0;
+	}
+	
+	memcpy(&sb->buf[sb->len], src, len);
+	sb->len += len;
+	sb->buf[sb->len] = '\0';
+}
+
+/**
+ * @brief  追加一个字符
+ */
+void str_buf_append_char(str_buf_t* sb, char c)
+{
+	str_buf_append_mem(sb, &c, 1);
+}
+
+/**
+ * @brief  追加字符串
+ */
+void str_buf_append_str(str_buf_t* sb, const char* src)
+{
+	str_buf_append_mem(sb, src, strlen(src));
+}
+
+/**
+ * @brief  字节流数组以十六进制字符串追加
+ * @param  upper_lower: 0转换后的字母为大写，1转换后的字母为小写
+ */
+void str_buf_append_hex(str_buf_t* sb, const unsigned char* src, int src_len, unsigned char upper_lower)
+{
+	const char* tb = upper_lower ? hex_lower_tb : hex_upper_tb;
+	char tmp[2];
+	
+	for(int i = 0; i < src_len; i++)
+	{
+		tmp[0] = tb[src[i] >> 4];
+		tmp[1] = tb[src[i] & 0X0F];
+		str_buf_append_mem(sb, tmp, 2);
+	}
+}
+
+/**
+ * @brief  无符号整数以十进制追加
+ * @param  value: 待转换的整数
+ * @param  width: 最小宽度，不足时高位补0，0表示不补
+ */
+void str_buf_append_uint(str_buf_t* sb, uint32_t value, uint8_t width)
+{
+	char tmp[10];
+	uint8_t i = sizeof(tmp);
+	
+	while(value >= 100)
+	{
+		uint32_t pair = value % 100;
+		value /= 100;
+		i -= 2;
+		memcpy(&tmp[i], &digit_pair_tb[pair * 2], 2);
+	}
+	
+	if(value >= 10)
+	{
+		i -= 2;
+		memcpy(&tmp[i], &digit_pair_tb[value * 2], 2);
+	}
+	else
+	{
+		tmp[--i] = '0' + value;
+	}
+	
+	for(uint8_t len = sizeof(tmp) - i; len < width; len++)
+	{
+		str_buf_append_char(sb, '0');
+	}
+	
+	str_buf_append_mem(sb, &tmp[i], sizeof(tmp) - i);
+}
+
+/**
+ * @brief  有符号整数以十进制追加
+ */
+void str_buf_append_int(str_buf_t* sb, int32_t value)
+{
+	if(value < 0)
+	{
+		str_buf_append_char(sb, '-');
+		str_buf_append_uint(sb, 0U - (uint32_t)value, 0);
+	}
+	else
+	{
+		str_buf_append_uint(sb, value, 0);
+	}
+}
+
+/**
+ * @brief  浮点数以定点小数追加，等同于printf("%.*f")
+ * @param  value: 待转换的浮点数
+ * @param  decimals: 小数位数(0~6)
+ */
+void str_buf_append_fixed(str_buf_t* sb, float value, uint8_t decimals)
+{
+	if(value != value)
+	{
+		str_buf_append_str(sb, "nan");
+		return;
+	}
+	
+	if(decimals > 6)
+	{
+		decimals = 6;
+	}
+	
+	if(value < 0)
+	{
+		str_buf_append_char(sb, '-');
+		value = -value;
+	}
+	
+	if(value >= 4294967295.0f)
+	{
+		str_buf_append_str(sb, "inf");
+		return;
+	}
+	
+	/* 按IEEE754位域拆分为mant*2^exp，小数部分用整数精确换算 */
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	
+	uint32_t mant = bits & 0X007FFFFF;
+	int32_t exp = (int32_t)((bits >> 23) & 0XFF);
+	if(exp != 0)
+	{
+		mant |= 0X00800000;
+	}
+	else
+	{
+		exp = 1; //非规格化数
+	}
+	exp -= 150;
+	
+	uint32_t scale = pow10_tb[decimals];
+	uint32_t ip = 0;
+	uint64_t frac = 0; //小数部分，定点数，小数位数为shift
+	uint32_t shift = 0;
+	uint8_t sticky = 0; //舍去的低位是否非0
+	
+	if(exp >= 0)
+	{
+		ip = mant << exp;
+	}
+	else
+	{
+		shift = -exp;
+		ip = shift < 32 ? mant >> shift : 0;
+		frac = mant & (shift < 32 ? ((1UL << shift) - 1) : 0XFFFFFFFF);
+		
+		/* 限制小数位数使frac*scale不超过64位，舍去的位只影响恰好为0.5的判断 */
+		if(shift > STR_BUF_FIXED_FRAC_BITS)
+		{
+			uint32_t drop = shift - STR_BUF_FIXED_FRAC_BITS;
+			
+			sticky = drop < 32 ? (frac & ((1UL << drop) - 1)) != 0 : frac != 0;
+			frac = drop < 32 ? frac >> drop : 0;
+			shift = STR_BUF_FIXED_FRAC_BITS;
+		}
+	}
+	
+	/* 四舍六入五成双，与printf一致 */
+	uint32_t fp = 0;
+	if(shift != 0)
+	{
+		uint64_t prod = frac * scale;
+		uint64_t half = 1ULL << (shift - 1);
+		uint64_t rem = prod & ((half << 1) - 1);
+		
+		fp = (uint32_t)(prod >> shift);
+		uint32_t last = decimals ? fp : ip; //保留的最低位
+		if(rem > half || (rem == half && (sticky || (last & 1))))
+		{
+			fp++;
+		}
+	}
+	
+	if(fp >= scale)
+	{
+		ip++;
+		fp -= scale;
+	}
+	
+	str_buf_append_uint(sb, ip, 0);
+	if(decimals != 0)
+	{
+		str_buf_append_char(sb, '.');
+		str_buf_append_uint(sb, fp, decimals);
+	}
+}
 
@@ -1,7 +1,15 @@
 #ifndef __STRING_OPERATE_H__
 #define __STRING_OPERATE_H__
+#include <stdint.h>
 
 
+/* 追加式字符串缓存，写满后截断，始终以'\0'结尾 */
+typedef struct {
+	char* buf;
+	uint16_t size; //缓存大小(含结尾'\0')
+	uint16_t len; //已写入长度
+}str_buf_t;
+
 void hex_string_to_bytes(const char* src, unsigned char* dst, int src_len);
 void bytes_to_hex_string(const unsigned char* src, char* dst, int src_len, unsigned char upper_lower);
 void bytes_to_char(const unsigned char* src, char* dst, int src_len);
@@ -12,6 +20,14 @@ int string_to_double(const char* src, double* dst);
 int is_hex_or_digit(const char src);
 char* int_to_string(int value, char *string, int radix);
 
+void str_buf_init(str_buf_t* sb, char* buf, uint16_t size);
+void str_buf_append_char(str_buf_t* sb, char c);
+void str_buf_append_str(str_buf_t* sb, const char* src);
+void str_buf_append_hex(str_buf_t* sb, const unsigned char* src, int src_len, unsigned char upper_lower);
+void str_buf_append_uint(str_buf_t* sb, uint32_t value, uint8_t width);
+void str_buf_append_int(str_buf_t* sb, int32_t value);
+void str_buf_append_fixed(str_buf_t* sb, float value, uint8_t decimals);
+
 
 #endif
 
@@ -1,65 +1,447 @@
 #include "sys_param.h"
 #include "string.h"
+#include "stddef.h"
+#include "fds.h"
 #include "flash.h"
+#include "uart_svc.h"
+#include "wireless_comm_services.h"
 
 
 static sys_param_t sys_param;
 
-void Sys_ParamInit(void)
+#define SYS_PARAM_FIELD(key, member)		{key, offsetof(sys_param_t, member), sizeof(((sys_param_t*)0)->member)}
+
+typedef struct {
+	uint16_t key; //FDS记录号
+	uint16_t offset; //字段在sys_param_t中的偏移
+	uint8_t len; //字段长度
+}sys_param_field_t;
+
+/* 记录号一经使用不可修改，新增字段使用新的记录号 */
+static const sys_param_field_t sys_param_field_tb[] = {
+	SYS_PARAM_FIELD(0X0001, ble_tx_power),
+	SYS_PARAM_FIELD(0X0002, ble_adv_interval),
+	SYS_PARAM_FIELD(0X0003, ble_adv_time),
+	SYS_PARAM_FIELD(0X0004, ble_min_conn_interval),
+	SYS_PARAM_FIELD(0X0005, ble_max_conn_interval),
+	SYS_PARAM_FIELD(0X0006, ble_slave_latency),
+	SYS_PARAM_FIELD(0X0007, ble_conn_timeout),
+	SYS_PARAM_FIELD(0X0008, lora_freq),
+	SYS_PARAM_FIELD(0X0009, lora_power),
+	SYS_PARAM_FIELD(0X000A, lora_bw),
+	SYS_PARAM_FIELD(0X000B, lora_sf),
+	SYS_PARAM_FIELD(0X000C, lora_code_rate),
+	SYS_PARAM_FIELD(0X000D, lora_preamble),
+	SYS_PARAM_FIELD(0X000E, lora_header),
+	SYS_PARAM_FIELD(0X000F, lora_crc),
+	SYS_PARAM_FIELD(0X0010, dev_gateway_addr),
+	SYS_PARAM_FIELD(0X0011, dev_long_addr),
+	SYS_PARAM_FIELD(0X0012, dev_short_addr),
+	SYS_PARAM_FIELD(0X0013, iot_mode),
+	SYS_PARAM_FIELD(0X0014, iot_sample_interval),
+	SYS_PARAM_FIELD(0X0015, iot_x_angle_threshold),
+	SYS_PARAM_FIELD(0X0016, iot_y_angle_threshold),
+	SYS_PARAM_FIELD(0X0017, lora_sync_word),
+};
+
+#define SYS_PARAM_FIELD_NUMS				(sizeof(sys_param_field_tb) / sizeof(sys_param_field_tb[0]))
+#define SYS_PARAM_NODE_FLAG_WORDS			((GATEWAY_CAP_SIZE + 31) / 32)
+
+static fds_record_desc_t field_desc[SYS_PARAM_FIELD_NUMS]; //字段记录描述符
+static sys_param_record_t field_rec[SYS_PARAM_FIELD_NUMS]; //字段最近一次写入的内容，写入过程中保持有效
+static uint32_t field_id[SYS_PARAM_FIELD_NUMS]; //字段记录ID，0表示尚无记录
+static volatile uint8_t field_busy[SYS_PARAM_FIELD_NUMS]; //字段记录正在写入
+
+static sys_param_record_t node_rec; //测点记录写缓存
+static uint32_t node_id[GATEWAY_CAP_SIZE]; //测点记录ID，0表示尚无记录
+static uint32_t node_save_flag[SYS_PARAM_NODE_FLAG_WORDS]; //待保存的测点
+static volatile uint8_t node_busy = 0;
+
+static volatile uint8_t fds_inited = 0;
+static volatile uint8_t fds_gc_run = 0;
+static volatile uint8_t fds_gc_check = 0;
+
+static uint16_t sys_param_record_crc(sys_param_record_t* rec)
+{
+	return Wireless_CommSvcGetHandle()->modbusRtuCRC(rec->value, rec->len);
+}
+
+static int sys_param_field_find(uint16_t key)
+{
+	for(int i = 0; i < SYS_PARAM_FIELD_NUMS; i++)
+	{
+		if(sys_param_field_tb[i].key == key)
+		{
+			return i;
+		}
+	}
+	
+	return -1;
+}
+
+static void sys_param_fds_evt_handler(fds_evt_t const * p_evt)
 {
-//	flash_read(SYS_PARAM_FLASH_PAGE_ADDR, (uint8_t *)&sys_param, sizeof(sys_param));
-	sys_param.update_flag = 0XFF;
-	if(sys_param.update_flag == 0XFF)
-	{
-		sys_param.ble_tx_power = SYS_PARAM_BLE_TX_POWER;
-		sys_param.ble_adv_interval = SYS_PARAM_BLE_ADV_INTERVAL;
-		sys_param.ble_adv_time = SYS_PARAM_BLE_ADV_TIME;
-		sys_param.ble_min_conn_interval = SYS_PARAM_BLE_MIN_CONN_INTERVAL;
-		sys_param.ble_max_conn_interval = SYS_PARAM_BLE_MAX_CONN_INTERVAL;
-		sys_param.ble_slave_latency = SYS_PARAM_BLE_SLAVE_LATENCY;
-		sys_param.ble_conn_timeout = SYS_PARAM_BLE_CONN_TIMEOUT;
+	int i;
+	
+	switch(p_evt->id)
+	{
+		//初始化完成事件
+		case FDS_EVT_INIT:
+			fds_inited = (p_evt->result == FDS_SUCCESS) ? 1 : 0XFF;
+			break;
+		
+		//写完成事件
+		case FDS_EVT_WRITE:
+		case FDS_EVT_UPDATE:
+			if(p_evt->write.file_id == SYS_PARAM_FDS_FILE_ID)
+			{
+				i = sys_param_field_find(p_evt->write.record_key);
+				if(i < 0)
+				{
+					break;
+				}
+				
+				if(p_evt->result == FDS_SUCCESS)
+				{
+					field_id[i] = p_evt->write.record_id;
+				}
+				else
+				{
+					field_rec[i].version = 0; //写失败，下次重新写入
+					sys_param.update_flag = 1;
+				}
+				field_busy[i] = 0;
+			}
+			else if(p_evt->write.file_id == SYS_PARAM_FDS_NODE_FILE_ID)
+			{
+				uint8_t index = p_evt->write.record_key - 1;
+				if(p_evt->result == FDS_SUCCESS)
+				{
+					node_id[index] = p_evt->write.record_id;
+				}
+				else
+				{
+					node_save_flag[index / 32] |= (1u << (index % 32));
+				}
+				node_busy = 0;
+			}
+			
+			if(p_evt->result == FDS_ERR_NO_SPACE_IN_FLASH)
+			{
+				fds_gc_check = 1;
+			}
+			else if(p_evt->id == FDS_EVT_UPDATE)
+			{
+				fds_gc_check = 1; //更新产生了无效记录
+			}
+			break;
 		
-		sys_param.lora_freq = SYS_PARAM_LORA_FREQ;
-		sys_param.lora_power = SYS_PARAM_LORA_POWER;
-		sys_param.lora_bw = SYS_PARAM_LORA_BW;
-		sys_param.lora_sf = SYS_PARAM_LORA_SF;
-		sys_param.lora_code_rate = SYS_PARAM_LORA_CODE_RATE;
-		sys_param.lora_preamble = SYS_PARAM_LORA_PREAMBLE;
-		sys_param.lora_header = SYS_PARAM_LORA_HEADER;
-		sys_param.lora_crc = SYS_PARAM_LORA_CRC;
+		//删除完成事件
+		case FDS_EVT_DEL_RECORD:
+			fds_gc_check = 1;
+			break;
 		
-		uint8_t dev_gateway_addr[8] = SYS_PARAM_DEV_GATEWAY_ADDR;
-		uint8_t dev_long_addr[8] = SYS_PARAM_DEV_LONG_ADDR;
-		uint8_t dev_short_addr[2] = SYS_PARAM_DEV_SHORT_ADDR;
-		memcpy(sys_param.dev_gateway_addr,dev_gateway_addr,8);
-		memcpy(sys_param.dev_long_addr,dev_long_addr,8);
-		memcpy(sys_param.dev_short_addr,dev_short_addr,2);
+		//垃圾回收完成事件
+		case FDS_EVT_GC:
+			fds_gc_run = 0;
+			break;
 		
-		sys_param.iot_mode = SYS_PARAM_IOT_MODE;
-		sys_param.iot_sample_interval = SYS_PARAM_IOT_SAMPLE_INTERVAL;
-		sys_param.iot_x_angle_threshold = SYS_PARAM_IOT_X_ANGLE_THRESHOLD;
-		sys_param.iot_y_angle_threshold = SYS_PARAM_IOT_Y_ANGLE_THRESHOLD;
+		default: break;
 	}
+}
+
+/* 一次遍历所有记录恢复系统参数与测点信息，同一字段有多条记录时保留最新的一条 */
+static void sys_param_fds_load(void)
+{
+	extern peer_data_t peer_data;
+	fds_record_desc_t desc = {0};
+	fds_find_token_t token = {0};
+	fds_flash_record_t record;
 	
-	uint8_t data[8] = SYS_PARAM_DEV_GATEWAY_ADDR;
-	memcpy(sys_param.dev_gateway_addr, data,8);
-	sys_param.lora_freq = 470;
-	sys_param.lora_power = 17;
-	sys_param.lora_bw = 7;
-	sys_param.lora_sf = 11;
+	while(fds_record_iterate(&desc, &token) == FDS_SUCCESS)
+	{
+		if(fds_record_open(&desc, &record) != FDS_SUCCESS)
+		{
+			continue;
+		}
+		
+		uint16_t file_id = record.p_header->file_id;
+		uint16_t key = record.p_header->record_key;
+		uint32_t record_id = record.p_header->record_id;
+		sys_param_record_t rec;
+		uint8_t valid = 0;
+		
+		if(record.p_header->length_words == sizeof(rec) / 4)
+		{
+			memcpy(&rec, record.p_data, sizeof(rec));
+			valid = (rec.version == SYS_PARAM_RECORD_VERSION &&
+					 rec.len <= SYS_PARAM_RECORD_VALUE_SIZE &&
+					 rec.crc == sys_param_record_crc(&rec));
+		}
+		fds_record_close(&desc);
+		
+		if(file_id == SYS_PARAM_FDS_FILE_ID)
+		{
+			int i = sys_param_field_find(key);
+			if(i < 0 || (field_id[i] != 0 && field_id[i] > record_id))
+			{
+				fds_record_delete(&desc); //未知字段或旧记录
+				continue;
+			}
+			
+			if(field_id[i] != 0)
+			{
+				fds_record_delete(&field_desc[i]); //掉电残留的旧记录
+			}
+			field_desc[i] = desc;
+			field_id[i] = record_id;
+			
+			if(valid && rec.len == sys_param_field_tb[i].len)
+			{
+				memcpy((uint8_t*)&sys_param + sys_param_field_tb[i].offset, rec.value, rec.len);
+				field_rec[i] = rec;
+			}
+		}
+		else if(file_id == SYS_PARAM_FDS_NODE_FILE_ID)
+		{
+			if(key == 0 || key > GATEWAY_CAP_SIZE || (node_id[key - 1] != 0 && node_id[key - 1] > record_id))
+			{
+				fds_record_delete(&desc); //无效测点序号或旧记录
+				continue;
+			}
+			
+			if(node_id[key - 1] != 0)
+			{
+				fds_record_desc_t old_desc = {0};
+				if(fds_descriptor_from_rec_id(&old_desc, node_id[key - 1]) == FDS_SUCCESS)
+				{
+					fds_record_delete(&old_desc); //掉电残留的旧记录
+				}
+			}
+			node_id[key - 1] = record_id;
+			
+			if(!valid || rec.len != 10)
+			{
+				continue;
+			}
+			
+			peer_attr_t* peer = &peer_data.peer_attr[key - 1];
+			memcpy(peer->long_addr, rec.value, 8);
+			memcpy(peer->short_addr, &rec.value[8], 2);
+			if(key > peer_data.current_conn_nums)
+			{
+				peer_data.current_conn_nums = key;
+			}
+		}
+	}
+}
+
+void Sys_ParamInit(void)
+{
+	sys_param.ble_tx_power = SYS_PARAM_BLE_TX_POWER;
+	sys_param.ble_adv_interval = SYS_PARAM_BLE_ADV_INTERVAL;
+	sys_param.ble_adv_time = SYS_PARAM_BLE_ADV_TIME;
+	sys_param.ble_min_conn_interval = SYS_PARAM_BLE_MIN_CONN_INTERVAL;
+	sys_param.ble_max_conn_interval = SYS_PARAM_BLE_MAX_CONN_INTERVAL;
+	sys_param.ble_slave_latency = SYS_PARAM_BLE_SLAVE_LATENCY;
+	sys_param.ble_conn_timeout = SYS_PARAM_BLE_CONN_TIMEOUT;
+	
+	sys_param.lora_freq = SYS_PARAM_LORA_FREQ;
+	sys_param.lora_power = SYS_PARAM_LORA_POWER;
+	sys_param.lora_bw = SYS_PARAM_LORA_BW;
+	sys_param.lora_sf = SYS_PARAM_LORA_SF;
+	sys_param.lora_code_rate = SYS_PARAM_LORA_CODE_RATE;
+	sys_param.lora_preamble = SYS_PARAM_LORA_PREAMBLE;
+	sys_param.lora_header = SYS_PARAM_LORA_HEADER;
+	sys_param.lora_crc = SYS_PARAM_LORA_CRC;
+	sys_param.lora_sync_word = SYS_PARAM_LORA_SYNC_WORD;
 	
-	sys_param.update_flag = 0;
+	uint8_t dev_gateway_addr[8] = SYS_PARAM_DEV_GATEWAY_ADDR;
+	uint8_t dev_long_addr[8] = SYS_PARAM_DEV_LONG_ADDR;
+	uint8_t dev_short_addr[2] = SYS_PARAM_DEV_SHORT_ADDR;
+	memcpy(sys_param.dev_gateway_addr,dev_gateway_addr,8);
+	memcpy(sys_param.dev_long_addr,dev_long_addr,8);
+	memcpy(sys_param.dev_short_addr,dev_short_addr,2);
+	
+	sys_param.iot_mode = SYS_PARAM_IOT_MODE;
+	sys_param.iot_sample_interval = SYS_PARAM_IOT_SAMPLE_INTERVAL;
+	sys_param.iot_x_angle_threshold = SYS_PARAM_IOT_X_ANGLE_THRESHOLD;
+	sys_param.iot_y_angle_threshold = SYS_PARAM_IOT_Y_ANGLE_THRESHOLD;
+	
+	/* 协议栈使能前FDS操作同步完成 */
+	fds_register(sys_param_fds_evt_handler);
+	if(fds_init() == FDS_SUCCESS)
+	{
+		for(uint32_t t = 0; fds_inited == 0 && t < SYS_PARAM_FDS_INIT_TIMEOUT; t++)
+		{
+			nrf_delay_ms(1);
+		}
+	}
+	
+	//初始化失败或超时使用默认参数，不再读写FDS
+	if(fds_inited != 1)
+	{
+		fds_inited = 0XFF;
+	}
+	
+	if(fds_inited == 1)
+	{
+		sys_param_fds_load();
+	}
+	
+	sys_param.update_flag = 1; //没有记录的字段写入默认值
 	sys_param.saveParamToFlash = Sys_SaveParamToFlash;
 }
 
+static void sys_param_field_save(int i)
+{
+	uint8_t* value = (uint8_t*)&sys_param + sys_param_field_tb[i].offset;
+	
+	if(field_rec[i].version == SYS_PARAM_RECORD_VERSION &&
+	   memcmp(field_rec[i].value, value, sys_param_field_tb[i].len) == 0)
+	{
+		return; //字段未修改
+	}
+	
+	if(field_busy[i])
+	{
+		sys_param.update_flag = 1; //上一次写入完成后再写
+		return;
+	}
+	
+	memset(&field_rec[i], 0XFF, sizeof(field_rec[i]));
+	field_rec[i].version = SYS_PARAM_RECORD_VERSION;
+	field_rec[i].len = sys_param_field_tb[i].len;
+	memcpy(field_rec[i].value, value, field_rec[i].len);
+	field_rec[i].crc = sys_param_record_crc(&field_rec[i]);
+	
+	fds_record_t record = {
+		.file_id = SYS_PARAM_FDS_FILE_ID,
+		.key = sys_param_field_tb[i].key,
+		.data.p_data = &field_rec[i],
+		.data.length_words = sizeof(field_rec[i]) / 4,
+	};
+	
+	ret_code_t err_code;
+	field_busy[i] = 1;
+	if(field_id[i] != 0)
+	{
+		err_code = fds_record_update(&field_desc[i], &record);
+	}
+	else
+	{
+		err_code = fds_record_write(&field_desc[i], &record);
+	}
+	
+	if(err_code != FDS_SUCCESS)
+	{
+		field_busy[i] = 0;
+		field_rec[i].version = 0;
+		sys_param.update_flag = 1; //队列满或空间不足，稍后重试
+		if(err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+		{
+			fds_gc_check = 1;
+		}
+	}
+}
+
+static void sys_param_node_save(void)
+{
+	extern peer_data_t peer_data;
+	
+	if(node_busy)
+	{
+		return;
+	}
+	
+	for(uint8_t index = 0; index < GATEWAY_CAP_SIZE; index++)
+	{
+		if(!(node_save_flag[index / 32] & (1u << (index % 32))))
+		{
+			continue;
+		}
+		
+		memset(&node_rec, 0XFF, sizeof(node_rec));
+		node_rec.version = SYS_PARAM_RECORD_VERSION;
+		node_rec.len = 10;
+		memcpy(node_rec.value, peer_data.peer_attr[index].long_addr, 8);
+		memcpy(&node_rec.value[8], peer_data.peer_attr[index].short_addr, 2);
+		node_rec.crc = sys_param_record_crc(&node_rec);
+		
+		fds_record_t record = {
+			.file_id = SYS_PARAM_FDS_NODE_FILE_ID,
+			.key = index + 1,
+			.data.p_data = &node_rec,
+			.data.length_words = sizeof(node_rec) / 4,
+		};
+		
+		fds_record_desc_t desc = {0};
+		ret_code_t err_code;
+		node_busy = 1;
+		if(node_id[index] != 0 && fds_descriptor_from_rec_id(&desc, node_id[index]) == FDS_SUCCESS)
+		{
+			err_code = fds_record_update(&desc, &record);
+		}
+		else
+		{
+			err_code = fds_record_write(&desc, &record);
+		}
+		
+		if(err_code != FDS_SUCCESS)
+		{
+			node_busy = 0;
+			if(err_code == FDS_ERR_NO_SPACE_IN_FLASH)
+			{
+				fds_gc_check = 1;
+			}
+			return;
+		}
+		
+		node_save_flag[index / 32] &= ~(1u << (index % 32));
+		return; //每次只写一个测点
+	}
+}
+
+/* 主循环中调用，只写入修改过的字段，写入与垃圾回收均在后台完成 */
 uint8_t Sys_SaveParamToFlash(void)
 {
+	if(fds_inited != 1)
+	{
+		return 1;
+	}
+	
+	/* FDS写入同样占用flash，避开待回复与正在接收的数据帧 */
+	if(!flash_job_allowed(FLASH_WORD_WRITE_TIME_US * sizeof(sys_param_record_t) / 4 / 1000 + 1))
+	{
+		return 0;
+	}
+	
 	if(sys_param.update_flag == 1)
 	{
 		sys_param.update_flag = 0;
-//		return flash_write(SYS_PARAM_FLASH_PAGE_ADDR,
-//						  (uint32_t*)&sys_param,
-//						   sizeof(sys_param)%4==0?sizeof(sys_param)/4:(sizeof(sys_param)/4+1));
+		for(int i = 0; i < SYS_PARAM_FIELD_NUMS; i++)
+		{
+			sys_param_field_save(i);
+		}
+	}
+	
+	sys_param_node_save();
+	
+	if(fds_gc_check == 1 && fds_gc_run == 0 && flash_job_allowed(FLASH_PAGE_ERASE_TIME))
+	{
+		fds_stat_t stat;
+		fds_gc_check = 0;
+		if(fds_stat(&stat) == FDS_SUCCESS && stat.freeable_words >= SYS_PARAM_FDS_GC_WORDS)
+		{
+			if(fds_gc() == FDS_SUCCESS)
+			{
+				fds_gc_run = 1;
+			}
+			else
+			{
+				fds_gc_check = 1;
+			}
+		}
 	}
 	
 	return 0;
@@ -76,6 +458,17 @@ void sys_param_set(uint8_t* param, uint8_t* value, uint8_t len)
 	sys_param.update_flag = 1;
 }
 
+//标记测点信息待保存
+void Sys_ParamNodeSave(uint8_t index)
+{
+	if(index >= GATEWAY_CAP_SIZE)
+	{
+		return;
+	}
+	
+	node_save_flag[index / 32] |= (1u << (index % 32));
+}
+
 
 
 
@@ -10,10 +10,17 @@
 #include "host_net_swap.h"
 #include "sx1262.h"
 #include "calendar.h"
+#include "uplink_journal.h"
+#include "sys_param.h"
+#include "rx_filter.h"
+#include "link_sweep.h"
+#include "group_ack.h"
+#include "block_transfer.h"
+#include "sample_batch.h"
 
 
-#define UART_TX_BUF_SIZE 256       //ڷͻСֽ
-#define UART_RX_BUF_SIZE 256       //ڽջСֽ
+#define UART_TX_BUF_SIZE 256       //串口发送缓存大小（字节数）
+#define UART_RX_BUF_SIZE 256       //串口接收缓存大小（字节数）
 
 static uint16_t UartRxBufSize = 0;
 static uint8_t UartRxBuf[255];
@@ -22,9 +29,14 @@ static uint16_t LoraRxBufSize = 0;
 static uint8_t LoraRxBuf[255];
 static uint8_t LoraRxFlag = 0;
 
-//0X01:ӡԭʼ
-//0X02:ӡ
-//0X04:ӡظ
+//0X01:打印原始数据
+//0X02:打印解析数据
+//0X04:打印回复数据
+//dev_ctrl 0X01:回复测点
+//dev_ctrl 0X02:上行数据日志发送到主机
+//dev_ctrl 0X04:丢弃长地址不在允许列表的数据帧
+//dev_ctrl 0X08:组确认广播代替逐个回复
+//dev_ctrl 0X10:C9波形块只发送特征，超过阈值才转发原始数据
 ctrl_class_t ctrl_class = {
 	.print_ctrl = 0X02,
 	.dev_ctrl = 0X01,
@@ -70,24 +82,24 @@ void bytes_to_chars(uint8_t* des, char* src, uint16_t size)
 
 void uart_error_handle(app_uart_evt_t * p_event)
 {
-	//ͨѶ¼
+	//通讯错误事件
 	if (p_event->evt_type == APP_UART_COMMUNICATION_ERROR)
 	{
 		APP_ERROR_HANDLER(p_event->data.error_communication);
 	}
-	//FIFO¼
+	//FIFO错误事件
 	else if (p_event->evt_type == APP_UART_FIFO_ERROR)
 	{
 		APP_ERROR_HANDLER(p_event->data.error_code);
 	}
-	//ڽ¼
+	//串口接收事件
 	else if (p_event->evt_type == APP_UART_DATA_READY)
 	{
 		app_uart_get(&UartRxBuf[UartRxBufSize]);
 		UartRxBufSize++;
 		app_timer_start(uart_id, APP_TIMER_TICKS(20), NULL);
 	}
-	//ڷ¼
+	//串口发送完成事件
 	else if (p_event->evt_type == APP_UART_TX_EMPTY)
 	{
 		;
@@ -96,9 +108,24 @@ void uart_error_handle(app_uart_evt_t * p_event)
 
 void Lora_RxHandler(uint8_t* p_data, uint8_t size)
 {
+	//CRC错误或非接收完成中断
+	if(size == 0)
+	{
+		return;
+	}
+	
 	LoraRxFlag = 1;
 	LoraRxBufSize = size;
 	memcpy(LoraRxBuf, p_data, size);
+	
+	//连接与数据上行帧写入日志，主机确认前不会丢失
+	if(*(uint32_t*)LoraRxBuf == 0X01000000 || *(uint32_t*)LoraRxBuf == 0X03000000)
+	{
+		extern sx1262_drive_t* lora_obj_get(void);
+		sx1262_drive_t* lora_obj = lora_obj_get();
+		Journal_GetHandle()->Append(LoraRxBuf, size, lora_obj->radio_state.rssi, lora_obj->radio_state.snr,
+									Calendar_TicksToTimeStamp(LORA_IrqTicks()));
+	}
 }
 
 void iot_param_cfg(void)
@@ -117,11 +144,32 @@ void iot_param_cfg(void)
 	}
 }
 
+//网络字节序浮点数
+static float peer_value_float(uint8_t* p)
+{
+	uint32_t net;
+	float value;
+	memcpy(&net, p, 4);
+	net = swap_ntohl(net);
+	memcpy(&value, &net, 4);
+	return value;
+}
+
+//记录测点信号质量与接收时间
+static void peer_value_link_update(peer_value_t* value)
+{
+	extern sx1262_drive_t* lora_obj_get(void);
+	sx1262_drive_t* lora_obj = lora_obj_get();
+	value->rx_time = Calendar_TicksToTimeStamp(LORA_IrqTicks());
+	value->rssi = lora_obj->radio_state.rssi;
+	value->snr = lora_obj->radio_state.snr;
+}
+
 void iot_conn_process(void)
 {
 	extern lora_reply_data_t lora_reply_data;
 	memcpy(lora_reply_data.long_addr, &LoraRxBuf[5], 8);
-
+	
 	if(ctrl_class.print_ctrl & 0X02)
 	{
 		char str[17];
@@ -130,21 +178,21 @@ void iot_conn_process(void)
 		char div_2 = ' ';
 		char div_3 = ' ';
 //		if(lora_reply_data.long_addr[0] == 0XC8)
-//			printf("ǲ%c",div_1);
+//			printf("倾角测点连接%c",div_1);
 //		else if(lora_reply_data.long_addr[0] == 0XC9)
-//			printf("Ʋ%c",div_1);
-		printf("%c",div_1);
-		printf("ַ%c%s%c",div_2,str,div_3);
+//			printf("崩塌计测点连接%c",div_1);
+		printf("测点连接%c",div_1);
+		printf("长地址%c%s%c",div_2,str,div_3);
 	}
-
+	
 	if(ctrl_class.print_ctrl & 0X02)
 	{
 		extern sx1262_drive_t* lora_obj_get(void);
 		char div_2 = ' ';
-		printf("źǿ%c%d",div_2,lora_obj_get()->radio_state.rssi);
+		printf("上行信号强度%c%d",div_2,lora_obj_get()->radio_state.rssi);
 		printf("\n");
 	}
-		
+	
 	if(ctrl_class.dev_ctrl & 0X01 && (lora_reply_data.long_addr[0]==0XC8||lora_reply_data.long_addr[0]==0XC9))
 	{
 		extern void Lora_ConnReply(void);
@@ -157,14 +205,18 @@ void iot_conn_process(void)
 			   *(uint32_t*)&lora_reply_data.long_addr[4]  == *(uint32_t*)&peer_data.peer_attr[i].long_addr[4])
 			{
 				peer_data.peer_attr[i].init_flag = 1;
+				peer_value_link_update(&peer_data.peer_attr[i].value);
 				return;
 			}
 		}
 		
-		if(i >=  peer_data.current_conn_nums)
+		if(i >=  peer_data.current_conn_nums && peer_data.current_conn_nums < GATEWAY_CAP_SIZE)
 		{
 			memcpy(peer_data.peer_attr[peer_data.current_conn_nums].long_addr, lora_reply_data.long_addr, 8);
 			peer_data.peer_attr[peer_data.current_conn_nums].init_flag = 1;
+			peer_value_link_update(&peer_data.peer_attr[peer_data.current_conn_nums].value);
+			RxFilter_GetHandle()->Add(lora_reply_data.long_addr); //加入接收允许列表
+			Sys_ParamNodeSave(peer_data.current_conn_nums); //保存测点信息，网关重启后无需测点重新连接
 			peer_data.current_conn_nums++;
 		}
 	}
@@ -182,116 +234,529 @@ uint8_t long_addr_match(uint8_t* param, uint8_t* value, uint8_t len)
 	return 0;
 }
 
-uint8_t device_long_addr[8];
-void iot_data_push_process(void)
+//查找测点，返回测点序号，不存在返回-1
+static int peer_find(uint8_t* long_addr)
 {
-	signed char downlink_rssi = -127;
+	for(int i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		if(long_addr_match(peer_data.peer_attr[i].long_addr, long_addr, 8) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static uint8_t peer_seq_bits(uint32_t v)
+{
+	uint8_t n = 0;
+	for(; v; v &= v - 1)
+	{
+		n++;
+	}
+	return n;
+}
+
+//按帧计数统计接收、丢失、重复与乱序帧
+static void peer_seq_update(peer_seq_t* seq, uint16_t fcnt)
+{
+	uint16_t diff = fcnt - seq->last_fcnt;
+	uint16_t back = seq->last_fcnt - fcnt;
 	
-	if(ctrl_class.print_ctrl & 0X02)
+	if(seq->valid && diff == 0)
 	{
-		char div_1 = ':';
-		char div_2 = ' ';
-		char div_3 = ' ';
-		float value = 0;
-		uint8_t index = 0;
+		seq->dup_nums++;
+		return;
+	}
 	
-		extern lora_reply_data_t lora_reply_data;
-		printf("㷢%c",div_1);
-		
-		index += 5; //ͷݳ
+	if(seq->valid && diff < 0X8000) //新帧，中间跳过的计数为丢失
+	{
+		seq->window = (diff >= PEER_SEQ_WINDOW) ? 1 : ((seq->window << diff) | 1);
+		seq->window_len = (seq->window_len + diff >= PEER_SEQ_WINDOW) ? PEER_SEQ_WINDOW : seq->window_len + diff;
+		seq->missed_nums += diff - 1;
+		seq->rx_nums++;
+		seq->last_fcnt = fcnt;
+		return;
+	}
+	
+	if(seq->valid && back < seq->window_len) //窗口内的迟到帧
+	{
+		if(seq->window & (1UL << back))
+		{
+			seq->dup_nums++;
+			return;
+		}
+		seq->window |= 1UL << back;
+		seq->ooo_nums++;
+		seq->rx_nums++;
+		if(seq->missed_nums > 0)
+		{
+			seq->missed_nums--;
+		}
+		return;
+	}
+	
+	//首帧或帧计数回退超出窗口(测点重启)，重新同步
+	if(seq->valid)
+	{
+		seq->reset_nums++;
+	}
+	seq->valid = 1;
+	seq->window = 1;
+	seq->window_len = 1;
+	seq->last_fcnt = fcnt;
+	seq->rx_nums++;
+}
+
+//测点最近PEER_SEQ_WINDOW个帧计数的丢包率，单位0.1%，没有帧计数返回0XFFFF
+uint16_t peer_link_per(uint8_t index)
+{
+	peer_seq_t* seq = &peer_data.peer_attr[index].seq;
+	
+	if(index >= peer_data.current_conn_nums || seq->valid == 0)
+	{
+		return 0XFFFF;
+	}
+	
+	return (uint16_t)((seq->window_len - peer_seq_bits(seq->window)) * 1000u / seq->window_len);
+}
+
+//测点上一次回复下发的参数：支持上行标志的测点以PEER_UPLINK_CFG_ACK确认，未确认的重发；
+//旧测点收到下一帧即视为已写入。超过重发次数放弃，参数保持未确认
+static void peer_cfg_confirm(peer_attr_t* peer)
+{
+	peer_cfg_t* cfg = &peer->cfg;
+	
+	if(cfg->sent == 0)
+	{
+		return;
+	}
+	
+	if(!peer->reply.flags_valid || (peer->reply.uplink_flags & PEER_UPLINK_CFG_ACK))
+	{
+		cfg->known |= cfg->sent & PEER_CFG_TRACK_MASK;
+		cfg->pending &= ~cfg->sent;
+		cfg->retry_nums = 0;
+	}
+	else if(++cfg->retry_nums > PEER_CFG_RETRY_MAX)
+	{
+		cfg->pending &= ~cfg->sent;
+		cfg->retry_nums = 0;
+	}
+	
+	cfg->sent = 0;
+	if(cfg->pending)
+	{
+		peer->set_flag = 1;
+	}
+}
+
+//批量段：index为测量值之后帧计数的位置，上行标志带PEER_UPLINK_BATCH且批量段恰好到数据段结束时，
+//返回采样个数，p_index为第一个采样的位置，否则返回0
+static uint8_t peer_batch_locate(uint16_t index, uint8_t nums, uint16_t* p_index)
+{
+	uint16_t end = 5 + LoraRxBuf[4];
+	uint8_t batch_nums;
+	
+	if(end > LoraRxBufSize || index + 4 > end || !(LoraRxBuf[index + 2] & PEER_UPLINK_BATCH))
+	{
+		return 0;
+	}
+	
+	batch_nums = LoraRxBuf[index + 3];
+	if(batch_nums == 0 || index + 4 + batch_nums * SAMPLE_BATCH_SIZE(nums) != end)
+	{
+		return 0;
+	}
+	
+	*p_index = index + 4;
+	return batch_nums;
+}
+
+//批量段第k个采样，时间戳、温度、测量值为基准采样加增量，out可与base相同
+static void peer_batch_sample(uint16_t index, uint8_t k, peer_value_t* base, peer_value_t* out)
+{
+	uint8_t* p = &LoraRxBuf[index + k * SAMPLE_BATCH_SIZE(base->value_nums)];
+	
+	*out = *base;
+	out->time_stamp = base->time_stamp + swap_ntohs(*(uint16_t*)p);
+	out->temp = base->temp + (float)(int16_t)swap_ntohs(*(uint16_t*)&p[2]) / SAMPLE_BATCH_TEMP_SCALE;
+	for(uint8_t j = 0; j < base->value_nums; j++)
+	{
+		out->value[j] = base->value[j] + (float)(int16_t)swap_ntohs(*(uint16_t*)&p[4 + j * 2]) / SAMPLE_BATCH_VALUE_SCALE;
+	}
+}
+
+//测量值个数：C9数据段不小于PEER_C9_FULL_LEN为6个；3个测量值的批量帧可能超过该长度，按批量段识别
+//index为时间戳的位置
+static uint8_t peer_value_nums(uint16_t index)
+{
+	uint16_t batch_index;
+	
+	if(LoraRxBuf[5] != 0XC9 || peer_batch_locate(index + 10 + 3 * 4, 3, &batch_index) > 0)
+	{
+		return 3;
+	}
+	
+	return (LoraRxBuf[4] >= PEER_C9_FULL_LEN) ? 6 : 3;
+}
+
+//测点时间戳与接收时间偏差过大，下次回复带上校时
+static void peer_time_check(peer_value_t* value, peer_reply_t* reply)
+{
+	int32_t drift = (int32_t)(value->time_stamp - value->rx_time);
+	
+	if(value->rx_time >= PEER_TIME_VALID_MIN && 
+	   (drift > (int32_t)PEER_TIME_DRIFT_MAX || drift < -(int32_t)PEER_TIME_DRIFT_MAX))
+	{
+		reply->time_fix = 1;
+	}
+}
+
+//解析数据上行帧写入测点缓存，批量帧写入最新的采样
+static void peer_value_update(void)
+{
+	int i = peer_find(&LoraRxBuf[5]);
+	if(i < 0)
+	{
+		return;
+	}
+	
+	peer_value_t* value = &peer_data.peer_attr[i].value;
+	peer_reply_t* reply = &peer_data.peer_attr[i].reply;
+	uint16_t index = 13;
+	uint16_t batch_index;
+	uint8_t batch_nums;
+	uint8_t nums;
+	
+	reply->flags_valid = 0;
+	
+	index += LoraRxBuf[index] + 1; //跳过属性个数与属性号
+	nums = peer_value_nums(index);
+	if(index + 10 + nums * 4 > LoraRxBufSize)
+	{
+		return;
+	}
+	
+	peer_value_link_update(value);
+	value->time_stamp = swap_ntohl(*(uint32_t*)&LoraRxBuf[index]);
+	value->battery = LoraRxBuf[index + 4];
+	value->temp = peer_value_float(&LoraRxBuf[index + 5]);
+	value->downlink_rssi = (int8_t)LoraRxBuf[index + 9];
+	index += 10;
+	
+	value->value_nums = 0;
+	if(LoraRxBuf[5] != 0XC8 && LoraRxBuf[5] != 0XC9)
+	{
+		peer_time_check(value, reply);
+		return;
+	}
+	
+	for(uint8_t j = 0; j < nums; j++, index += 4)
+	{
+		value->value[j] = peer_value_float(&LoraRxBuf[index]);
+	}
+	value->value_nums = nums;
+	
+	//测量值之后、数据段结束前有2字节为帧计数，其后1字节为上行标志
+	if(index + 2 <= 5 + LoraRxBuf[4] && index + 2 <= LoraRxBufSize)
+	{
+		peer_seq_update(&peer_data.peer_attr[i].seq, swap_ntohs(*(uint16_t*)&LoraRxBuf[index]));
 		
-		char str[17];
-		bytes_to_hex_string(&LoraRxBuf[index], str, 8, 0);
-		index += 8;
-		printf("ַ%c%s%c",div_2,str,div_3);
+		if(index + 3 <= 5 + LoraRxBuf[4] && index + 3 <= LoraRxBufSize)
+		{
+			reply->flags_valid = 1;
+			reply->uplink_flags = LoraRxBuf[index + 2];
+		}
+	}
+	
+	//批量帧以最新的采样作为测点数据，校时按最新采样的时间戳判断
+	batch_nums = peer_batch_locate(index, nums, &batch_index);
+	if(batch_nums > 0)
+	{
+		peer_batch_sample(batch_index, batch_nums - 1, value, value);
+	}
+	
+	peer_time_check(value, reply);
+	peer_cfg_confirm(&peer_data.peer_attr[i]);
+}
+
+//数据帧是否需要回复：旧测点每帧回复；请求确认的帧回复；
+//非确认帧只有最近一次回复通知过下行待发(测点打开了接收窗口)，且有待下发配置或需要校时才回复
+uint8_t peer_reply_need(uint8_t* long_addr)
+{
+	int i = peer_find(long_addr);
+	if(i < 0)
+	{
+		return 0;
+	}
+	
+	peer_attr_t* peer = &peer_data.peer_attr[i];
+	peer_reply_t* reply = &peer->reply;
+	uint8_t confirm = reply->uplink_flags & PEER_UPLINK_CONFIRM;
+	uint8_t need = 1;
+	
+	if(reply->flags_valid && (ctrl_class.dev_ctrl & 0X08))
+	{
+		//组确认开启：确认与校时由周期广播完成，只有待下发的测点参数逐个回复
+		GroupAck_GetHandle()->Ack(i, confirm);
+		reply->time_fix = 0;
+		need = (confirm || reply->pending) && (peer->init_flag || peer->set_flag);
+	}
+	else if(reply->flags_valid && !confirm)
+	{
+		need = reply->pending && (peer->init_flag || peer->set_flag || reply->time_fix);
+	}
+	
+	if(need)
+	{
+		reply->reply_nums++;
+	}
+	else
+	{
+		reply->skip_nums++;
+		reply->saved_ms += (LORA_TimeOnAirUs(8 + RX_FILTER_FRAME_OVERHEAD) + 999) / 1000;
+	}
+	
+	return need;
+}
+
+static void peer_value_print(peer_attr_t* peer)
+{
+	char line[128];
+	str_buf_t sb;
+	peer_value_t* value = &peer->value;
+	
+	str_buf_init(&sb, line, sizeof(line));
+	str_buf_append_str(&sb, "r200:");
+	str_buf_append_hex(&sb, peer->long_addr, 8, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, (peer->init_flag ? 0X01 : 0) | (peer->set_flag ? 0X02 : 0), 0); //待下发的连接/配置回复
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, value->rx_time, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, value->time_stamp, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_int(&sb, value->rssi);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_int(&sb, value->snr);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_int(&sb, value->downlink_rssi);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_uint(&sb, value->battery, 0);
+	str_buf_append_char(&sb, ' ');
+	str_buf_append_fixed(&sb, value->temp, 1);
+	
+	for(uint8_t i = 0; i < value->value_nums; i++)
+	{
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_fixed(&sb, value->value[i], 3);
+	}
+	str_buf_append_char(&sb, '\n');
+	
+	printf("%s", line);
+}
+
+//向主机输出测点缓存，short_addr为0XFFFF时输出全部测点
+//帧格式：r200:begin <个数>，每个测点一行，r200:end <个数>
+void peer_value_dump(uint8_t* short_addr)
+{
+	uint8_t nums = 0;
+	uint8_t all = (short_addr[0] == 0XFF && short_addr[1] == 0XFF);
+	int i;
+	
+	for(i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		if(all || *(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)short_addr)
+		{
+			nums++;
+		}
+	}
+	
+	printf("r200:begin %d\n", nums);
+	for(i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		if(all || *(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)short_addr)
+		{
+			peer_value_print(&peer_data.peer_attr[i]);
+		}
+	}
+	printf("r200:end %d\n", nums);
+}
+
+//向主机输出测点帧计数与丢包统计，short_addr为0XFFFF时输出全部测点
+//帧格式：r202:begin <个数>，每个测点一行r202:<长地址> <接收> <丢失> <重复> <乱序> <重启> <丢包率(0.1%)> <最大帧计数>
+//<回复次数> <未回复次数> <未回复节省时间(ms)>，没有帧计数的测点丢包率与帧计数输出-1，r202:end <个数>
+void peer_link_dump(uint8_t* short_addr)
+{
+	uint8_t nums = 0;
+	uint8_t all = (short_addr[0] == 0XFF && short_addr[1] == 0XFF);
+	char line[96];
+	str_buf_t sb;
+	int i;
+	
+	for(i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		if(all || *(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)short_addr)
+		{
+			nums++;
+		}
+	}
+	
+	printf("r202:begin %d\n", nums);
+	for(i = 0; i < peer_data.current_conn_nums; i++)
+	{
+		peer_seq_t* seq = &peer_data.peer_attr[i].seq;
 		
-		uint8_t attr_nums = LoraRxBuf[index]; //Ը
-		index += (attr_nums+1); //Ը
+		if(!(all || *(uint16_t*)&peer_data.peer_attr[i].long_addr[6] == *(uint16_t*)short_addr))
+		{
+			continue;
+		}
 		
-		swap_reverse(&LoraRxBuf[index], 4);
-		printf("ʱ%c%d%c",div_2,*(uint32_t*)&LoraRxBuf[index],div_3);
-		char* timep_str = calendar_ctime((uint32_t *)&LoraRxBuf[index]);
-		printf("(%s)%c",timep_str, div_3);
-		index += 4;
+		str_buf_init(&sb, line, sizeof(line));
+		str_buf_append_str(&sb, "r202:");
+		str_buf_append_hex(&sb, peer_data.peer_attr[i].long_addr, 8, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, seq->rx_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, seq->missed_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, seq->dup_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, seq->ooo_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, seq->reset_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		if(seq->valid)
+		{
+			str_buf_append_uint(&sb, peer_link_per(i), 0);
+			str_buf_append_char(&sb, ' ');
+			str_buf_append_uint(&sb, seq->last_fcnt, 0);
+		}
+		else
+		{
+			str_buf_append_str(&sb, "-1 -1");
+		}
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, peer_data.peer_attr[i].reply.reply_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, peer_data.peer_attr[i].reply.skip_nums, 0);
+		str_buf_append_char(&sb, ' ');
+		str_buf_append_uint(&sb, peer_data.peer_attr[i].reply.saved_ms, 0);
+		str_buf_append_char(&sb, '\n');
+		printf("%s", line);
+	}
+	printf("r202:end %d\n", nums);
+}
+
+uint8_t device_long_addr[8];
+void iot_data_push_process(void)
+{
+	signed char downlink_rssi = -127;
+	
+	peer_value_update();
+	
+	if(ctrl_class.print_ctrl & 0X02)
+	{
+		static const char* const c8_value_name[] = {"X轴角度", "Y轴角度", "Z轴角度"};
+		static const char* const c9_value_name[] = {"X轴加速度", "Y轴加速度", "Z轴加速度", "X轴角度", "Y轴角度", "Z轴角度"};
+		static char line[320];
+		extern sx1262_drive_t* lora_obj_get(void);
+		const char* const* name = NULL;
+		uint16_t index = 13;
+		uint16_t batch_index;
+		uint8_t batch_nums = 0;
+		uint8_t nums = 0;
+		peer_value_t base = {0};
+		peer_value_t sample;
+		str_buf_t sb;
 		
-		printf("%c%d%%%c",div_2,LoraRxBuf[index],div_3);
-		index += 1;
+		index += LoraRxBuf[index] + 1; //跳过属性个数与属性号
+		if(LoraRxBuf[5] == 0XC8)
+		{
+			name = c8_value_name;
+			nums = 3;
+		}
+		else if(LoraRxBuf[5] == 0XC9)
+		{
+			name = c9_value_name;
+			nums = peer_value_nums(index);
+		}
 		
-		swap_reverse(&LoraRxBuf[index], 4);
-		memcpy(&value, &LoraRxBuf[index], 4);
-		index += 4;
-		printf("¶%c%.1f%c",div_2,value,div_3);
+		str_buf_init(&sb, line, sizeof(line));
+		str_buf_append_str(&sb, "测点发送数据:长地址 ");
+		str_buf_append_hex(&sb, &LoraRxBuf[5], 8, 0);
 		
-		downlink_rssi = (int8_t)LoraRxBuf[index];
-		index += 1;
-
-		uint8_t long_addr[8];
-		memcpy(long_addr, &LoraRxBuf[5], 8);
-		if(long_addr[0] == 0XC8)
+		if(index + 10 + nums * 4 <= LoraRxBufSize)
 		{
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
+			base.time_stamp = swap_ntohl(*(uint32_t*)&LoraRxBuf[index]);
 			index += 4;
-			printf("XǶ%c%.3f%c",div_2,value,div_3);
+			str_buf_append_str(&sb, " 时间戳 ");
+			str_buf_append_uint(&sb, base.time_stamp, 0);
+			str_buf_append_str(&sb, " (");
+			str_buf_append_str(&sb, calendar_ctime(&base.time_stamp));
 			
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
-			index += 4;
-			printf("YǶ%c%.3f%c",div_2,value,div_3);
+			str_buf_append_str(&sb, ") 电量 ");
+			str_buf_append_uint(&sb, LoraRxBuf[index], 0);
+			index += 1;
 			
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
-			index += 4;
-			printf("ZǶ%c%.3f%c",div_2,value,div_3);
-		}
-		else if(long_addr[0] == 0XC9)
-		{
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
+			base.temp = peer_value_float(&LoraRxBuf[index]);
+			str_buf_append_str(&sb, "% 温度 ");
+			str_buf_append_fixed(&sb, base.temp, 1);
 			index += 4;
-			printf("Xٶ%c%.3f%c",div_2,value,div_3);
 			
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
-			index += 4;
-			printf("Yٶ%c%.3f%c",div_2,value,div_3);
+			downlink_rssi = (int8_t)LoraRxBuf[index];
+			index += 1;
 			
-			swap_reverse(&LoraRxBuf[index], 4);
-			memcpy(&value, &LoraRxBuf[index], 4);
-			index += 4;
-			printf("Zٶ%c%.3f%c",div_2,value,div_3);
+			for(uint8_t i = 0; i < nums; i++, index += 4)
+			{
+				base.value[i] = peer_value_float(&LoraRxBuf[index]);
+				str_buf_append_char(&sb, ' ');
+				str_buf_append_str(&sb, name[i]);
+				str_buf_append_char(&sb, ' ');
+				str_buf_append_fixed(&sb, base.value[i], 3);
+			}
+			base.value_nums = nums;
 			
-			if(LoraRxBuf[4] == 53)
+			if(nums > 0)
 			{
-				swap_reverse(&LoraRxBuf[index], 4);
-				memcpy(&value, &LoraRxBuf[index], 4);
-				index += 4;
-				printf("XǶ%c%.3f%c",div_2,value,div_3);
-				
-				swap_reverse(&LoraRxBuf[index], 4);
-				memcpy(&value, &LoraRxBuf[index], 4);
-				index += 4;
-				printf("YǶ%c%.3f%c",div_2,value,div_3);
-				
-				swap_reverse(&LoraRxBuf[index], 4);
-				memcpy(&value, &LoraRxBuf[index], 4);
-				index += 4;
-				printf("ZǶ%c%.3f%c",div_2,value,div_3);
+				batch_nums = peer_batch_locate(index, nums, &batch_index);
 			}
 		}
-	}
-	
-	if(ctrl_class.print_ctrl & 0X02)
-	{
-		extern sx1262_drive_t* lora_obj_get(void);
-		char div_1 = ':';
-		char div_2 = ' ';
-		char div_3 = ' ';
-		printf("źǿ%c%d%c",div_2,lora_obj_get()->radio_state.rssi, div_3);
 		
-		printf("źǿ%c%d%c",div_2,downlink_rssi,div_3);
+		str_buf_append_str(&sb, " 上行信号强度 ");
+		str_buf_append_int(&sb, lora_obj_get()->radio_state.rssi);
+		str_buf_append_str(&sb, " 下行信号强度 ");
+		str_buf_append_int(&sb, downlink_rssi);
+		str_buf_append_str(&sb, " \n");
 		
-		printf("\n");
+		printf("%s", line);
+		
+		//批量帧其余采样每个一行
+		for(uint8_t k = 0; k < batch_nums; k++)
+		{
+			peer_batch_sample(batch_index, k, &base, &sample);
+			
+			str_buf_init(&sb, line, sizeof(line));
+			str_buf_append_str(&sb, "测点批量数据:长地址 ");
+			str_buf_append_hex(&sb, &LoraRxBuf[5], 8, 0);
+			str_buf_append_str(&sb, " 时间戳 ");
+			str_buf_append_uint(&sb, sample.time_stamp, 0);
+			str_buf_append_str(&sb, " (");
+			str_buf_append_str(&sb, calendar_ctime(&sample.time_stamp));
+			str_buf_append_str(&sb, ") 温度 ");
+			str_buf_append_fixed(&sb, sample.temp, 2);
+			for(uint8_t i = 0; i < nums; i++)
+			{
+				str_buf_append_char(&sb, ' ');
+				str_buf_append_str(&sb, name[i]);
+				str_buf_append_char(&sb, ' ');
+				str_buf_append_fixed(&sb, sample.value[i], 3);
+			}
+			str_buf_append_str(&sb, " \n");
+			
+			printf("%s", line);
+		}
 	}
 	
 	if(ctrl_class.dev_ctrl & 0X01)
@@ -324,7 +789,7 @@ void iot_data_push_process(void)
 			reply_flag = 1;
 		}
 		
-		if(!reply_flag)
+		if(!reply_flag || !peer_reply_need(long_addr))
 			return;
 		
 		memcpy(device_long_addr, long_addr, 8);
@@ -343,21 +808,28 @@ void iot_data_push_process(void)
 
 void iot_data_lost_rate_process(void)
 {
+	extern sx1262_drive_t* lora_obj_get(void);
+	extern lora_reply_data_t lora_reply_data;
+	memcpy(lora_reply_data.long_addr, &LoraRxBuf[5], 8);
+	extern uint8_t payload_length;
+	payload_length = LoraRxBuf[13];
+	
 	if(ctrl_class.print_ctrl & 0X02)
 	{
-		extern lora_reply_data_t lora_reply_data;
-		memcpy(lora_reply_data.long_addr, &LoraRxBuf[5], 8);
-		extern uint8_t payload_length;
-		payload_length = LoraRxBuf[13];
-		
 		char div_1 = ':';
 		char div_2 = ' ';
-		printf("LORAʲ%c",div_1);
-		extern sx1262_drive_t* lora_obj_get(void);
-		printf("źǿ%c%d",div_2,lora_obj_get()->radio_state.rssi);
+		printf("LORA丢包率测试%c",div_1);
+		printf("上行信号强度%c%d",div_2,lora_obj_get()->radio_state.rssi);
 		printf("\n");
 	}
 	
+	//链路扫描目标测点的测试帧，切换组合参数时由扫描回复
+	if(LinkSweep_GetHandle()->TestFrame(LoraRxBuf, LoraRxBufSize, 
+	   lora_obj_get()->radio_state.rssi, lora_obj_get()->radio_state.snr))
+	{
+		return;
+	}
+	
 	if(ctrl_class.dev_ctrl & 0X01)
 	{
 		extern void Lora_TestReply(void);
@@ -365,29 +837,49 @@ void iot_data_lost_rate_process(void)
 	}
 }
 
+void iot_block_process(void)
+{
+	if(ctrl_class.print_ctrl & 0X02)
+	{
+		char addr[17];
+		bytes_to_hex_string(&LoraRxBuf[5], addr, 8, 0);
+		printf("块传输分片:长地址 %s 块序号 %d 分片 %d/%d\n", addr, LoraRxBuf[13], LoraRxBuf[14], LoraRxBuf[15]);
+	}
+	
+	BlockTransfer_GetHandle()->Frag(LoraRxBuf, LoraRxBufSize);
+}
+
 void uart_test(void)
 {
 	if(LoraRxFlag == 1)
 	{
 		LoraRxFlag = 0;
-
+		
 		if(ctrl_class.print_ctrl & 0X01)
 		{
 			char div_1 = ':';
 			extern lora_reply_data_t lora_reply_data;
 //			if(lora_reply_data.long_addr[0] == 0XC8)
-//				printf("ǲ㷢ԭʼ%c",div_1);
+//				printf("倾角测点发送原始数据%c",div_1);
 //			else if(lora_reply_data.long_addr[0] == 0XC9)
-//				printf("Ʋ㷢ԭʼ%c",div_1);
-			printf("㷢ԭʼ%c",div_1);
+//				printf("崩塌计测点发送原始数据%c",div_1);
+			printf("测点发送原始数据%c",div_1);
+			char raw[31 * 5 + 1];
+			str_buf_t sb;
+			str_buf_init(&sb, raw, sizeof(raw));
 			for(int i=0; i<LoraRxBufSize; i++)
 			{
-				printf("0x%02x ", LoraRxBuf[i]);
+				str_buf_append_str(&sb, "0x");
+				str_buf_append_hex(&sb, &LoraRxBuf[i], 1, 1);
+				str_buf_append_char(&sb, ' ');
 				if(i%30 == 0 && i != 0)
 				{
+					printf("%s", raw);
+					str_buf_init(&sb, raw, sizeof(raw));
 					nrf_delay_ms(10);
 				}
 			}
+			printf("%s", raw);
 			nrf_delay_ms(5);
 		}
 		
@@ -424,11 +916,16 @@ void uart_test(void)
 			iot_data_lost_rate_process();
 			printf("\n");
 		}
+		else if(*(uint32_t*)LoraRxBuf == 0X09000000)
+		{
+			printf("\n");
+			iot_block_process();
+		}
 		else
 		{
 			extern sx1262_drive_t* lora_obj_get(void);
 			char div_1 = ':';
-			printf("źǿ%c%d",div_1,lora_obj_get()->radio_state.rssi);
+			printf("上行信号强度%c%d",div_1,lora_obj_get()->radio_state.rssi);
 			printf("\n");
 			printf("\n");
 		}
@@ -440,36 +937,45 @@ void uart_test(void)
 void uart_run(void)
 {
 	uart_test();
+	LinkSweep_GetHandle()->Proc();
+	GroupAck_GetHandle()->Proc();
+	BlockTransfer_GetHandle()->Proc();
+	Journal_GetHandle()->Drain();
 }
 
-//
+//串口配置
 void uart_init(void)
 {
 	uint32_t err_code = 0;
-
+	
 	uart_timer_init();
+	Journal_Init();
+	RxFilter_Init();
+	LinkSweep_Init();
+	GroupAck_Init();
+	BlockTransfer_Init();
 	
-	//崮ͨѶýṹ岢ʼ
+	//定义串口通讯参数配置结构体并初始化
 	const app_uart_comm_params_t comm_params =
 	{
-		UART_RX_PIN,//uart
-		UART_TX_PIN,//uart
-		UART_RTS_PIN,//uart RTSţعرպȻRTSCTSţԣţԿΪIOʹ
-		UART_CTS_PIN,//uart CTS
-		APP_UART_FLOW_CONTROL_DISABLED,//رuartӲ
-		false,//ֹż
-		NRF_UART_BAUDRATE_115200//uartΪ115200bps
+		UART_RX_PIN,//定义uart接收引脚
+		UART_TX_PIN,//定义uart发送引脚
+		UART_RTS_PIN,//定义uart RTS引脚，流控关闭后虽然定义了RTS和CTS引脚，但是驱动程序会忽略，不会配置这两个引脚，两个引脚仍可作为IO使用
+		UART_CTS_PIN,//定义uart CTS引脚
+		APP_UART_FLOW_CONTROL_DISABLED,//关闭uart硬件流控
+		false,//禁止奇偶检验
+		NRF_UART_BAUDRATE_115200//uart波特率设置为115200bps
 	};
-
-	//ʼڣעᴮ¼ص
-	//һνգŲӻᱨ
+	
+	//初始化串口，注册串口事件回调函数
+	//函数会启动一次接收，如果接收引脚不接会报错
 	APP_UART_FIFO_INIT(&comm_params,
 					 UART_RX_BUF_SIZE,
 					 UART_TX_BUF_SIZE,
 					 uart_error_handle,
 					 APP_IRQ_PRIORITY_LOWEST,
 					 err_code);
-
+	
 	APP_ERROR_CHECK(err_code);
 	
 }
@@ -528,50 +1034,50 @@ if(*(uint32_t*)LoraRxBuf == 0X03000000)
 	nrf_delay_ms(10);
 	printf("\n");
 	swap_reverse(&LoraRxBuf[0], 4);
-	printf("%-*d,",strlen(header_str),*(uint32_t*)&LoraRxBuf[0]); //ͷ
-	printf("%-*d,",strlen(length_str),LoraRxBuf[4]); //
-	printf("0x%02x,0x%02x ,", LoraRxBuf[5],LoraRxBuf[6]); //̵ַ
-	printf("%-*d,",strlen(attr_nums_str),LoraRxBuf[7]); //Ը
-	printf("%-*d,",strlen(gas_id_str),LoraRxBuf[8]); //Ժ
-	printf("%-*d,",strlen(temp_id_str),LoraRxBuf[9]); //¶Ժ
-	printf("%-*d,",strlen(x_accel_id_str),LoraRxBuf[10]); //xٶԺ
-	printf("%-*d,",strlen(y_accel_id_str),LoraRxBuf[11]); //yٶԺ
-	printf("%-*d,",strlen(z_accel_id_str),LoraRxBuf[12]); //zٶԺ
+	printf("%-*d,",strlen(header_str),*(uint32_t*)&LoraRxBuf[0]); //头
+	printf("%-*d,",strlen(length_str),LoraRxBuf[4]); //长度
+	printf("0x%02x,0x%02x ,", LoraRxBuf[5],LoraRxBuf[6]); //短地址
+	printf("%-*d,",strlen(attr_nums_str),LoraRxBuf[7]); //属性个数
+	printf("%-*d,",strlen(gas_id_str),LoraRxBuf[8]); //电量属性号
+	printf("%-*d,",strlen(temp_id_str),LoraRxBuf[9]); //温度属性号
+	printf("%-*d,",strlen(x_accel_id_str),LoraRxBuf[10]); //x加速度属性号
+	printf("%-*d,",strlen(y_accel_id_str),LoraRxBuf[11]); //y加速度属性号
+	printf("%-*d,",strlen(z_accel_id_str),LoraRxBuf[12]); //z加速度属性号
 	nrf_delay_ms(10);
 	uint8_t index = 0;
 	if(LoraRxBuf[4] == 40)
 	{
-		printf("%-*d,",strlen(x_angle_id_str),LoraRxBuf[13]); //xǶԺ
-		printf("%-*d,",strlen(y_angle_id_str),LoraRxBuf[14]); //yǶԺ
-		printf("%-*d,",strlen(z_angle_id_str),LoraRxBuf[15]); //zǶԺ
+		printf("%-*d,",strlen(x_angle_id_str),LoraRxBuf[13]); //x角度属性号
+		printf("%-*d,",strlen(y_angle_id_str),LoraRxBuf[14]); //y角度属性号
+		printf("%-*d,",strlen(z_angle_id_str),LoraRxBuf[15]); //z角度属性号
 		index += 3;
 	}
-	printf("%-*d,",strlen(gas_value_str),LoraRxBuf[13+index]); //ֵ
+	printf("%-*d,",strlen(gas_value_str),LoraRxBuf[13+index]); //电量值
 	swap_reverse(&LoraRxBuf[14+index], 4);
 	float value = 0;
 	memcpy(&value, &LoraRxBuf[14+index], 4);
-	printf("%-*.3f,",strlen(temp_value_str),value); //¶ֵ
+	printf("%-*.3f,",strlen(temp_value_str),value); //温度值
 	swap_reverse(&LoraRxBuf[18+index], 4);
 	memcpy(&value, &LoraRxBuf[18+index], 4);
-	printf("%-*.3f,",strlen(x_accel_value_str),value); //xٶֵ
+	printf("%-*.3f,",strlen(x_accel_value_str),value); //x加速度值
 	swap_reverse(&LoraRxBuf[22+index], 4);
 	memcpy(&value, &LoraRxBuf[22+index], 4);
-	printf("%-*.3f,",strlen(y_accel_value_str),value); //yٶֵ
+	printf("%-*.3f,",strlen(y_accel_value_str),value); //y加速度值
 	swap_reverse(&LoraRxBuf[26+index], 4);
 	memcpy(&value, &LoraRxBuf[26+index], 4);
-	printf("%-*.3f,",strlen(z_accel_value_str),value); //zٶֵ
+	printf("%-*.3f,",strlen(z_accel_value_str),value); //z加速度值
 	nrf_delay_ms(10);
 	if(LoraRxBuf[4] == 40)
 	{
 		swap_reverse(&LoraRxBuf[30+index], 4);
 		memcpy(&value, &LoraRxBuf[30+index], 4);
-		printf("%-*.3f,",strlen(x_angle_value_str),value); //xǶֵ
+		printf("%-*.3f,",strlen(x_angle_value_str),value); //x角度值
 		swap_reverse(&LoraRxBuf[34+index], 4);
 		memcpy(&value, &LoraRxBuf[34+index], 4);
-		printf("%-*.3f,",strlen(y_angle_value_str),value); //yǶֵ
+		printf("%-*.3f,",strlen(y_angle_value_str),value); //y角度值
 		swap_reverse(&LoraRxBuf[38+index], 4);
 		memcpy(&value, &LoraRxBuf[38+index], 4);
-		printf("%-*.3f,",strlen(z_angle_value_str),value); //zǶֵ
+		printf("%-*.3f,",strlen(z_angle_value_str),value); //z角度值
 	}
 	printf("\n");
 }
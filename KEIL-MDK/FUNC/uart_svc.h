@@ -19,6 +19,75 @@
 #define LROA_REPLY_ENBALE			1
 
 #define GATEWAY_CAP_SIZE			200
+#define PEER_VALUE_MAX_NUMS			6 //测点缓存的测量值个数上限
+#define PEER_SEQ_WINDOW				32 //丢包率统计窗口(帧计数个数)
+#define PEER_C9_FULL_LEN			53 //C9测点6个测量值的数据段长度，不小于该值为6个测量值
+#define PEER_TIME_DRIFT_MAX			5u //测点时间戳与网关时间偏差超过该值(s)时回复校时
+#define PEER_TIME_VALID_MIN			1577836800u //网关时间早于该值(2020-01-01)视为未校时，不给测点校时
+
+/* 上行标志，帧计数之后的1字节，旧测点没有该字节，每个数据帧都回复 */
+#define PEER_UPLINK_CONFIRM			0X01 //请求确认，测点打开接收窗口
+#define PEER_UPLINK_CFG_ACK			0X02 //上一次下行参数已写入
+#define PEER_UPLINK_BATCH			0X04 //其后为批量段(sample_batch.h)，数据帧带有多个采样
+
+#define PEER_CFG_RETRY_MAX			3 //下行参数未确认的最大重发次数
+#define PEER_CFG_REPLY_MAX_ATTRS	4 //单次回复的最多参数个数，其余参数在后续回复中下发
+
+typedef struct {
+	uint32_t rx_time; //网关接收时间，0表示未收到过数据
+	uint32_t time_stamp; //测点采样时间戳
+	float temp; //温度
+	float value[PEER_VALUE_MAX_NUMS]; //C8:XYZ角度，C9:XYZ加速度(+XYZ角度)
+	int16_t rssi; //上行信号强度
+	int8_t snr; //上行信噪比
+	int8_t downlink_rssi; //下行信号强度
+	uint8_t battery; //电量
+	uint8_t value_nums; //有效测量值个数
+}peer_value_t;
+
+/* 数据上行帧计数统计，帧计数为测点测量值之后的2字节(网络字节序)，旧测点没有帧计数不统计 */
+typedef struct {
+	uint32_t window; //最近PEER_SEQ_WINDOW个帧计数的接收位图，bit0为last_fcnt
+	uint32_t rx_nums; //接收帧数(不含重复帧)
+	uint32_t missed_nums; //丢失帧数(迟到帧到达后扣除)
+	uint16_t dup_nums; //重复帧数
+	uint16_t ooo_nums; //乱序(迟到)帧数
+	uint16_t reset_nums; //帧计数回退超出窗口(测点重启)次数
+	uint16_t last_fcnt; //已收到的最大帧计数
+	uint8_t window_len; //位图有效位数
+	uint8_t valid; //已收到过带帧计数的帧
+}peer_seq_t;
+
+/* 数据帧回复策略：请求确认的帧回复；非确认帧测点只在上次回复带有下行待发标志时打开接收窗口，
+ * 网关此时有待下发配置或需要校时才回复 */
+typedef struct {
+	uint32_t reply_nums; //回复次数
+	uint32_t skip_nums; //未回复的数据帧数
+	uint32_t saved_ms; //未回复节省的网关发送与测点接收窗口时间(按最短回复帧的空中时间估算)
+	uint8_t uplink_flags; //最近一帧的上行标志
+	uint8_t flags_valid; //测点支持上行标志
+	uint8_t pending; //最近一次回复已通知测点有待下发数据
+	uint8_t time_fix; //需要校时
+}peer_reply_t;
+
+/* 测点参数：主机设置的目标值与确认状态，掩码位同lora_transmission.h中的参数位 */
+typedef struct {
+	uint16_t known; //测点已确认与目标值一致的参数
+	uint16_t pending; //待下发的参数
+	uint16_t sent; //已下发等待测点下一帧确认的参数
+	uint16_t time_offset;
+	uint32_t period;
+	uint32_t interval;
+	float x_thres;
+	float y_thres;
+	float z_thres;
+	uint16_t accel_slope;
+	uint16_t data_points;
+	uint8_t mode;
+	uint8_t sensor_freq;
+	uint8_t retry_nums; //当前待确认参数的重发次数
+}peer_cfg_t;
+
 typedef enum {
 	disconn,
 	conn,
@@ -30,6 +99,10 @@ typedef struct {
 	uint8_t short_addr[2];
 	uint8_t set_flag;
 	uint8_t init_flag;
+	peer_value_t value; //测点最近一次上行数据
+	peer_seq_t seq; //帧计数与丢包统计
+	peer_reply_t reply; //回复策略与统计
+	peer_cfg_t cfg; //参数下发与确认
 }peer_attr_t;
 
 typedef struct {
@@ -46,6 +119,10 @@ void uart_init(void);
 void uart_send(uint8_t* data, uint16_t size);
 void uart_receive(uint8_t* buf, uint16_t size);
 void uart_run(void);
+void peer_value_dump(uint8_t* short_addr);
+void peer_link_dump(uint8_t* short_addr);
+uint16_t peer_link_per(uint8_t index);
+uint8_t peer_reply_need(uint8_t* long_addr);
 
 
 #endif
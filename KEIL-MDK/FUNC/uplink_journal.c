@@ -0,0 +1,435 @@
+#include "uplink_journal.h"
+#include "flash.h"
+#include "string.h"
+#include "mono_clock.h"
+#include "calendar.h"
+#include "uart_svc.h"
+#include "string_operate.h"
+#include "wireless_comm_services.h"
+
+
+/*
+ * 上行数据日志：网关收到的每一帧有效上行数据先顺序写入flash日志区，
+ * 再按窗口发送给主机，主机通过w202命令确认已收到的序号。
+ * 主机离线或响应慢时数据保留在flash中，恢复后从确认位置继续发送；
+ * 日志区写满后擦除最旧一页，未确认的记录计入lost_nums。
+ */
+
+#define JOURNAL_REC_HEAD_SIZE				sizeof(journal_rec_head_t)
+#define JOURNAL_ALIGN4(len)					(((len) + 3) & ~3u)
+#define JOURNAL_PAGE_START(addr)			((addr) & ~(JOURNAL_FLASH_PAGE_SIZE - 1))
+
+#define JOURNAL_REC_VALID					0 //有效记录
+#define JOURNAL_REC_FREE					1 //未写入区域或页尾
+#define JOURNAL_REC_INVALID					2 //无效记录
+
+static Journal_t journal;
+static uint32_t write_page; //当前写入页起始地址
+static uint32_t write_addr; //下一条记录写入地址(已分配)
+static uint32_t write_seq; //下一条记录的写入序号
+static uint32_t commit_addr; //已完成写入的位置，读取不超过该位置
+static uint32_t read_addr; //下一条待发送记录地址
+static uint32_t ack_addr; //第一条未确认记录地址
+static uint32_t last_tx_time; //最近一次发送时刻，单位ms
+static uint32_t ack_timeout; //当前确认超时时间，单位ms
+static uint32_t rec_buf[(JOURNAL_REC_HEAD_SIZE + 256) / 4]; //记录读取缓存
+static uint32_t write_buf[JOURNAL_WRITE_BUF_NUMS][(JOURNAL_REC_HEAD_SIZE + 256) / 4]; //记录写缓存，写入完成前保持有效
+static uint32_t write_buf_end[JOURNAL_WRITE_BUF_NUMS]; //写缓存对应记录的结束地址
+static uint8_t write_buf_used[JOURNAL_WRITE_BUF_NUMS];
+static char hex_buf[255 * 2 + 1];
+
+static uint32_t journal_next_page(uint32_t addr)
+{
+	addr = JOURNAL_PAGE_START(addr) + JOURNAL_FLASH_PAGE_SIZE;
+	if(addr >= JOURNAL_FLASH_END_ADDR)
+	{
+		addr = JOURNAL_FLASH_START_ADDR;
+	}
+
+	return addr;
+}
+
+static uint32_t journal_rec_end(uint32_t addr, journal_rec_head_t* head)
+{
+	return addr + JOURNAL_REC_HEAD_SIZE + JOURNAL_ALIGN4(head->len);
+}
+
+/* 读取并校验addr处的记录，有效记录的完整内容保存在rec_buf中 */
+static uint8_t journal_rec_read(uint32_t addr, journal_rec_head_t* head)
+{
+	uint32_t page_end = JOURNAL_PAGE_START(addr) + JOURNAL_FLASH_PAGE_SIZE;
+	if(page_end - addr < JOURNAL_REC_HEAD_SIZE)
+	{
+		return JOURNAL_REC_FREE;
+	}
+
+	flash_read(addr, (uint8_t*)head, JOURNAL_REC_HEAD_SIZE);
+	if(head->magic == JOURNAL_REC_MAGIC_FREE)
+	{
+		return JOURNAL_REC_FREE;
+	}
+
+	if((head->magic != JOURNAL_REC_MAGIC_DATA && head->magic != JOURNAL_REC_MAGIC_ACK) ||
+	   journal_rec_end(addr, head) > page_end)
+	{
+		return JOURNAL_REC_INVALID;
+	}
+
+	flash_read(addr, (uint8_t*)rec_buf, JOURNAL_REC_HEAD_SIZE + head->len);
+	((journal_rec_head_t*)rec_buf)->crc = 0;
+	uint16_t crc = Wireless_CommSvcGetHandle()->modbusRtuCRC((uint8_t*)rec_buf, JOURNAL_REC_HEAD_SIZE + head->len);
+	if(crc != head->crc)
+	{
+		return JOURNAL_REC_INVALID;
+	}
+
+	return JOURNAL_REC_VALID;
+}
+
+/* 从*p_addr开始查找下一条有效记录，页尾或无效记录跳到下一页，到达已写入位置返回1 */
+static uint8_t journal_cursor_get(uint32_t* p_addr, journal_rec_head_t* head)
+{
+	for(uint8_t i = 0; i <= JOURNAL_FLASH_PAGE_NUMS; i++)
+	{
+		if(*p_addr == commit_addr)
+		{
+			return 1;
+		}
+
+		if(journal_rec_read(*p_addr, head) == JOURNAL_REC_VALID)
+		{
+			return 0;
+		}
+
+		*p_addr = journal_next_page(*p_addr);
+	}
+
+	return 1;
+}
+
+/* 擦除页前将确认与发送位置移出该页，未确认的数据记录计为丢失 */
+static void journal_page_drop(uint32_t page)
+{
+	journal_rec_head_t head;
+
+	if(ack_addr != commit_addr && JOURNAL_PAGE_START(ack_addr) == page)
+	{
+		uint32_t addr = ack_addr;
+		while(JOURNAL_PAGE_START(addr) == page && journal_rec_read(addr, &head) == JOURNAL_REC_VALID)
+		{
+			if(head.magic == JOURNAL_REC_MAGIC_DATA && head.seq > journal.ack_seq)
+			{
+				journal.lost_nums++;
+				journal.ack_seq = head.seq;
+			}
+			addr = journal_rec_end(addr, &head);
+		}
+		ack_addr = journal_next_page(page);
+	}
+
+	if(read_addr != commit_addr && JOURNAL_PAGE_START(read_addr) == page)
+	{
+		read_addr = ack_addr;
+	}
+
+	if(journal.sent_seq < journal.ack_seq)
+	{
+		journal.sent_seq = journal.ack_seq;
+	}
+}
+
+static void journal_erase_cb(uint8_t result, void* p_context)
+{
+	commit_addr = (uint32_t)p_context;
+}
+
+static void journal_write_cb(uint8_t result, void* p_context)
+{
+	uint32_t i = (uint32_t)p_context;
+	commit_addr = write_buf_end[i];
+	write_buf_used[i] = 0;
+	if(result != 0)
+	{
+		journal.lost_nums++;
+	}
+}
+
+static uint8_t journal_page_switch(void)
+{
+	uint32_t page = journal_next_page(write_page);
+	if(flash_job_erase(page, 1, journal_erase_cb, (void*)page) != 0)
+	{
+		return 1;
+	}
+	
+	journal_page_drop(page);
+	write_page = page;
+	write_addr = page;
+	return 0;
+}
+
+/* 分配写入位置并添加后台写任务，返回0: 成功，非0: 写缓存或任务队列已满 */
+static uint8_t journal_rec_write(uint16_t magic, uint32_t seq, uint8_t* p_data, uint8_t size, int16_t rssi, int8_t snr, uint32_t time_stamp)
+{
+	uint32_t rec_size = JOURNAL_REC_HEAD_SIZE + JOURNAL_ALIGN4(size);
+	uint32_t i;
+	
+	for(i = 0; i < JOURNAL_WRITE_BUF_NUMS; i++)
+	{
+		if(write_buf_used[i] == 0)
+		{
+			break;
+		}
+	}
+	
+	if(i >= JOURNAL_WRITE_BUF_NUMS)
+	{
+		return 1;
+	}
+	
+	if(write_page + JOURNAL_FLASH_PAGE_SIZE - write_addr < rec_size)
+	{
+		if(journal_page_switch() != 0)
+		{
+			return 1;
+		}
+	}
+
+	journal_rec_head_t* head = (journal_rec_head_t*)write_buf[i];
+	write_buf[i][rec_size / 4 - 1] = 0XFFFFFFFF; //填充字节
+	head->magic = magic;
+	head->len = size;
+	head->snr = snr;
+	head->rssi = rssi;
+	head->crc = 0;
+	head->seq = seq;
+	head->time_stamp = time_stamp;
+	head->write_seq = write_seq;
+	if(size != 0)
+	{
+		memcpy((uint8_t*)write_buf[i] + JOURNAL_REC_HEAD_SIZE, p_data, size);
+	}
+	head->crc = Wireless_CommSvcGetHandle()->modbusRtuCRC((uint8_t*)write_buf[i], JOURNAL_REC_HEAD_SIZE + size);
+
+	if(flash_job_write(write_addr, write_buf[i], rec_size / 4, journal_write_cb, (void*)i) != 0)
+	{
+		return 1;
+	}
+	write_buf_used[i] = 1;
+	write_seq++;
+	write_addr += rec_size;
+	write_buf_end[i] = write_addr;
+
+	/* 本页已写满时立即换页，保证写入位置始终落在当前写入页内 */
+	if(write_page + JOURNAL_FLASH_PAGE_SIZE - write_addr < JOURNAL_REC_HEAD_SIZE)
+	{
+		journal_page_switch();
+	}
+	
+	return 0;
+}
+
+static void Journal_Append(uint8_t* p_data, uint8_t size, int16_t rssi, int8_t snr, uint32_t time_stamp)
+{
+	if(journal_rec_write(JOURNAL_REC_MAGIC_DATA, journal.head_seq + 1, p_data, size, rssi, snr, time_stamp) != 0)
+	{
+		journal.lost_nums++;
+		return;
+	}
+	journal.head_seq++;
+}
+
+static void Journal_Ack(uint32_t seq)
+{
+	journal_rec_head_t head;
+
+	if(seq <= journal.ack_seq || seq > journal.head_seq)
+	{
+		return;
+	}
+
+	while(journal_cursor_get(&ack_addr, &head) == 0)
+	{
+		if(head.magic == JOURNAL_REC_MAGIC_DATA && head.seq > seq)
+		{
+			break;
+		}
+		ack_addr = journal_rec_end(ack_addr, &head);
+	}
+
+	journal.ack_seq = seq;
+	if(journal.sent_seq < seq)
+	{
+		journal.sent_seq = seq;
+		read_addr = ack_addr;
+	}
+
+	ack_timeout = JOURNAL_ACK_TIMEOUT;
+	last_tx_time = Mono_ClockGetMs();
+
+	journal_rec_write(JOURNAL_REC_MAGIC_ACK, seq, NULL, 0, 0, 0, Calendar_GetHandle()->GetTimeStamp()); //保存确认位置
+}
+
+static void Journal_Drain(void)
+{
+	extern ctrl_class_t ctrl_class;
+	journal_rec_head_t head;
+	uint32_t now = Mono_ClockGetMs();
+
+	if(!(ctrl_class.dev_ctrl & 0X02))
+	{
+		return;
+	}
+
+	if(journal.sent_seq != journal.ack_seq)
+	{
+		if(now - last_tx_time >= ack_timeout)
+		{
+			/* 确认超时，退回到确认位置重发，超时时间指数退避 */
+			read_addr = ack_addr;
+			journal.sent_seq = journal.ack_seq;
+			last_tx_time = now;
+			ack_timeout = (ack_timeout >= JOURNAL_ACK_MAX_TIMEOUT / 2) ? JOURNAL_ACK_MAX_TIMEOUT : (ack_timeout << 1);
+			return;
+		}
+
+		if(journal.sent_seq - journal.ack_seq >= JOURNAL_TX_WINDOW)
+		{
+			return;
+		}
+	}
+
+	/* 每次调用最多发送一条记录 */
+	while(journal_cursor_get(&read_addr, &head) == 0)
+	{
+		read_addr = journal_rec_end(read_addr, &head);
+		if(head.magic != JOURNAL_REC_MAGIC_DATA || head.seq <= journal.sent_seq)
+		{
+			continue;
+		}
+
+		bytes_to_hex_string((uint8_t*)rec_buf + JOURNAL_REC_HEAD_SIZE, hex_buf, head.len, 0);
+		printf("j200:%u %u %d %d %s\n", head.seq, head.time_stamp, head.rssi, head.snr, hex_buf);
+		journal.sent_seq = head.seq;
+		last_tx_time = now;
+		break;
+	}
+}
+
+Journal_t* Journal_Init(void)
+{
+	uint32_t page_key[JOURNAL_FLASH_PAGE_NUMS]; //页内最大写入序号，0表示无有效记录
+	uint16_t page_used[JOURNAL_FLASH_PAGE_NUMS]; //页内已写入长度，0表示空页
+	journal_rec_head_t head;
+	int best = -1;
+
+	journal.head_seq = 0;
+	journal.ack_seq = 0;
+	journal.lost_nums = 0;
+	write_addr = 0;
+	write_seq = 0;
+	commit_addr = 0;
+
+	/* 扫描日志区，恢复最新序号与主机确认序号 */
+	for(int i = 0; i < JOURNAL_FLASH_PAGE_NUMS; i++)
+	{
+		uint32_t page = JOURNAL_FLASH_START_ADDR + i * JOURNAL_FLASH_PAGE_SIZE;
+		uint32_t addr = page;
+		uint8_t ret;
+
+		page_key[i] = 0;
+		while((ret = journal_rec_read(addr, &head)) == JOURNAL_REC_VALID)
+		{
+			if(head.write_seq > page_key[i])
+			{
+				page_key[i] = head.write_seq;
+			}
+
+			if(head.magic == JOURNAL_REC_MAGIC_DATA && head.seq > journal.head_seq)
+			{
+				journal.head_seq = head.seq;
+			}
+			else if(head.magic == JOURNAL_REC_MAGIC_ACK && head.seq > journal.ack_seq)
+			{
+				journal.ack_seq = head.seq;
+			}
+			addr = journal_rec_end(addr, &head);
+		}
+
+		/* 掉电导致的残缺记录之后不可再写入，视为整页已满 */
+		page_used[i] = (ret == JOURNAL_REC_INVALID) ? JOURNAL_FLASH_PAGE_SIZE : (addr - page);
+	}
+
+	/* 写入页：写入序号最大的页。确认记录的序号不大于最新数据序号，
+	   只含确认记录的页按记录序号无法与之前的数据页区分先后 */
+	for(int i = 0; i < JOURNAL_FLASH_PAGE_NUMS; i++)
+	{
+		if(page_key[i] != 0 && (best < 0 || page_key[i] > page_key[best]))
+		{
+			best = i;
+		}
+	}
+	write_seq = (best < 0) ? 1 : (page_key[best] + 1);
+
+	if(best < 0)
+	{
+		write_page = JOURNAL_FLASH_START_ADDR;
+		write_addr = write_page;
+		if(journal_rec_read(write_page, &head) != JOURNAL_REC_FREE)
+		{
+			flash_page_erase(write_page, 1);
+		}
+	}
+	else
+	{
+		write_page = JOURNAL_FLASH_START_ADDR + best * JOURNAL_FLASH_PAGE_SIZE;
+		write_addr = write_page + page_used[best];
+	}
+
+	if(journal.ack_seq > journal.head_seq)
+	{
+		journal.ack_seq = journal.head_seq;
+	}
+
+	/* 写入页已满时暂以页首作为查找终点，随后换页 */
+	uint8_t page_full = (write_page + JOURNAL_FLASH_PAGE_SIZE - write_addr < JOURNAL_REC_HEAD_SIZE);
+	if(page_full)
+	{
+		write_addr = write_page;
+	}
+	commit_addr = write_addr;
+
+	/* 从最旧一页开始查找第一条未确认记录 */
+	ack_addr = journal_next_page(write_page);
+	while(journal_cursor_get(&ack_addr, &head) == 0)
+	{
+		if(head.magic == JOURNAL_REC_MAGIC_DATA && head.seq > journal.ack_seq)
+		{
+			break;
+		}
+		ack_addr = journal_rec_end(ack_addr, &head);
+	}
+	read_addr = ack_addr;
+	journal.sent_seq = journal.ack_seq;
+
+	if(page_full)
+	{
+		journal_page_switch();
+	}
+
+	ack_timeout = JOURNAL_ACK_TIMEOUT;
+	last_tx_time = Mono_ClockGetMs();
+
+	journal.Append = Journal_Append;
+	journal.Ack = Journal_Ack;
+	journal.Drain = Journal_Drain;
+
+	return &journal;
+}
+
+Journal_t* Journal_GetHandle(void)
+{
+	return &journal;
+}
+
+
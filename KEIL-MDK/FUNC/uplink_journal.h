@@ -0,0 +1,49 @@
+#ifndef __UPLINK_JOURNAL_H__
+#define __UPLINK_JOURNAL_H__
+#include "main.h"
+
+
+/* 上行数据日志存储区，紧邻系统参数页之后，避开IOT对象属性页(85,86)与FDS页(125~127) */
+#define JOURNAL_FLASH_START_ADDR			ADDR_FLASH_PAGE_88 //日志存储起始地址
+#define JOURNAL_FLASH_PAGE_NUMS				32 //日志存储页数(page88~page119)
+#define JOURNAL_FLASH_PAGE_SIZE				4096 //flash页大小
+#define JOURNAL_FLASH_END_ADDR				(JOURNAL_FLASH_START_ADDR + JOURNAL_FLASH_PAGE_NUMS * JOURNAL_FLASH_PAGE_SIZE)
+
+#define JOURNAL_REC_MAGIC_DATA				0XA55A //上行数据记录
+#define JOURNAL_REC_MAGIC_ACK				0X5AA5 //主机确认位置记录
+#define JOURNAL_REC_MAGIC_FREE				0XFFFF //未写入区域
+
+#define JOURNAL_WRITE_BUF_NUMS				4 //等待写入flash的记录数
+#define JOURNAL_TX_WINDOW					16 //未确认记录窗口大小
+#define JOURNAL_ACK_TIMEOUT					2000u //主机确认超时时间，单位ms
+#define JOURNAL_ACK_MAX_TIMEOUT				64000u //主机确认退避最大时间，单位ms
+
+/* 日志记录头，数据按4字节对齐紧随其后，记录不跨页 */
+typedef struct {
+	uint16_t magic; //记录类型
+	uint8_t len; //数据长度
+	int8_t snr; //上行信噪比
+	int16_t rssi; //上行信号强度
+	uint16_t crc; //记录头(crc置0)与数据的CRC
+	uint32_t seq; //数据记录：记录序号，确认记录：主机已确认序号
+	uint32_t time_stamp; //接收时间戳
+	uint32_t write_seq; //写入序号，每写入一条记录递增，与记录序号无关，用于上电查找写入页
+}journal_rec_head_t;
+
+typedef struct {
+	uint32_t head_seq; //最新写入的记录序号
+	uint32_t ack_seq; //主机已确认的记录序号
+	uint32_t sent_seq; //已发送到主机的记录序号
+	uint32_t lost_nums; //未确认即被覆盖的记录数
+
+	void (*Append)(uint8_t* p_data, uint8_t size, int16_t rssi, int8_t snr, uint32_t time_stamp); //time_stamp:接收时间戳
+	void (*Ack)(uint32_t seq);
+	void (*Drain)(void);
+}Journal_t;
+
+Journal_t* Journal_Init(void);
+Journal_t* Journal_GetHandle(void);
+
+#endif
+
+
@@ -0,0 +1,251 @@
+#include "vib_feature.h"
+#include "string.h"
+#include "math.h"
+
+
+#define VIB_FEATURE_Q15_ONE					32767
+#define VIB_FEATURE_INPUT_MAX				16383 //输入放大上限(14位)，蝶形相加不溢出
+
+static VibFeature_t vib_feature;
+static int16_t fft_re[VIB_FEATURE_FFT_MAX];
+static int16_t fft_im[VIB_FEATURE_FFT_MAX];
+static int16_t cos_tb[VIB_FEATURE_FFT_MAX / 2]; //cos(2*pi*i/VIB_FEATURE_FFT_MAX)，Q15
+static uint8_t* block_buf;
+static int8_t input_shift; //输入放大位数，负数为缩小
+
+static int16_t vib_sample_get(uint16_t index, uint8_t axis)
+{
+	uint8_t* p = &block_buf[index * VIB_FEATURE_SAMPLE_SIZE + axis * 2];
+	
+	return (int16_t)((p[0] << 8) | p[1]);
+}
+
+//sin(2*pi*i/N) = cos(2*pi*(i-N/4)/N)，i取0~N/2-1
+static int16_t vib_sin_get(uint16_t i)
+{
+	return cos_tb[i >= VIB_FEATURE_FFT_MAX / 4 ? i - VIB_FEATURE_FFT_MAX / 4 : VIB_FEATURE_FFT_MAX / 4 - i];
+}
+
+static uint16_t vib_bit_reverse(uint16_t i, uint16_t n)
+{
+	uint16_t r = 0;
+	
+	for(n >>= 1; n > 0; n >>= 1)
+	{
+		r = (r << 1) | (i & 0X01);
+		i >>= 1;
+	}
+	
+	return r;
+}
+
+//时域统计，去直流后按位反序装入FFT缓存
+static void vib_stat_step(void)
+{
+	vib_axis_feature_t* feature = &vib_feature.feature[vib_feature.axis];
+	int32_t sum = 0;
+	int32_t mean, v;
+	int32_t peak = 0;
+	float sq_sum = 0;
+	
+	for(uint16_t i = 0; i < vib_feature.sample_nums; i++)
+	{
+		sum += vib_sample_get(i, vib_feature.axis);
+	}
+	mean = sum / vib_feature.sample_nums;
+	
+	for(uint16_t i = 0; i < vib_feature.sample_nums; i++)
+	{
+		v = vib_sample_get(i, vib_feature.axis) - mean;
+		sq_sum += (float)(v * v);
+		v = v < 0 ? -v : v;
+		peak = v > peak ? v : peak;
+	}
+	
+	feature->rms = sqrtf(sq_sum / vib_feature.sample_nums);
+	feature->peak = (float)peak;
+	feature->crest = feature->rms > 0 ? feature->peak / feature->rms : 0;
+	
+	//块浮点：按FFT段内最大值放大到8192~16383
+	peak = 0;
+	for(uint16_t i = 0; i < vib_feature.fft_size; i++)
+	{
+		v = vib_sample_get(i, vib_feature.axis) - mean;
+		v = v < 0 ? -v : v;
+		peak = v > peak ? v : peak;
+	}
+	input_shift = 0;
+	while(peak > 0 && peak <= VIB_FEATURE_INPUT_MAX / 2 && input_shift < 15)
+	{
+		peak <<= 1;
+		input_shift++;
+	}
+	while(peak > VIB_FEATURE_INPUT_MAX)
+	{
+		peak >>= 1;
+		input_shift--;
+	}
+	
+	for(uint16_t i = 0; i < vib_feature.fft_size; i++)
+	{
+		v = vib_sample_get(i, vib_feature.axis) - mean;
+		v = input_shift >= 0 ? v << input_shift : v >> -input_shift;
+		fft_re[vib_bit_reverse(i, vib_feature.fft_size)] = (int16_t)v;
+		fft_im[i] = 0;
+	}
+	
+	vib_feature.stage = 0;
+	vib_feature.state = VIB_FEATURE_FFT;
+}
+
+//一级蝶形运算，输出右移1位
+static void vib_fft_step(void)
+{
+	uint16_t half = 1 << vib_feature.stage;
+	uint16_t step = VIB_FEATURE_FFT_MAX / (half << 1);
+	int32_t c, s, tr, ti;
+	uint16_t j;
+	
+	for(uint16_t k = 0; k < half; k++)
+	{
+		c = cos_tb[k * step];
+		s = vib_sin_get(k * step);
+		for(uint16_t i = k; i < vib_feature.fft_size; i += half << 1)
+		{
+			j = i + half;
+			tr = (fft_re[j] * c + fft_im[j] * s) >> 15;
+			ti = (fft_im[j] * c - fft_re[j] * s) >> 15;
+			fft_re[j] = (int16_t)((fft_re[i] - tr) >> 1);
+			fft_im[j] = (int16_t)((fft_im[i] - ti) >> 1);
+			fft_re[i] = (int16_t)((fft_re[i] + tr) >> 1);
+			fft_im[i] = (int16_t)((fft_im[i] + ti) >> 1);
+		}
+	}
+	
+	vib_feature.stage++;
+	if((1 << vib_feature.stage) >= vib_feature.fft_size)
+	{
+		vib_feature.state = VIB_FEATURE_BAND;
+	}
+}
+
+//输出为X(k)/N，单边频谱2|Y(k)|^2之和为均方值，不含直流与奈奎斯特频点
+static void vib_band_step(void)
+{
+	vib_axis_feature_t* feature = &vib_feature.feature[vib_feature.axis];
+	float energy[VIB_FEATURE_BAND_NUMS] = {0};
+	uint16_t bins = vib_feature.fft_size / 2;
+	uint32_t power;
+	
+	for(uint16_t k = 1; k < bins; k++)
+	{
+		power = (uint32_t)(fft_re[k] * fft_re[k]) + (uint32_t)(fft_im[k] * fft_im[k]);
+		energy[k * VIB_FEATURE_BAND_NUMS / bins] += (float)power;
+	}
+	
+	for(uint8_t i = 0; i < VIB_FEATURE_BAND_NUMS; i++)
+	{
+		feature->band_rms[i] = sqrtf(ldexpf(energy[i] * 2, -2 * input_shift));
+	}
+	
+	vib_feature.axis++;
+	if(vib_feature.axis >= VIB_FEATURE_AXIS_NUMS)
+	{
+		vib_feature.stat.block_nums++;
+		vib_feature.state = VIB_FEATURE_DONE;
+	}
+	else
+	{
+		vib_feature.state = VIB_FEATURE_STAT;
+	}
+}
+
+static uint8_t VibFeature_Start(uint8_t* p_block, uint16_t len)
+{
+	uint16_t nums = len / VIB_FEATURE_SAMPLE_SIZE;
+	
+	if(len % VIB_FEATURE_SAMPLE_SIZE != 0 || nums < VIB_FEATURE_FFT_MIN)
+	{
+		return 0;
+	}
+	
+	block_buf = p_block;
+	vib_feature.sample_nums = nums;
+	vib_feature.fft_size = VIB_FEATURE_FFT_MAX;
+	while(vib_feature.fft_size > nums)
+	{
+		vib_feature.fft_size >>= 1;
+	}
+	vib_feature.axis = 0;
+	vib_feature.stage = 0;
+	memset(vib_feature.feature, 0, sizeof(vib_feature.feature));
+	vib_feature.state = VIB_FEATURE_STAT;
+	
+	return 1;
+}
+
+static uint8_t VibFeature_Step(void)
+{
+	switch(vib_feature.state)
+	{
+		case VIB_FEATURE_STAT:
+			vib_stat_step();
+			break;
+		case VIB_FEATURE_FFT:
+			vib_fft_step();
+			break;
+		case VIB_FEATURE_BAND:
+			vib_band_step();
+			break;
+		default:
+			break;
+	}
+	
+	return vib_feature.state == VIB_FEATURE_DONE;
+}
+
+static void VibFeature_Stop(void)
+{
+	vib_feature.state = VIB_FEATURE_IDLE;
+	block_buf = NULL;
+}
+
+static uint8_t VibFeature_Exceed(float* thres)
+{
+	uint8_t mask = 0;
+	
+	for(uint8_t i = 0; i < VIB_FEATURE_AXIS_NUMS; i++)
+	{
+		if(thres[i] > 0 && vib_feature.feature[i].peak > thres[i] * 1000)
+		{
+			mask |= 1 << i;
+		}
+	}
+	
+	return mask;
+}
+
+VibFeature_t* VibFeature_Init(void)
+{
+	memset(&vib_feature, 0, sizeof(vib_feature));
+	block_buf = NULL;
+	
+	for(uint16_t i = 0; i < VIB_FEATURE_FFT_MAX / 2; i++)
+	{
+		cos_tb[i] = (int16_t)lroundf(VIB_FEATURE_Q15_ONE * cosf(2 * 3.14159265f * i / VIB_FEATURE_FFT_MAX));
+	}
+	
+	vib_feature.Start = VibFeature_Start;
+	vib_feature.Step = VibFeature_Step;
+	vib_feature.Stop = VibFeature_Stop;
+	vib_feature.Exceed = VibFeature_Exceed;
+	
+	return &vib_feature;
+}
+
+VibFeature_t* VibFeature_GetHandle(void)
+{
+	return &vib_feature;
+}
+
+
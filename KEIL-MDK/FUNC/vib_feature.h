@@ -0,0 +1,63 @@
+#ifndef __VIB_FEATURE_H__
+#define __VIB_FEATURE_H__
+#include "main.h"
+
+
+/*
+ * 振动特征提取：对块传输收齐的C9波形块计算每轴有效值、峰值、峰值因子与频带有效值，
+ * 主循环每次调用只执行一步(一轴统计或一级蝶形运算)，不阻塞射频收发。
+ *
+ * 波形块格式：采样点按X、Y、Z顺序交错排列，每轴16位有符号数(网络字节序)，单位mg。
+ * 频谱使用Q15定点基2 FFT，每级蝶形右移1位防止溢出，输入按块浮点方式放大到14位，
+ * 输出按放大倍数还原后即为各频点均方值(Parseval)，频带有效值单位同为mg。
+ * 频带按0~采样率/2等分，主机按测点采样率换算频率范围。
+ */
+
+#define VIB_FEATURE_AXIS_NUMS				3 //轴数
+#define VIB_FEATURE_SAMPLE_SIZE				(VIB_FEATURE_AXIS_NUMS * 2) //每个采样点字节数
+#define VIB_FEATURE_FFT_MAX					512 //FFT最大点数，超出部分只参与时域统计
+#define VIB_FEATURE_FFT_MIN					16 //FFT最小点数，采样点数不足时不提取特征
+#define VIB_FEATURE_BAND_NUMS				4 //频带数
+
+typedef enum {
+	VIB_FEATURE_IDLE, //空闲
+	VIB_FEATURE_STAT, //时域统计并装入FFT缓存
+	VIB_FEATURE_FFT, //蝶形运算，每步一级
+	VIB_FEATURE_BAND, //频带有效值
+	VIB_FEATURE_DONE, //全部轴完成
+}VibFeature_State;
+
+typedef struct {
+	float rms; //有效值(去直流)，单位mg
+	float peak; //峰值(去直流绝对值最大)，单位mg
+	float crest; //峰值因子
+	float band_rms[VIB_FEATURE_BAND_NUMS]; //频带有效值，单位mg
+}vib_axis_feature_t;
+
+typedef struct {
+	uint32_t block_nums; //提取特征的块数
+	uint32_t raw_nums; //特征超过阈值转发原始数据的块数
+	uint32_t saved_bytes; //未转发原始数据节省的主机串口字节数
+}vib_feature_stat_t;
+
+typedef struct {
+	VibFeature_State state;
+	uint16_t sample_nums; //每轴采样点数
+	uint16_t fft_size; //FFT点数
+	uint8_t axis; //当前轴
+	uint8_t stage; //当前蝶形级
+	vib_axis_feature_t feature[VIB_FEATURE_AXIS_NUMS];
+	vib_feature_stat_t stat;
+	
+	uint8_t (*Start)(uint8_t* p_block, uint16_t len); //采样点数不足或长度不是整数个采样点返回0，块缓存在完成前不能改动
+	uint8_t (*Step)(void); //全部轴完成返回1
+	void (*Stop)(void);
+	uint8_t (*Exceed)(float* thres); //峰值超过阈值(单位g，不大于0不检查)的轴位图
+}VibFeature_t;
+
+VibFeature_t* VibFeature_Init(void);
+VibFeature_t* VibFeature_GetHandle(void);
+
+#endif
+
+
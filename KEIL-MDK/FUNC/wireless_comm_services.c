@@ -1,10 +1,15 @@
 /*
  * modbus_slave.c
- * οһ汾ʵͬ485ͨѶЭ
- *  Created on: 201921
+ * 参考张新星上一个版本，实现同禾485通讯协议
+ *  Created on: 2019年2月1日
  *      Author: xuhui
  */
 #include "wireless_comm_services.h"
+#include "string.h"
+#include "block_transfer.h"
+#include "link_sweep.h"
+#include "lora_transmission.h"
+#include "mono_clock.h"
 
 static const uint8_t aucCRCHi[] = {
 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81,
@@ -68,7 +73,7 @@ static uint8_t _isCmdValid()
 * Input          : *pucFrame,usLen
 * Output         : uint16_t
 * Return         : None
-* Attention		 : λںλǰ PLCר
+* Attention		 : 高位在后地位在前 PLC专用
 *******************************************************************************/
 static uint16_t _modbusRtuCRC(uint8_t *pucFrame, uint16_t usLen)
 {
@@ -82,7 +87,7 @@ static uint16_t _modbusRtuCRC(uint8_t *pucFrame, uint16_t usLen)
         ucCRCLo = (uint8_t)( ucCRCHi ^ aucCRCHi[iIndex] );
         ucCRCHi = aucCRCLo[iIndex];
     }
-//		return (uint16_t)( ucCRCLo<< 8 | ucCRCHi  );//λںλǰ PLCר
+//		return (uint16_t)( ucCRCLo<< 8 | ucCRCHi  );//高位在后地位在前 PLC专用
 	
 	return (uint16_t)(ucCRCLo | ucCRCHi<<8);
 }
@@ -101,10 +106,10 @@ static uint8_t _isCRCValid()
 
 static void _clearFlags()
 {
-	//buffer
+	//清除接收buffer
 	self._rx_count = 0;
 
-	//buffer
+	//清除发送buffer
 	self._tx_count = 0;
 
 	self._frame_finish_flag = 0;
@@ -141,12 +146,12 @@ static uint8_t _writeShortAddr()
 
 static uint8_t _writeMultiProps()
 {
-	//ԸǷСԸ
+	//检查属性个数是否小于最大属性个数
 	uint8_t nProps = self._rx_buf[DATA_LEN_BYTE_ID + 3];
 //	if(nProps > MAX_PROP_COUNT)
 //		return 0;
 
-	//ԺǷ, cannot be greater than max property count
+	//检查属性号是否合理, cannot be greater than max property count
 	uint8_t i;
 	uint8_t totalLens = nProps + 1;
 
@@ -158,11 +163,11 @@ static uint8_t _writeMultiProps()
 		totalLens += self._sensor->getPropLen(self._rx_buf[DATA_LEN_BYTE_ID + 4 + i]);
 	}
 
-	//ݳǷȷ
+	//检查数据长度是否正确
 	if(self._rx_buf[DATA_LEN_BYTE_ID] != totalLens)
 		return 0;
 
-	//ݣдiot_object
+	//解析数据，写入iot_object
 	uint8_t propId;
 	uint8_t pStart = DATA_LEN_BYTE_ID + 4 + nProps;
 
@@ -181,12 +186,12 @@ static uint8_t _writeMultiProps()
 
 static uint8_t _readMultiProps()
 {
-	//ԸǷСԸ
+	//检查属性个数是否小于最大属性个数
 	uint8_t nProps = self._rx_buf[DATA_LEN_BYTE_ID];
 //	if(nProps > MAX_PROP_COUNT)
 //		return 0;
 
-	//ԺǷ, cannot be greater than max property count
+	//检查属性号是否合理, cannot be greater than max property count
 	uint8_t i;
 	uint8_t totalLens = nProps + 1;
 
@@ -198,13 +203,13 @@ static uint8_t _readMultiProps()
 		totalLens += self._sensor->getPropLen(self._rx_buf[DATA_LEN_BYTE_ID + 1 + i]);
 	}
 
-	//صݳ
+	//返回的数据长
 	self._tx_buf[DATA_LEN_BYTE_ID] = totalLens;
 
-	//Ը
+	//总属性个数
 	self._tx_buf[DATA_LEN_BYTE_ID + 1] = nProps;
 
-	//ȡiot_objectݵʹ
+	//读取iot_object的数据到发送传输数组中
 	uint8_t propId;
 	uint8_t pStart = DATA_LEN_BYTE_ID + 2 + nProps;
 
@@ -240,7 +245,7 @@ static uint8_t _parseMasterMsg(void)
 {
 	if(self._frame_finish_flag)
 	{
-		//ݳǷȷ
+		//检查数据长度是否正确
 		if(self._rx_buf[DATA_LEN_BYTE_ID] != self._rx_count)
 		{
 			_clearFlags();
@@ -277,11 +282,17 @@ static uint8_t _parseMasterMsg(void)
 				return 0;
 			}
 			
-			if(_writeShortAddr() == 0)				//дSHORT_NAME
+			if(_writeShortAddr() == 0)				//写对象的SHORT_NAME
 			{
 				_clearFlags();
 				return 0;
 			}
+			
+			//短地址之后为组序号
+			if(self._rx_buf[DATA_LEN_BYTE_ID] >= 19)
+			{
+				self._group_index = self._rx_buf[DATA_LEN_BYTE_ID + 19];
+			}
 		}
 		else if(cmd == CMD_PUBLISH_RESP)
 		{
@@ -291,7 +302,7 @@ static uint8_t _parseMasterMsg(void)
 				return 0;
 			}
 			
-			if (_writeMultiProps() == 0)				//дĶͨ
+			if (_writeMultiProps() == 0)				//写对象的多个普通属性
 			{
 				_clearFlags();
 				return 0;
@@ -320,6 +331,19 @@ static uint8_t _parseMasterMsg(void)
 					return 0;
 				}
 			}
+			
+			//链路扫描组合参数下记录往返时间，下一个测试帧带给网关
+			if(self._sweep.active)
+			{
+				uint32_t now = Mono_ClockGetMs();
+				uint32_t rtt = now - self._sweep.tx_time;
+				self._sweep.rtt = (rtt == 0) ? 1 : (rtt > UINT16_MAX ? UINT16_MAX : rtt);
+				self._sweep.rx_time = now;
+				if(self._sweep.seq >= self._sweep.frames)
+				{
+					self._sweep.done = 1;
+				}
+			}
 		}
 
 		//clear the flags and buffers
@@ -331,9 +355,275 @@ static uint8_t _parseMasterMsg(void)
 		return 0;	//no msg received
 }
 
+//网络字节序
+static uint32_t _readNetU32(uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+//写入属性个数+属性号+属性值，长度与属性表不符返回0
+static uint8_t _writePropsAt(uint8_t* buf, uint8_t size)
+{
+	uint8_t nProps = buf[0];
+	uint8_t totalLens = nProps + 1;
+	uint8_t i;
+
+	for(i = 0; i < nProps && i + 1 < size; i++)
+	{
+		totalLens += self._sensor->getPropLen(buf[1 + i]);
+	}
+
+	if(size != totalLens)
+		return 0;
+
+	uint8_t propId;
+	uint8_t pStart = 1 + nProps;
+
+	for(i = 0; i < nProps; i++)
+	{
+		propId = buf[1 + i];
+		self._sensor->writePropFromBuf(propId, &buf[pStart]);
+		pStart += self._sensor->getPropLen(propId);
+	}
+
+	return 1;
+}
+
+//组确认帧：命令头+长度+网关长地址8+周期序号1+网关时间戳4+周期4+确认方式1+确认长度1+确认数据+参数段个数1+参数段
+//确认方式0为短地址(长地址末2字节)列表，1为按组序号排列的位图；参数段为测点类型1+长度1+属性
+static uint8_t _parseGroupAck(void)
+{
+	uint8_t* p = self._rx_buf;
+	uint8_t len = p[DATA_LEN_BYTE_ID];
+	uint16_t end = DATA_LEN_BYTE_ID + 1 + len;
+	uint16_t index = DATA_LEN_BYTE_ID + 9;
+	uint8_t result = GROUP_ACK_RESULT_TIME;
+	uint8_t mode, nums, i;
+	uint16_t crc;
+
+	if(!self._frame_finish_flag || self._rx_count != len + 7 || len < 8 + 11)
+		return 0;
+
+	if(_readNetU32(p) != CMD_GROUP_ACK || memcmp(&p[DATA_LEN_BYTE_ID + 1], self._gateway_long_addr, 8) != 0)
+		return 0;
+
+	//网关按小端写入CRC
+	crc = _modbusRtuCRC(p, end);
+	if(p[end] != (crc & 0xFF) || p[end + 1] != (crc >> 8))
+	{
+		_clearFlags();
+		return 0;
+	}
+
+	self._group_seq = p[index];
+	self._group_time_stamp = _readNetU32(&p[index + 1]);
+	self._group_period = _readNetU32(&p[index + 5]);
+	index += 9;
+
+	mode = p[index];
+	nums = p[index + 1];
+	index += 2;
+	if(mode == 0)
+	{
+		for(i = 0; i < nums && index + 2 <= end; i++, index += 2)
+		{
+			if(memcmp(&p[index], &self._sensor->_longAddr[6], 2) == 0)
+				result |= GROUP_ACK_RESULT_ACKED;
+		}
+	}
+	else
+	{
+		if(self._group_index < nums * 8 && index + self._group_index / 8 < end &&
+		   (p[index + self._group_index / 8] & (1 << (self._group_index % 8))))
+			result |= GROUP_ACK_RESULT_ACKED;
+		index += nums;
+	}
+
+	//只写入本类测点的参数段
+	if(index < end)
+	{
+		nums = p[index++];
+		for(i = 0; i < nums && index + 2 <= end; i++)
+		{
+			if(p[index] == self._sensor->_longAddr[0] && index + 2 + p[index + 1] <= end &&
+			   _writePropsAt(&p[index + 2], p[index + 1]))
+				result |= GROUP_ACK_RESULT_ATTR;
+			index += 2 + p[index + 1];
+		}
+	}
+
+	_clearFlags();
+	return result;
+}
+
+//分片帧：命令头+长度+长地址8+块序号1+分片序号1+分片个数1+标志1+块长度2+分片数据
+static uint8_t _packBlockFrag(uint8_t* block, uint16_t block_len, uint8_t block_id, uint8_t index, uint8_t flags)
+{
+	uint8_t nums = (block_len + BLOCK_FRAG_SIZE - 1) / BLOCK_FRAG_SIZE;
+	uint8_t frag_len;
+	uint16_t crc;
+	uint8_t* p = self._tx_buf;
+
+	if(index >= nums)
+		return 0;
+
+	frag_len = (index == nums - 1) ? block_len - index * BLOCK_FRAG_SIZE : BLOCK_FRAG_SIZE;
+
+	p[0] = (CMD_BLOCK >> 24) & 0xFF;
+	p[1] = (CMD_BLOCK >> 16) & 0xFF;
+	p[2] = (CMD_BLOCK >> 8) & 0xFF;
+	p[3] = CMD_BLOCK & 0xFF;
+	p[DATA_LEN_BYTE_ID] = BLOCK_FRAG_HEAD_LEN + frag_len;
+	memcpy(&p[DATA_LEN_BYTE_ID + 1], self._sensor->_longAddr, 8);
+	p[DATA_LEN_BYTE_ID + 9] = block_id;
+	p[DATA_LEN_BYTE_ID + 10] = index;
+	p[DATA_LEN_BYTE_ID + 11] = nums;
+	p[DATA_LEN_BYTE_ID + 12] = flags;
+	p[DATA_LEN_BYTE_ID + 13] = block_len >> 8;
+	p[DATA_LEN_BYTE_ID + 14] = block_len & 0xFF;
+	memcpy(&p[DATA_LEN_BYTE_ID + 1 + BLOCK_FRAG_HEAD_LEN], &block[index * BLOCK_FRAG_SIZE], frag_len);
+
+	self._tx_count = DATA_LEN_BYTE_ID + 1 + p[DATA_LEN_BYTE_ID];
+	crc = _modbusRtuCRC(p, self._tx_count);
+	p[self._tx_count++] = crc & 0xFF;
+	p[self._tx_count++] = crc >> 8;
+
+	return self._tx_count;
+}
+
+//确认帧：命令头+长度+长地址8+网关长地址8+块序号1+分片个数1+状态1+已收分片位图4
+static uint8_t _parseBlockAck(uint8_t block_id, uint8_t* status, uint32_t* frag_map)
+{
+	uint8_t* p = self._rx_buf;
+	uint8_t len = p[DATA_LEN_BYTE_ID];
+	uint16_t end = DATA_LEN_BYTE_ID + 1 + len;
+	uint16_t crc;
+
+	if(!self._frame_finish_flag || self._rx_count != len + 7 || len < 16 + 7)
+		return 0;
+
+	if(_readNetU32(p) != CMD_BLOCK_ACK || self._sensor->isLongAddrEq(&p[DATA_LEN_BYTE_ID + 1]) == 0 ||
+	   memcmp(&p[DATA_LEN_BYTE_ID + 9], self._gateway_long_addr, 8) != 0 || p[DATA_LEN_BYTE_ID + 17] != block_id)
+		return 0;
+
+	//网关按小端写入CRC
+	crc = _modbusRtuCRC(p, end);
+	if(p[end] != (crc & 0xFF) || p[end + 1] != (crc >> 8))
+	{
+		_clearFlags();
+		return 0;
+	}
+
+	*status = p[DATA_LEN_BYTE_ID + 19];
+	*frag_map = _readNetU32(&p[DATA_LEN_BYTE_ID + 20]);
+
+	_clearFlags();
+	return 1;
+}
+
+//扫描命令：命令头+长度+长地址8+网关长地址8+组合序号1+扩频因子1+带宽序号1+发射功率1+载荷长度1+测试帧数1+回退时间2
+static uint8_t _parseSweep(void)
+{
+	uint8_t* p = self._rx_buf;
+	uint8_t len = p[DATA_LEN_BYTE_ID];
+	uint16_t end = DATA_LEN_BYTE_ID + 1 + len;
+	uint8_t* data = &p[DATA_LEN_BYTE_ID + 17];
+	Lora_RadioCfg_t cfg;
+	uint16_t crc;
+
+	if(!self._frame_finish_flag || self._rx_count != len + 7 || len < 16 + 8)
+		return 0;
+
+	if(_readNetU32(p) != CMD_SWEEP || self._sensor->isLongAddrEq(&p[DATA_LEN_BYTE_ID + 1]) == 0 ||
+	   memcmp(&p[DATA_LEN_BYTE_ID + 9], self._gateway_long_addr, 8) != 0)
+		return 0;
+
+	//网关按小端写入CRC，扩频因子5~12，带宽序号0~9
+	crc = _modbusRtuCRC(p, end);
+	if(p[end] != (crc & 0xFF) || p[end + 1] != (crc >> 8) ||
+	   data[1] < 5 || data[1] > 12 || data[2] > 9 || data[5] == 0 || data[5] > LINK_SWEEP_MAX_FRAMES)
+	{
+		_clearFlags();
+		return 0;
+	}
+
+	self._sweep.cell_index = data[0];
+	self._sweep.len = data[4];
+	self._sweep.frames = data[5];
+	self._sweep.fallback = ((uint16_t)data[6] << 8) | data[7];
+	if(self._sweep.fallback == 0)
+		self._sweep.fallback = LINK_SWEEP_FALLBACK_TIME;
+	self._sweep.seq = 0;
+	self._sweep.rtt = 0;
+	self._sweep.done = 0;
+	self._sweep.rx_time = Mono_ClockGetMs();
+	self._sweep.active = 1;
+
+	cfg.sf = data[1];
+	cfg.bw = data[2];
+	cfg.power = (int8_t)data[3];
+	LORA_RadioApply(&cfg);
+
+	_clearFlags();
+	return 1;
+}
+
+//测试帧：命令头+长度+长地址8+回复载荷长度1+测试序号1+上一次往返时间2
+//组合参数下载荷长度取扫描命令的值，基准参数下序号与往返时间为0
+static uint8_t _packSweepTest(uint8_t reply_len)
+{
+	uint8_t* p = self._tx_buf;
+	uint8_t seq = 0;
+	uint16_t rtt = 0;
+	uint16_t crc;
+
+	if(self._sweep.active)
+	{
+		if(self._sweep.seq >= self._sweep.frames)
+			return 0;
+
+		reply_len = self._sweep.len;
+		seq = self._sweep.seq++;
+		rtt = self._sweep.rtt;
+		self._sweep.tx_time = Mono_ClockGetMs();
+	}
+
+	p[0] = (CMD_TEST >> 24) & 0xFF;
+	p[1] = (CMD_TEST >> 16) & 0xFF;
+	p[2] = (CMD_TEST >> 8) & 0xFF;
+	p[3] = CMD_TEST & 0xFF;
+	p[DATA_LEN_BYTE_ID] = 8 + 4;
+	memcpy(&p[DATA_LEN_BYTE_ID + 1], self._sensor->_longAddr, 8);
+	p[DATA_LEN_BYTE_ID + 9] = reply_len;
+	p[DATA_LEN_BYTE_ID + 10] = seq;
+	p[DATA_LEN_BYTE_ID + 11] = rtt >> 8;
+	p[DATA_LEN_BYTE_ID + 12] = rtt & 0xFF;
+
+	self._tx_count = DATA_LEN_BYTE_ID + 1 + p[DATA_LEN_BYTE_ID];
+	crc = _modbusRtuCRC(p, self._tx_count);
+	p[self._tx_count++] = crc & 0xFF;
+	p[self._tx_count++] = crc >> 8;
+
+	return self._tx_count;
+}
+
+static uint8_t _sweepProc(void)
+{
+	if(!self._sweep.active)
+		return 0;
+
+	if(self._sweep.done || Mono_ClockGetMs() - self._sweep.rx_time >= self._sweep.fallback * 1000u)
+	{
+		self._sweep.active = 0;
+		LORA_RadioApply(NULL);
+	}
+
+	return self._sweep.active;
+}
+
 static void _wirelessRxCpltCallBack(uint8_t* pData, uint16_t size)
 {
-	//ջ
+	//放入接收缓存区
 	if(self._rx_count == 0 && size < MAX_WIRELESS_COMM_BUF_SIZE-1)
 	{
 		self._rx_count = size;
@@ -348,12 +638,20 @@ static void _wirelessRxCpltCallBack(uint8_t* pData, uint16_t size)
 
 wireless_comm_services_t * createWirelessCommServiceHandler(void)
 {
-	//ʼ֡־
+	//初始化帧标志
 	self._rx_count = 0;
 	self._tx_count = 0;
 	self._frame_finish_flag = 0;
+	self._group_index = GROUP_INDEX_NONE;
+	memset(&self._sweep, 0, sizeof(self._sweep));
 
 	self.parseMasterMsg = _parseMasterMsg;
+	self.parseGroupAck = _parseGroupAck;
+	self.packBlockFrag = _packBlockFrag;
+	self.parseBlockAck = _parseBlockAck;
+	self.parseSweep = _parseSweep;
+	self.packSweepTest = _packSweepTest;
+	self.sweepProc = _sweepProc;
 	self.wirelessRxCpltCallBack = _wirelessRxCpltCallBack;
 	self.setFrameFinishFlag = _setFrameFinishFlag;
 	self.setSensorHandler = _setSensorHandler;
@@ -1,8 +1,8 @@
 /*
  * modbus_slave.h
- * ʵֻ485ߵmodbus˽ͨѶЭ
+ * 实现基于485总线的类modbus私有通讯协议
  *
- *  Created on: 201921
+ *  Created on: 2019年2月1日
  *      Author: xuhui
  */
 
@@ -18,38 +18,86 @@
 #define CMD_PUBLISH_RESP				0x00000004
 #define CMD_TEST						0x00000005
 #define CMD_TEST_RESP					0x00000006
+#define CMD_SWEEP						0x00000007 //链路扫描参数切换(网关->测点)
+#define CMD_GROUP_ACK					0x00000008 //组确认广播(网关->全体测点)
+#define CMD_BLOCK						0x00000009 //块传输分片(测点->网关)
+#define CMD_BLOCK_ACK					0x0000000A //块传输选择确认(网关->测点)
+#define CMD_FLAG_PENDING				0x00000100 //数据回复下行待发标志，测点下一帧非确认帧也需打开接收窗口
 
 #define DATA_LEN_BYTE_ID 			4
 
 #define MAX_WIRELESS_COMM_BUF_SIZE	255
 
+/* 组确认帧解析结果 */
+#define GROUP_ACK_RESULT_ACKED		0X01 //本测点上一周期的数据帧已确认
+#define GROUP_ACK_RESULT_TIME		0X02 //收到网关时间与周期
+#define GROUP_ACK_RESULT_ATTR		0X04 //收到全体测点参数并已写入
+#define GROUP_INDEX_NONE			0XFF //未分配组序号
+
+/* 测点链路扫描状态，组合参数由网关CMD_SWEEP下发 */
+typedef struct {
+	uint8_t active; //处于组合参数
+	uint8_t done; //最后一个测试帧已收到回复
+	uint8_t cell_index; //组合序号
+	uint8_t len; //测试帧回复载荷长度
+	uint8_t frames; //测试帧数
+	uint8_t seq; //下一个测试帧序号
+	uint16_t fallback; //回退时间(s)
+	uint16_t rtt; //上一个测试帧的往返时间(ms)，0表示无效
+	uint32_t tx_time; //最近一次发送测试帧的时间(ms)
+	uint32_t rx_time; //最近一次收到网关帧的时间(ms)
+}wireless_sweep_t;
+
 
 typedef struct wireless_comm_services {
-	//1ɹ򷵻0
+	//解析主机发过来的命令，返回1如果解析成功，否则返回0
 	uint8_t (*parseMasterMsg)(void);
 
-	//յݣ֡־
+	//处理接收到的数据，清理接收帧标志，并计数
 	void (*wirelessRxCpltCallBack)(uint8_t* pData, uint16_t size);
 
-	//Frame Finish Flag1ʾһ֡Ӧⲿʱже
+	//将Frame Finish Flag至1，表示一帧结束，应当在外部定时器中断中调用
 	void (*setFrameFinishFlag)(void);
 
-	//ôsensor handler
+	//设置待处理的sensor handler
 	void (*setSensorHandler)(iot_object_t *obj);
 	
-	//سַ
+	//设置网关长地址
 	void (*setGatewayLongAddr)(uint8_t* addr);
 	
 	uint16_t (*modbusRtuCRC)(uint8_t *pucFrame, uint16_t usLen);
+	
+	//解析网关组确认广播，返回GROUP_ACK_RESULT_*，不是本网关的组确认帧返回0且不清除接收缓存
+	uint8_t (*parseGroupAck)(void);
+	
+	//块传输分片打包到发送缓存，返回帧长度，分片序号超出块长度返回0
+	uint8_t (*packBlockFrag)(uint8_t* block, uint16_t block_len, uint8_t block_id, uint8_t index, uint8_t flags);
+	
+	//解析网关块传输确认，返回1并输出状态与已收分片位图，不是本测点该块的确认帧返回0且不清除接收缓存
+	uint8_t (*parseBlockAck)(uint8_t block_id, uint8_t* status, uint32_t* frag_map);
+	
+	//解析网关链路扫描命令并切换到组合参数，返回1，不是本测点的扫描命令返回0且不清除接收缓存
+	uint8_t (*parseSweep)(void);
+	
+	//链路扫描测试帧打包到发送缓存，返回帧长度，组合参数下测试帧已发完返回0
+	uint8_t (*packSweepTest)(uint8_t reply_len);
+	
+	//链路扫描回退检查，测试帧发完并收到回复或超过回退时间没有收到网关帧时恢复基准参数，返回是否处于组合参数
+	uint8_t (*sweepProc)(void);
 
 	uint8_t _rx_buf[MAX_WIRELESS_COMM_BUF_SIZE];			//receive buffer
 	uint8_t _tx_buf[MAX_WIRELESS_COMM_BUF_SIZE];			//transmit buffer
 	uint8_t _gateway_long_addr[8];
-	uint8_t _frame_finish_flag;		//־һ֡ս
-	uint8_t _rx_count;			//ǰֽ֡ڸ
-	uint8_t _tx_count;			//ǰֽ֡ڸ
-
-	iot_object_t * _sensor;		//sensorʵ
+	uint8_t _frame_finish_flag;		//标志一帧接收结束
+	uint8_t _rx_count;			//当前接收帧的字节个数
+	uint8_t _tx_count;			//当前发送帧的字节个数
+	uint8_t _group_index;		//组序号，连接回复下发
+	uint8_t _group_seq;			//最近一次组确认的周期序号
+	uint32_t _group_time_stamp;	//最近一次组确认的网关时间戳
+	uint32_t _group_period;		//组确认广播周期(s)
+	wireless_sweep_t _sweep;	//链路扫描状态
+
+	iot_object_t * _sensor;		//待处理的sensor实体
 
 } wireless_comm_services_t;
 
@@ -76,6 +76,7 @@
 #include "iot_operate.h"
 #include "sys_param.h"
 #include "calendar.h"
+#include "mono_clock.h"
 #include "uart_svc.h"
 #include "light.h"
 #include "ble_char_handler.h"
@@ -132,8 +133,8 @@ IoT_dev_t* IoTDevHandle;
 Signal_Det_Info_t*  SignalDetHandle;
 
 /**
- * @brief  ʼЭԳ
- * @param  sensor: ָiot_object_tṹľ
+ * @brief  初始化物联网协议属性长度
+ * @param  sensor: 指向iot_object_t结构的句柄
  * @retval None
  */
 void IoT_SetProp(iot_object_t *sensor) {
@@ -155,7 +156,7 @@ void LPM_EnterHandler(void)
 	}
 	else
 	{
-		NRF_POWER->DCDCEN = 0; //͹ĹرDCDC
+		NRF_POWER->DCDCEN = 0; //低功耗关闭DCDC
 	}
 
 	if(BLEHandle->State == BLE_STA_IDLE)
@@ -173,7 +174,7 @@ void LPM_ExitHandler(void)
 	}
 	else
 	{
-		NRF_POWER->DCDCEN = 1; //˳͹ĴDCDC
+		NRF_POWER->DCDCEN = 1; //退出低功耗打开DCDC
 	}
 	
 	SIGNAL_DET_PWOER_DISABLE();
@@ -185,49 +186,50 @@ uint32_t LedCnt = 0;
  */
 int main(void)
 {
-	/**********************************Ӳ豸ʼ**********************************/
-	NRF_POWER->DCDCEN = 1; //DCDC
+	/**********************************硬件设备初始化**********************************/
+	NRF_POWER->DCDCEN = 1; //打开DCDC
 //	NRF_CLOCK->EVENTS_HFCLKSTARTED = 0;
-//	NRF_CLOCK->TASKS_HFCLKSTART = 1; //ⲿʱԴ
-//	while(!NRF_CLOCK->EVENTS_HFCLKSTARTED); //ȴⲿʱԴ
-	LFCLK_Config(); //RTCʱԴ
-	Light_Init(); //豸ָʾƳʼ
-	timers_init(); //ʱʼRTC1
-	fs_flash_init(); //flashʼ
+//	NRF_CLOCK->TASKS_HFCLKSTART = 1; //启动外部时钟源
+//	while(!NRF_CLOCK->EVENTS_HFCLKSTARTED); //等待外部时钟源启动完成
+	LFCLK_Config(); //RTC时钟源设置
+	Light_Init(); //设备指示灯初始化
+	timers_init(); //定时器初始化基于RTC1
+	Mono_ClockInit(); //单调时钟初始化，与定时器共用RTC1
+	fs_flash_init(); //flash初始化
 	
-	/**********************************ģʼ**********************************/
-	iot_object_t *mySensor = createSensorHandler(); //ʼ
+	/**********************************功能模块初始化**********************************/
+	iot_object_t *mySensor = createSensorHandler(); //传感器对象初始化
 	IoT_SetProp(mySensor);
 	mySensor->init();
-	WirelessCommSvc = createWirelessCommServiceHandler(); //ͨŷʼ
+	WirelessCommSvc = createWirelessCommServiceHandler(); //无线通信服务初始化
 	WirelessCommSvc->setSensorHandler(mySensor);
-	Sys_ParamInit(); //ϵͳʼ
-//	Signal_DetInit(); //źż⹦ܳʼ
-	SWT_Init(); //ʱʼ
-	Calendar_Init(); //ܳʼʼ
-	RNG_LPM_Init(); //͹ʼ
+	Sys_ParamInit(); //系统参数初始化
+//	Signal_DetInit(); //信号检测功能初始化
+	SWT_Init(); //软件定时器初始化
+	Calendar_Init(); //日历功能初始化初始化
+	RNG_LPM_Init(); //低功耗随机数发生器初始化
 
-	/**********************************BLEʼ**********************************/
+	/**********************************BLE初始化**********************************/
 	BLE_Init();
 
-	/**********************************Ӧóʼ**********************************/
-	LPMHandle = LPM_Init(); //͹Ĺʼ
-	BLEHandle = Ble_Init(LPMHandle); //BLEʼ	
-	SignalDetHandle = Signal_DetTaskInit(LPMHandle); //źżʼ
-	LORAHandle = LORA_TaskInit(LPMHandle); //LORAʼ
-	SLPHandle = SLP_TaskInit(LPMHandle); //ϵͳ͹ʼ
-//	InclinometerHandle = Inclinometer_TaskInit(LPMHandle); //бʼ
-	IoTDevHandle = IoT_Init(mySensor, InclinometerHandle); //ЭԳʼ
+	/**********************************应用初始化**********************************/
+	LPMHandle = LPM_Init(); //低功耗管理初始化
+	BLEHandle = Ble_Init(LPMHandle); //BLE任务初始化	
+	SignalDetHandle = Signal_DetTaskInit(LPMHandle); //软件信号检测任务初始化
+	LORAHandle = LORA_TaskInit(LPMHandle); //LORA任务初始化
+	SLPHandle = SLP_TaskInit(LPMHandle); //系统低功耗任务初始化
+//	InclinometerHandle = Inclinometer_TaskInit(LPMHandle); //测斜仪任务初始化
+	IoTDevHandle = IoT_Init(mySensor, InclinometerHandle); //物联网协议属性初始化
 	
-	/**********************************ϵͳ**********************************/
+	/**********************************系统任务设置**********************************/
 	Sys_Task_t task;
 	task.BleTask = BLEHandle;
 	task.InclinometerTask = InclinometerHandle;
 	task.LoraTask = LORAHandle;
 	task.SignalDetTask = SignalDetHandle;
 	task.SlpTask = SLPHandle;
-	Sys_TaskInit(&task); //ϵͳʼ
-	Sys_Startup(); //ϵͳ
+	Sys_TaskInit(&task); //系统任务初始化
+	Sys_Startup(); //系统启动
 	
 	nrf_delay_ms(300);
 	LIGHT_OFF();
@@ -262,6 +264,8 @@ int main(void)
 		LedCnt++;
 		
 		uart_run();
+		
+		flash_job_proc();
 	}
 }
 
@@ -48,9 +48,9 @@ extern "C" {
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
 
-/* ǰӲ汾 */
+/* 当前硬件版本 */
 #define SYS_HW_VERSION						SYS_HW_VERSION_V0_1_1
-/* ֵ֧Ӳ汾 */
+/* 支持的硬件版本 */
 #define SYS_HW_VERSION_V0_3_0				1
 #define SYS_HW_VERSION_V0_1_1				2
 
@@ -1,13 +1,15 @@
 /*
  * function.c
  *
- *  Created on: 2019320
+ *  Created on: 2019年3月20日
  *      Author: xxk
  */
 #include "function.h"
 #include "lora_transmission.h"
+#include "mono_clock.h"
+#include "rx_filter.h"
 
-//spiշ
+//spi收发数据
 uint8_t spi_rw(uint8_t data)
 {
 	uint8_t txBuf[1] = {data};
@@ -16,7 +18,7 @@ uint8_t spi_rw(uint8_t data)
 	return rxBuf[0];
 }
 
-//ģ鸴λź
+//设置模块复位信号
 void rst_pin_set (uint8_t val)
 {
 	if (val == 1) 
@@ -29,7 +31,7 @@ void rst_pin_set (uint8_t val)
 	}
 }
 
-//Ƭѡź
+//设置片选信号
 void sel_pin_set (uint8_t val)
 {
 	if (val == 1) 
@@ -42,24 +44,89 @@ void sel_pin_set (uint8_t val)
 	}
 }
 
-//busy
+//busy，超时记录故障后返回，已有故障时不再等待
 void check_busy(void)
 {
-	while(LORA_READ_STATUS() == 1){};
+	uint64_t start;
+	
+	if(LORA_READ_STATUS() == 0 || LORA_RadioFaulted())
+	{
+		return;
+	}
+	
+	start = Mono_ClockGetTicks();
+	while(LORA_READ_STATUS() == 1)
+	{
+		if(Mono_ClockGetTicks() - start > MONO_CLOCK_MS_TO_TICKS(LORA_BUSY_TIMEOUT_MS))
+		{
+			LORA_RadioFault(LORA_FAULT_BUSY);
+			return;
+		}
+	}
+}
+
+//等待发送完成DIO1置高，超时时间为空中时间加余量，超时返回0
+uint8_t dio1_wait_tx(uint8_t payload_len)
+{
+	uint64_t start = Mono_ClockGetTicks();
+	uint32_t timeout_ms = LORA_TimeOnAirUs(payload_len) / 1000 + LORA_TX_WAIT_MARGIN_MS;
+	
+	while(LORA_READ_IRQ_STATUS() == 0)
+	{
+		if(Mono_ClockGetTicks() - start > MONO_CLOCK_MS_TO_TICKS(timeout_ms))
+		{
+			LORA_RadioFault(LORA_FAULT_DIO1);
+			return 0;
+		}
+	}
+	
+	return 1;
 }
 	
-//DIO1ĵƽ״
+//DIO1中断状态硬件预读布防（接收模式下调用）
+void irq_prefetch_arm(void)
+{
+	LORA_PrefetchArm();
+}
+
+//取出预读的中断状态与接收缓冲区状态，无预读结果返回0
+uint8_t irq_prefetch_get(uint16_t *irq, uint8_t *payload_len, uint8_t *buf_pointer)
+{
+	return LORA_PrefetchGet(irq, payload_len, buf_pointer);
+}
+
+//返回DIO1的电平状况
 uint8_t dio1_pin_read (void)
 {
 	return LORA_READ_IRQ_STATUS();
 }
 
-//ʱ
+//毫秒延时
 void delay_ms(uint16_t ms)
 {
 	nrf_delay_ms(ms);
 }
 
+//接收过滤需要读出的帧头长度
+uint8_t rx_frame_head_size(void)
+{
+	return RX_FILTER_HEAD_SIZE;
+}
 
+//帧头过滤，返回0丢弃
+uint8_t rx_frame_accept(uint8_t *p_head, uint8_t head_len, uint8_t frame_len)
+{
+	return RxFilter_GetHandle()->Check(p_head, head_len, frame_len) == RX_FILTER_PASS;
+}
 
+//射频时间统计计时，单调时钟计数值(32768Hz)
+uint64_t radio_ticks_get(void)
+{
+	return Mono_ClockGetTicks();
+}
 
+//当前调制参数下的空中时间，单位us
+uint32_t radio_time_on_air_us(uint8_t payload_len)
+{
+	return LORA_TimeOnAirUs(payload_len);
+}
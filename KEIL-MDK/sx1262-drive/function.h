@@ -1,7 +1,7 @@
 /*
  * function.h
  *
- *  Created on: 2019320
+ *  Created on: 2019年3月20日
  *      Author: xxk
  */
 
@@ -17,22 +17,37 @@
 
 void gpio_init(void);
 
-//spi2շ
+//spi2收发数据
 uint8_t spi_rw(uint8_t data);
 
-//ģ鸴λź
+//设置模块复位信号
 void 	rst_pin_set (uint8_t val);
 
-//Ƭѡź
+//设置片选信号
 void 	sel_pin_set (uint8_t val);
 
-//DIO0ĵƽ״
+//DIO1中断状态硬件预读
+void 	irq_prefetch_arm(void);
+uint8_t irq_prefetch_get(uint16_t *irq, uint8_t *payload_len, uint8_t *buf_pointer);
+
+//返回DIO0的电平状况
 uint8_t dio1_pin_read (void);
 
 //busy
 void check_busy(void);
 
-//ʱ
+//等待发送完成
+uint8_t dio1_wait_tx(uint8_t payload_len);
+
+//延时函数
 void delay_ms(uint16_t ms);
 
+//接收帧头过滤，返回0丢弃
+uint8_t rx_frame_head_size(void);
+uint8_t rx_frame_accept(uint8_t *p_head, uint8_t head_len, uint8_t frame_len);
+
+//射频时间统计计时与空中时间
+uint64_t radio_ticks_get(void);
+uint32_t radio_time_on_air_us(uint8_t payload_len);
+
 #endif /* FUNCTION_H_ */
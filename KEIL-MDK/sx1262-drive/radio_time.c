@@ -0,0 +1,238 @@
+/*
+ * radio_time.c
+ * 射频模块各工作状态时间与空中时间统计
+ * 累计时间使用单调时钟计数值，分钟/小时窗口按绝对时间对齐的桶滚动
+ */
+#include "radio_time.h"
+#include "function.h"
+#include <string.h>
+
+#define RADIO_TIME_SLOT_TICKS		((uint64_t)RADIO_TIME_SLOT_SECONDS * RADIO_TIME_TICKS_FREQ)
+#define RADIO_TIME_SLOTS_PER_MINUTE	(60u / RADIO_TIME_SLOT_SECONDS)
+#define RADIO_TIME_TICKS_TO_MS(ticks)	((uint32_t)(((ticks) * 1000u) / RADIO_TIME_TICKS_FREQ))
+#define RADIO_TIME_UNITS_TO_MS(units)	((uint32_t)(((units) * 1000u) >> (15 - RADIO_TIME_UNIT_SHIFT)))
+
+typedef struct {
+	uint8_t state;
+	uint8_t started;
+	uint32_t slot_no;						//当前桶序号(绝对时间/桶长度)
+	uint64_t last_ticks;					//上次结算时刻
+	uint64_t start_ticks;					//开始统计时刻
+	uint64_t tx_start_ticks;				//进入发送时刻
+	uint64_t total[RADIO_TIME_STATE_NUMS];	//单位tick
+	uint16_t slot[RADIO_TIME_SLOT_NUMS][RADIO_TIME_STATE_NUMS];		//单位见RADIO_TIME_UNIT_SHIFT
+	uint16_t minute[RADIO_TIME_MINUTE_NUMS][RADIO_TIME_STATE_NUMS];
+	uint64_t sf_tx[RADIO_TIME_SF_NUMS];		//单位tick
+	uint64_t sf_rx[RADIO_TIME_SF_NUMS];
+	uint32_t channel_freq[RADIO_TIME_CHANNEL_NUMS];
+	uint64_t channel_tx[RADIO_TIME_CHANNEL_NUMS];
+	uint64_t channel_rx[RADIO_TIME_CHANNEL_NUMS];
+	uint32_t tx_nums;
+	uint32_t rx_nums;
+}radio_time_t;
+
+static radio_time_t m_radio_time;
+
+//新桶清零，每分钟第一个桶同时清零新的分钟桶
+static void radio_time_slot_open(uint32_t slot_no)
+{
+	memset(m_radio_time.slot[slot_no % RADIO_TIME_SLOT_NUMS], 0, sizeof(m_radio_time.slot[0]));
+	if(slot_no % RADIO_TIME_SLOTS_PER_MINUTE == 0)
+	{
+		memset(m_radio_time.minute[(slot_no / RADIO_TIME_SLOTS_PER_MINUTE) % RADIO_TIME_MINUTE_NUMS], 0,
+			   sizeof(m_radio_time.minute[0]));
+	}
+}
+
+//[from,to)位于当前桶内，按单位边界差值计入，多次累加不丢失截断误差
+static void radio_time_slot_add(uint8_t state, uint64_t from, uint64_t to)
+{
+	uint16_t units = (uint16_t)((to >> RADIO_TIME_UNIT_SHIFT) - (from >> RADIO_TIME_UNIT_SHIFT));
+
+	m_radio_time.slot[m_radio_time.slot_no % RADIO_TIME_SLOT_NUMS][state] += units;
+	m_radio_time.minute[(m_radio_time.slot_no / RADIO_TIME_SLOTS_PER_MINUTE) % RADIO_TIME_MINUTE_NUMS][state] += units;
+}
+
+//将上次结算至now的时间计入当前状态
+static uint64_t radio_time_advance(void)
+{
+	uint64_t now = radio_ticks_get();
+	uint64_t slot_end;
+
+	if(m_radio_time.started == 0)
+	{
+		m_radio_time.started = 1;
+		m_radio_time.state = RADIO_TIME_STANDBY;
+		m_radio_time.start_ticks = now;
+		m_radio_time.last_ticks = now;
+		m_radio_time.slot_no = (uint32_t)(now / RADIO_TIME_SLOT_TICKS);
+		return now;
+	}
+
+	m_radio_time.total[m_radio_time.state] += now - m_radio_time.last_ticks;
+	while(m_radio_time.last_ticks < now)
+	{
+		slot_end = (uint64_t)(m_radio_time.slot_no + 1) * RADIO_TIME_SLOT_TICKS;
+		if(now < slot_end)
+		{
+			radio_time_slot_add(m_radio_time.state, m_radio_time.last_ticks, now);
+			m_radio_time.last_ticks = now;
+			break;
+		}
+
+		radio_time_slot_add(m_radio_time.state, m_radio_time.last_ticks, slot_end);
+		m_radio_time.last_ticks = slot_end;
+		m_radio_time.slot_no++;
+		radio_time_slot_open(m_radio_time.slot_no);
+	}
+
+	return now;
+}
+
+//查找信道，未记录时占用空闲项或替换空中时间最少的项
+static uint8_t radio_time_channel_get(uint32_t frequency)
+{
+	uint8_t i, min = 0;
+
+	for(i = 0; i < RADIO_TIME_CHANNEL_NUMS; i++)
+	{
+		if(m_radio_time.channel_freq[i] == frequency)
+		{
+			return i;
+		}
+	}
+
+	for(i = 0; i < RADIO_TIME_CHANNEL_NUMS; i++)
+	{
+		if(m_radio_time.channel_freq[i] == 0)
+		{
+			min = i;
+			break;
+		}
+
+		if(m_radio_time.channel_tx[i] + m_radio_time.channel_rx[i] <
+		   m_radio_time.channel_tx[min] + m_radio_time.channel_rx[min])
+		{
+			min = i;
+		}
+	}
+
+	m_radio_time.channel_freq[min] = frequency;
+	m_radio_time.channel_tx[min] = 0;
+	m_radio_time.channel_rx[min] = 0;
+	return min;
+}
+
+void radio_time_enter(radio_time_state_t state)
+{
+	uint64_t now = radio_time_advance();
+
+	if(state == RADIO_TIME_TX && m_radio_time.state != RADIO_TIME_TX)
+	{
+		m_radio_time.tx_start_ticks = now;
+	}
+	m_radio_time.state = state;
+}
+
+void radio_time_tx_done(uint8_t sf, uint32_t frequency)
+{
+	uint64_t now = radio_time_advance();
+	uint64_t airtime;
+
+	if(m_radio_time.state == RADIO_TIME_TX)
+	{
+		airtime = now - m_radio_time.tx_start_ticks;
+		if(sf >= RADIO_TIME_SF_MIN && sf < RADIO_TIME_SF_MIN + RADIO_TIME_SF_NUMS)
+		{
+			m_radio_time.sf_tx[sf - RADIO_TIME_SF_MIN] += airtime;
+		}
+		m_radio_time.channel_tx[radio_time_channel_get(frequency)] += airtime;
+		m_radio_time.tx_nums++;
+	}
+	m_radio_time.state = RADIO_TIME_STANDBY;
+}
+
+void radio_time_rx_frame(uint8_t sf, uint32_t frequency, uint32_t airtime_us)
+{
+	uint64_t airtime = ((uint64_t)airtime_us * RADIO_TIME_TICKS_FREQ) / 1000000u;
+	uint16_t units = (uint16_t)(airtime >> RADIO_TIME_UNIT_SHIFT);
+	uint16_t *slot, *minute;
+
+	radio_time_advance();
+
+	//帧在监听期间接收，从监听时间中划出，不超过已累计的监听时间
+	if(airtime > m_radio_time.total[RADIO_TIME_RX_ARMED])
+	{
+		airtime = m_radio_time.total[RADIO_TIME_RX_ARMED];
+	}
+	m_radio_time.total[RADIO_TIME_RX_ARMED] -= airtime;
+	m_radio_time.total[RADIO_TIME_RX_BUSY] += airtime;
+
+	//窗口桶只调整当前桶
+	slot = m_radio_time.slot[m_radio_time.slot_no % RADIO_TIME_SLOT_NUMS];
+	minute = m_radio_time.minute[(m_radio_time.slot_no / RADIO_TIME_SLOTS_PER_MINUTE) % RADIO_TIME_MINUTE_NUMS];
+	if(units > slot[RADIO_TIME_RX_ARMED])
+	{
+		units = slot[RADIO_TIME_RX_ARMED];
+	}
+	slot[RADIO_TIME_RX_ARMED] -= units;
+	slot[RADIO_TIME_RX_BUSY] += units;
+	minute[RADIO_TIME_RX_ARMED] -= units;
+	minute[RADIO_TIME_RX_BUSY] += units;
+
+	if(sf >= RADIO_TIME_SF_MIN && sf < RADIO_TIME_SF_MIN + RADIO_TIME_SF_NUMS)
+	{
+		m_radio_time.sf_rx[sf - RADIO_TIME_SF_MIN] += airtime;
+	}
+	m_radio_time.channel_rx[radio_time_channel_get(frequency)] += airtime;
+	m_radio_time.rx_nums++;
+}
+
+void radio_time_report(radio_time_report_t *p_report)
+{
+	uint64_t now = radio_time_advance();
+	uint64_t elapsed = now - m_radio_time.start_ticks;
+	uint64_t window;
+	uint32_t minute_units, hour_units;
+	uint8_t i, j;
+
+	for(i = 0; i < RADIO_TIME_STATE_NUMS; i++)
+	{
+		minute_units = 0;
+		for(j = 0; j < RADIO_TIME_SLOT_NUMS; j++)
+		{
+			minute_units += m_radio_time.slot[j][i];
+		}
+
+		hour_units = 0;
+		for(j = 0; j < RADIO_TIME_MINUTE_NUMS; j++)
+		{
+			hour_units += m_radio_time.minute[j][i];
+		}
+
+		p_report->total_ms[i] = RADIO_TIME_TICKS_TO_MS(m_radio_time.total[i]);
+		p_report->minute_ms[i] = RADIO_TIME_UNITS_TO_MS(minute_units);
+		p_report->hour_ms[i] = RADIO_TIME_UNITS_TO_MS(hour_units);
+	}
+
+	//窗口长度：完整桶加当前桶已过时间，上电时间不足时取上电时间
+	window = (RADIO_TIME_SLOT_NUMS - 1) * RADIO_TIME_SLOT_TICKS + now % RADIO_TIME_SLOT_TICKS;
+	p_report->minute_window_ms = RADIO_TIME_TICKS_TO_MS(window < elapsed ? window : elapsed);
+	window = (RADIO_TIME_MINUTE_NUMS - 1) * RADIO_TIME_SLOTS_PER_MINUTE * RADIO_TIME_SLOT_TICKS +
+			 now % (RADIO_TIME_SLOTS_PER_MINUTE * RADIO_TIME_SLOT_TICKS);
+	p_report->hour_window_ms = RADIO_TIME_TICKS_TO_MS(window < elapsed ? window : elapsed);
+
+	p_report->tx_nums = m_radio_time.tx_nums;
+	p_report->rx_nums = m_radio_time.rx_nums;
+	for(i = 0; i < RADIO_TIME_SF_NUMS; i++)
+	{
+		p_report->sf_tx_ms[i] = RADIO_TIME_TICKS_TO_MS(m_radio_time.sf_tx[i]);
+		p_report->sf_rx_ms[i] = RADIO_TIME_TICKS_TO_MS(m_radio_time.sf_rx[i]);
+	}
+	for(i = 0; i < RADIO_TIME_CHANNEL_NUMS; i++)
+	{
+		p_report->channel[i].frequency = m_radio_time.channel_freq[i];
+		p_report->channel[i].tx_ms = RADIO_TIME_TICKS_TO_MS(m_radio_time.channel_tx[i]);
+		p_report->channel[i].rx_ms = RADIO_TIME_TICKS_TO_MS(m_radio_time.channel_rx[i]);
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * radio_time.h
+ * 射频模块各工作状态时间与空中时间统计
+ */
+
+#ifndef RADIO_TIME_H_
+#define RADIO_TIME_H_
+#include <stdint.h>
+
+/* 统计的工作状态 */
+typedef enum {
+	RADIO_TIME_RX_ARMED,	//接收监听
+	RADIO_TIME_RX_BUSY,		//接收数据帧(按收到帧的空中时间从监听时间中划出)
+	RADIO_TIME_TX,			//发送
+	RADIO_TIME_CAD,			//信道活动检测
+	RADIO_TIME_STANDBY,		//待机与参数配置
+	RADIO_TIME_SLEEP,		//睡眠
+	RADIO_TIME_RESET,		//复位
+	RADIO_TIME_STATE_NUMS,
+}radio_time_state_t;
+
+#define RADIO_TIME_TICKS_FREQ		32768u	//计时时钟频率(单调时钟)
+#define RADIO_TIME_UNIT_SHIFT		5		//窗口计时单位32tick(1/1024s)，分钟桶不超过16位
+#define RADIO_TIME_SLOT_SECONDS		10u		//分钟窗口桶长度，单位s
+#define RADIO_TIME_SLOT_NUMS		7		//分钟窗口：6个完整桶+当前桶
+#define RADIO_TIME_MINUTE_NUMS		61		//小时窗口：60个完整分钟+当前分钟
+#define RADIO_TIME_SF_MIN			5		//统计SF5~SF12
+#define RADIO_TIME_SF_NUMS			8
+#define RADIO_TIME_CHANNEL_NUMS		4		//统计的信道数，超出时替换空中时间最少的信道
+
+typedef struct {
+	uint32_t frequency;		//信道频率，0为未使用
+	uint32_t tx_ms;			//发送空中时间
+	uint32_t rx_ms;			//接收空中时间
+}radio_time_channel_t;
+
+typedef struct {
+	uint32_t total_ms[RADIO_TIME_STATE_NUMS];	//上电以来各状态时间
+	uint32_t minute_ms[RADIO_TIME_STATE_NUMS];	//最近1分钟各状态时间
+	uint32_t hour_ms[RADIO_TIME_STATE_NUMS];	//最近1小时各状态时间
+	uint32_t minute_window_ms;					//分钟窗口实际长度(上电不足时较短)
+	uint32_t hour_window_ms;					//小时窗口实际长度
+	uint32_t tx_nums;							//发送帧数
+	uint32_t rx_nums;							//接收帧数
+	uint32_t sf_tx_ms[RADIO_TIME_SF_NUMS];		//各扩频因子发送空中时间
+	uint32_t sf_rx_ms[RADIO_TIME_SF_NUMS];		//各扩频因子接收空中时间
+	radio_time_channel_t channel[RADIO_TIME_CHANNEL_NUMS];
+}radio_time_report_t;
+
+//进入工作状态
+void radio_time_enter(radio_time_state_t state);
+
+//发送完成，发送状态时间计入扩频因子与信道的发送空中时间，模块回到待机
+void radio_time_tx_done(uint8_t sf, uint32_t frequency);
+
+//接收完成一帧，空中时间由接收监听转为接收数据帧
+void radio_time_rx_frame(uint8_t sf, uint32_t frequency, uint32_t airtime_us);
+
+//读取统计结果
+void radio_time_report(radio_time_report_t *p_report);
+
+#endif /* RADIO_TIME_H_ */
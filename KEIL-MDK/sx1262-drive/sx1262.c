@@ -7,6 +7,7 @@
 
 #include "sx1262.h"
 #include "sys_param.h"
+#include "radio_time.h"
 
 
 sx1262_drive_t self;
@@ -22,13 +23,32 @@ sx1262_drive_t self;
 #define CAD_STATE_GET(p_this)         ((p_this).run_state.cad_state)
 #define CAD_STATE_CLR(p_this)         ((p_this).run_state.cad_state = 0)
 
+#define SHADOW_INVALIDATE(p_this)     ((p_this).radio_shadow.valid = 0)
+
+/* 配置与影子一致时返回1并计数，否则更新影子有效位并返回0 */
+static uint8_t _ShadowHit(uint8_t valid_bit, uint8_t same)
+{
+	if((self.radio_shadow.valid & valid_bit) && same)
+	{
+		self.radio_shadow.saved_nums++;
+		return 1;
+	}
+
+	self.radio_shadow.valid |= valid_bit;
+	self.radio_shadow.sent_nums++;
+	return 0;
+}
+
 //设备复位
 void _Reset()
 {
+	SHADOW_INVALIDATE(self);
+	radio_time_enter(RADIO_TIME_RESET);
 	rst_pin_set(0);
 	delay_ms(20);		//more thena 100us, delay 10ms
 	rst_pin_set(1);
 	delay_ms(10);		//delay 10ms
+	radio_time_enter(RADIO_TIME_STANDBY);
 }
 
 //设备休眠
@@ -44,6 +64,9 @@ void _SetSleep(void)
 	spi_rw(SX126X_CMD_SET_SLEEP);
 	spi_rw(sleepConfig);
 	sel_pin_set (1);
+	radio_time_enter(RADIO_TIME_SLEEP);
+
+	SHADOW_INVALIDATE(self); //唤醒后不依赖保留的配置
 }
 
 //0:STDBY_RC; 1:STDBY_XOSC  设置为待机模式，等待配置设备参数
@@ -54,6 +77,7 @@ void _SetStandby(uint8_t StdbyConfig)
 	spi_rw(SX126X_CMD_SET_STANDBY);
 	spi_rw(StdbyConfig);
 	sel_pin_set(1);
+	radio_time_enter(RADIO_TIME_STANDBY);
 }
 
 //设置发送模式，和等待时间
@@ -72,6 +96,7 @@ void _SetTx(uint32_t timeout)
 	spi_rw(time_out[1]);
 	spi_rw(time_out[2]);
 	sel_pin_set (1);
+	radio_time_enter(RADIO_TIME_TX);
 }
 
 //设置发送超时时间
@@ -101,6 +126,7 @@ void _SetRx(bool rx_mode,uint32_t timeout)
 	spi_rw(time_out[1]);
 	spi_rw(time_out[2]);
 	sel_pin_set (1);
+	radio_time_enter(RADIO_TIME_RX_ARMED);
 }
 
 //设置接收超时时间
@@ -152,6 +178,21 @@ void _GetChipStatus(uint8_t status,uint16_t IrqStatus)
 	sel_pin_set (1);
 }
 
+//获取芯片状态字节，bit6:4为芯片模式，bit3:1为命令状态
+uint8_t _GetDeviceStatus(void)
+{
+	uint8_t status;
+
+	check_busy();
+
+	sel_pin_set(0);
+	spi_rw(SX126X_CMD_GET_STATUS);
+	status = spi_rw(0xFF);
+	sel_pin_set(1);
+
+	return status;
+}
+
 //获取中断状态
 uint16_t _GetIrqStatus(void)
 {
@@ -214,11 +255,20 @@ void _SetCADMode()
 	sel_pin_set(0);
 	spi_rw(SX126X_CMD_SET_CAD);
 	sel_pin_set (1);
+	radio_time_enter(RADIO_TIME_CAD);
 }
 
 //打开中断和dio1中断映射
 void  _SetDioIrqParams(uint16_t Mask,uint16_t DIO1)
 {
+	if(_ShadowHit(SHADOW_DIO_IRQ_VALID,
+				  self.radio_shadow.irq_mask == Mask && self.radio_shadow.dio1_mask == DIO1))
+	{
+		return;
+	}
+	self.radio_shadow.irq_mask = Mask;
+	self.radio_shadow.dio1_mask = DIO1;
+
 	check_busy();
 
 	uint16_t Irq_Mask;
@@ -257,6 +307,14 @@ void  _SetDioIrqParams(uint16_t Mask,uint16_t DIO1)
 //设置缓存区地址（发送缓存区地址、接收缓存区地址）
 void _SetBufferBaseAddress(uint8_t TX_base_addr,uint8_t RX_base_addr)
 {
+	if(_ShadowHit(SHADOW_BUF_BASE_VALID,
+				  self.radio_shadow.tx_base_addr == TX_base_addr && self.radio_shadow.rx_base_addr == RX_base_addr))
+	{
+		return;
+	}
+	self.radio_shadow.tx_base_addr = TX_base_addr;
+	self.radio_shadow.rx_base_addr = RX_base_addr;
+
 	check_busy();
 	sel_pin_set(0);
 	spi_rw(SX126X_CMD_SET_BUFFER_BASE_ADDRESS);
@@ -308,6 +366,7 @@ void _CADStart(uint8_t *p_state)
 		_SetCADMode();
 		
 		while(dio1_pin_read() == 0){};//等待CAD检测完成
+		radio_time_enter(RADIO_TIME_STANDBY);//CAD_ONLY完成后模块回到待机
 			
 		/* 判断是否是CAD中断 */
     reg_val = _GetIrqStatus();
@@ -349,10 +408,17 @@ void _SetPacketType()
 //RF_Freq = freq_reg*32M/(2^25)-----> freq_reg = (RF_Freq * (2^25))/32
 void _SetRfFrequency(uint32_t frequency)
 {
-	check_busy();
 	uint8_t Rf_Freq[4];
 	uint32_t RfFreq = 0;
 	self.radio_param.frequency = frequency;
+
+	if(_ShadowHit(SHADOW_RF_FREQ_VALID, self.radio_shadow.frequency == frequency))
+	{
+		return;
+	}
+	self.radio_shadow.frequency = frequency;
+
+	check_busy();
 	
 	RfFreq = (uint32_t)((double)frequency / (double)FREQ_STEP);
 
@@ -370,6 +436,40 @@ void _SetRfFrequency(uint32_t frequency)
 	sel_pin_set(1);
 }
 
+//写寄存器
+void _WriteRegister(uint16_t addr, uint8_t *data, uint8_t length)
+{
+	uint8_t i;
+
+	check_busy();
+	sel_pin_set(0);
+	spi_rw(SX126X_CMD_WRITE_REGISTER);
+	spi_rw((addr>>8)&0xFF);//MSB
+	spi_rw(addr&0xFF);//LSB
+	for(i=0;i<length;i++)
+	{
+		spi_rw(data[i]);
+	}
+	sel_pin_set(1);
+}
+
+//设置LoRa同步字，0x12->0x1424(私有网络)，0x34->0x3444(LoRaWAN公共网络)
+void _SetSyncWord(uint8_t sync_word)
+{
+	uint8_t reg[2];
+	self.radio_param.sync_word = sync_word;
+
+	if(_ShadowHit(SHADOW_SYNC_WORD_VALID, self.radio_shadow.sync_word == sync_word))
+	{
+		return;
+	}
+	self.radio_shadow.sync_word = sync_word;
+
+	reg[0] = (sync_word & 0xF0) | 0x04;//SX126X_REG_LORA_SYNC_WORD_MSB
+	reg[1] = ((sync_word & 0x0F) << 4) | 0x04;//SX126X_REG_LORA_SYNC_WORD_LSB
+	_WriteRegister(SX126X_REG_LORA_SYNC_WORD_MSB, reg, 2);
+}
+
 //设置pa状态    选择sx1268设备    设置设备能达到的最大输出功率为22dbm
 void _SetPaConfig()
 {
@@ -415,6 +515,16 @@ SET_RAMP_3400U 	0x07	3400
 //设置发送功率和等待时间
 void _SetTxParams(uint8_t power,uint8_t RampTime)
 {
+	self.radio_param.power = power;
+
+	if(_ShadowHit(SHADOW_TX_PARAMS_VALID,
+				  self.radio_shadow.power == power && self.radio_shadow.ramp_time == RampTime))
+	{
+		return;
+	}
+	self.radio_shadow.power = power;
+	self.radio_shadow.ramp_time = RampTime;
+
 	check_busy();
 
 	sel_pin_set(0);
@@ -427,12 +537,21 @@ void _SetTxParams(uint8_t power,uint8_t RampTime)
 //设置设备的扩频因子、带宽、通信码率、通信模式（lora）
 void _SetModulationParams(uint8_t sf, uint8_t bw, uint8_t cr)
 {
-	check_busy();
-
 	self.radio_param.sf = sf;
 	self.radio_param.bandwidth = bw;
 	self.radio_param.coderate = cr;
 
+	if(_ShadowHit(SHADOW_MOD_PARAMS_VALID,
+				  self.radio_shadow.sf == sf && self.radio_shadow.bw == bw && self.radio_shadow.cr == cr))
+	{
+		return;
+	}
+	self.radio_shadow.sf = sf;
+	self.radio_shadow.bw = bw;
+	self.radio_shadow.cr = cr;
+
+	check_busy();
+
 	sel_pin_set(0);
 	spi_rw(SX126X_CMD_SET_MODULATION_PARAMS);
 
@@ -455,13 +574,24 @@ void _SetPacketParams(uint16_t preamble_len,bool header_mode,uint8_t payload_len
 	uint16_t prea_len;
 	uint8_t prea_len_h,prea_len_l;
 
-	check_busy();
-
 	self.radio_param.preamble_len = preamble_len;
 	self.radio_param.header_mode = header_mode;
 	self.radio_param.payload_len = payload_len;
 	self.radio_param.crc_on = crc_on;
 
+	if(_ShadowHit(SHADOW_PKT_PARAMS_VALID,
+				  self.radio_shadow.preamble_len == preamble_len && self.radio_shadow.header_mode == header_mode &&
+				  self.radio_shadow.payload_len == payload_len && self.radio_shadow.crc_on == crc_on))
+	{
+		return;
+	}
+	self.radio_shadow.preamble_len = preamble_len;
+	self.radio_shadow.header_mode = header_mode;
+	self.radio_shadow.payload_len = payload_len;
+	self.radio_shadow.crc_on = crc_on;
+
+	check_busy();
+
 	prea_len = preamble_len;
 	prea_len_h = prea_len>>8;
 	prea_len_l = prea_len&0xFF;
@@ -554,7 +684,11 @@ int _Tx_Data(uint8_t *txbuf,uint8_t payload_length)
 	_SetTx(self.radio_param.tx_pkt_timeout);//timeout = 320000 * 15.625us = 5s
 
 	//Wait for the IRQ TxDone or Timeout
-	while(dio1_pin_read() == 0);//等待数据发送完成或时间结束
+	if(dio1_wait_tx(payload_length) == 0)//等待数据发送完成或时间结束
+	{
+		return LORA_RET_CODE_ERR;
+	}
+	radio_time_tx_done(self.radio_param.sf, self.radio_param.frequency);//发送结束后模块自动回到待机
 
 	
 	Irq_Status = _GetIrqStatus();
@@ -591,8 +725,11 @@ void _SetRxMode(void)
 {
 	SM_STATE_SET(self, RFLR_STATE_RX_RUNNING);
 	_SetBufferBaseAddress(0,0);	//(TX_base_addr,RX_base_addr)
-	_SetDioIrqParams(SX126X_IRQ_RX_DONE | SX126X_IRQ_CRC_ERR | SX126X_IRQ_TIMEOUT,SX126X_IRQ_RX_DONE | SX126X_IRQ_TIMEOUT);//RxDone IRQ
+	_ClearIrqStatus(SX126X_IRQ_PREAMBLE_DETECTED | SX126X_IRQ_HEADER_VALID);
+	_SetDioIrqParams(SX126X_IRQ_RX_DONE | SX126X_IRQ_CRC_ERR | SX126X_IRQ_TIMEOUT | SX126X_IRQ_PREAMBLE_DETECTED | SX126X_IRQ_HEADER_VALID,
+					 SX126X_IRQ_RX_DONE | SX126X_IRQ_TIMEOUT);//RxDone IRQ，前导码与报头标志只用于查询接收状态
 	_SetRx(self.radio_param.rx_mode,self.radio_param.rx_pkt_timeout);//timeout = 0
+	irq_prefetch_arm();//DIO1中断时由硬件读出中断状态与接收缓冲区状态
 }
 
 uint8_t _GetPtkStatus(void)
@@ -601,24 +738,33 @@ uint8_t _GetPtkStatus(void)
 	sel_pin_set(0);
 	spi_rw(SX126X_CMD_GET_PACKET_STATUS);
 	uint8_t status = spi_rw(0xFF);
-	uint8_t rx_status = spi_rw(0xFF);
-	uint8_t rssi_sync = spi_rw(0xFF);
-	uint8_t rssi_avg = spi_rw(0xFF);
+	spi_rw(0xFF);//RssiPkt，未使用
+	uint8_t snr_pkt = spi_rw(0xFF);
+	uint8_t signal_rssi_pkt = spi_rw(0xFF);
 	sel_pin_set(1);
-	return rssi_avg;
+	self.radio_state.snr = (int8_t)snr_pkt / 4;//SnrPkt单位0.25dB
+	return signal_rssi_pkt;
 }
 
 //接收数据
 int _Rx_Data(uint8_t *addr,uint8_t *size)
 {
 	uint8_t buf_offset;
+	uint8_t head_len;
 	uint16_t Irq_Status;
-	Irq_Status = _GetIrqStatus();//读取中断状态
+	uint8_t prefetch = irq_prefetch_get(&Irq_Status, size, &buf_offset);//硬件已预读则不再访问SPI
+	if(prefetch == 0)
+	{
+		Irq_Status = _GetIrqStatus();//读取中断状态
+	}
 	if(Irq_Status & SX126X_IRQ_RX_DONE)
 	{
-		_ClearIrqStatus(SX126X_IRQ_RX_DONE);//Clear the IRQ RxDone flag
+		_ClearIrqStatus(SX126X_IRQ_RX_DONE | SX126X_IRQ_PREAMBLE_DETECTED | SX126X_IRQ_HEADER_VALID);//Clear the IRQ RxDone flag
 
-		Irq_Status = _GetIrqStatus();
+		if(prefetch == 0)
+		{
+			Irq_Status = _GetIrqStatus();
+		}
 		if((Irq_Status & SX126X_IRQ_CRC_ERR)== SX126X_IRQ_CRC_ERR)
 		{
 			_ClearIrqStatus(SX126X_IRQ_CRC_ERR);//Clear the IRQ CRC_ERR flag
@@ -626,8 +772,21 @@ int _Rx_Data(uint8_t *addr,uint8_t *size)
 			return LORA_RET_RECV_CRC_ERR;
 		}
 
-		_GetRxBufferStatus(size, &buf_offset);
-		_ReadBuffer(buf_offset, addr, *size);
+		if(prefetch == 0)
+		{
+			_GetRxBufferStatus(size, &buf_offset);
+		}
+		radio_time_rx_frame(self.radio_param.sf, self.radio_param.frequency, radio_time_on_air_us(*size));
+
+		//先读帧头过滤，非本网络的帧不再读取数据段
+		head_len = (*size < rx_frame_head_size()) ? *size : rx_frame_head_size();
+		_ReadBuffer(buf_offset, addr, head_len);
+		if(rx_frame_accept(addr, head_len, *size) == 0)
+		{
+			*size = 0;
+			return LORA_RET_RECV_DROP;
+		}
+		_ReadBuffer(buf_offset + head_len, addr + head_len, *size - head_len);
 		self.radio_state.rssi = 0-(_GetPtkStatus())/2;
 
 		if (self.radio_param.rx_mode == CONTINUOUS_RECV_MODE)
@@ -733,6 +892,8 @@ void _sx1262_init()
 	
 	_SetPacketType();	 //0:GFSK; 1:LORA  选择工作模式为lora
 	
+	_SetSyncWord(self.radio_param.sync_word);//同步字不同的网络帧在前导码后即被模块丢弃
+	
 	_SetRfFrequency(self.radio_param.frequency);//434M ; RF_Freq = freq_reg*32M/(2^25)  设置发射频率
 	
 	_SetTxParams(self.radio_param.power,SX126X_PA_RAMP_10U);//set power and ramp_time 设置发射功率和等待时间
@@ -806,6 +967,7 @@ sx1262_lora_param_set_t __sx1262_lora_param = {
     10,            							/* 负载长度 */
     14,             						/* 前导码长度  */
 	SX126X_DIO3_OUTPUT_3_3,			  		/*晶振电源输入大小*/
+	0x12,									/* 同步字 */
 };
 
 radio_drv_funcs_t radio_sx1262_lora_init()
@@ -824,6 +986,7 @@ radio_drv_funcs_t radio_sx1262_lora_init()
 	self.radio_param.preamble_len = param->lora_preamble;
 	self.radio_param.header_mode = param->lora_header;
 	self.radio_param.crc_on = param->lora_crc;	
+	self.radio_param.sync_word = param->lora_sync_word;
 	
 	return *self.p_drive;
 }
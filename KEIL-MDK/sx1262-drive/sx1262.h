@@ -1,7 +1,7 @@
 /*
  * sx1262.h
  *
- *  Created on: 2019626
+ *  Created on: 2019年6月26日
  *      Author: xxk
  */
 
@@ -12,7 +12,7 @@
 #include "function.h"
 
 /**
- * \brief ģ鵱ǰ״̬
+ * \brief 模块当前运行状态
  */
 typedef enum {
     IDLE_ST = 0,
@@ -29,7 +29,7 @@ typedef enum {
  * \name grp_lora_state
  */
 typedef enum {
-    RFLR_STATE_IDLE,    	//״̬
+    RFLR_STATE_IDLE,    	//空闲状态
     RFLR_STATE_RX_INIT,
     RFLR_STATE_RX_RUNNING,
     RFLR_STATE_RX_DONE,
@@ -43,7 +43,7 @@ typedef enum {
 } sx1262_lora_sm_t;
 
 /*
- * \name grp_lora_cad_state  CAD ״̬
+ * \name grp_lora_cad_state  CAD 状态
  */
 #define CAD_STATE_START         0x01
 #define CAD_STATE_FINISH        0x02
@@ -52,9 +52,9 @@ typedef enum {
 
 
 /*
- * \brief ״̬
- *  cad_stateֵοgrp_lora_cad_state
- *  sm_state ֵοgrp_lora_state
+ * \brief 运行状态
+ *  cad_state值参考：grp_lora_cad_state
+ *  sm_state 值参考：grp_lora_state
  */
 typedef struct sx127x_setting {
     uint8_t          cad_state;
@@ -63,7 +63,7 @@ typedef struct sx127x_setting {
 
 
 /*
- * \brief ֵ
+ * \brief 函数返回值
  */
 enum {
 	LORA_RET_CODE_OK = 0,
@@ -71,7 +71,8 @@ enum {
 	LORA_RET_CODE_NO_CAD_DONE_IRQ,
 	LORA_RET_CODE_NO_CAD_DETECT_IRQ,
 	LORA_RET_CAD_RUNNING,
-	LORA_RET_RECV_CRC_ERR
+	LORA_RET_RECV_CRC_ERR,
+	LORA_RET_RECV_DROP
 };
 
 /*
@@ -88,27 +89,28 @@ enum {
 
 
 /**
- * \brief LoRa
+ * \brief LoRa参数配置
  */
 typedef struct sx1262_lora_param_set {
-    uint32_t frequency;              /* Ƶ */
-    int8_t   power;                  /* 书 */
-    uint8_t  bandwidth;              /*  [0: 7.8 kHz, 1: 10.4 kHz, 2: 15.6 kHz, 3: 20.8 kHz, 4: 31.2 kHz,
+    uint32_t frequency;              /* 频率 */
+    int8_t   power;                  /* 发射功率 */
+    uint8_t  bandwidth;              /* 带宽 [0: 7.8 kHz, 1: 10.4 kHz, 2: 15.6 kHz, 3: 20.8 kHz, 4: 31.2 kHz,
                                               5: 41.6 kHz, 6: 62.5 kHz, 7: 125 kHz, 8: 250 kHz,  9: 500 kHz, other: Reserved] */
-    uint8_t  sf;                     /* Ƶ [5:326: 64, 7: 128, 8: 256, 9: 512, 10: 1024, 11: 2048, 12: 4096  chips] */
-    uint8_t  coderate;               /*  [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8] */
-    bool     crc_on;                 /* CRC [0: ر, 1: ] */
-    bool     header_mode;            /* ͷģʽ [0: ʽͷģʽ, 1: ʽͷģʽ] עSFΪ6ʱֻʹʽͷ */
-    bool     rx_mode;                /* ģʽ [0: Continuous, 1 Single] */
-    uint32_t tx_pkt_timeout;         /* ͳʱ */
-    uint32_t rx_pkt_timeout;         /* ճʱ */
-    uint8_t  payload_len;            /* س */
-    uint16_t preamble_len;           /* ǰ볤 */
-    uint8_t  tcxoVoltage;			 /* ԴС*/
+    uint8_t  sf;                     /* 扩频因子 [5:32，6: 64, 7: 128, 8: 256, 9: 512, 10: 1024, 11: 2048, 12: 4096  chips] */
+    uint8_t  coderate;               /* 编码率 [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8] */
+    bool     crc_on;                 /* CRC检验 [0: 关闭, 1: 开启] */
+    bool     header_mode;            /* 报头模式 [0: 显式报头模式, 1: 隐式报头模式] 注：SF为6时只能使用隐式报头 */
+    bool     rx_mode;                /* 接收模式 [0: Continuous, 1 Single] */
+    uint32_t tx_pkt_timeout;         /* 发送超时 */
+    uint32_t rx_pkt_timeout;         /* 接收超时 */
+    uint8_t  payload_len;            /* 负载长度 */
+    uint16_t preamble_len;           /* 前导码长度 */
+    uint8_t  tcxoVoltage;			 /* 晶振电源输入大小*/
+    uint8_t  sync_word;              /* 同步字 [0x12: 私有网络, 0x34: LoRaWAN公共网络] */
 } sx1262_lora_param_set_t;
 
 /*
- * \brief packet Ϣṹ
+ * \brief packet 包信息结构体
  */
 typedef struct sx1262_pkt_state {
 	bool    crc_pass;
@@ -126,8 +128,44 @@ typedef struct sx1262_CADParams{
 }sx1262_CADParams_t;
 
 
+/*
+ * \name grp_shadow_valid  配置影子有效位
+ */
+#define SHADOW_BUF_BASE_VALID        0x01
+#define SHADOW_DIO_IRQ_VALID         0x02
+#define SHADOW_PKT_PARAMS_VALID      0x04
+#define SHADOW_MOD_PARAMS_VALID      0x08
+#define SHADOW_TX_PARAMS_VALID       0x10
+#define SHADOW_RF_FREQ_VALID         0x20
+#define SHADOW_SYNC_WORD_VALID       0x40
+
+/*
+ * \brief 芯片当前保存的配置(影子)，参数相同的配置命令不再下发
+ *  复位与休眠后全部失效
+ */
+typedef struct sx1262_shadow {
+	uint8_t  valid;                 /* 有效位，参考grp_shadow_valid */
+	uint8_t  tx_base_addr;
+	uint8_t  rx_base_addr;
+	uint16_t irq_mask;
+	uint16_t dio1_mask;
+	uint16_t preamble_len;
+	uint8_t  header_mode;
+	uint8_t  payload_len;
+	uint8_t  crc_on;
+	uint8_t  sf;
+	uint8_t  bw;
+	uint8_t  cr;
+	uint8_t  power;
+	uint8_t  ramp_time;
+	uint32_t frequency;
+	uint8_t  sync_word;
+	uint32_t sent_nums;             /* 已下发的配置命令数 */
+	uint32_t saved_nums;            /* 省略的配置命令数 */
+} sx1262_shadow_t;
+
 /**
- * \brief ģָ
+ * \brief 模块驱动函数指针
  */
 typedef struct radio_drv_funcs {
 	  void					 (*radio_reset)									(void);
@@ -151,7 +189,7 @@ typedef struct radio_drv_funcs {
 	  void  		     (*radio_GetChipStatus)					(uint8_t status,uint16_t IrqStatus);
 
     int 		       (*radio_dio1_irq_func)					(uint8_t *addr,uint8_t *size);
-    void		       (*radio_SetDIO3AsTCXOCtrl)			(uint8_t tcxoVoltage);  //òԴС
+    void		       (*radio_SetDIO3AsTCXOCtrl)			(uint8_t tcxoVoltage);  //设置补偿晶振电源输入大小
 
 }radio_drv_funcs_t;
 
@@ -164,10 +202,11 @@ typedef struct sx1262_drive
 	sx1262_run_state_t       run_state;
 	sx1262_pkt_info_t 			 radio_state;
 	sx1262_CADParams_t			 radio_cad;
+	sx1262_shadow_t          radio_shadow;
 } sx1262_drive_t;
 
 /**
- * \brief ʼ
+ * \brief 驱动初始函数
  */
 radio_drv_funcs_t radio_sx1262_lora_init(void);
 
@@ -1,7 +1,7 @@
 /*
  * sx1262-regs.h
  *
- *  Created on: 2019626
+ *  Created on: 2019年6月26日
  *      Author: xxk
  */
 
@@ -29,7 +29,7 @@
 
 // SX126X physical layer properties
 #define FREQ_STEP                       0.953674 //FREQ_STEP = 32e6/2^25 Hz
-//#define FREQ_STEP               61.03515625   /**< \brief ֱ*/
+//#define FREQ_STEP               61.03515625   /**< \brief 分辨率*/
 
 // SX126X SPI commands
 // operational modes commands
@@ -0,0 +1,29 @@
+#include <time.h>
+#include "ref_time.h"
+
+
+/**
+ * @brief  主机gmtime换算的参考日期
+ * @param  t: 秒数(已加时区偏移)
+ * @param  date: 返回的日期，依次为年、月、日、时、分、秒
+ * @retval 0成功，-1失败
+ */
+int ref_gmtime(long long t, int date[6])
+{
+	time_t tt = (time_t)t;
+	struct tm tm_buf;
+	
+	if(gmtime_r(&tt, &tm_buf) == NULL)
+	{
+		return -1;
+	}
+	
+	date[0] = tm_buf.tm_year + 1900;
+	date[1] = tm_buf.tm_mon + 1;
+	date[2] = tm_buf.tm_mday;
+	date[3] = tm_buf.tm_hour;
+	date[4] = tm_buf.tm_min;
+	date[5] = tm_buf.tm_sec;
+	
+	return 0;
+}
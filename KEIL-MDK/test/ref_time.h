@@ -0,0 +1,8 @@
+#ifndef __REF_TIME_H__
+#define __REF_TIME_H__
+
+
+/* 单独编译单元包含主机<time.h>，避免与calendar.h的time_t冲突 */
+int ref_gmtime(long long t, int date[6]);
+
+#endif
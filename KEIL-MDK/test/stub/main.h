@@ -0,0 +1,10 @@
+#ifndef __MAIN_H__
+#define __MAIN_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/* 主机测试用main.h，只提供固件公共头文件中的标准类型 */
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef __TEST_STUB_TIME_H__
+#define __TEST_STUB_TIME_H__
+
+
+/* 屏蔽主机<time.h>，time_t由calendar.h定义为32位无符号数 */
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include "calendar.h"
+#include "ref_time.h"
+
+
+/* 东八区偏移，与calendar.c一致 */
+#define TEST_TIME_ZONE_OFFSET		(3600 * 8)
+/* 时间戳上限，加时区偏移后不溢出32位 */
+#define TEST_TIME_STAMP_MAX			(0XFFFFFFFFu - TEST_TIME_ZONE_OFFSET)
+#define TEST_STRIDE_DEFAULT			61u //步长与60互质，遍历到每个秒/分数值
+
+static unsigned long fail_nums = 0;
+
+/* calendar.c使用单调时钟换算帧时间，主机测试不涉及 */
+uint64_t Mono_ClockGetTicks(void)
+{
+	return 0;
+}
+
+static void test_check(time_t t)
+{
+	Date_t date;
+	int ref[6];
+	
+	Calendar_TimeStampToDate(t, &date);
+	
+	if(ref_gmtime((long long)t + TEST_TIME_ZONE_OFFSET, ref) != 0 ||
+	   date.Year != ref[0] || date.Month != ref[1] || date.Day != ref[2] ||
+	   date.Hour != ref[3] || date.Minute != ref[4] || date.Second != ref[5])
+	{
+		if(fail_nums++ < 10)
+		{
+			printf("date mismatch: %u -> %04d-%02d-%02d %02d:%02d:%02d, gmtime %04d-%02d-%02d %02d:%02d:%02d\r\n",
+				   t, date.Year, date.Month, date.Day, date.Hour, date.Minute, date.Second,
+				   ref[0], ref[1], ref[2], ref[3], ref[4], ref[5]);
+		}
+		return;
+	}
+	
+	if(Calendar_DateToTimeStamp(&date) != t)
+	{
+		if(fail_nums++ < 10)
+		{
+			printf("round trip mismatch: %u -> %u\r\n", t, Calendar_DateToTimeStamp(&date));
+		}
+	}
+}
+
+/**
+ * @brief  时间戳与日期互换测试，以gmtime为参考并校验往返一致
+ *         用法: test_calendar [步长]，步长为1时遍历全部时间戳
+ */
+int main(int argc, char* argv[])
+{
+	unsigned long stride = TEST_STRIDE_DEFAULT;
+	unsigned long nums = 0;
+	
+	/* 主机<stdlib.h>会引入64位time_t，不使用strtoul */
+	if(argc > 1 && sscanf(argv[1], "%lu", &stride) != 1)
+	{
+		stride = TEST_STRIDE_DEFAULT;
+	}
+	
+	if(stride == 0)
+	{
+		stride = 1;
+	}
+	
+	/* 按步长覆盖整个32位时间戳范围 */
+	for(unsigned long long t = 0; t <= TEST_TIME_STAMP_MAX; t += stride)
+	{
+		test_check((time_t)t);
+		nums++;
+	}
+	
+	/* 每天的首尾两秒，覆盖所有日期及跨日、跨月、闰日 */
+	for(unsigned long long t = 86400 - TEST_TIME_ZONE_OFFSET; t <= TEST_TIME_STAMP_MAX; t += 86400)
+	{
+		test_check((time_t)(t - 1));
+		test_check((time_t)t);
+		nums += 2;
+	}
+	
+	test_check(0);
+	test_check(TEST_TIME_STAMP_MAX);
+	nums += 2;
+	
+	printf("calendar: %lu checked, %lu failed\r\n", nums, fail_nums);
+	
+	return fail_nums ? 1 : 0;
+}
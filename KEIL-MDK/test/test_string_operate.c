@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "string_operate.h"
+
+
+#define TEST_BENCH_TIMES			1000000u //性能对比的执行次数
+
+static unsigned long check_nums = 0;
+static unsigned long fail_nums = 0;
+
+static void test_expect(const char* name, const char* out, const char* ref)
+{
+	check_nums++;
+	
+	if(strcmp(out, ref) != 0)
+	{
+		if(fail_nums++ < 20)
+		{
+			printf("%s mismatch: \"%s\", snprintf \"%s\"\r\n", name, out, ref);
+		}
+	}
+}
+
+static void test_uint(uint32_t value, uint8_t width)
+{
+	char out[16], ref[16];
+	str_buf_t sb;
+	
+	str_buf_init(&sb, out, sizeof(out));
+	str_buf_append_uint(&sb, value, width);
+	snprintf(ref, sizeof(ref), "%0*u", width, value);
+	test_expect("uint", out, ref);
+}
+
+static void test_int(int32_t value)
+{
+	char out[16], ref[16];
+	str_buf_t sb;
+	
+	str_buf_init(&sb, out, sizeof(out));
+	str_buf_append_int(&sb, value);
+	snprintf(ref, sizeof(ref), "%d", value);
+	test_expect("int", out, ref);
+}
+
+static void test_fixed(float value, uint8_t decimals)
+{
+	char out[32], ref[32];
+	str_buf_t sb;
+	
+	str_buf_init(&sb, out, sizeof(out));
+	str_buf_append_fixed(&sb, value, decimals);
+	snprintf(ref, sizeof(ref), "%.*f", decimals, (double)value);
+	test_expect("fixed", out, ref);
+}
+
+static void test_hex(void)
+{
+	unsigned char src[256];
+	char out[520], ref[520];
+	str_buf_t sb;
+	
+	for(int i = 0; i < (int)sizeof(src); i++)
+	{
+		src[i] = i;
+	}
+	
+	for(unsigned char upper_lower = 0; upper_lower < 2; upper_lower++)
+	{
+		str_buf_init(&sb, out, sizeof(out));
+		str_buf_append_hex(&sb, src, sizeof(src), upper_lower);
+		
+		for(int i = 0; i < (int)sizeof(src); i++)
+		{
+			sprintf(&ref[i * 2], upper_lower ? "%02x" : "%02X", src[i]);
+		}
+		
+		test_expect("hex", out, ref);
+	}
+}
+
+/* 写满后截断，且始终以'\0'结尾 */
+static void test_truncate(void)
+{
+	char out[8];
+	str_buf_t sb;
+	
+	memset(out, 0X55, sizeof(out));
+	str_buf_init(&sb, out, 6);
+	str_buf_append_str(&sb, "ab");
+	str_buf_append_uint(&sb, 123456, 0);
+	str_buf_append_char(&sb, 'c');
+	test_expect("truncate", out, "ab123");
+	
+	check_nums++;
+	if(sb.len != 5 || out[6] != 0X55)
+	{
+		fail_nums++;
+		printf("truncate overflow: len %u\r\n", sb.len);
+	}
+	
+	str_buf_init(&sb, out, 1);
+	str_buf_append_fixed(&sb, -1.5f, 1);
+	test_expect("truncate", out, "");
+}
+
+static double test_elapsed_ns(const struct timespec* start)
+{
+	struct timespec end;
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	
+	return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+/* 与uart_svc打印节点数据的格式相同，对比snprintf的耗时 */
+static void test_bench(void)
+{
+	static const unsigned char addr[4] = {0X12, 0X34, 0XAB, 0XCD};
+	volatile float value = -12.3456f;
+	volatile uint32_t ts = 1577836800u;
+	char out[64];
+	struct timespec start;
+	str_buf_t sb;
+	double ns_sb, ns_printf;
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(uint32_t i = 0; i < TEST_BENCH_TIMES; i++)
+	{
+		str_buf_init(&sb, out, sizeof(out));
+		str_buf_append_hex(&sb, addr, sizeof(addr), 0);
+		str_buf_append_char(&sb, ',');
+		str_buf_append_uint(&sb, ts + i, 0);
+		str_buf_append_char(&sb, ',');
+		str_buf_append_fixed(&sb, value, 3);
+		str_buf_append_str(&sb, "\r\n");
+	}
+	ns_sb = test_elapsed_ns(&start) / TEST_BENCH_TIMES;
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(uint32_t i = 0; i < TEST_BENCH_TIMES; i++)
+	{
+		snprintf(out, sizeof(out), "%02X%02X%02X%02X,%u,%.3f\r\n",
+				 addr[0], addr[1], addr[2], addr[3], ts + i, (double)value);
+	}
+	ns_printf = test_elapsed_ns(&start) / TEST_BENCH_TIMES;
+	
+	printf("bench: str_buf %.1f ns/line, snprintf %.1f ns/line\r\n", ns_sb, ns_printf);
+}
+
+/**
+ * @brief  追加式字符串格式化与snprintf的结果对比及耗时对比
+ */
+int main(void)
+{
+	static const uint32_t uint_tb[] = {0, 1, 9, 10, 99, 100, 999, 1000, 65535, 65536,
+									   99999999, 100000000, 999999999, 1000000000, 4294967295u};
+	static const int32_t int_tb[] = {0, 1, -1, 9, -9, 10, -10, 2147483647, -2147483647 - 1};
+	
+	for(uint32_t i = 0; i < sizeof(uint_tb) / sizeof(uint_tb[0]); i++)
+	{
+		for(uint8_t width = 0; width <= 12; width++)
+		{
+			test_uint(uint_tb[i], width);
+		}
+	}
+	
+	for(uint32_t i = 0; i < sizeof(int_tb) / sizeof(int_tb[0]); i++)
+	{
+		test_int(int_tb[i]);
+	}
+	
+	srand(1);
+	for(uint32_t i = 0; i < 1000000u; i++)
+	{
+		uint32_t value = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		
+		test_uint(value >> (i % 32), i % 4);
+		test_int((int32_t)value);
+	}
+	
+	/* 角度、温度等实际数据范围，覆盖0.5的舍入边界 */
+	for(int32_t i = -200000; i <= 200000; i++)
+	{
+		for(uint8_t decimals = 0; decimals <= 6; decimals++)
+		{
+			test_fixed(i / 1000.0f, decimals);
+		}
+		
+		test_fixed(i / 2000.0f, 3);
+		test_fixed(i * 0.05f, 1);
+	}
+	
+	for(uint32_t i = 0; i < 1000000u; i++)
+	{
+		float value = (float)rand() / RAND_MAX * 200000.0f - 100000.0f;
+		
+		test_fixed(value, i % 7);
+	}
+	
+	/* 恰好为0.5的舍入边界按五成双处理 */
+	for(int32_t i = -64; i <= 64; i++)
+	{
+		test_fixed(i / 2.0f, 0);
+		test_fixed(i / 4.0f, 1);
+		test_fixed(i / 8.0f, 2);
+		test_fixed(i / 64.0f, 5);
+	}
+	
+	test_fixed(0.0f, 3);
+	test_fixed(1e-30f, 6);
+	test_fixed(5e-7f, 6);
+	test_fixed(4.9999997e-7f, 6);
+	test_fixed(16777215.5f, 0);
+	test_fixed(-0.0001f, 3);
+	test_fixed(0.9999999f, 6);
+	test_fixed(4294967040.0f, 0);
+	
+	test_hex();
+	test_truncate();
+	
+	printf("string_operate: %lu checked, %lu failed\r\n", check_nums, fail_nums);
+	
+	test_bench();
+	
+	return fail_nums ? 1 : 0;
+}